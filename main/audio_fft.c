@@ -0,0 +1,77 @@
+/**
+ * @file audio_fft.c
+ * @brief Implementación de la FFT en punto fijo
+ *
+ * Decimación en el tiempo: reordenación por inversión de bits seguida de
+ * log2(N) etapas de mariposas. Con N = 256 el índice del twiddle k de
+ * una etapa de longitud len es k * (256 / len), directamente la entrada
+ * de fx_sin_table.
+ */
+
+#include "audio_fft.h"
+#include "fx_math.h"
+#include "esp_attr.h"
+
+// Un cuarto de vuelta en la tabla de seno: cos(a) = sin(a + 64)
+#define QUARTER_TURN    64
+
+void audio_fft_window(const int16_t *samples, int32_t *re, int32_t *im)
+{
+    for (int n = 0; n < AUDIO_FFT_SIZE; n++) {
+        // hann(n) = 0.5 - 0.5 cos(2 pi n / N), en Q15
+        int32_t c = fx_sin_table[(n + QUARTER_TURN) & 0xFF];
+        int32_t w = (32767 - c) >> 1;
+        re[n] = (samples[n] * w) >> 15;
+        im[n] = 0;
+    }
+}
+
+void IRAM_ATTR audio_fft(int32_t *re, int32_t *im)
+{
+    // Reordenación por inversión de bits
+    for (int i = 1, j = 0; i < AUDIO_FFT_SIZE; i++) {
+        int bit = AUDIO_FFT_SIZE >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int32_t t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // Mariposas, escalando 1/2 por etapa
+    for (int len = 2; len <= AUDIO_FFT_SIZE; len <<= 1) {
+        int half = len >> 1;
+        int step = AUDIO_FFT_SIZE / len;
+
+        for (int k = 0; k < half; k++) {
+            // w = cos(2 pi k / len) - j sin(2 pi k / len), Q15
+            int32_t wr = fx_sin_table[(k * step + QUARTER_TURN) & 0xFF];
+            int32_t wi = -fx_sin_table[k * step];
+
+            for (int i = k; i < AUDIO_FFT_SIZE; i += len) {
+                int j = i + half;
+                int32_t tr = ((re[j] * wr) >> 15) - ((im[j] * wi) >> 15);
+                int32_t ti = ((re[j] * wi) >> 15) + ((im[j] * wr) >> 15);
+                re[j] = (re[i] - tr) >> 1;
+                im[j] = (im[i] - ti) >> 1;
+                re[i] = (re[i] + tr) >> 1;
+                im[i] = (im[i] + ti) >> 1;
+            }
+        }
+    }
+}
+
+void audio_fft_magnitude(const int32_t *re, const int32_t *im, uint16_t *mag)
+{
+    for (int k = 0; k < AUDIO_FFT_BINS; k++) {
+        int32_t a = re[k] < 0 ? -re[k] : re[k];
+        int32_t b = im[k] < 0 ? -im[k] : im[k];
+        int32_t hi = a > b ? a : b;
+        int32_t lo = a > b ? b : a;
+        int32_t m = hi + ((lo * 3) >> 3);
+        mag[k] = m > 0xFFFF ? 0xFFFF : (uint16_t)m;
+    }
+}
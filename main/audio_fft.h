@@ -0,0 +1,48 @@
+/**
+ * @file audio_fft.h
+ * @brief FFT compleja radix-2 en punto fijo para el análisis de audio
+ *
+ * Transformada de AUDIO_FFT_SIZE puntos sobre int32_t en Q15, en el
+ * sitio (sin buffers auxiliares). Cada etapa divide entre 2 para que
+ * los valores no desborden, así que el resultado queda escalado por
+ * 1 / AUDIO_FFT_SIZE. Los twiddles salen de la tabla de seno de
+ * fx_math (256 muestras por vuelta), por eso el tamaño es fijo.
+ */
+
+#ifndef AUDIO_FFT_H
+#define AUDIO_FFT_H
+
+#include <stdint.h>
+
+#define AUDIO_FFT_SIZE  256
+#define AUDIO_FFT_BINS  (AUDIO_FFT_SIZE / 2)
+
+/**
+ * @brief Aplica la ventana de Hann a un bloque de muestras
+ *
+ * @param samples Bloque de AUDIO_FFT_SIZE muestras PCM de 16 bits
+ * @param[out] re Parte real de la entrada de la FFT
+ * @param[out] im Parte imaginaria (se pone a cero)
+ */
+void audio_fft_window(const int16_t *samples, int32_t *re, int32_t *im);
+
+/**
+ * @brief FFT en el sitio de AUDIO_FFT_SIZE puntos
+ *
+ * @param re Parte real (entrada y salida)
+ * @param im Parte imaginaria (entrada y salida)
+ */
+void audio_fft(int32_t *re, int32_t *im);
+
+/**
+ * @brief Magnitud aproximada de los bins 0 .. AUDIO_FFT_BINS - 1
+ *
+ * Usa max + 3/8 min (error < 7 %) para evitar la raíz cuadrada.
+ *
+ * @param re  Parte real de la salida de la FFT
+ * @param im  Parte imaginaria de la salida de la FFT
+ * @param[out] mag AUDIO_FFT_BINS magnitudes
+ */
+void audio_fft_magnitude(const int32_t *re, const int32_t *im, uint16_t *mag);
+
+#endif // AUDIO_FFT_H
@@ -0,0 +1,380 @@
+/**
+ * @file audio_reactive.c
+ * @brief Implementación de la cadena de audio reactivo
+ *
+ * Dos tareas:
+ * - Captura (solo con fuente I2S): lee del canal I2S y llena bloques
+ * - Análisis: procesa cada bloque completo (FFT, bandas, beat)
+ *
+ * Con la fuente "feed" el papel de la captura lo hace quien llama a
+ * audio_reactive_feed(). En ambos casos el intercambio de bloques usa el
+ * mismo doble buffer protegido por un spinlock.
+ */
+
+#include "audio_reactive.h"
+#include "audio_fft.h"
+#include "fx_math.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AUDIO_SOURCE_I2S
+#include "driver/i2s_std.h"
+#endif
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+static const char *TAG = "AUDIO";
+
+#ifdef CONFIG_AUDIO_ENABLE
+
+#define SAMPLE_RATE         CONFIG_AUDIO_SAMPLE_RATE
+#define BLOCK_PERIOD_US     ((uint32_t)((AUDIO_FFT_SIZE * 1000000ULL) / SAMPLE_RATE))
+#define BUDGET_US           (BLOCK_PERIOD_US * CONFIG_AUDIO_CPU_BUDGET_PCT / 100)
+
+// Límites de las bandas en bins de la FFT (escala aproximadamente logarítmica)
+static const uint8_t s_band_edges[AUDIO_NUM_BANDS + 1] = {
+    1, 2, 4, 7, 12, 20, 34, 60, AUDIO_FFT_BINS
+};
+
+// Magnitud mínima del control automático de ganancia (evita amplificar ruido)
+#define NOISE_FLOOR         24
+// Decaimiento del pico del AGC por bloque (1/256 ~ 4 s a 62 bloques/s)
+#define PEAK_DECAY_SHIFT    8
+// Caída de las bandas por bloque (1/8)
+#define BAND_RELEASE_SHIFT  3
+// Bandas que alimentan el detector de beat (graves)
+#define BEAT_BANDS          3
+// Separación mínima entre beats (limita a 240 bpm)
+#define MIN_BEAT_US         250000
+#define FLUX_FLOOR          32
+
+#define ANALYSIS_TASK_STACK 3072
+#define ANALYSIS_TASK_PRIO  4
+
+// --- Doble buffer de muestras ---
+static int16_t s_blocks[2][AUDIO_FFT_SIZE];
+static int s_fill;                  // Bloque que se está llenando
+static size_t s_fill_pos;
+static bool s_block_ready;          // El otro bloque espera o está en análisis
+static portMUX_TYPE s_block_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- Estado del análisis (solo lo toca la tarea de análisis) ---
+static int32_t s_re[AUDIO_FFT_SIZE];
+static int32_t s_im[AUDIO_FFT_SIZE];
+static uint16_t s_mag[AUDIO_FFT_BINS];
+static uint32_t s_peak[AUDIO_NUM_BANDS + 1];
+static uint32_t s_prev_energy[BEAT_BANDS];
+static int32_t s_flux_avg;
+static int32_t s_smooth[AUDIO_NUM_FEATURES];
+static int64_t s_last_beat_us;
+
+static TaskHandle_t s_analysis_task;
+static bool s_running;
+
+#endif // CONFIG_AUDIO_ENABLE
+
+// --- Resultados publicados ---
+static audio_features_t s_features;
+static audio_stats_t s_stats;
+static portMUX_TYPE s_features_mux = portMUX_INITIALIZER_UNLOCKED;
+
+#ifdef CONFIG_AUDIO_ENABLE
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+/**
+ * @brief Añade muestras al bloque en curso y lo entrega al completarse
+ */
+static void push_samples(const int16_t *pcm, size_t samples)
+{
+    while (samples > 0) {
+        size_t n = AUDIO_FFT_SIZE - s_fill_pos;
+        if (n > samples) {
+            n = samples;
+        }
+        memcpy(&s_blocks[s_fill][s_fill_pos], pcm, n * sizeof(int16_t));
+        s_fill_pos += n;
+        pcm += n;
+        samples -= n;
+
+        if (s_fill_pos < AUDIO_FFT_SIZE) {
+            break;
+        }
+        s_fill_pos = 0;
+
+        portENTER_CRITICAL(&s_block_mux);
+        bool busy = s_block_ready;
+        if (!busy) {
+            s_block_ready = true;
+            s_fill ^= 1;
+        }
+        portEXIT_CRITICAL(&s_block_mux);
+
+        if (busy) {
+            // El análisis va atrasado: se sobrescribe el bloque en curso
+            s_stats.blocks_dropped++;
+        } else {
+            xTaskNotifyGive(s_analysis_task);
+        }
+    }
+}
+
+/**
+ * @brief Normaliza un valor con control automático de ganancia
+ *
+ * @return valor / pico en Q16.16, con el pico siguiendo al máximo reciente
+ */
+static int32_t agc(uint32_t value, uint32_t *peak)
+{
+    uint32_t p = *peak - (*peak >> PEAK_DECAY_SHIFT);
+    if (value > p) {
+        p = value;
+    }
+    if (p < NOISE_FLOOR) {
+        p = NOISE_FLOOR;
+    }
+    *peak = p;
+    return (int32_t)(((uint64_t)value << FX_SHIFT) / p);
+}
+
+/**
+ * @brief Ataque inmediato, caída exponencial
+ */
+static int32_t smooth(int feature, int32_t value)
+{
+    int32_t s = s_smooth[feature] - (s_smooth[feature] >> BAND_RELEASE_SHIFT);
+    s_smooth[feature] = value > s ? value : s;
+    return s_smooth[feature];
+}
+
+/**
+ * @brief Analiza un bloque completo y publica las características
+ */
+static void analyze_block(const int16_t *block)
+{
+    audio_features_t f;
+
+    audio_fft_window(block, s_re, s_im);
+    audio_fft(s_re, s_im);
+    audio_fft_magnitude(s_re, s_im, s_mag);
+
+    // --- Bandas y nivel global ---
+    uint32_t total = 0;
+    uint32_t flux = 0;
+    for (int b = 0; b < AUDIO_NUM_BANDS; b++) {
+        uint32_t sum = 0;
+        for (int k = s_band_edges[b]; k < s_band_edges[b + 1]; k++) {
+            sum += s_mag[k];
+        }
+        total += sum;
+        uint32_t energy = sum / (s_band_edges[b + 1] - s_band_edges[b]);
+
+        if (b < BEAT_BANDS) {
+            if (energy > s_prev_energy[b]) {
+                flux += energy - s_prev_energy[b];
+            }
+            s_prev_energy[b] = energy;
+        }
+
+        f.v[AUDIO_FEATURE_BAND0 + b] = smooth(b, agc(energy, &s_peak[b]));
+    }
+    uint32_t level = total / (AUDIO_FFT_BINS - 1);
+    f.v[AUDIO_FEATURE_LEVEL] = smooth(AUDIO_FEATURE_LEVEL,
+                                      agc(level, &s_peak[AUDIO_NUM_BANDS]));
+
+    // --- Onsets por flujo espectral de los graves ---
+    int32_t threshold = s_flux_avg + (s_flux_avg >> 1) + FLUX_FLOOR;
+    s_flux_avg += ((int32_t)flux - s_flux_avg) >> 4;
+
+    int32_t onset = (int32_t)(((int64_t)flux << FX_SHIFT) / (2 * threshold));
+    f.v[AUDIO_FEATURE_ONSET] = fx_clamp01(onset);
+
+    int64_t now = esp_timer_get_time();
+    bool beat = (int32_t)flux > threshold && now - s_last_beat_us >= MIN_BEAT_US;
+    if (beat) {
+        s_last_beat_us = now;
+        s_smooth[AUDIO_FEATURE_BEAT] = FX_ONE;
+    } else {
+        s_smooth[AUDIO_FEATURE_BEAT] -= s_smooth[AUDIO_FEATURE_BEAT] >> 2;
+    }
+    f.v[AUDIO_FEATURE_BEAT] = s_smooth[AUDIO_FEATURE_BEAT];
+
+    portENTER_CRITICAL(&s_features_mux);
+    memcpy(s_features.v, f.v, sizeof(f.v));
+    s_features.beat_count += beat;
+    s_features.block_seq++;
+    portEXIT_CRITICAL(&s_features_mux);
+}
+
+/**
+ * @brief Tarea de análisis: un bloque por notificación
+ */
+static void analysis_task(void *pvParameter)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // El bloque listo es el que no se está llenando
+        portENTER_CRITICAL(&s_block_mux);
+        int ready = s_fill ^ 1;
+        portEXIT_CRITICAL(&s_block_mux);
+
+        int64_t start = esp_timer_get_time();
+        analyze_block(s_blocks[ready]);
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+
+        s_stats.blocks_analyzed++;
+        s_stats.last_us = elapsed;
+        if (elapsed > s_stats.max_us) {
+            s_stats.max_us = elapsed;
+        }
+        if (elapsed > BUDGET_US) {
+            s_stats.over_budget++;
+        }
+
+        portENTER_CRITICAL(&s_block_mux);
+        s_block_ready = false;
+        portEXIT_CRITICAL(&s_block_mux);
+    }
+}
+
+#ifdef CONFIG_AUDIO_SOURCE_I2S
+
+#define I2S_CHUNK           64
+// Los micrófonos I2S (INMP441, SPH0645...) entregan 24 bits en slots de 32
+#define I2S_SAMPLE_SHIFT    14
+
+static i2s_chan_handle_t s_rx_chan;
+
+/**
+ * @brief Tarea de captura: lee del I2S y llena bloques
+ */
+static void capture_task(void *pvParameter)
+{
+    static int32_t raw[I2S_CHUNK];
+    static int16_t pcm[I2S_CHUNK];
+
+    while (1) {
+        size_t bytes = 0;
+        if (i2s_channel_read(s_rx_chan, raw, sizeof(raw), &bytes, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+
+        size_t n = bytes / sizeof(int32_t);
+        for (size_t i = 0; i < n; i++) {
+            int32_t s = raw[i] >> I2S_SAMPLE_SHIFT;
+            pcm[i] = s > INT16_MAX ? INT16_MAX : (s < INT16_MIN ? INT16_MIN : s);
+        }
+        push_samples(pcm, n);
+    }
+}
+
+static esp_err_t i2s_input_init(void)
+{
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+    esp_err_t err = i2s_new_channel(&chan_cfg, NULL, &s_rx_chan);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT,
+                                                        I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = CONFIG_AUDIO_I2S_BCLK_GPIO,
+            .ws = CONFIG_AUDIO_I2S_WS_GPIO,
+            .dout = I2S_GPIO_UNUSED,
+            .din = CONFIG_AUDIO_I2S_DIN_GPIO,
+        },
+    };
+    std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT;
+
+    err = i2s_channel_init_std_mode(s_rx_chan, &std_cfg);
+    if (err == ESP_OK) {
+        err = i2s_channel_enable(s_rx_chan);
+    }
+    return err;
+}
+
+#endif // CONFIG_AUDIO_SOURCE_I2S
+
+#endif // CONFIG_AUDIO_ENABLE
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+/**
+ * @brief Inicializa la cadena de audio
+ */
+esp_err_t audio_reactive_init(void)
+{
+#ifdef CONFIG_AUDIO_ENABLE
+    s_stats.budget_us = BUDGET_US;
+
+    xTaskCreate(analysis_task, "AUDIO_FFT", ANALYSIS_TASK_STACK, NULL,
+                ANALYSIS_TASK_PRIO, &s_analysis_task);
+
+#ifdef CONFIG_AUDIO_SOURCE_I2S
+    esp_err_t err = i2s_input_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error configurando I2S: %s", esp_err_to_name(err));
+        return err;
+    }
+    xTaskCreate(capture_task, "AUDIO_I2S", 2048, NULL, ANALYSIS_TASK_PRIO + 1, NULL);
+#endif
+
+    s_running = true;
+    ESP_LOGI(TAG, "Audio a %d Hz, bloques de %d muestras (%lu us, presupuesto %lu us)",
+             SAMPLE_RATE, AUDIO_FFT_SIZE, (unsigned long)BLOCK_PERIOD_US,
+             (unsigned long)BUDGET_US);
+    return ESP_OK;
+#else
+    ESP_LOGI(TAG, "Audio desactivado en menuconfig");
+    return ESP_OK;
+#endif
+}
+
+/**
+ * @brief Entrega muestras PCM a la cadena
+ */
+esp_err_t audio_reactive_feed(const int16_t *pcm, size_t samples)
+{
+#ifdef CONFIG_AUDIO_SOURCE_FEED
+    if (!s_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    push_samples(pcm, samples);
+    return ESP_OK;
+#else
+    return ESP_ERR_INVALID_STATE;
+#endif
+}
+
+/**
+ * @brief Copia las características del último bloque analizado
+ */
+void audio_reactive_get_features(audio_features_t *features)
+{
+    portENTER_CRITICAL(&s_features_mux);
+    *features = s_features;
+    portEXIT_CRITICAL(&s_features_mux);
+}
+
+/**
+ * @brief Copia las estadísticas de la cadena de audio
+ */
+void audio_reactive_get_stats(audio_stats_t *stats)
+{
+    *stats = s_stats;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file audio_reactive.h
+ * @brief Cadena de audio para efectos reactivos a la música
+ *
+ * ENTRADA -> FFT -> BANDAS -> DETECTOR DE BEAT -> EFECTOS
+ *
+ * - Entrada: micrófono I2S o line-in con un códec I2S (CONFIG_AUDIO_SOURCE_I2S),
+ *   o muestras PCM entregadas por otra parte del firmware con
+ *   audio_reactive_feed() (CONFIG_AUDIO_SOURCE_FEED), p.ej. desde la red
+ *   o desde un fichero
+ * - Las muestras se acumulan en bloques de AUDIO_FFT_SIZE con doble
+ *   buffer: mientras se analiza un bloque se llena el otro. Si el
+ *   análisis no termina a tiempo el bloque nuevo se descarta (contador
+ *   blocks_dropped), nunca se encolan bloques sin límite
+ * - Análisis por bloque: ventana de Hann, FFT de 256 puntos en Q15,
+ *   AUDIO_NUM_BANDS bandas en escala logarítmica con control automático
+ *   de ganancia, nivel global y detector de onsets por flujo espectral
+ * - El coste por bloque se mide y se compara con el presupuesto
+ *   CONFIG_AUDIO_CPU_BUDGET_PCT del periodo del bloque
+ *
+ * Los efectos leen una copia de las características en led_fx_ctx_t::audio
+ * (el render stage la actualiza cada frame). En la VM de bytecode están
+ * disponibles con la instrucción AUDIO.
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef AUDIO_REACTIVE_H
+#define AUDIO_REACTIVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define AUDIO_NUM_BANDS 8
+
+/**
+ * @brief Índices de audio_features_t::v
+ */
+typedef enum {
+    AUDIO_FEATURE_BAND0 = 0,                    ///< Bandas 0 (graves) .. 7 (agudos)
+    AUDIO_FEATURE_LEVEL = AUDIO_NUM_BANDS,      ///< Volumen global
+    AUDIO_FEATURE_BEAT,                         ///< Envolvente del beat: 1.0 en el beat, decae
+    AUDIO_FEATURE_ONSET,                        ///< Fuerza del último onset
+    AUDIO_NUM_FEATURES
+} audio_feature_t;
+
+/**
+ * @brief Características de audio expuestas a los efectos
+ *
+ * Todos los valores en Q16.16 dentro de [0, 1].
+ */
+typedef struct {
+    int32_t v[AUDIO_NUM_FEATURES];
+    uint32_t beat_count;        ///< Beats detectados desde el arranque
+    uint32_t block_seq;         ///< Bloques analizados (cambia con cada análisis)
+} audio_features_t;
+
+/**
+ * @brief Estadísticas de la cadena de audio
+ */
+typedef struct {
+    uint32_t blocks_analyzed;
+    uint32_t blocks_dropped;    ///< Bloques descartados por análisis atrasado
+    uint32_t budget_us;         ///< Presupuesto de CPU por bloque
+    uint32_t last_us;           ///< Coste del último bloque
+    uint32_t max_us;            ///< Coste máximo observado
+    uint32_t over_budget;       ///< Bloques que superaron el presupuesto
+} audio_stats_t;
+
+/**
+ * @brief Inicializa la cadena de audio
+ *
+ * Crea la tarea de análisis y, con CONFIG_AUDIO_SOURCE_I2S, configura el
+ * canal I2S de recepción y la tarea de captura.
+ *
+ * @return ESP_OK, o el error del driver I2S
+ */
+esp_err_t audio_reactive_init(void);
+
+/**
+ * @brief Entrega muestras PCM a la cadena (fuente CONFIG_AUDIO_SOURCE_FEED)
+ *
+ * Las muestras se copian al buffer de captura; cada vez que se completa
+ * un bloque pasa al análisis. No bloquea.
+ *
+ * @param pcm     Muestras mono de 16 bits a CONFIG_AUDIO_SAMPLE_RATE
+ * @param samples Número de muestras
+ * @return ESP_OK, o ESP_ERR_INVALID_STATE si la cadena no está iniciada
+ */
+esp_err_t audio_reactive_feed(const int16_t *pcm, size_t samples);
+
+/**
+ * @brief Copia las características del último bloque analizado
+ *
+ * Es barato (copia de unas decenas de bytes) y seguro desde cualquier
+ * tarea. Si el audio está desactivado devuelve todo a cero.
+ */
+void audio_reactive_get_features(audio_features_t *features);
+
+/**
+ * @brief Copia las estadísticas de la cadena de audio
+ */
+void audio_reactive_get_stats(audio_stats_t *stats);
+
+#endif // AUDIO_REACTIVE_H
@@ -0,0 +1,142 @@
+/**
+ * @file fx_draw.c
+ * @brief Implementación de las primitivas 1D con antialiasing
+ *
+ * Las posiciones se pasan a 1/256 de LED (Q24.8) al empezar: así la
+ * cobertura de cada extremo es una resta entera y las de un punto suman
+ * exactamente 256. El modo de mezcla se resuelve fuera del bucle: cada
+ * primitiva tiene una versión por modo con el modo constante.
+ */
+
+#include "fx_draw.h"
+#include "fx_math.h"
+#include "esp_attr.h"
+
+/**
+ * @brief Mezcla un color sobre el píxel con cobertura w (0-256)
+ */
+FORCE_INLINE_ATTR void put(uint8_t *px, const uint8_t *c, int w, fx_draw_mode_t mode)
+{
+    if (mode == FX_DRAW_ADD) {
+        int v;
+        v = px[0] + ((c[0] * w) >> 8); px[0] = v > 255 ? 255 : v;
+        v = px[1] + ((c[1] * w) >> 8); px[1] = v > 255 ? 255 : v;
+        v = px[2] + ((c[2] * w) >> 8); px[2] = v > 255 ? 255 : v;
+    } else if (w == 256) {
+        px[0] = c[0];
+        px[1] = c[1];
+        px[2] = c[2];
+    } else {
+        px[0] += ((c[0] - px[0]) * w) >> 8;
+        px[1] += ((c[1] - px[1]) * w) >> 8;
+        px[2] += ((c[2] - px[2]) * w) >> 8;
+    }
+}
+
+/**
+ * @brief LEDs que toca [a, b) (en 1/256 de LED) y coberturas de los extremos
+ *
+ * @param[out] first Primer LED tocado
+ * @param[out] last  Último LED tocado
+ * @param[out] w0    Cobertura del primero (la de todo el tramo si first == last)
+ * @param[out] w1    Cobertura del último
+ */
+FORCE_INLINE_ATTR void span(int32_t a, int32_t b, int *first, int *last, int *w0, int *w1)
+{
+    *first = a >> 8;
+    *last = (b - 1) >> 8;
+    if (*first == *last) {
+        *w0 = *w1 = b - a;
+    } else {
+        *w0 = ((*first + 1) << 8) - a;
+        *w1 = b - (*last << 8);
+    }
+}
+
+FORCE_INLINE_ATTR void draw_bar(const fx_canvas_t *cv, int32_t x0, int32_t x1,
+                                const uint8_t *color, fx_draw_mode_t mode)
+{
+    const int32_t a = x0 >> 8, b = x1 >> 8;
+    if (b <= a) {
+        return;
+    }
+
+    int first, last, w0, w1;
+    span(a, b, &first, &last, &w0, &w1);
+    int lo = first < cv->start ? cv->start : first;
+    int hi = last >= cv->end ? cv->end - 1 : last;
+    if (lo > hi) {
+        return;
+    }
+
+    uint8_t *rgb = cv->rgb;
+    if (lo == first) {
+        put(rgb + first * 3, color, w0, mode);
+        lo++;
+    }
+    if (hi == last && last != first) {
+        put(rgb + last * 3, color, w1, mode);
+        hi--;
+    }
+    for (int i = lo; i <= hi; i++) {
+        put(rgb + i * 3, color, 256, mode);
+    }
+}
+
+FORCE_INLINE_ATTR void draw_gradient(const fx_canvas_t *cv, int32_t x0, int32_t x1,
+                                     const uint8_t *c0, const uint8_t *c1, fx_draw_mode_t mode)
+{
+    const int32_t a = x0 >> 8, b = x1 >> 8;
+    if (b <= a) {
+        return;
+    }
+
+    int first, last, w0, w1;
+    span(a, b, &first, &last, &w0, &w1);
+    int lo = first < cv->start ? cv->start : first;
+    int hi = last >= cv->end ? cv->end - 1 : last;
+    if (lo > hi) {
+        return;
+    }
+
+    // Posición del centro de cada LED dentro del degradado, u en [0, 1] Q16
+    const int32_t du = (int32_t)(((int64_t)256 << FX_SHIFT) / (b - a));
+    int32_t u = (int32_t)(((int64_t)((lo << 8) + 128 - a) << FX_SHIFT) / (b - a));
+    const int dr = c1[0] - c0[0], dg = c1[1] - c0[1], db = c1[2] - c0[2];
+
+    for (int i = lo; i <= hi; i++, u += du) {
+        int32_t uc = u < 0 ? 0 : (u > FX_ONE ? FX_ONE : u);
+        uint8_t c[3] = {
+            (uint8_t)(c0[0] + ((dr * uc) >> FX_SHIFT)),
+            (uint8_t)(c0[1] + ((dg * uc) >> FX_SHIFT)),
+            (uint8_t)(c0[2] + ((db * uc) >> FX_SHIFT)),
+        };
+        int w = i == first ? w0 : (i == last ? w1 : 256);
+        put(cv->rgb + i * 3, c, w, mode);
+    }
+}
+
+void IRAM_ATTR fx_draw_bar(const fx_canvas_t *cv, int32_t x0, int32_t x1, const uint8_t *color,
+                           fx_draw_mode_t mode)
+{
+    if (mode == FX_DRAW_ADD) {
+        draw_bar(cv, x0, x1, color, FX_DRAW_ADD);
+    } else {
+        draw_bar(cv, x0, x1, color, FX_DRAW_OVER);
+    }
+}
+
+void fx_draw_point(const fx_canvas_t *cv, int32_t x, const uint8_t *color, fx_draw_mode_t mode)
+{
+    fx_draw_bar(cv, x, x + FX_ONE, color, mode);
+}
+
+void IRAM_ATTR fx_draw_gradient(const fx_canvas_t *cv, int32_t x0, int32_t x1,
+                                const uint8_t *c0, const uint8_t *c1, fx_draw_mode_t mode)
+{
+    if (mode == FX_DRAW_ADD) {
+        draw_gradient(cv, x0, x1, c0, c1, FX_DRAW_ADD);
+    } else {
+        draw_gradient(cv, x0, x1, c0, c1, FX_DRAW_OVER);
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * @file fx_draw.h
+ * @brief Primitivas 1D con posición sub-píxel y antialiasing
+ *
+ * Puntos, barras y degradados a lo largo de la tira con posiciones Q16.16.
+ * En lugar de saltar de LED en LED, cada primitiva pinta cada LED con la
+ * fracción que cubre de él (antialiasing por cobertura): un punto que
+ * avanza despacio pasa de un LED al siguiente repartiendo el brillo, y
+ * los extremos de una barra se encienden a medias.
+ *
+ * GEOMETRÍA:
+ * =========
+ * El LED i ocupa el intervalo [i, i + 1). Una barra [x0, x1) cubre los
+ * LEDs enteros de su interior y una fracción de los de los extremos. Un
+ * punto es una barra de un LED de ancho que empieza en x: en x = i
+ * enciende solo el LED i, y entre dos posiciones enteras se reparte entre
+ * los dos LEDs (igual que las partículas de fx_particles.h).
+ *
+ * DIBUJO:
+ * =======
+ * - Directamente sobre el frame de 8 bits, sin buffers intermedios
+ * - Recorte contra el rango [start, end) del lienzo (render por rangos)
+ * - La cobertura va en 0-256 y solo se calcula en los dos extremos: el
+ *   interior de una barra cuesta lo mismo que un relleno entero
+ * - Dos modos de mezcla: suma con saturación (luces que se solapan) o
+ *   encima del contenido (objetos opacos)
+ */
+
+#ifndef FX_DRAW_H
+#define FX_DRAW_H
+
+#include <stdint.h>
+#include "fx_gfx.h"
+
+/**
+ * @brief Modo de mezcla con el contenido del frame
+ */
+typedef enum {
+    FX_DRAW_ADD = 0,    ///< Suma el color por la cobertura, saturando a 255
+    FX_DRAW_OVER,       ///< Mezcla hacia el color con la cobertura como alpha
+} fx_draw_mode_t;
+
+/**
+ * @brief Dibuja un punto de un LED de ancho en la posición x
+ *
+ * @param cv    Lienzo
+ * @param x     Posición en LEDs (Q16.16)
+ * @param color Color RGB (3 bytes)
+ * @param mode  Modo de mezcla
+ */
+void fx_draw_point(const fx_canvas_t *cv, int32_t x, const uint8_t *color,
+                   fx_draw_mode_t mode);
+
+/**
+ * @brief Dibuja una barra de un color sobre [x0, x1)
+ *
+ * @param x0 Extremo izquierdo en LEDs (Q16.16)
+ * @param x1 Extremo derecho (Q16.16); sin efecto si x1 <= x0
+ */
+void fx_draw_bar(const fx_canvas_t *cv, int32_t x0, int32_t x1, const uint8_t *color,
+                 fx_draw_mode_t mode);
+
+/**
+ * @brief Dibuja un degradado lineal de c0 (en x0) a c1 (en x1) sobre [x0, x1)
+ *
+ * El color de cada LED es el del degradado en su centro, así que un
+ * degradado que se mueve despacio también cambia de forma continua.
+ */
+void fx_draw_gradient(const fx_canvas_t *cv, int32_t x0, int32_t x1,
+                      const uint8_t *c0, const uint8_t *c1, fx_draw_mode_t mode);
+
+#endif // FX_DRAW_H
@@ -0,0 +1,117 @@
+/**
+ * @file fx_gfx.c
+ * @brief Implementación del dibujo de bitmaps y texto
+ *
+ * Con x fraccionaria f, la columna de destino c recibe la columna de
+ * origen c con peso (1 - f) y la c - 1 con peso f. Recorriendo cada fila
+ * de izquierda a derecha basta con recordar el alpha de la columna
+ * anterior: cada píxel de origen se desempaqueta una sola vez.
+ */
+
+#include "fx_gfx.h"
+#include "fx_math.h"
+#include "esp_attr.h"
+
+// Escala del valor empaquetado a alpha 0-255, indexada por bpp
+static const uint8_t s_alpha_scale[5] = { 0, 255, 85, 0, 17 };
+
+/**
+ * @brief Alpha (0-255) de la columna c de una fila empaquetada
+ */
+static inline int src_alpha(const uint8_t *row, int c, int bpp)
+{
+    int bit = c * bpp;
+    int v = (row[bit >> 3] >> (8 - bpp - (bit & 7))) & ((1 << bpp) - 1);
+    return v * s_alpha_scale[bpp];
+}
+
+/**
+ * @brief Mezcla color sobre el píxel con alpha 0-255
+ */
+static inline void blend(uint8_t *px, const uint8_t *color, int alpha)
+{
+    int w = alpha + (alpha >> 7);   // 0-256
+    px[0] += ((color[0] - px[0]) * w) >> 8;
+    px[1] += ((color[1] - px[1]) * w) >> 8;
+    px[2] += ((color[2] - px[2]) * w) >> 8;
+}
+
+/**
+ * @brief Dibuja un bloque de alpha empaquetado con recorte
+ */
+static void IRAM_ATTR draw(const fx_canvas_t *cv, const uint8_t *data, int width, int height,
+                           int bpp, int stride, int32_t x, int y, const uint8_t *color)
+{
+    const int ix = x >> FX_SHIFT;
+    const int f = (x >> 8) & 0xFF;
+
+    // Columnas de destino (relativas a ix) y filas visibles
+    int c0 = ix < 0 ? -ix : 0;
+    int c1 = width + (f ? 1 : 0);
+    if (ix + c1 > FX_GFX_WIDTH) {
+        c1 = FX_GFX_WIDTH - ix;
+    }
+    int r0 = y < 0 ? -y : 0;
+    int r1 = height;
+    if (y + r1 > FX_GFX_HEIGHT) {
+        r1 = FX_GFX_HEIGHT - y;
+    }
+
+    for (int r = r0; r < r1; r++) {
+        const uint8_t *row = data + r * stride;
+        int prev = (c0 > 0 && c0 <= width) ? src_alpha(row, c0 - 1, bpp) : 0;
+
+        for (int c = c0; c < c1; c++) {
+            int cur = c < width ? src_alpha(row, c, bpp) : 0;
+            int alpha = (cur * (256 - f) + prev * f) >> 8;
+            prev = cur;
+            if (alpha == 0) {
+                continue;
+            }
+
+            int idx = fx_gfx_index(ix + c, y + r);
+            if (idx >= cv->start && idx < cv->end) {
+                blend(cv->rgb + idx * 3, color, alpha);
+            }
+        }
+    }
+}
+
+void fx_gfx_blit(const fx_canvas_t *cv, const fx_bitmap_t *bmp, int32_t x, int y,
+                 const uint8_t *color)
+{
+    draw(cv, bmp->data, bmp->width, bmp->height, bmp->bpp, bmp->stride, x, y, color);
+}
+
+int fx_gfx_text(const fx_canvas_t *cv, const fx_font_t *font, const char *text,
+                int32_t x, int y, const uint8_t *color)
+{
+    const int advance = font->width + font->spacing;
+    const int glyph_bytes = font->height * font->stride;
+    int col = 0;
+
+    for (const char *p = text; *p; p++, col += advance) {
+        int32_t gx = x + FX_FROM_INT(col);
+        int left = gx >> FX_SHIFT;
+        if (left >= FX_GFX_WIDTH) {
+            // El resto queda a la derecha de la matriz: solo cuenta el ancho
+            continue;
+        }
+        unsigned ch = (uint8_t)*p - font->first;
+        if (left + font->width < 0 || ch >= font->count) {
+            continue;
+        }
+        draw(cv, font->data + ch * glyph_bytes, font->width, font->height,
+             font->bpp, font->stride, gx, y, color);
+    }
+    return col ? col - font->spacing : 0;
+}
+
+int fx_gfx_text_width(const fx_font_t *font, const char *text)
+{
+    int n = 0;
+    while (text[n]) {
+        n++;
+    }
+    return n ? n * (font->width + font->spacing) - font->spacing : 0;
+}
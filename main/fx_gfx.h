@@ -0,0 +1,125 @@
+/**
+ * @file fx_gfx.h
+ * @brief Texto y sprites para tiras montadas como matriz
+ *
+ * GEOMETRÍA:
+ * =========
+ * La matriz es de CONFIG_LED_MATRIX_WIDTH x CONFIG_LED_MATRIX_HEIGHT con
+ * el origen (0, 0) arriba a la izquierda. fx_gfx_index() traduce (x, y)
+ * al índice del LED en la tira según el cableado configurado: por filas o
+ * por columnas, y en zigzag (serpentina) o no.
+ *
+ * BITMAPS:
+ * =======
+ * Sprites y fuentes son bitmaps de alpha empaquetados en flash, con 1, 2
+ * o 4 bits por píxel (bpp). Cada fila ocupa stride bytes y los píxeles
+ * van del bit más alto al más bajo. El color lo pone quien dibuja: el
+ * valor del píxel es la cobertura (0 transparente, máximo opaco). Los
+ * arrays se generan con tools/gfxpack.py a partir de imágenes PBM/PGM.
+ *
+ * Una fuente es un atlas de glifos del mismo tamaño, uno detrás de otro,
+ * desde el carácter first.
+ *
+ * DIBUJO:
+ * ======
+ * - Mezcla sobre el contenido del frame (no lo borra), así el texto puede
+ *   ir encima de cualquier otro efecto
+ * - Recorte contra los bordes de la matriz y contra el rango de píxeles
+ *   [start, end) del lienzo (para render por rangos)
+ * - La x es Q16.16: con posiciones fraccionarias cada columna se reparte
+ *   entre dos columnas de LEDs, lo que hace suave el scroll lento
+ */
+
+#ifndef FX_GFX_H
+#define FX_GFX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#define FX_GFX_WIDTH    CONFIG_LED_MATRIX_WIDTH
+#define FX_GFX_HEIGHT   CONFIG_LED_MATRIX_HEIGHT
+
+/**
+ * @brief Bitmap de alpha empaquetado
+ */
+typedef struct {
+    const uint8_t *data;
+    uint16_t width;
+    uint16_t height;
+    uint8_t bpp;            ///< 1, 2 o 4
+    uint8_t stride;         ///< Bytes por fila
+} fx_bitmap_t;
+
+/**
+ * @brief Fuente de ancho fijo: atlas de count glifos
+ */
+typedef struct {
+    const uint8_t *data;    ///< Glifos seguidos, height * stride bytes cada uno
+    uint8_t width;
+    uint8_t height;
+    uint8_t bpp;
+    uint8_t stride;
+    uint8_t first;          ///< Primer carácter del atlas
+    uint8_t count;          ///< Número de glifos
+    uint8_t spacing;        ///< Columnas vacías entre caracteres
+} fx_font_t;
+
+/**
+ * @brief Zona del frame en la que se puede dibujar
+ */
+typedef struct {
+    uint8_t *rgb;           ///< Frame completo (3 bytes por píxel)
+    int start;              ///< Primer índice de LED escribible
+    int end;                ///< Índice siguiente al último
+} fx_canvas_t;
+
+/** Fuente 5x7 ASCII (caracteres 32 a 126), 1 bpp */
+extern const fx_font_t fx_font_5x7;
+
+/**
+ * @brief Índice en la tira del LED de la posición (x, y) de la matriz
+ */
+static inline int fx_gfx_index(int x, int y)
+{
+#ifdef CONFIG_LED_MATRIX_VERTICAL
+    int major = x, minor = y, len = FX_GFX_HEIGHT;
+#else
+    int major = y, minor = x, len = FX_GFX_WIDTH;
+#endif
+#ifdef CONFIG_LED_MATRIX_SERPENTINE
+    if (major & 1) {
+        minor = len - 1 - minor;
+    }
+#endif
+    return major * len + minor;
+}
+
+/**
+ * @brief Dibuja un bitmap con un color
+ *
+ * @param cv     Lienzo
+ * @param bmp    Bitmap de alpha
+ * @param x      Columna de la esquina izquierda (Q16.16, puede ser negativa)
+ * @param y      Fila de la esquina superior
+ * @param color  Color RGB (3 bytes)
+ */
+void fx_gfx_blit(const fx_canvas_t *cv, const fx_bitmap_t *bmp, int32_t x, int y,
+                 const uint8_t *color);
+
+/**
+ * @brief Dibuja un texto en una línea
+ *
+ * Los caracteres que no están en la fuente se dibujan como espacio.
+ *
+ * @return Ancho del texto en columnas
+ */
+int fx_gfx_text(const fx_canvas_t *cv, const fx_font_t *font, const char *text,
+                int32_t x, int y, const uint8_t *color);
+
+/**
+ * @brief Ancho en columnas que ocupa un texto
+ */
+int fx_gfx_text_width(const fx_font_t *font, const char *text);
+
+#endif // FX_GFX_H
@@ -0,0 +1,134 @@
+/**
+ * @file fx_math.c
+ * @brief Tablas y funciones no inline de la matemática en punto fijo
+ */
+
+#include "fx_math.h"
+
+// ============================================================================
+// TABLAS (const: se quedan en flash)
+// ============================================================================
+
+const int16_t fx_sin_table[256] = {
+         0,    804,   1608,   2410,   3212,   4011,   4808,   5602,
+      6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+     12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+     18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+     23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,
+     27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+     30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,
+     32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+     32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+     32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+     30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,
+     27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+     23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,
+     18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+     12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+      6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+         0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,
+     -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530,
+    -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971,
+    -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285,
+    -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868,
+    -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,
+     -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804,
+};
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+/**
+ * @brief Hash entero de una celda de la red, resultado en [0, 1) Q16.16
+ */
+static inline int32_t lattice_value(int32_t ix, int32_t iy)
+{
+    uint32_t h = (uint32_t)ix * 0x27d4eb2dU ^ (uint32_t)iy * 0x165667b1U;
+    h ^= h >> 15;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    return (int32_t)(h >> 16);
+}
+
+/**
+ * @brief Curva de suavizado 3t^2 - 2t^3 en Q16.16
+ */
+static inline int32_t smoothstep(int32_t t)
+{
+    return fx_mul(fx_mul(t, t), FX_FROM_INT(3) - 2 * t);
+}
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+int32_t fx_value_noise2(int32_t x, int32_t y)
+{
+    int32_t ix = x >> FX_SHIFT;
+    int32_t iy = y >> FX_SHIFT;
+    int32_t fx = smoothstep(fx_frac(x));
+    int32_t fy = smoothstep(fx_frac(y));
+
+    int32_t v00 = lattice_value(ix, iy);
+    int32_t v10 = lattice_value(ix + 1, iy);
+    int32_t v01 = lattice_value(ix, iy + 1);
+    int32_t v11 = lattice_value(ix + 1, iy + 1);
+
+    int32_t top = v00 + fx_mul(v10 - v00, fx);
+    int32_t bottom = v01 + fx_mul(v11 - v01, fx);
+    return top + fx_mul(bottom - top, fy);
+}
+
+/**
+ * @brief HSV a RGB en Q16.16 (común a las versiones de 8 y 16 bits)
+ */
+static void hsv_to_rgb_fx(int32_t h, int32_t s, int32_t v, int32_t *rgb)
+{
+    s = fx_clamp01(s);
+    v = fx_clamp01(v);
+
+    int32_t h6 = fx_frac(h) * 6;
+    int sector = h6 >> FX_SHIFT;
+    int32_t f = fx_frac(h6);
+
+    int32_t p = fx_mul(v, FX_ONE - s);
+    int32_t q = fx_mul(v, FX_ONE - fx_mul(s, f));
+    int32_t t = fx_mul(v, FX_ONE - fx_mul(s, FX_ONE - f));
+
+    switch (sector) {
+        case 0:  rgb[0] = v; rgb[1] = t; rgb[2] = p; break;
+        case 1:  rgb[0] = q; rgb[1] = v; rgb[2] = p; break;
+        case 2:  rgb[0] = p; rgb[1] = v; rgb[2] = t; break;
+        case 3:  rgb[0] = p; rgb[1] = q; rgb[2] = v; break;
+        case 4:  rgb[0] = t; rgb[1] = p; rgb[2] = v; break;
+        default: rgb[0] = v; rgb[1] = p; rgb[2] = q; break;
+    }
+}
+
+void fx_hsv_to_rgb(int32_t h, int32_t s, int32_t v, uint8_t *rgb)
+{
+    int32_t c[3];
+    hsv_to_rgb_fx(h, s, v, c);
+    rgb[0] = fx_to_u8(c[0]);
+    rgb[1] = fx_to_u8(c[1]);
+    rgb[2] = fx_to_u8(c[2]);
+}
+
+void fx_hsv_to_rgb16(int32_t h, int32_t s, int32_t v, uint16_t *rgb)
+{
+    int32_t c[3];
+    hsv_to_rgb_fx(h, s, v, c);
+    rgb[0] = fx_to_u16(c[0]);
+    rgb[1] = fx_to_u16(c[1]);
+    rgb[2] = fx_to_u16(c[2]);
+}
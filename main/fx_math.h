@@ -0,0 +1,130 @@
+/**
+ * @file fx_math.h
+ * @brief Matemática en punto fijo para efectos LED
+ *
+ * Los cores del ESP32 no tienen FPU (o es lenta en doble precisión), así
+ * que todos los efectos trabajan en punto fijo Q16.16: un int32_t donde
+ * los 16 bits bajos son la parte fraccionaria (FX_ONE = 1.0).
+ *
+ * Convenciones:
+ * - Ángulos en "vueltas": 1.0 = 360 grados. fx_sin(FX_ONE / 4) = 1.0
+ * - Colores en [0, 1] (Q16.16) antes de convertirse a bytes 0-255
+ *
+ * Las funciones sencillas son inline para que el compilador las integre
+ * en los bucles por píxel; las tablas viven en fx_math.c (flash).
+ */
+
+#ifndef FX_MATH_H
+#define FX_MATH_H
+
+#include <stdint.h>
+
+#define FX_SHIFT        16
+#define FX_ONE          (1 << FX_SHIFT)
+#define FX_HALF         (FX_ONE / 2)
+
+// Convierte un entero a Q16.16
+#define FX_FROM_INT(i)  ((int32_t)(i) << FX_SHIFT)
+// Convierte una constante Q8.8 (p.ej. 0x0180 = 1.5) a Q16.16
+#define FX_FROM_Q8(q)   ((int32_t)(q) << 8)
+
+// Seno con 256 muestras por vuelta, Q1.15
+extern const int16_t fx_sin_table[256];
+
+/**
+ * @brief Multiplicación Q16.16
+ */
+static inline int32_t fx_mul(int32_t a, int32_t b)
+{
+    return (int32_t)(((int64_t)a * b) >> FX_SHIFT);
+}
+
+/**
+ * @brief División Q16.16 (devuelve 0 si b es 0)
+ */
+static inline int32_t fx_div(int32_t a, int32_t b)
+{
+    return b ? (int32_t)(((int64_t)a << FX_SHIFT) / b) : 0;
+}
+
+/**
+ * @brief Parte fraccionaria en [0, 1)
+ */
+static inline int32_t fx_frac(int32_t a)
+{
+    return a & (FX_ONE - 1);
+}
+
+/**
+ * @brief Recorta a [0, 1]
+ */
+static inline int32_t fx_clamp01(int32_t a)
+{
+    return a < 0 ? 0 : (a > FX_ONE ? FX_ONE : a);
+}
+
+/**
+ * @brief Seno de un ángulo en vueltas, resultado en [-1, 1]
+ *
+ * Tabla de 256 entradas con interpolación lineal entre muestras.
+ */
+static inline int32_t fx_sin(int32_t turns)
+{
+    uint32_t idx = ((uint32_t)turns >> 8) & 0xFF;
+    int32_t frac = turns & 0xFF;
+    int32_t s0 = fx_sin_table[idx];
+    int32_t s1 = fx_sin_table[(idx + 1) & 0xFF];
+    return (s0 + (((s1 - s0) * frac) >> 8)) << 1;
+}
+
+/**
+ * @brief Coseno de un ángulo en vueltas, resultado en [-1, 1]
+ */
+static inline int32_t fx_cos(int32_t turns)
+{
+    return fx_sin(turns + FX_ONE / 4);
+}
+
+/**
+ * @brief Convierte un valor Q16.16 en [0, 1] a byte 0-255 (con recorte)
+ */
+static inline uint8_t fx_to_u8(int32_t a)
+{
+    a = fx_clamp01(a);
+    return (uint8_t)((a * 255 + FX_HALF) >> FX_SHIFT);
+}
+
+/**
+ * @brief Convierte un valor Q16.16 en [0, 1] a 16 bits 0-65535 (con recorte)
+ */
+static inline uint16_t fx_to_u16(int32_t a)
+{
+    a = fx_clamp01(a);
+    return (uint16_t)(a - (a >> 16));   // 1.0 -> 65535
+}
+
+/**
+ * @brief Ruido de valor 2D suavizado, resultado en [0, 1]
+ *
+ * Las coordenadas se dan en Q16.16; la red de valores tiene paso 1.0.
+ */
+int32_t fx_value_noise2(int32_t x, int32_t y);
+
+/**
+ * @brief Convierte HSV (Q16.16) a RGB de 8 bits
+ *
+ * @param h   Tono en vueltas (solo se usa la parte fraccionaria)
+ * @param s   Saturación en [0, 1]
+ * @param v   Valor/brillo en [0, 1]
+ * @param[out] rgb Tres bytes R, G, B
+ */
+void fx_hsv_to_rgb(int32_t h, int32_t s, int32_t v, uint8_t *rgb);
+
+/**
+ * @brief Convierte HSV (Q16.16) a RGB de 16 bits por canal
+ *
+ * Igual que fx_hsv_to_rgb() sin cuantizar a 8 bits.
+ */
+void fx_hsv_to_rgb16(int32_t h, int32_t s, int32_t v, uint16_t *rgb);
+
+#endif // FX_MATH_H
@@ -0,0 +1,249 @@
+/**
+ * @file fx_noise.c
+ * @brief Implementación del ruido de Perlin en punto fijo
+ *
+ * Las versiones _row() hacen exactamente las mismas operaciones que las
+ * de una muestra (mismo resultado bit a bit), pero calculan los hashes y
+ * las contribuciones de y/z de los gradientes solo al entrar en una celda
+ * nueva. Dentro de una celda cada muestra cuesta la curva de suavizado,
+ * 4 (2D) u 8 (3D) productos y 3 o 7 interpolaciones.
+ */
+
+#include "fx_noise.h"
+#include "fx_math.h"
+#include "esp_attr.h"
+
+// ============================================================================
+// TABLAS (FLASH)
+// ============================================================================
+
+// Permutación de referencia de Ken Perlin
+static const uint8_t s_perm[256] = {
+    151, 160, 137,  91,  90,  15, 131,  13, 201,  95,  96,  53, 194, 233,   7, 225,
+    140,  36, 103,  30,  69, 142,   8,  99,  37, 240,  21,  10,  23, 190,   6, 148,
+    247, 120, 234,  75,   0,  26, 197,  62,  94, 252, 219, 203, 117,  35,  11,  32,
+     57, 177,  33,  88, 237, 149,  56,  87, 174,  20, 125, 136, 171, 168,  68, 175,
+     74, 165,  71, 134, 139,  48,  27, 166,  77, 146, 158, 231,  83, 111, 229, 122,
+     60, 211, 133, 230, 220, 105,  92,  41,  55,  46, 245,  40, 244, 102, 143,  54,
+     65,  25,  63, 161,   1, 216,  80,  73, 209,  76, 132, 187, 208,  89,  18, 169,
+    200, 196, 135, 130, 116, 188, 159,  86, 164, 100, 109, 198, 173, 186,   3,  64,
+     52, 217, 226, 250, 124, 123,   5, 202,  38, 147, 118, 126, 255,  82,  85, 212,
+    207, 206,  59, 227,  47,  16,  58,  17, 182, 189,  28,  42, 223, 183, 170, 213,
+    119, 248, 152,   2,  44, 154, 163,  70, 221, 153, 101, 155, 167,  43, 172,   9,
+    129,  22,  39, 253,  19,  98, 108, 110,  79, 113, 224, 232, 178, 185, 112, 104,
+    218, 246,  97, 228, 251,  34, 242, 193, 238, 210, 144,  12, 191, 179, 162, 241,
+     81,  51, 145, 235, 249,  14, 239, 107,  49, 192, 214,  31, 181, 199, 106, 157,
+    184,  84, 204, 176, 115, 121,  50,  45, 127,   4, 150, 254, 138, 236, 205,  93,
+    222, 114,  67,  29,  24,  72, 243, 141, 128, 195,  78,  66, 215,  61, 156, 180,
+};
+
+// Gradientes 2D: diagonales y ejes
+static const int8_t s_grad2[8][2] = {
+    { 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 },
+    { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 },
+};
+
+// Gradientes 3D: las 12 aristas del cubo, 4 repetidas para indexar con & 15
+static const int8_t s_grad3[16][3] = {
+    { 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 },
+    { 1, 0, 1 }, { -1, 0, 1 }, { 1, 0, -1 }, { -1, 0, -1 },
+    { 0, 1, 1 }, { 0, -1, 1 }, { 0, 1, -1 }, { 0, -1, -1 },
+    { 1, 1, 0 }, { -1, 1, 0 }, { 0, -1, 1 }, { 0, -1, -1 },
+};
+
+// 6t^5 - 15t^4 + 10t^3 en 256 tramos (Q16, t = índice / 256)
+static const uint16_t s_fade[257] = {
+        0,     0,     0,     1,     2,     5,     8,    13,    19,    27,    37,    49,
+       63,    79,    99,   121,   145,   173,   204,   239,   277,   319,   364,   414,
+      467,   524,   586,   652,   723,   798,   878,   963,  1052,  1146,  1246,  1350,
+     1460,  1574,  1695,  1820,  1951,  2087,  2229,  2376,  2529,  2687,  2851,  3021,
+     3196,  3377,  3564,  3757,  3955,  4159,  4369,  4585,  4806,  5033,  5266,  5505,
+     5749,  5999,  6255,  6517,  6784,  7057,  7335,  7619,  7909,  8204,  8504,  8810,
+     9121,  9438,  9759, 10086, 10418, 10755, 11098, 11445, 11797, 12154, 12515, 12882,
+    13253, 13628, 14008, 14393, 14781, 15174, 15571, 15973, 16378, 16787, 17199, 17616,
+    18036, 18460, 18887, 19317, 19751, 20187, 20627, 21070, 21515, 21963, 22414, 22867,
+    23323, 23781, 24241, 24703, 25168, 25634, 26101, 26571, 27042, 27514, 27987, 28462,
+    28938, 29415, 29892, 30370, 30849, 31329, 31808, 32288, 32768, 33248, 33728, 34207,
+    34687, 35166, 35644, 36121, 36598, 37074, 37549, 38022, 38494, 38965, 39435, 39902,
+    40368, 40833, 41295, 41755, 42213, 42669, 43122, 43573, 44021, 44466, 44909, 45349,
+    45785, 46219, 46649, 47076, 47500, 47920, 48337, 48749, 49158, 49563, 49965, 50362,
+    50755, 51143, 51528, 51908, 52283, 52654, 53021, 53382, 53739, 54091, 54438, 54781,
+    55118, 55450, 55777, 56098, 56415, 56726, 57032, 57332, 57627, 57917, 58201, 58479,
+    58752, 59019, 59281, 59537, 59787, 60031, 60270, 60503, 60730, 60951, 61167, 61377,
+    61581, 61779, 61972, 62159, 62340, 62515, 62685, 62849, 63007, 63160, 63307, 63449,
+    63585, 63716, 63841, 63962, 64076, 64186, 64290, 64390, 64484, 64573, 64658, 64738,
+    64813, 64884, 64950, 65012, 65069, 65122, 65172, 65217, 65259, 65297, 65332, 65363,
+    65391, 65415, 65437, 65457, 65473, 65487, 65499, 65509, 65517, 65523, 65528, 65531,
+    65534, 65535, 65535, 65535, 65535,
+};
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+#define P(i)    s_perm[(i) & 0xFF]
+
+static inline int32_t fade(int32_t t)
+{
+    int idx = t >> 8;
+    int32_t a = s_fade[idx];
+    return a + (((s_fade[idx + 1] - a) * (t & 0xFF)) >> 8);
+}
+
+static inline int32_t lerp(int32_t a, int32_t b, int32_t t)
+{
+    return a + fx_mul(b - a, t);
+}
+
+static inline int32_t grad2(int h, int32_t x, int32_t y)
+{
+    const int8_t *g = s_grad2[h & 7];
+    return g[0] * x + g[1] * y;
+}
+
+static inline int32_t grad3(int h, int32_t x, int32_t y, int32_t z)
+{
+    const int8_t *g = s_grad3[h & 15];
+    return g[0] * x + g[1] * y + g[2] * z;
+}
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+int32_t fx_noise2(int32_t x, int32_t y)
+{
+    int xi = (x >> FX_SHIFT) & 0xFF;
+    int yi = (y >> FX_SHIFT) & 0xFF;
+    int32_t xf = x & (FX_ONE - 1);
+    int32_t yf = y & (FX_ONE - 1);
+
+    int a = P(xi) + yi;
+    int b = P(xi + 1) + yi;
+
+    int32_t n00 = grad2(P(a),     xf,          yf);
+    int32_t n10 = grad2(P(b),     xf - FX_ONE, yf);
+    int32_t n01 = grad2(P(a + 1), xf,          yf - FX_ONE);
+    int32_t n11 = grad2(P(b + 1), xf - FX_ONE, yf - FX_ONE);
+
+    int32_t u = fade(xf);
+    return lerp(lerp(n00, n10, u), lerp(n01, n11, u), fade(yf));
+}
+
+int32_t fx_noise3(int32_t x, int32_t y, int32_t z)
+{
+    int xi = (x >> FX_SHIFT) & 0xFF;
+    int yi = (y >> FX_SHIFT) & 0xFF;
+    int zi = (z >> FX_SHIFT) & 0xFF;
+    int32_t xf = x & (FX_ONE - 1);
+    int32_t yf = y & (FX_ONE - 1);
+    int32_t zf = z & (FX_ONE - 1);
+
+    int a = P(xi) + yi;
+    int b = P(xi + 1) + yi;
+    int aa = P(a) + zi;
+    int ab = P(a + 1) + zi;
+    int ba = P(b) + zi;
+    int bb = P(b + 1) + zi;
+
+    int32_t u = fade(xf);
+    int32_t v = fade(yf);
+    int32_t w = fade(zf);
+
+    int32_t x00 = lerp(grad3(P(aa), xf, yf, zf),
+                       grad3(P(ba), xf - FX_ONE, yf, zf), u);
+    int32_t x10 = lerp(grad3(P(ab), xf, yf - FX_ONE, zf),
+                       grad3(P(bb), xf - FX_ONE, yf - FX_ONE, zf), u);
+    int32_t x01 = lerp(grad3(P(aa + 1), xf, yf, zf - FX_ONE),
+                       grad3(P(ba + 1), xf - FX_ONE, yf, zf - FX_ONE), u);
+    int32_t x11 = lerp(grad3(P(ab + 1), xf, yf - FX_ONE, zf - FX_ONE),
+                       grad3(P(bb + 1), xf - FX_ONE, yf - FX_ONE, zf - FX_ONE), u);
+
+    return lerp(lerp(x00, x10, v), lerp(x01, x11, v), w);
+}
+
+void IRAM_ATTR fx_noise2_row(int32_t x0, int32_t dx, int32_t y, int32_t *out, int count)
+{
+    const int yi = (y >> FX_SHIFT) & 0xFF;
+    const int32_t yf = y & (FX_ONE - 1);
+    const int32_t v = fade(yf);
+
+    int cell = -1;
+    // Gradientes de la celda actual: componente x y contribución de y
+    int32_t gx00 = 0, gx10 = 0, gx01 = 0, gx11 = 0;
+    int32_t c00 = 0, c10 = 0, c01 = 0, c11 = 0;
+
+    int32_t x = x0;
+    for (int k = 0; k < count; k++, x += dx) {
+        int xi = (x >> FX_SHIFT) & 0xFF;
+        int32_t xf = x & (FX_ONE - 1);
+
+        if (xi != cell) {
+            cell = xi;
+            int a = P(xi) + yi;
+            int b = P(xi + 1) + yi;
+            const int8_t *g00 = s_grad2[P(a) & 7];
+            const int8_t *g10 = s_grad2[P(b) & 7];
+            const int8_t *g01 = s_grad2[P(a + 1) & 7];
+            const int8_t *g11 = s_grad2[P(b + 1) & 7];
+            gx00 = g00[0]; c00 = g00[1] * yf;
+            gx10 = g10[0]; c10 = g10[1] * yf - gx10 * FX_ONE;
+            gx01 = g01[0]; c01 = g01[1] * (yf - FX_ONE);
+            gx11 = g11[0]; c11 = g11[1] * (yf - FX_ONE) - gx11 * FX_ONE;
+        }
+
+        int32_t u = fade(xf);
+        int32_t n0 = lerp(gx00 * xf + c00, gx10 * xf + c10, u);
+        int32_t n1 = lerp(gx01 * xf + c01, gx11 * xf + c11, u);
+        out[k] = lerp(n0, n1, v);
+    }
+}
+
+void IRAM_ATTR fx_noise3_row(int32_t x0, int32_t dx, int32_t y, int32_t z,
+                             int32_t *out, int count)
+{
+    const int yi = (y >> FX_SHIFT) & 0xFF;
+    const int zi = (z >> FX_SHIFT) & 0xFF;
+    const int32_t yf = y & (FX_ONE - 1);
+    const int32_t zf = z & (FX_ONE - 1);
+    const int32_t v = fade(yf);
+    const int32_t w = fade(zf);
+
+    int cell = -1;
+    // Por esquina (índice = dx + 2 dy + 4 dz): componente x y resto del producto
+    int32_t gx[8] = {0};
+    int32_t c[8] = {0};
+
+    int32_t x = x0;
+    for (int k = 0; k < count; k++, x += dx) {
+        int xi = (x >> FX_SHIFT) & 0xFF;
+        int32_t xf = x & (FX_ONE - 1);
+
+        if (xi != cell) {
+            cell = xi;
+            int a = P(xi) + yi;
+            int b = P(xi + 1) + yi;
+            int aa = P(a) + zi;
+            int ab = P(a + 1) + zi;
+            int ba = P(b) + zi;
+            int bb = P(b + 1) + zi;
+            const int hash[8] = {
+                P(aa), P(ba), P(ab), P(bb), P(aa + 1), P(ba + 1), P(ab + 1), P(bb + 1),
+            };
+            for (int j = 0; j < 8; j++) {
+                const int8_t *g = s_grad3[hash[j] & 15];
+                int32_t cy = (j & 2) ? yf - FX_ONE : yf;
+                int32_t cz = (j & 4) ? zf - FX_ONE : zf;
+                gx[j] = g[0];
+                c[j] = g[1] * cy + g[2] * cz - ((j & 1) ? g[0] * FX_ONE : 0);
+            }
+        }
+
+        int32_t u = fade(xf);
+        int32_t x00 = lerp(gx[0] * xf + c[0], gx[1] * xf + c[1], u);
+        int32_t x10 = lerp(gx[2] * xf + c[2], gx[3] * xf + c[3], u);
+        int32_t x01 = lerp(gx[4] * xf + c[4], gx[5] * xf + c[5], u);
+        int32_t x11 = lerp(gx[6] * xf + c[6], gx[7] * xf + c[7], u);
+        out[k] = lerp(lerp(x00, x10, v), lerp(x01, x11, v), w);
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ * @file fx_noise.h
+ * @brief Ruido de gradiente (Perlin) 2D y 3D en punto fijo
+ *
+ * Base de los efectos de fuego, nubes y plasma. Todo en Q16.16 con tablas
+ * constantes en flash:
+ * - Permutación de 256 entradas (la de referencia de Ken Perlin)
+ * - Gradientes de 8 direcciones (2D) y 16 aristas del cubo (3D)
+ * - Curva de suavizado 6t^5 - 15t^4 + 10t^3 tabulada en 256 tramos
+ *
+ * El resultado está en [-1, 1] aproximadamente y es continuo con su
+ * derivada. El ruido se repite cada 256 unidades en cada eje.
+ *
+ * Para calcular muchos píxeles usar las versiones _row(): evalúan una fila
+ * de coordenadas equiespaciadas en x reutilizando todo lo que depende de
+ * y, z y de la celda actual, que es la mayor parte del coste cuando el
+ * paso es menor que una celda (el caso habitual en una tira).
+ */
+
+#ifndef FX_NOISE_H
+#define FX_NOISE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Ruido de Perlin 2D
+ *
+ * @param x, y Coordenadas (Q16.16)
+ * @return Valor en [-1, 1] (Q16.16)
+ */
+int32_t fx_noise2(int32_t x, int32_t y);
+
+/**
+ * @brief Ruido de Perlin 3D
+ *
+ * @param x, y, z Coordenadas (Q16.16)
+ * @return Valor en [-1, 1] (Q16.16)
+ */
+int32_t fx_noise3(int32_t x, int32_t y, int32_t z);
+
+/**
+ * @brief Ruido 2D de una fila: out[k] = fx_noise2(x0 + k * dx, y)
+ *
+ * @param x0  Primera coordenada x (Q16.16)
+ * @param dx  Paso entre muestras (Q16.16, puede ser negativo)
+ * @param y   Coordenada y común a la fila (Q16.16)
+ * @param out Resultado, count valores
+ * @param count Número de muestras
+ */
+void fx_noise2_row(int32_t x0, int32_t dx, int32_t y, int32_t *out, int count);
+
+/**
+ * @brief Ruido 3D de una fila: out[k] = fx_noise3(x0 + k * dx, y, z)
+ */
+void fx_noise3_row(int32_t x0, int32_t dx, int32_t y, int32_t z, int32_t *out, int count);
+
+#endif // FX_NOISE_H
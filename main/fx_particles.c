@@ -0,0 +1,138 @@
+/**
+ * @file fx_particles.c
+ * @brief Implementación del motor de partículas
+ */
+
+#include "fx_particles.h"
+#include "fx_math.h"
+#include <string.h>
+#include "esp_attr.h"
+
+/**
+ * @brief Elimina la partícula k moviendo la última a su hueco
+ */
+static inline void kill(fx_particles_t *ps, int k)
+{
+    int last = --ps->count;
+    ps->pos[k] = ps->pos[last];
+    ps->vel[k] = ps->vel[last];
+    ps->life[k] = ps->life[last];
+    ps->fade[k] = ps->fade[last];
+    ps->r[k] = ps->r[last];
+    ps->g[k] = ps->g[last];
+    ps->b[k] = ps->b[last];
+}
+
+/**
+ * @brief Suma un color escalado a un píxel con saturación
+ *
+ * @param w Peso en [0, 256]
+ */
+static inline void add_pixel(uint8_t *px, uint8_t r, uint8_t g, uint8_t b, int w)
+{
+    int v;
+    v = px[0] + ((r * w) >> 8); px[0] = v > 255 ? 255 : v;
+    v = px[1] + ((g * w) >> 8); px[1] = v > 255 ? 255 : v;
+    v = px[2] + ((b * w) >> 8); px[2] = v > 255 ? 255 : v;
+}
+
+void fx_particles_init(fx_particles_t *ps, int32_t gravity, int32_t drag)
+{
+    uint32_t seed = ps->seed;
+    memset(ps, 0, sizeof(*ps));
+    ps->gravity = gravity;
+    ps->drag = drag;
+    // Se conserva la secuencia aleatoria entre reinicios del pool
+    ps->seed = seed ? seed : 0x9E3779B9;
+}
+
+int fx_particles_spawn(fx_particles_t *ps, int32_t pos, int32_t vel, int32_t life,
+                       const uint8_t *rgb)
+{
+    if (ps->count >= FX_PARTICLES_MAX || life <= 0) {
+        ps->dropped++;
+        return -1;
+    }
+
+    int k = ps->count++;
+    ps->pos[k] = pos;
+    ps->vel[k] = vel;
+    ps->life[k] = life;
+    ps->fade[k] = fx_div(FX_ONE, life);
+    ps->r[k] = rgb[0];
+    ps->g[k] = rgb[1];
+    ps->b[k] = rgb[2];
+
+    ps->spawned++;
+    if (ps->count > ps->peak) {
+        ps->peak = ps->count;
+    }
+    return k;
+}
+
+void IRAM_ATTR fx_particles_update(fx_particles_t *ps, int32_t dt, int num_leds)
+{
+    const int32_t limit = FX_FROM_INT(num_leds);
+    const int32_t dv = fx_mul(ps->gravity, dt);
+    int32_t damp = FX_ONE - fx_mul(ps->drag, dt);
+    if (damp < 0) {
+        damp = 0;
+    }
+
+    int32_t *pos = ps->pos;
+    int32_t *vel = ps->vel;
+    int32_t *life = ps->life;
+
+    for (int k = 0; k < ps->count; ) {
+        life[k] -= dt;
+        vel[k] = fx_mul(vel[k] + dv, damp);
+        pos[k] += fx_mul(vel[k], dt);
+
+        if (life[k] <= 0 || pos[k] <= -FX_ONE || pos[k] >= limit) {
+            kill(ps, k);    // La última ocupa el hueco: se procesa sin avanzar k
+            continue;
+        }
+        k++;
+    }
+}
+
+void IRAM_ATTR fx_particles_render(const fx_particles_t *ps, uint8_t *rgb, int start, int end)
+{
+    for (int k = 0; k < ps->count; k++) {
+        // Brillo en [0, 256] según la vida restante
+        int bright = fx_mul(ps->life[k], ps->fade[k]) >> 8;
+        if (bright > 256) {
+            bright = 256;
+        }
+
+        // Reparto entre el píxel de la izquierda y el de la derecha
+        int32_t p = ps->pos[k];
+        int i = p >> FX_SHIFT;
+        int frac = (p & (FX_ONE - 1)) >> 8;
+        int w0 = ((256 - frac) * bright) >> 8;
+        int w1 = (frac * bright) >> 8;
+
+        if (i >= start && i < end) {
+            add_pixel(rgb + i * 3, ps->r[k], ps->g[k], ps->b[k], w0);
+        }
+        if (i + 1 >= start && i + 1 < end) {
+            add_pixel(rgb + (i + 1) * 3, ps->r[k], ps->g[k], ps->b[k], w1);
+        }
+    }
+}
+
+uint32_t fx_particles_rand(fx_particles_t *ps)
+{
+    uint32_t x = ps->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    ps->seed = x;
+    return x;
+}
+
+int32_t fx_particles_rand_range(fx_particles_t *ps, int32_t lo, int32_t hi)
+{
+    uint32_t u = fx_particles_rand(ps) >> FX_SHIFT;    // [0, 1) en Q16.16
+    return lo + fx_mul(hi - lo, (int32_t)u);
+}
@@ -0,0 +1,99 @@
+/**
+ * @file fx_particles.h
+ * @brief Motor de partículas para efectos (chispas, lluvia, fuegos artificiales)
+ *
+ * Características:
+ * - Pool de capacidad fija (FX_PARTICLES_MAX), reservado por quien lo usa:
+ *   sin memoria dinámica en ningún momento
+ * - Estructura de arrays: cada campo es un array contiguo, así el bucle de
+ *   física recorre memoria secuencial y no arrastra campos que no usa
+ * - Partículas vivas siempre compactas en [0, count): crear y eliminar es
+ *   O(1) (la última ocupa el hueco de la eliminada)
+ * - Física en punto fijo Q16.16 sobre la tira: posición en píxeles,
+ *   velocidad en píxeles/s, gravedad y rozamiento comunes al pool
+ * - Render aditivo con saturación y posición sub-píxel (cada partícula
+ *   reparte su color entre los dos píxeles vecinos)
+ *
+ * Las partículas que salen de la tira o agotan su vida se eliminan solas.
+ * Si el pool está lleno fx_particles_spawn() descarta la partícula nueva.
+ */
+
+#ifndef FX_PARTICLES_H
+#define FX_PARTICLES_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#define FX_PARTICLES_MAX    CONFIG_FX_PARTICLES_MAX
+
+/**
+ * @brief Pool de partículas
+ *
+ * Unos 19 bytes por partícula (4.8 KB con 256).
+ */
+typedef struct {
+    int32_t pos[FX_PARTICLES_MAX];      ///< Posición en píxeles (Q16.16)
+    int32_t vel[FX_PARTICLES_MAX];      ///< Velocidad en píxeles/s (Q16.16)
+    int32_t life[FX_PARTICLES_MAX];     ///< Vida restante en segundos (Q16.16)
+    int32_t fade[FX_PARTICLES_MAX];     ///< 1 / vida inicial: brillo = life * fade
+    uint8_t r[FX_PARTICLES_MAX];
+    uint8_t g[FX_PARTICLES_MAX];
+    uint8_t b[FX_PARTICLES_MAX];
+    uint16_t count;                     ///< Partículas vivas
+    uint16_t peak;                      ///< Máximo de partículas vivas
+    uint32_t spawned;                   ///< Partículas creadas
+    uint32_t dropped;                   ///< Partículas descartadas por pool lleno
+    int32_t gravity;                    ///< Aceleración en píxeles/s² (Q16.16)
+    int32_t drag;                       ///< Rozamiento en 1/s (Q16.16)
+    uint32_t seed;                      ///< Estado del generador aleatorio
+} fx_particles_t;
+
+/**
+ * @brief Vacía el pool y fija la física común
+ *
+ * @param ps      Pool
+ * @param gravity Aceleración en píxeles/s² (negativa hacia el píxel 0)
+ * @param drag    Fracción de velocidad perdida por segundo (Q16.16)
+ */
+void fx_particles_init(fx_particles_t *ps, int32_t gravity, int32_t drag);
+
+/**
+ * @brief Crea una partícula
+ *
+ * @param ps   Pool
+ * @param pos  Posición inicial en píxeles (Q16.16)
+ * @param vel  Velocidad inicial en píxeles/s (Q16.16)
+ * @param life Vida en segundos (Q16.16, > 0)
+ * @param rgb  Color a brillo máximo (3 bytes)
+ * @return Índice de la partícula o -1 si el pool está lleno
+ */
+int fx_particles_spawn(fx_particles_t *ps, int32_t pos, int32_t vel, int32_t life,
+                       const uint8_t *rgb);
+
+/**
+ * @brief Avanza la simulación dt segundos
+ *
+ * @param ps       Pool
+ * @param dt       Paso de tiempo en segundos (Q16.16)
+ * @param num_leds Longitud de la tira: las partículas fuera se eliminan
+ */
+void fx_particles_update(fx_particles_t *ps, int32_t dt, int num_leds);
+
+/**
+ * @brief Suma las partículas a los píxeles [start, end) de rgb
+ *
+ * No borra el frame: el efecto decide el fondo antes de llamarla.
+ */
+void fx_particles_render(const fx_particles_t *ps, uint8_t *rgb, int start, int end);
+
+/**
+ * @brief Número aleatorio de 32 bits (xorshift, estado en el pool)
+ */
+uint32_t fx_particles_rand(fx_particles_t *ps);
+
+/**
+ * @brief Valor aleatorio uniforme en [lo, hi) (Q16.16)
+ */
+int32_t fx_particles_rand_range(fx_particles_t *ps, int32_t lo, int32_t hi);
+
+#endif // FX_PARTICLES_H
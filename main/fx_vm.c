@@ -0,0 +1,347 @@
+/**
+ * @file fx_vm.c
+ * @brief Implementación de la VM de bytecode para efectos
+ *
+ * El intérprete es un switch sobre el código de operación. Como solo hay
+ * saltos hacia delante (verificado en fx_vm_load), el bucle termina como
+ * mucho tras code_len instrucciones y no necesita contador de seguridad.
+ */
+
+#include "fx_vm.h"
+#include "fx_math.h"
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char *TAG = "FX_VM";
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+static inline uint16_t read_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline int32_t read_i32(const uint8_t *p)
+{
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                     ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static inline uint16_t insn_imm(const fx_insn_t *in)
+{
+    return (uint16_t)(in->b | (in->c << 8));
+}
+
+/**
+ * @brief Características de audio del frame, o ceros si no hay audio
+ */
+static const int32_t *audio_values(const led_fx_ctx_t *ctx)
+{
+    static const int32_t silence[AUDIO_NUM_FEATURES];
+    return ctx->audio ? ctx->audio->v : silence;
+}
+
+/**
+ * @brief Comprueba una instrucción en la posición pc
+ */
+static bool validate_insn(const fx_insn_t *in, uint16_t pc, uint16_t code_len,
+                          uint8_t n_consts)
+{
+    if (in->op >= FX_OP_COUNT) {
+        return false;
+    }
+
+    switch (in->op) {
+        case FX_OP_END:
+            return true;
+        case FX_OP_LDI:
+            return in->a < FX_VM_NUM_REGS;
+        case FX_OP_LDK:
+            return in->a < FX_VM_NUM_REGS && in->b < n_consts;
+        case FX_OP_AUDIO:
+            return in->a < FX_VM_NUM_REGS && in->b < AUDIO_NUM_FEATURES;
+        case FX_OP_JMP:
+        case FX_OP_JZ: {
+            uint16_t target = insn_imm(in);
+            return in->a < FX_VM_NUM_REGS && target > pc && target <= code_len;
+        }
+        default:
+            return in->a < FX_VM_NUM_REGS && in->b < FX_VM_NUM_REGS &&
+                   in->c < FX_VM_NUM_REGS;
+    }
+}
+
+/**
+ * @brief Analiza los registros de una entrada
+ *
+ * Recorre la entrada en orden hasta un END que siempre se ejecuta. Como
+ * los saltos solo van hacia delante, una escritura en pc define el
+ * registro para las lecturas posteriores si ningún salto anterior puede
+ * pasar por encima de ella.
+ *
+ * @param[out] inputs  Registros que pueden leerse antes de escribirse (su
+ *                     valor viene de fuera de la entrada)
+ * @param[out] outputs Registros que la entrada puede escribir
+ */
+static void entry_regs(const fx_vm_t *vm, uint16_t entry, uint16_t *inputs, uint16_t *outputs)
+{
+    uint16_t defined = 0;
+    uint16_t reach = 0;     // Destino más lejano de los saltos vistos
+
+    *inputs = 0;
+    *outputs = 0;
+
+    for (uint16_t pc = entry; pc < vm->code_len; pc++) {
+        const fx_insn_t *in = &vm->code[pc];
+        uint16_t reads = 0;
+        uint16_t writes = 0;
+
+        switch (in->op) {
+            case FX_OP_END:
+                if (pc >= reach) {
+                    return;
+                }
+                break;
+            case FX_OP_JMP:
+            case FX_OP_JZ:
+                if (in->op == FX_OP_JZ) {
+                    reads = 1u << in->a;
+                }
+                if (insn_imm(in) > reach) {
+                    reach = insn_imm(in);
+                }
+                break;
+            case FX_OP_LDI:
+            case FX_OP_LDK:
+            case FX_OP_AUDIO:
+                writes = 1u << in->a;
+                break;
+            case FX_OP_OUT:
+            case FX_OP_OUTHSV:
+                reads = (1u << in->a) | (1u << in->b) | (1u << in->c);
+                break;
+            case FX_OP_MAD:
+                reads = (1u << in->a) | (1u << in->b) | (1u << in->c);
+                writes = 1u << in->a;
+                break;
+            default:
+                // Las operaciones de un operando ignoran c, que siempre es un
+                // registro válido: contarlo como leído solo es conservador
+                reads = (1u << in->b) | (1u << in->c);
+                writes = 1u << in->a;
+                break;
+        }
+
+        *inputs |= reads & ~defined;
+        *outputs |= writes;
+        if (pc >= reach) {
+            defined |= writes;
+        }
+    }
+}
+
+/**
+ * @brief Indica si la entrada por píxel arrastra estado en r8-r15
+ *
+ * Hay estado si la entrada por píxel escribe un registro que ella misma
+ * (en el píxel siguiente) o la entrada de frame (en el frame siguiente)
+ * leen sin haberlo escrito antes. Los registros que solo usa como
+ * temporales o que solo lee (globales y expresiones precalculadas en la
+ * entrada de frame) no cuentan.
+ */
+static bool pixel_carries_state(const fx_vm_t *vm)
+{
+    const uint16_t globals = (uint16_t)~((1u << FX_VM_FIRST_GLOBAL) - 1);
+    uint16_t pixel_in, pixel_out;
+
+    entry_regs(vm, vm->pixel_entry, &pixel_in, &pixel_out);
+    uint16_t carried = pixel_in;
+
+    if (vm->frame_entry != FX_VM_NO_ENTRY) {
+        uint16_t frame_in, frame_out;
+        entry_regs(vm, vm->frame_entry, &frame_in, &frame_out);
+        carried |= frame_in;
+    }
+    return (pixel_out & carried & globals) != 0;
+}
+
+/**
+ * @brief Ejecuta una entrada del programa sobre el banco de registros r
+ *
+ * @param audio Características de audio (AUDIO_NUM_FEATURES valores)
+ * @param out   Píxel destino (3 bytes) o NULL en la entrada de frame
+ */
+static void IRAM_ATTR execute(const fx_vm_t *vm, int32_t *r, uint16_t pc,
+                              const int32_t *audio, uint8_t *out)
+{
+    const fx_insn_t *code = vm->code;
+    const uint16_t len = vm->code_len;
+
+    while (pc < len) {
+        const fx_insn_t *in = &code[pc++];
+
+        switch (in->op) {
+            case FX_OP_END:    return;
+            case FX_OP_MOV:    r[in->a] = r[in->b]; break;
+            case FX_OP_LDI:    r[in->a] = FX_FROM_Q8((int16_t)insn_imm(in)); break;
+            case FX_OP_LDK:    r[in->a] = vm->consts[in->b]; break;
+            case FX_OP_ADD:    r[in->a] = r[in->b] + r[in->c]; break;
+            case FX_OP_SUB:    r[in->a] = r[in->b] - r[in->c]; break;
+            case FX_OP_MUL:    r[in->a] = fx_mul(r[in->b], r[in->c]); break;
+            case FX_OP_DIV:    r[in->a] = fx_div(r[in->b], r[in->c]); break;
+            case FX_OP_MAD:    r[in->a] += fx_mul(r[in->b], r[in->c]); break;
+            case FX_OP_MIN:    r[in->a] = r[in->b] < r[in->c] ? r[in->b] : r[in->c]; break;
+            case FX_OP_MAX:    r[in->a] = r[in->b] > r[in->c] ? r[in->b] : r[in->c]; break;
+            case FX_OP_NEG:    r[in->a] = -r[in->b]; break;
+            case FX_OP_ABS:    r[in->a] = r[in->b] < 0 ? -r[in->b] : r[in->b]; break;
+            case FX_OP_FRAC:   r[in->a] = fx_frac(r[in->b]); break;
+            case FX_OP_FLOOR:  r[in->a] = r[in->b] & ~(FX_ONE - 1); break;
+            case FX_OP_CLAMP:  r[in->a] = fx_clamp01(r[in->b]); break;
+            case FX_OP_LT:     r[in->a] = r[in->b] < r[in->c] ? FX_ONE : 0; break;
+            case FX_OP_SIN:    r[in->a] = fx_sin(r[in->b]); break;
+            case FX_OP_COS:    r[in->a] = fx_cos(r[in->b]); break;
+            case FX_OP_NOISE:  r[in->a] = fx_value_noise2(r[in->b], r[in->c]); break;
+            case FX_OP_JMP:    pc = insn_imm(in); break;
+            case FX_OP_JZ:
+                if (r[in->a] == 0) {
+                    pc = insn_imm(in);
+                }
+                break;
+            case FX_OP_OUT:
+                if (out) {
+                    out[0] = fx_to_u8(r[in->a]);
+                    out[1] = fx_to_u8(r[in->b]);
+                    out[2] = fx_to_u8(r[in->c]);
+                }
+                break;
+            case FX_OP_OUTHSV:
+                if (out) {
+                    fx_hsv_to_rgb(r[in->a], r[in->b], r[in->c], out);
+                }
+                break;
+            case FX_OP_AUDIO:  r[in->a] = audio[in->b]; break;
+            default:
+                return;
+        }
+    }
+}
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+/**
+ * @brief Valida y carga un programa en la VM
+ */
+esp_err_t fx_vm_load(fx_vm_t *vm, const uint8_t *bin, size_t len)
+{
+    vm->loaded = false;
+
+    if (bin == NULL || len < FX_VM_HEADER_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (memcmp(bin, "FXB1", 4) != 0 || bin[4] != FX_VM_VERSION) {
+        ESP_LOGW(TAG, "Cabecera de programa no válida");
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    uint8_t n_consts = bin[5];
+    uint16_t n_code = read_u16(bin + 6);
+    uint16_t frame_entry = read_u16(bin + 8);
+    uint16_t pixel_entry = read_u16(bin + 10);
+
+    if (n_consts > FX_VM_MAX_CONSTS || n_code == 0 || n_code > FX_VM_MAX_CODE ||
+        len != FX_VM_HEADER_SIZE + n_consts * 4u + n_code * 4u) {
+        ESP_LOGW(TAG, "Tamaño de programa no válido (%u const, %u instr, %u bytes)",
+                 n_consts, n_code, (unsigned)len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (pixel_entry >= n_code ||
+        (frame_entry != FX_VM_NO_ENTRY && frame_entry >= n_code)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint8_t *p = bin + FX_VM_HEADER_SIZE;
+    for (int i = 0; i < n_consts; i++, p += 4) {
+        vm->consts[i] = read_i32(p);
+    }
+    for (uint16_t pc = 0; pc < n_code; pc++, p += 4) {
+        fx_insn_t *in = &vm->code[pc];
+        in->op = p[0];
+        in->a = p[1];
+        in->b = p[2];
+        in->c = p[3];
+        if (!validate_insn(in, pc, n_code, n_consts)) {
+            ESP_LOGW(TAG, "Instrucción %u no válida (op %u)", pc, in->op);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    vm->code_len = n_code;
+    vm->frame_entry = frame_entry;
+    vm->pixel_entry = pixel_entry;
+    memset(vm->globals, 0, sizeof(vm->globals));
+    vm->carries_state = pixel_carries_state(vm);
+    vm->loaded = true;
+
+    ESP_LOGI(TAG, "Programa cargado: %u instrucciones, %u constantes%s", n_code, n_consts,
+             vm->carries_state ? " (estado entre píxeles: un solo core)" : "");
+    return ESP_OK;
+}
+
+/**
+ * @brief Ejecuta la entrada de frame (si el programa tiene una)
+ */
+void fx_vm_run_frame(fx_vm_t *vm, const led_fx_ctx_t *ctx)
+{
+    if (!vm->loaded || vm->frame_entry == FX_VM_NO_ENTRY) {
+        return;
+    }
+
+    int32_t r[FX_VM_NUM_REGS] = {0};
+    r[2] = ctx->t;
+    r[3] = FX_FROM_INT(ctx->num_leds);
+    memcpy(&r[FX_VM_FIRST_GLOBAL], vm->globals, sizeof(vm->globals));
+
+    execute(vm, r, vm->frame_entry, audio_values(ctx), NULL);
+
+    memcpy(vm->globals, &r[FX_VM_FIRST_GLOBAL], sizeof(vm->globals));
+}
+
+/**
+ * @brief Ejecuta la entrada por píxel sobre los píxeles [start, end)
+ */
+void fx_vm_run_pixels(fx_vm_t *vm, uint8_t *rgb, int start, int end,
+                      const led_fx_ctx_t *ctx)
+{
+    if (!vm->loaded) {
+        memset(rgb + start * 3, 0, (end - start) * 3);
+        return;
+    }
+
+    int32_t r[FX_VM_NUM_REGS];
+    int32_t step = fx_div(FX_ONE, FX_FROM_INT(ctx->num_leds));
+    const int32_t *audio = audio_values(ctx);
+    memcpy(&r[FX_VM_FIRST_GLOBAL], vm->globals, sizeof(vm->globals));
+
+    for (int i = start; i < end; i++) {
+        uint8_t *out = rgb + i * 3;
+        r[0] = FX_FROM_INT(i);
+        r[1] = step * i;
+        r[2] = ctx->t;
+        r[3] = FX_FROM_INT(ctx->num_leds);
+        r[4] = r[5] = r[6] = r[7] = 0;
+        out[0] = out[1] = out[2] = 0;
+
+        execute(vm, r, vm->pixel_entry, audio, out);
+    }
+
+    // Sin estado entre píxeles lo que queda en r8-r15 son temporales que
+    // nadie vuelve a leer: no se guardan y la VM queda intacta
+    if (vm->carries_state) {
+        memcpy(vm->globals, &r[FX_VM_FIRST_GLOBAL], sizeof(vm->globals));
+    }
+}
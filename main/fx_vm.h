@@ -0,0 +1,172 @@
+/**
+ * @file fx_vm.h
+ * @brief Máquina virtual de bytecode para efectos cargados en tiempo de ejecución
+ *
+ * Permite añadir efectos sin recompilar ni hacer OTA del firmware: el
+ * efecto se compila a bytecode (ver tools/fxc.py) y se sube al equipo.
+ *
+ * Características:
+ * - VM de registros: 16 registros int32_t en punto fijo Q16.16
+ * - Dos puntos de entrada: uno por frame y uno por píxel
+ * - Seno/coseno por tabla y ruido 2D (fx_math)
+ * - Lectura de las características de audio (bandas, nivel, beat)
+ * - Sin memoria dinámica: el programa se copia a una estructura fx_vm_t
+ *   de tamaño fijo que reserva quien la usa
+ * - Coste acotado: solo se admiten saltos hacia delante, así que cada
+ *   entrada ejecuta como mucho code_len instrucciones por píxel
+ *
+ * REGISTROS:
+ * =========
+ * r0  índice del píxel (entero, Q16.16)          | entrada por píxel
+ * r1  posición x = i / num_leds en [0, 1)        | entrada por píxel
+ * r2  tiempo de animación en segundos            | ambas entradas
+ * r3  número de LEDs (entero, Q16.16)            | ambas entradas
+ * r4-r7   temporales, valen 0 al empezar cada entrada
+ * r8-r15  globales: se conservan entre la entrada de frame, los píxeles
+ *         y los frames siguientes (estado del efecto)
+ *
+ * FORMATO BINARIO (little endian):
+ * ===============================
+ * @code
+ * 0   'F' 'X' 'B' '1'                      magic
+ * 4   u8  versión (FX_VM_VERSION)
+ * 5   u8  número de constantes (n_consts)
+ * 6   u16 número de instrucciones (n_code)
+ * 8   u16 entrada de frame (FX_VM_NO_ENTRY si no hay)
+ * 10  u16 entrada por píxel
+ * 12  i32 constantes[n_consts]             Q16.16
+ * ..  instrucciones[n_code]                4 bytes: op, a, b, c
+ * @endcode
+ *
+ * En las instrucciones aritméticas "a" es el registro destino y "b", "c"
+ * los operandos. Los inmediatos de 16 bits se codifican como b | c << 8.
+ */
+
+#ifndef FX_VM_H
+#define FX_VM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_effects.h"
+#include "sdkconfig.h"
+
+#define FX_VM_VERSION       1
+#define FX_VM_HEADER_SIZE   12
+#define FX_VM_NUM_REGS      16
+#define FX_VM_FIRST_GLOBAL  8
+#define FX_VM_MAX_CODE      CONFIG_FX_VM_MAX_CODE
+#define FX_VM_MAX_CONSTS    32
+#define FX_VM_NO_ENTRY      0xFFFF
+
+/**
+ * @brief Códigos de operación
+ *
+ * El orden es parte del formato binario: solo se añaden al final.
+ */
+typedef enum {
+    FX_OP_END = 0,  ///< Fin de la entrada
+    FX_OP_MOV,      ///< a = b
+    FX_OP_LDI,      ///< a = inmediato Q8.8 con signo (b | c << 8)
+    FX_OP_LDK,      ///< a = constantes[b]
+    FX_OP_ADD,      ///< a = b + c
+    FX_OP_SUB,      ///< a = b - c
+    FX_OP_MUL,      ///< a = b * c
+    FX_OP_DIV,      ///< a = b / c (0 si c es 0)
+    FX_OP_MAD,      ///< a = a + b * c
+    FX_OP_MIN,      ///< a = min(b, c)
+    FX_OP_MAX,      ///< a = max(b, c)
+    FX_OP_NEG,      ///< a = -b
+    FX_OP_ABS,      ///< a = |b|
+    FX_OP_FRAC,     ///< a = parte fraccionaria de b
+    FX_OP_FLOOR,    ///< a = parte entera de b
+    FX_OP_CLAMP,    ///< a = b recortado a [0, 1]
+    FX_OP_LT,       ///< a = (b < c) ? 1 : 0
+    FX_OP_SIN,      ///< a = sin(b), b en vueltas
+    FX_OP_COS,      ///< a = cos(b), b en vueltas
+    FX_OP_NOISE,    ///< a = ruido2d(b, c) en [0, 1]
+    FX_OP_JMP,      ///< salto hacia delante a (b | c << 8)
+    FX_OP_JZ,       ///< si a == 0, salto hacia delante a (b | c << 8)
+    FX_OP_OUT,      ///< color del píxel = (a, b, c) RGB en [0, 1]
+    FX_OP_OUTHSV,   ///< color del píxel = HSV(a, b, c)
+    FX_OP_AUDIO,    ///< a = característica de audio b (audio_feature_t), 0 sin audio
+    FX_OP_COUNT
+} fx_opcode_t;
+
+/**
+ * @brief Instrucción de la VM (4 bytes)
+ */
+typedef struct {
+    uint8_t op;
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+} fx_insn_t;
+
+// Macros para escribir programas como arrays de bytes en C
+#define FXB_HEADER(n_consts, n_code, frame_entry, pixel_entry) \
+    'F', 'X', 'B', '1', FX_VM_VERSION, (n_consts), \
+    (n_code) & 0xFF, (n_code) >> 8, \
+    (frame_entry) & 0xFF, (frame_entry) >> 8, \
+    (pixel_entry) & 0xFF, (pixel_entry) >> 8
+#define FXB_OP(op, a, b, c)     (op), (a), (b), (c)
+#define FXB_LDI(a, q8)          FX_OP_LDI, (a), (q8) & 0xFF, ((q8) >> 8) & 0xFF
+
+/**
+ * @brief Estado de la VM con un programa cargado
+ *
+ * Ocupa unos 1.2 KB con FX_VM_MAX_CODE = 256. Debe reservarse de forma
+ * estática (o en el stack de quien la use), nunca por programa.
+ */
+typedef struct {
+    fx_insn_t code[FX_VM_MAX_CODE];
+    int32_t consts[FX_VM_MAX_CONSTS];
+    int32_t globals[FX_VM_NUM_REGS - FX_VM_FIRST_GLOBAL];
+    uint16_t code_len;
+    uint16_t frame_entry;
+    uint16_t pixel_entry;
+    bool loaded;
+    /** La entrada por píxel pasa valores en r8-r15 de un píxel al siguiente o
+     *  al frame siguiente: hay que ejecutarla en orden y en un solo core */
+    bool carries_state;
+} fx_vm_t;
+
+/**
+ * @brief Valida y carga un programa en la VM
+ *
+ * Comprueba cabecera, tamaños, registros, índices de constantes y que
+ * todos los saltos vayan hacia delante. Si algo falla la VM queda sin
+ * programa (loaded = false). También calcula carries_state.
+ *
+ * @param vm  VM destino
+ * @param bin Programa en el formato binario descrito arriba
+ * @param len Tamaño de bin en bytes
+ * @return ESP_OK, ESP_ERR_INVALID_VERSION si la cabecera no corresponde,
+ *         ESP_ERR_INVALID_SIZE si el programa no cabe o está truncado,
+ *         ESP_ERR_INVALID_ARG si alguna instrucción no es válida
+ */
+esp_err_t fx_vm_load(fx_vm_t *vm, const uint8_t *bin, size_t len);
+
+/**
+ * @brief Ejecuta la entrada de frame (si el programa tiene una)
+ */
+void fx_vm_run_frame(fx_vm_t *vm, const led_fx_ctx_t *ctx);
+
+/**
+ * @brief Ejecuta la entrada por píxel sobre los píxeles [start, end)
+ *
+ * Los píxeles que no ejecutan OUT/OUTHSV quedan en negro. Si el programa
+ * no tiene carries_state, la VM no se modifica y se puede llamar desde
+ * varios cores a la vez con rangos disjuntos.
+ *
+ * @param vm    VM con programa cargado
+ * @param rgb   Frame completo (3 bytes por píxel)
+ * @param start Primer píxel a calcular
+ * @param end   Píxel siguiente al último
+ * @param ctx   Contexto del frame
+ */
+void fx_vm_run_pixels(fx_vm_t *vm, uint8_t *rgb, int start, int end,
+                      const led_fx_ctx_t *ctx);
+
+#endif // FX_VM_H
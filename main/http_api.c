@@ -0,0 +1,610 @@
+/**
+ * @file http_api.c
+ * @brief Implementación de la API REST de control
+ *
+ * Todos los POST comparten un manejador: lee el cuerpo, lo tokeniza y
+ * llama a la acción del endpoint (user_ctx), que valida los campos y deja
+ * el comando en la cola. Los GET comparten otro que llama a una función
+ * de escritura sobre un buffer de la pila.
+ *
+ * El servidor atiende las peticiones en una sola tarea, así que los
+ * contadores HTTP no necesitan protección.
+ */
+
+#include "http_api.h"
+#include "json_tok.h"
+#include "led_cmd.h"
+#include "led_cue.h"
+#include "led_effects.h"
+#include "led_render.h"
+#include "ws_api.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_HTTP_API_ENABLE
+#include "esp_http_server.h"
+#include "lwip/sockets.h"
+#endif
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+#ifdef CONFIG_HTTP_API_ENABLE
+
+static const char *TAG = "HTTP_API";
+
+#define MAX_BODY            CONFIG_HTTP_API_MAX_BODY
+#define MAX_TOKENS          32          // El comando más largo (segmento) usa 13
+#define RESP_SIZE           768         // Respuesta más larga: estado con 8 segmentos
+#define CUE_CHUNK           16          // Registros de cue leídos por recv
+
+// El cuerpo y la respuesta van en la pila de la tarea del servidor
+#define SERVER_STACK        (4096 + MAX_BODY + RESP_SIZE)
+
+/**
+ * @brief Acción de un POST
+ *
+ * @param js  Cuerpo (se puede modificar: cadenas en su sitio)
+ * @param tok Tokens del cuerpo; tok[0] es el objeto raíz
+ * @param[out] msg Mensaje de error para la respuesta (opcional)
+ */
+typedef esp_err_t (*action_fn_t)(char *js, const json_tok_t *tok, const char **msg);
+
+/**
+ * @brief Respuesta en construcción sobre un buffer fijo
+ */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} resp_t;
+
+typedef void (*writer_fn_t)(resp_t *r);
+
+// Contadores de la API
+static uint32_t s_requests;
+static uint32_t s_errors;
+static uint64_t s_handle_sum_us;        // Tiempo en el manejador hasta la respuesta
+static uint32_t s_handle_max_us;
+
+static httpd_handle_t s_server;
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+/**
+ * @brief Añade texto con formato a la respuesta (se recorta si no cabe)
+ */
+static void out(resp_t *r, const char *fmt, ...)
+{
+    if (r->len >= r->size - 1) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(r->buf + r->len, r->size - r->len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        r->len += (size_t)n < r->size - r->len ? (size_t)n : r->size - r->len - 1;
+    }
+}
+
+/**
+ * @brief Lee un entero de una clave del objeto raíz dentro de [lo, hi]
+ */
+static bool get_int(const char *js, const json_tok_t *tok, const char *key,
+                    int32_t lo, int32_t hi, int32_t *v)
+{
+    int i = json_tok_find(js, tok, 0, key);
+    return i >= 0 && json_tok_int(js, &tok[i], v) && *v >= lo && *v <= hi;
+}
+
+/**
+ * @brief Lee un color: [r, g, b] o "#rrggbb"
+ */
+static bool get_color(const char *js, const json_tok_t *tok, const char *key, uint8_t *rgb)
+{
+    int i = json_tok_find(js, tok, 0, key);
+    if (i < 0) {
+        return false;
+    }
+
+    const json_tok_t *t = &tok[i];
+    if (t->type == JSON_TOK_ARRAY && t->size == 3) {
+        for (int k = 0; k < 3; k++) {
+            int32_t v;
+            if (!json_tok_int(js, &tok[i + 1 + k], &v) || v < 0 || v > 255) {
+                return false;
+            }
+            rgb[k] = (uint8_t)v;
+        }
+        return true;
+    }
+
+    if (t->type == JSON_TOK_STRING && t->end - t->start == 7 && js[t->start] == '#') {
+        for (int k = 0; k < 3; k++) {
+            int v = 0;
+            for (int d = 0; d < 2; d++) {
+                char c = js[t->start + 1 + k * 2 + d];
+                int h = (c >= '0' && c <= '9') ? c - '0' :
+                        (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                        (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                if (h < 0) {
+                    return false;
+                }
+                v = (v << 4) | h;
+            }
+            rgb[k] = (uint8_t)v;
+        }
+        return true;
+    }
+    return false;
+}
+
+// --- Acciones de los POST ---
+
+static esp_err_t action_color(char *js, const json_tok_t *tok, const char **msg)
+{
+    led_cmd_t cmd = { .type = LED_CMD_COLOR };
+    if (!get_color(js, tok, "color", cmd.rgb)) {
+        *msg = "color must be [r, g, b] or '#rrggbb'";
+        return ESP_ERR_INVALID_ARG;
+    }
+    return led_cmd_post(&cmd);
+}
+
+static esp_err_t action_effect(char *js, const json_tok_t *tok, const char **msg)
+{
+    led_cmd_t cmd = { .type = LED_CMD_EFFECT, .effect = LED_FX_NONE };
+
+    int i = json_tok_find(js, tok, 0, "name");
+    if (i < 0) {
+        *msg = "missing name";
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!json_tok_null(js, &tok[i])) {
+        const char *name = json_tok_str(js, &tok[i]);
+        if (name == NULL) {
+            *msg = "name must be a string or null";
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (strcmp(name, "none") != 0) {
+            cmd.effect = led_effects_find(name);
+            if (cmd.effect == LED_FX_NONE) {
+                *msg = "unknown effect";
+                return ESP_ERR_NOT_FOUND;
+            }
+        }
+    }
+    return led_cmd_post(&cmd);
+}
+
+static esp_err_t action_brightness(char *js, const json_tok_t *tok, const char **msg)
+{
+    int32_t v;
+    if (!get_int(js, tok, "value", 0, 255, &v)) {
+        *msg = "value must be 0-255";
+        return ESP_ERR_INVALID_ARG;
+    }
+    led_cmd_t cmd = { .type = LED_CMD_BRIGHTNESS, .brightness = (uint8_t)v };
+    return led_cmd_post(&cmd);
+}
+
+static esp_err_t action_segment(char *js, const json_tok_t *tok, const char **msg)
+{
+    int32_t index, start = 0, len;
+    led_cmd_t cmd = { .type = LED_CMD_SEGMENT };
+
+    if (!get_int(js, tok, "index", 0, LED_RENDER_MAX_SEGMENTS - 1, &index) ||
+        !get_int(js, tok, "len", 0, UINT16_MAX, &len)) {
+        *msg = "index and len are required";
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > 0 && (!get_int(js, tok, "start", 0, UINT16_MAX, &start) ||
+                    !get_color(js, tok, "color", cmd.rgb))) {
+        *msg = "start and color are required";
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cmd.index = (uint8_t)index;
+    cmd.start = (uint16_t)start;
+    cmd.len = (uint16_t)len;
+    esp_err_t err = led_cmd_post(&cmd);
+    if (err == ESP_ERR_INVALID_ARG) {
+        *msg = "segment outside the strip";
+    }
+    return err;
+}
+
+static esp_err_t action_preset(char *js, const json_tok_t *tok, const char **msg)
+{
+    int32_t slot;
+    if (get_int(js, tok, "save", 0, LED_CMD_PRESETS - 1, &slot)) {
+        return led_cmd_preset_save(slot);
+    }
+    if (get_int(js, tok, "load", 0, LED_CMD_PRESETS - 1, &slot)) {
+        esp_err_t err = led_cmd_preset_load(slot);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            *msg = "empty preset slot";
+        }
+        return err;
+    }
+    *msg = "expected save or load with a slot number";
+    return ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t action_cues_play(char *js, const json_tok_t *tok, const char **msg)
+{
+    int32_t from = 0;
+    if (json_tok_find(js, tok, 0, "from") >= 0 && !get_int(js, tok, "from", 0, INT32_MAX, &from)) {
+        *msg = "from must be a position in ms";
+        return ESP_ERR_INVALID_ARG;
+    }
+    led_cue_play((uint32_t)from);
+    return ESP_OK;
+}
+
+static esp_err_t action_cues_stop(char *js, const json_tok_t *tok, const char **msg)
+{
+    led_cue_stop();
+    return ESP_OK;
+}
+
+static esp_err_t action_timecode(char *js, const json_tok_t *tok, const char **msg)
+{
+    int32_t ms;
+    if (!get_int(js, tok, "ms", 0, INT32_MAX, &ms)) {
+        *msg = "ms must be a position in ms";
+        return ESP_ERR_INVALID_ARG;
+    }
+    led_cue_timecode((int64_t)ms * 1000);
+    return ESP_OK;
+}
+
+// --- Respuestas de los GET ---
+
+static void write_state(resp_t *r)
+{
+    led_cmd_state_t st;
+    led_cmd_get_state(&st);
+
+    const led_effect_t *fx = led_effects_get(st.effect);
+    if (fx) {
+        out(r, "{\"effect\":\"%s\"", fx->name);
+    } else {
+        out(r, "{\"effect\":null");
+    }
+    out(r, ",\"color\":[%u,%u,%u],\"brightness\":%u,\"segments\":[",
+        st.rgb[0], st.rgb[1], st.rgb[2], st.brightness);
+
+    bool first = true;
+    for (int i = 0; i < LED_RENDER_MAX_SEGMENTS; i++) {
+        const led_cmd_segment_t *seg = &st.segments[i];
+        if (seg->len == 0) {
+            continue;
+        }
+        out(r, "%s{\"index\":%d,\"start\":%u,\"len\":%u,\"color\":[%u,%u,%u]}",
+            first ? "" : ",", i, seg->start, seg->len, seg->rgb[0], seg->rgb[1], seg->rgb[2]);
+        first = false;
+    }
+    out(r, "]}");
+}
+
+static void write_effects(resp_t *r)
+{
+    out(r, "[");
+    for (int i = 0; i < led_effects_count(); i++) {
+        out(r, "%s\"%s\"", i ? "," : "", led_effects_get(i)->name);
+    }
+    out(r, "]");
+}
+
+static void write_stats(resp_t *r)
+{
+    led_cmd_stats_t cmd;
+    led_render_stats_t render;
+    led_cmd_get_stats(&cmd);
+    led_render_get_stats(&render);
+
+    uint32_t avg = cmd.latency_samples ? (uint32_t)(cmd.latency_sum_us / cmd.latency_samples) : 0;
+    out(r, "{\"commands\":{\"received\":%lu,\"dropped\":%lu,\"coalesced\":%lu,"
+        "\"applied\":%lu},",
+        (unsigned long)cmd.received, (unsigned long)cmd.dropped,
+        (unsigned long)cmd.coalesced, (unsigned long)cmd.applied);
+    out(r, "\"latency_us\":{\"samples\":%lu,\"last\":%lu,\"avg\":%lu,\"max\":%lu,\"sum\":%llu,"
+        "\"p50\":%lu,\"p90\":%lu,\"p99\":%lu},",
+        (unsigned long)cmd.latency_samples, (unsigned long)cmd.latency_last_us,
+        (unsigned long)avg, (unsigned long)cmd.latency_max_us,
+        (unsigned long long)cmd.latency_sum_us, (unsigned long)cmd.latency_p50_us,
+        (unsigned long)cmd.latency_p90_us, (unsigned long)cmd.latency_p99_us);
+
+    uint32_t handle_avg = s_requests ? (uint32_t)(s_handle_sum_us / s_requests) : 0;
+    out(r, "\"http\":{\"requests\":%lu,\"errors\":%lu,\"handler_avg_us\":%lu,"
+        "\"handler_max_us\":%lu},",
+        (unsigned long)s_requests, (unsigned long)s_errors,
+        (unsigned long)handle_avg, (unsigned long)s_handle_max_us);
+    uint32_t output_avg = render.frames_rendered ?
+        (uint32_t)(render.output_sum_us / render.frames_rendered) : 0;
+    out(r, "\"render\":{\"fps\":%u,\"frames\":%lu,\"partial\":%lu,\"updates\":%lu,"
+        "\"pixels_updated\":%lu,\"wire_bytes\":%llu,\"output_avg_us\":%lu,"
+        "\"output_sum_us\":%llu}}",
+        render.fps, (unsigned long)render.frames_rendered,
+        (unsigned long)render.frames_partial, (unsigned long)render.updates_received,
+        (unsigned long)render.pixels_updated, (unsigned long long)render.wire_bytes,
+        (unsigned long)output_avg, (unsigned long long)render.output_sum_us);
+}
+
+static void write_cues(resp_t *r)
+{
+    static const char *const sources[] = { "stopped", "local", "timecode" };
+    led_cue_status_t st;
+    led_cue_get_status(&st);
+
+    uint32_t late_avg = st.activations ? (uint32_t)(st.late_sum_us / st.activations) : 0;
+    out(r, "{\"source\":\"%s\",\"freewheel\":%s,\"cues\":%u,\"active\":%d,"
+        "\"position_ms\":%lld,\"activations\":%lu,\"seeks\":%lu,\"timecodes\":%lu,",
+        sources[st.source], st.freewheel ? "true" : "false", st.cues, st.active,
+        (long long)(st.position_us / 1000), (unsigned long)st.activations,
+        (unsigned long)st.seeks, (unsigned long)st.timecodes);
+    out(r, "\"late_us\":{\"last\":%lu,\"avg\":%lu,\"max\":%lu}}",
+        (unsigned long)st.late_last_us, (unsigned long)late_avg,
+        (unsigned long)st.late_max_us);
+}
+
+// --- Manejadores ---
+
+/**
+ * @brief Envía la respuesta y actualiza los contadores
+ */
+static esp_err_t respond(httpd_req_t *req, esp_err_t err, const char *msg,
+                         const char *body, size_t len, int64_t t0)
+{
+    char error[96];
+    const char *status = HTTPD_200;
+
+    if (err != ESP_OK) {
+        switch (err) {
+            case ESP_ERR_INVALID_ARG:
+                status = "400 Bad Request";
+                break;
+            case ESP_ERR_NOT_FOUND:
+            case ESP_ERR_NVS_NOT_FOUND:
+                status = "404 Not Found";
+                break;
+            case ESP_ERR_INVALID_SIZE:
+            case ESP_ERR_NO_MEM:
+                status = "413 Payload Too Large";
+                break;
+            case ESP_ERR_INVALID_STATE:
+                status = "409 Conflict";
+                break;
+            case ESP_ERR_TIMEOUT:
+                status = "503 Service Unavailable";
+                msg = "command queue full";
+                break;
+            default:
+                status = HTTPD_500;
+                break;
+        }
+        len = snprintf(error, sizeof(error), "{\"error\":\"%s\"}",
+                       msg ? msg : esp_err_to_name(err));
+        body = error;
+        s_errors++;
+    }
+
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    esp_err_t ret = httpd_resp_send(req, body, len);
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    s_requests++;
+    s_handle_sum_us += us;
+    if (us > s_handle_max_us) {
+        s_handle_max_us = us;
+    }
+    return ret;
+}
+
+/**
+ * @brief Recibe exactamente len bytes del cuerpo
+ *
+ * @return false si la conexión se ha cerrado
+ */
+static bool recv_all(httpd_req_t *req, uint8_t *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len) {
+        int n = httpd_req_recv(req, (char *)buf + got, len - got);
+        if (n == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+static esp_err_t post_handler(httpd_req_t *req)
+{
+    static const char ok[] = "{\"ok\":true}";
+    char body[MAX_BODY];
+    json_tok_t tok[MAX_TOKENS];
+    int64_t t0 = esp_timer_get_time();
+    const char *msg = NULL;
+    esp_err_t err;
+
+    // El resto de un cuerpo demasiado grande lo descarta el servidor
+    if (req->content_len > sizeof(body)) {
+        return respond(req, ESP_ERR_INVALID_SIZE, "body too large", NULL, 0, t0);
+    }
+
+    if (!recv_all(req, (uint8_t *)body, req->content_len)) {
+        return ESP_FAIL;        // Conexión cerrada: el servidor la libera
+    }
+
+    int n = json_tok_parse(body, req->content_len, tok, MAX_TOKENS);
+    if (n < 1 || tok[0].type != JSON_TOK_OBJECT) {
+        err = ESP_ERR_INVALID_ARG;
+        msg = n == JSON_TOK_ERR_NOMEM ? "too many JSON values" : "body must be a JSON object";
+    } else {
+        action_fn_t action = (action_fn_t)req->user_ctx;
+        err = action(body, tok, &msg);
+    }
+    return respond(req, err, msg, ok, sizeof(ok) - 1, t0);
+}
+
+/**
+ * @brief POST /api/cues: lista de cues en el formato binario de led_cue.h
+ *
+ * El cuerpo no pasa por el buffer de MAX_BODY: se lee por bloques de
+ * CUE_CHUNK registros que van directos a la lista en carga.
+ */
+static esp_err_t cues_handler(httpd_req_t *req)
+{
+    static const char ok[] = "{\"ok\":true}";
+    uint8_t buf[CUE_CHUNK * LED_CUE_RECORD_SIZE];
+    int64_t t0 = esp_timer_get_time();
+
+    if (req->content_len < LED_CUE_HEADER_SIZE) {
+        return respond(req, ESP_ERR_INVALID_ARG, "missing CUE1 header", NULL, 0, t0);
+    }
+    if (!recv_all(req, buf, LED_CUE_HEADER_SIZE)) {
+        return ESP_FAIL;
+    }
+    int count = led_cue_decode_header(buf, LED_CUE_HEADER_SIZE);
+    if (count < 0 ||
+        req->content_len != LED_CUE_HEADER_SIZE + (size_t)count * LED_CUE_RECORD_SIZE) {
+        return respond(req, ESP_ERR_INVALID_ARG, "bad CUE1 header or length", NULL, 0, t0);
+    }
+
+    esp_err_t err = led_cue_load_begin();
+    if (err != ESP_OK) {
+        return respond(req, err, "cue list upload in progress", NULL, 0, t0);
+    }
+
+    const char *msg = NULL;
+    for (int done = 0; done < count && err == ESP_OK; ) {
+        int n = count - done < CUE_CHUNK ? count - done : CUE_CHUNK;
+        if (!recv_all(req, buf, (size_t)n * LED_CUE_RECORD_SIZE)) {
+            led_cue_load_abort();
+            return ESP_FAIL;
+        }
+        for (int k = 0; k < n && err == ESP_OK; k++) {
+            led_cue_t cue;
+            if (!led_cue_decode(buf + k * LED_CUE_RECORD_SIZE, &cue)) {
+                err = ESP_ERR_INVALID_ARG;
+                msg = "reserved cue fields must be zero";
+            } else {
+                err = led_cue_load_add(&cue);
+                msg = err == ESP_ERR_NO_MEM ? "too many cues" : "unknown effect or flags";
+            }
+        }
+        done += n;
+    }
+
+    if (err != ESP_OK) {
+        led_cue_load_abort();
+        return respond(req, err, msg, NULL, 0, t0);
+    }
+    led_cue_load_commit();
+    return respond(req, ESP_OK, NULL, ok, sizeof(ok) - 1, t0);
+}
+
+static esp_err_t get_handler(httpd_req_t *req)
+{
+    char buf[RESP_SIZE];
+    resp_t r = { .buf = buf, .size = sizeof(buf) };
+    int64_t t0 = esp_timer_get_time();
+
+    ((writer_fn_t)req->user_ctx)(&r);
+    return respond(req, ESP_OK, NULL, buf, r.len, t0);
+}
+
+/**
+ * @brief Desactiva Nagle en cada conexión nueva
+ *
+ * La respuesta sale en dos escrituras (cabeceras y cuerpo); con Nagle la
+ * segunda espera al ACK de la primera, que el cliente puede retrasar
+ * decenas de milisegundos.
+ */
+static esp_err_t open_socket(httpd_handle_t hd, int sockfd)
+{
+    int one = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return ESP_OK;
+}
+
+static const httpd_uri_t s_uris[] = {
+    { .uri = "/api/state",      .method = HTTP_GET,  .handler = get_handler,
+      .user_ctx = write_state },
+    { .uri = "/api/effects",    .method = HTTP_GET,  .handler = get_handler,
+      .user_ctx = write_effects },
+    { .uri = "/api/stats",      .method = HTTP_GET,  .handler = get_handler,
+      .user_ctx = write_stats },
+    { .uri = "/api/color",      .method = HTTP_POST, .handler = post_handler,
+      .user_ctx = action_color },
+    { .uri = "/api/effect",     .method = HTTP_POST, .handler = post_handler,
+      .user_ctx = action_effect },
+    { .uri = "/api/brightness", .method = HTTP_POST, .handler = post_handler,
+      .user_ctx = action_brightness },
+    { .uri = "/api/segment",    .method = HTTP_POST, .handler = post_handler,
+      .user_ctx = action_segment },
+    { .uri = "/api/preset",     .method = HTTP_POST, .handler = post_handler,
+      .user_ctx = action_preset },
+    { .uri = "/api/cues",       .method = HTTP_GET,  .handler = get_handler,
+      .user_ctx = write_cues },
+    { .uri = "/api/cues",       .method = HTTP_POST, .handler = cues_handler },
+    { .uri = "/api/cues/play",  .method = HTTP_POST, .handler = post_handler,
+      .user_ctx = action_cues_play },
+    { .uri = "/api/cues/stop",  .method = HTTP_POST, .handler = post_handler,
+      .user_ctx = action_cues_stop },
+    { .uri = "/api/timecode",   .method = HTTP_POST, .handler = post_handler,
+      .user_ctx = action_timecode },
+};
+
+#define NUM_URIS ((int)(sizeof(s_uris) / sizeof(s_uris[0])))
+
+#endif // CONFIG_HTTP_API_ENABLE
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+esp_err_t http_api_start(void)
+{
+#ifdef CONFIG_HTTP_API_ENABLE
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_HTTP_API_PORT;
+    config.stack_size = SERVER_STACK;
+    config.max_uri_handlers = NUM_URIS + 1;    // Más /ws
+    config.lru_purge_enable = true;
+    config.open_fn = open_socket;
+
+    esp_err_t err = httpd_start(&s_server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo arrancar el servidor: %s", esp_err_to_name(err));
+        return err;
+    }
+    for (int i = 0; i < NUM_URIS; i++) {
+        httpd_register_uri_handler(s_server, &s_uris[i]);
+    }
+#ifdef CONFIG_HTTP_API_WS
+    ws_api_register(s_server);
+#endif
+
+    ESP_LOGI(TAG, "API de control en el puerto %d (%d endpoints, cuerpo máx. %d bytes)",
+             CONFIG_HTTP_API_PORT, NUM_URIS, MAX_BODY);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
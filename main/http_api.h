@@ -0,0 +1,56 @@
+/**
+ * @file http_api.h
+ * @brief API REST de control sobre el servidor HTTP de ESP-IDF
+ *
+ * ENDPOINTS:
+ * =========
+ * GET  /api/state       Estado aplicado: efecto, color, brillo y segmentos
+ * GET  /api/effects     Nombres de los efectos disponibles
+ * GET  /api/stats       Contadores de comandos, latencia petición-luz, HTTP y
+ *                       render stage (envíos parciales, bytes por el cable)
+ * POST /api/color       {"color": [r, g, b]} o {"color": "#rrggbb"}
+ * POST /api/effect      {"name": "fire"}; null o "none" lo detiene
+ * POST /api/brightness  {"value": 0-255}
+ * POST /api/segment     {"index": i, "start": s, "len": n, "color": [r, g, b]};
+ *                       "len": 0 lo borra
+ * POST /api/preset      {"save": slot} o {"load": slot}
+ * GET  /api/cues        Reproducción de la lista de cues (led_cue.h)
+ * POST /api/cues        Lista de cues nueva, en el formato binario CUE1
+ * POST /api/cues/play   {"from": ms}: reproduce con el reloj local
+ * POST /api/cues/stop   {}
+ * POST /api/timecode    {"ms": posición} de un código de tiempo
+ * GET  /ws              Canal WebSocket binario (ws_api.h, CONFIG_HTTP_API_WS)
+ *
+ * Los POST responden {"ok":true} en cuanto el comando está en la cola del
+ * render stage (led_cmd.h), sin esperar al frame. Los errores responden
+ * {"error":"..."} con 400 (petición inválida), 404 (efecto o preset que
+ * no existe), 409 (otra carga de cues en curso), 413 (cuerpo mayor que
+ * CONFIG_HTTP_API_MAX_BODY o más de CONFIG_LED_CUE_MAX cues) o 503 (cola
+ * llena).
+ *
+ * SIN MEMORIA DINÁMICA POR PETICIÓN:
+ * =================================
+ * El cuerpo se lee en un buffer de la pila de la tarea del servidor, se
+ * tokeniza en su sitio (json_tok.h) con un array fijo de tokens, y las
+ * respuestas se escriben con snprintf en otro buffer de la pila.
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef HTTP_API_H
+#define HTTP_API_H
+
+#include "esp_err.h"
+
+/**
+ * @brief Arranca el servidor HTTP y registra los endpoints
+ *
+ * @note Necesita la red ya configurada (después de wifi_init_sta()) y
+ *       led_cmd_init()
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED sin CONFIG_HTTP_API_ENABLE o el
+ *         error de httpd_start()
+ */
+esp_err_t http_api_start(void);
+
+#endif // HTTP_API_H
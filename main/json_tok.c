@@ -0,0 +1,321 @@
+/**
+ * @file json_tok.c
+ * @brief Implementación del tokenizador JSON
+ *
+ * Un solo recorrido con una pila de contenedores abiertos (índices de
+ * token) y un estado que dice qué puede venir a continuación. Cada valor
+ * suma uno al tamaño del array que lo contiene; en los objetos cuentan las
+ * claves, y el valor cuelga de su clave.
+ */
+
+#include "json_tok.h"
+#include <string.h>
+
+/**
+ * @brief Qué se espera en la siguiente posición del texto
+ */
+typedef enum {
+    EXPECT_VALUE = 0,       ///< Un valor (inicio, tras ':' o ',' en array)
+    EXPECT_KEY,             ///< Una clave (tras '{' o ',' en objeto)
+    EXPECT_COLON,           ///< ':' tras una clave
+    EXPECT_NEXT,            ///< ',' o cierre del contenedor tras un valor
+    EXPECT_END,             ///< Solo espacios: el documento está completo
+} expect_t;
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static int hex_value(char c)
+{
+    if (is_digit(c)) return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Comprueba que [s, e) es un número JSON, true, false o null
+ */
+static bool valid_primitive(const char *s, const char *e)
+{
+    size_t n = e - s;
+    if ((n == 4 && memcmp(s, "true", 4) == 0) || (n == 5 && memcmp(s, "false", 5) == 0) ||
+        (n == 4 && memcmp(s, "null", 4) == 0)) {
+        return true;
+    }
+
+    if (s < e && *s == '-') s++;
+    if (s == e || !is_digit(*s)) return false;
+    if (*s == '0') {
+        s++;
+    } else {
+        while (s < e && is_digit(*s)) s++;
+    }
+    if (s < e && *s == '.') {
+        if (++s == e || !is_digit(*s)) return false;
+        while (s < e && is_digit(*s)) s++;
+    }
+    if (s < e && (*s == 'e' || *s == 'E')) {
+        s++;
+        if (s < e && (*s == '+' || *s == '-')) s++;
+        if (s == e || !is_digit(*s)) return false;
+        while (s < e && is_digit(*s)) s++;
+    }
+    return s == e;
+}
+
+/**
+ * @brief Busca las comillas de cierre de la cadena que empieza en pos
+ *
+ * @return Posición de las comillas, o -1 si la cadena no es válida
+ */
+static int scan_string(const char *js, int len, int pos)
+{
+    for (int i = pos; i < len; i++) {
+        char c = js[i];
+        if (c == '"') {
+            return i;
+        }
+        if ((unsigned char)c < 0x20) {
+            return -1;
+        }
+        if (c != '\\') {
+            continue;
+        }
+        if (++i == len) {
+            return -1;
+        }
+        switch (js[i]) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                if (i + 4 >= len) return -1;
+                for (int k = 1; k <= 4; k++) {
+                    if (hex_value(js[i + k]) < 0) return -1;
+                }
+                i += 4;
+                break;
+            default:
+                return -1;
+        }
+    }
+    return -1;
+}
+
+int json_tok_parse(const char *js, size_t len, json_tok_t *tok, int max)
+{
+    int stack[JSON_TOK_MAX_DEPTH];
+    int depth = 0;
+    int count = 0;
+    expect_t expect = EXPECT_VALUE;
+    bool opened = false;        // Contenedor recién abierto: se admite el cierre
+
+    if (len > UINT16_MAX) {
+        return JSON_TOK_ERR_NOMEM;
+    }
+
+    for (int pos = 0; pos < (int)len; pos++) {
+        char c = js[pos];
+        if (is_space(c)) {
+            continue;
+        }
+
+        switch (c) {
+            case '{':
+            case '[':
+                if (expect != EXPECT_VALUE) return JSON_TOK_ERR_INVALID;
+                if (count == max || depth == JSON_TOK_MAX_DEPTH) return JSON_TOK_ERR_NOMEM;
+                if (depth > 0 && tok[stack[depth - 1]].type == JSON_TOK_ARRAY) {
+                    tok[stack[depth - 1]].size++;
+                }
+                tok[count] = (json_tok_t){
+                    .type = c == '{' ? JSON_TOK_OBJECT : JSON_TOK_ARRAY,
+                    .start = pos,
+                };
+                stack[depth++] = count++;
+                expect = c == '{' ? EXPECT_KEY : EXPECT_VALUE;
+                opened = true;
+                continue;
+
+            case '}':
+            case ']': {
+                if (depth == 0) return JSON_TOK_ERR_INVALID;
+                json_tok_t *t = &tok[stack[depth - 1]];
+                if (t->type != (c == '}' ? JSON_TOK_OBJECT : JSON_TOK_ARRAY)) {
+                    return JSON_TOK_ERR_INVALID;
+                }
+                if (expect != EXPECT_NEXT && !(opened && expect != EXPECT_COLON)) {
+                    return JSON_TOK_ERR_INVALID;
+                }
+                t->end = pos + 1;
+                depth--;
+                break;
+            }
+
+            case ':':
+                if (expect != EXPECT_COLON) return JSON_TOK_ERR_INVALID;
+                expect = EXPECT_VALUE;
+                continue;
+
+            case ',':
+                if (expect != EXPECT_NEXT || depth == 0) return JSON_TOK_ERR_INVALID;
+                expect = tok[stack[depth - 1]].type == JSON_TOK_OBJECT ? EXPECT_KEY : EXPECT_VALUE;
+                opened = false;
+                continue;
+
+            case '"': {
+                if (expect != EXPECT_VALUE && expect != EXPECT_KEY) return JSON_TOK_ERR_INVALID;
+                if (count == max) return JSON_TOK_ERR_NOMEM;
+                int close = scan_string(js, (int)len, pos + 1);
+                if (close < 0) return JSON_TOK_ERR_INVALID;
+                bool key = expect == EXPECT_KEY;
+                if (key || (depth > 0 && tok[stack[depth - 1]].type == JSON_TOK_ARRAY)) {
+                    tok[stack[depth - 1]].size++;
+                }
+                tok[count++] = (json_tok_t){
+                    .type = JSON_TOK_STRING, .start = pos + 1, .end = close, .size = key,
+                };
+                pos = close;
+                opened = false;
+                if (key) {
+                    expect = EXPECT_COLON;
+                    continue;
+                }
+                break;
+            }
+
+            default: {
+                if (expect != EXPECT_VALUE) return JSON_TOK_ERR_INVALID;
+                if (count == max) return JSON_TOK_ERR_NOMEM;
+                int end = pos;
+                while (end < (int)len && !is_space(js[end]) && js[end] != ',' &&
+                       js[end] != ']' && js[end] != '}' && js[end] != ':') {
+                    end++;
+                }
+                if (!valid_primitive(js + pos, js + end)) return JSON_TOK_ERR_INVALID;
+                if (depth > 0 && tok[stack[depth - 1]].type == JSON_TOK_ARRAY) {
+                    tok[stack[depth - 1]].size++;
+                }
+                tok[count++] = (json_tok_t){
+                    .type = JSON_TOK_PRIMITIVE, .start = pos, .end = end,
+                };
+                pos = end - 1;
+                break;
+            }
+        }
+
+        // Valor completo
+        opened = false;
+        expect = depth > 0 ? EXPECT_NEXT : EXPECT_END;
+    }
+
+    return expect == EXPECT_END ? count : JSON_TOK_ERR_INVALID;
+}
+
+int json_tok_skip(const json_tok_t *tok, int i)
+{
+    for (int pending = 1; pending > 0; i++) {
+        pending += tok[i].size - 1;
+    }
+    return i;
+}
+
+int json_tok_find(const char *js, const json_tok_t *tok, int obj, const char *key)
+{
+    if (tok[obj].type != JSON_TOK_OBJECT) {
+        return -1;
+    }
+    int i = obj + 1;
+    for (int k = 0; k < tok[obj].size; k++) {
+        if (json_tok_eq(js, &tok[i], key)) {
+            return i + 1;
+        }
+        i = json_tok_skip(tok, i);
+    }
+    return -1;
+}
+
+bool json_tok_eq(const char *js, const json_tok_t *t, const char *s)
+{
+    size_t n = strlen(s);
+    return t->type == JSON_TOK_STRING && (size_t)(t->end - t->start) == n &&
+           memcmp(js + t->start, s, n) == 0;
+}
+
+bool json_tok_int(const char *js, const json_tok_t *t, int32_t *out)
+{
+    if (t->type != JSON_TOK_PRIMITIVE) {
+        return false;
+    }
+    const char *s = js + t->start, *e = js + t->end;
+    bool neg = *s == '-';
+    if (neg) s++;
+
+    int64_t v = 0;
+    for (; s < e; s++) {
+        if (!is_digit(*s)) {
+            return false;
+        }
+        v = v * 10 + (*s - '0');
+        if (v > (int64_t)INT32_MAX + 1) {
+            return false;
+        }
+    }
+    v = neg ? -v : v;
+    if (v > INT32_MAX) {
+        return false;
+    }
+    *out = (int32_t)v;
+    return true;
+}
+
+bool json_tok_null(const char *js, const json_tok_t *t)
+{
+    return t->type == JSON_TOK_PRIMITIVE && t->end - t->start == 4 &&
+           memcmp(js + t->start, "null", 4) == 0;
+}
+
+const char *json_tok_str(char *js, const json_tok_t *t)
+{
+    if (t->type != JSON_TOK_STRING) {
+        return NULL;
+    }
+
+    // La escritura nunca adelanta a la lectura: cada escape se queda en un carácter
+    char *w = js + t->start;
+    for (const char *r = js + t->start; r < js + t->end; r++) {
+        if (*r != '\\') {
+            *w++ = *r;
+            continue;
+        }
+        switch (*++r) {
+            case 'b': *w++ = '\b'; break;
+            case 'f': *w++ = '\f'; break;
+            case 'n': *w++ = '\n'; break;
+            case 'r': *w++ = '\r'; break;
+            case 't': *w++ = '\t'; break;
+            case 'u': {
+                int v = 0;
+                for (int k = 1; k <= 4; k++) {
+                    v = (v << 4) | hex_value(r[k]);
+                }
+                if (v == 0 || v > 0x7F) {
+                    return NULL;
+                }
+                *w++ = (char)v;
+                r += 4;
+                break;
+            }
+            default: *w++ = *r; break;     // '"', '\\' y '/'
+        }
+    }
+    *w = '\0';
+    return js + t->start;
+}
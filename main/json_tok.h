@@ -0,0 +1,111 @@
+/**
+ * @file json_tok.h
+ * @brief Tokenizador JSON en el propio buffer, sin memoria dinámica
+ *
+ * Recorre el texto una vez y lo describe con un array de tokens que
+ * pone quien llama (normalmente en la pila): cada token guarda su tipo,
+ * dónde empieza y acaba dentro del texto y cuántos hijos tiene. No se
+ * copia nada: los valores se leen directamente del buffer, y las cadenas
+ * se terminan y se decodifican en su sitio (json_tok_str()).
+ *
+ * ORDEN DE LOS TOKENS:
+ * ===================
+ * Preorden: un objeto va seguido de sus claves, cada clave de su valor y
+ * un array de sus elementos. Para {"a":[1,2],"b":3}:
+ *
+ *   0 OBJECT (2)  1 "a" (1)  2 ARRAY (2)  3 1  4 2  5 "b" (1)  6 3
+ *
+ * Se acepta el JSON estándar con dos límites pensados para comandos
+ * cortos: como mucho JSON_TOK_MAX_DEPTH niveles de anidamiento, y en las
+ * cadenas solo los escapes \uXXXX que son ASCII.
+ */
+
+#ifndef JSON_TOK_H
+#define JSON_TOK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Niveles de objetos y arrays anidados admitidos
+#define JSON_TOK_MAX_DEPTH 8
+
+// Errores de json_tok_parse()
+#define JSON_TOK_ERR_INVALID   (-1)    ///< El texto no es JSON válido
+#define JSON_TOK_ERR_NOMEM     (-2)    ///< No caben los tokens o el anidamiento
+
+/**
+ * @brief Tipo de un token
+ */
+typedef enum {
+    JSON_TOK_OBJECT = 0,
+    JSON_TOK_ARRAY,
+    JSON_TOK_STRING,        ///< Sin las comillas
+    JSON_TOK_PRIMITIVE,     ///< Número, true, false o null
+} json_tok_type_t;
+
+/**
+ * @brief Un valor del documento
+ */
+typedef struct {
+    uint8_t type;           ///< json_tok_type_t
+    uint16_t start;         ///< Primer carácter dentro del texto
+    uint16_t end;           ///< Uno después del último
+    uint16_t size;          ///< Pares de un objeto, elementos de un array, 1 en una clave
+} json_tok_t;
+
+/**
+ * @brief Tokeniza un documento JSON
+ *
+ * @param js   Texto (no hace falta que acabe en '\0'; como mucho 65535 bytes)
+ * @param len  Longitud del texto
+ * @param tok  Array de tokens de salida
+ * @param max  Tokens del array
+ * @return Número de tokens usados, o JSON_TOK_ERR_*
+ */
+int json_tok_parse(const char *js, size_t len, json_tok_t *tok, int max);
+
+/**
+ * @brief Índice del token que sigue a i y a todos sus descendientes
+ */
+int json_tok_skip(const json_tok_t *tok, int i);
+
+/**
+ * @brief Busca una clave en un objeto
+ *
+ * @param obj Índice del objeto
+ * @return Índice del valor de la clave, o -1 si no está (o obj no es un objeto)
+ */
+int json_tok_find(const char *js, const json_tok_t *tok, int obj, const char *key);
+
+/**
+ * @brief Compara un token de tipo cadena con un texto
+ */
+bool json_tok_eq(const char *js, const json_tok_t *t, const char *s);
+
+/**
+ * @brief Lee un entero
+ *
+ * @return false si el token no es un número entero o no cabe en 32 bits
+ */
+bool json_tok_int(const char *js, const json_tok_t *t, int32_t *out);
+
+/**
+ * @brief Indica si el token es null
+ */
+bool json_tok_null(const char *js, const json_tok_t *t);
+
+/**
+ * @brief Termina y decodifica una cadena en su sitio
+ *
+ * Escribe el '\0' en el carácter de las comillas de cierre y resuelve los
+ * escapes hacia atrás dentro del mismo buffer (el resultado nunca es más
+ * largo). Modifica el texto: los demás tokens siguen siendo válidos, pero
+ * esta cadena ya no se puede comparar con json_tok_eq().
+ *
+ * @return La cadena, o NULL si el token no es una cadena o tiene un
+ *         escape no admitido
+ */
+const char *json_tok_str(char *js, const json_tok_t *t);
+
+#endif // JSON_TOK_H
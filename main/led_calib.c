@@ -0,0 +1,74 @@
+/**
+ * @file led_calib.c
+ * @brief Implementación de la calibración de color
+ *
+ * Las matrices se normalizan al blanco objetivo al configurarlas, de modo
+ * que el paso por píxel es una sola multiplicación matriz-vector en Q12.
+ * La tabla de gamma se calcula una vez al iniciar (es el único sitio con
+ * coma flotante).
+ */
+
+#include "led_calib.h"
+#include <math.h>
+#include <string.h>
+
+void led_calib_init(led_calib_t *cal, int gamma_x100)
+{
+    const float gamma = gamma_x100 / 100.0f;
+#ifdef CONFIG_LED_HDR
+    for (int k = 0; k <= 256; k++) {
+        long v = lroundf(powf(k / 256.0f, gamma) * 65536.0f);
+        cal->lin[k] = v > 0xFFFF ? 0xFFFF : v;
+    }
+#else
+    for (int v = 0; v < 256; v++) {
+        cal->lin[v] = (uint16_t)lroundf(powf(v / 255.0f, gamma) * LED_CALIB_ONE);
+    }
+#endif
+    led_calib_clear(cal);
+}
+
+void led_calib_clear(led_calib_t *cal)
+{
+    memset(cal->coef, 0, sizeof(cal->coef));
+    for (int c = 0; c < 3; c++) {
+        cal->coef[0][c * 4] = LED_CALIB_ONE;
+    }
+    memset(cal->seg_of, 0, sizeof(cal->seg_of));
+}
+
+esp_err_t led_calib_set_segment(led_calib_t *cal, int index, const led_calib_segment_t *seg)
+{
+    if (index < 0 || index >= LED_CALIB_MAX_SEGMENTS || seg == NULL ||
+        seg->start + seg->count > CONFIG_LED_NUM_LEDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Fila i escalada para que su suma sea white[i]: M * (1, 1, 1) = blanco
+    int16_t coef[9];
+    for (int i = 0; i < 3; i++) {
+        const int32_t *row = seg->matrix[i];
+        int64_t sum = (int64_t)row[0] + row[1] + row[2];
+        if (sum == 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (int j = 0; j < 3; j++) {
+            int64_t q16 = ((int64_t)seg->white[i] * row[j]) / sum;
+            int64_t q12 = (q16 + (1 << 3)) >> (16 - LED_CALIB_SHIFT);
+            if (q12 <= INT16_MIN || q12 > INT16_MAX) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            coef[i * 3 + j] = (int16_t)q12;
+        }
+    }
+
+    const uint8_t id = index + 1;
+    memcpy(cal->coef[id], coef, sizeof(coef));
+    for (int k = 0; k < CONFIG_LED_NUM_LEDS; k++) {
+        if (cal->seg_of[k] == id) {
+            cal->seg_of[k] = 0;
+        }
+    }
+    memset(cal->seg_of + seg->start, id, seg->count);
+    return ESP_OK;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file led_calib.h
+ * @brief Calibración de color por segmentos y corrección gamma
+ *
+ * Tiras de lotes distintos en una misma instalación no dan el mismo color
+ * para el mismo valor RGB. La calibración corrige cada segmento de la
+ * tira con una matriz 3x3 y un blanco objetivo:
+ *
+ *   lineal = gamma(rgb)                    (tabla de 256 entradas)
+ *   salida = M * lineal                    (M normalizada al blanco)
+ *
+ * La matriz mezcla canales (p.ej. un verde que tira a amarillo se corrige
+ * restando algo de rojo) y el blanco fija la salida para la entrada
+ * blanca: cada fila de M se escala para que M * (1, 1, 1) sea el blanco
+ * objetivo. Así se igualan el tono y el balance de blancos de todos los
+ * segmentos con una sola transformación.
+ *
+ * En tiras RGBW la matriz corrige R, G y B, y el canal blanco solo pasa
+ * por la gamma (led_calib_white()).
+ *
+ * Todo se aplica en punto fijo en el mismo recorrido que envía los
+ * píxeles a la tira (led_control_show()): tres lecturas de tabla y nueve
+ * multiplicaciones por píxel, sin buffers intermedios. Los LEDs que no
+ * están en ningún segmento solo reciben la gamma.
+ *
+ * Con CONFIG_LED_HDR la entrada es de 16 bits por canal: la gamma se
+ * interpola en una tabla de 257 puntos, la luz lineal va en Q16 y la
+ * salida se deja en 16 bits para que la cuantización a 8 bits (con
+ * dither) se haga una sola vez al codificar el frame (led_chipset.h).
+ *
+ * Este módulo no tiene estado global ni locks: led_control guarda su
+ * led_calib_t y lo protege con el mutex de la tira.
+ */
+
+#ifndef LED_CALIB_H
+#define LED_CALIB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#define LED_CALIB_MAX_SEGMENTS  8
+
+// Luz lineal en Q12: 4096 = 1.0
+#define LED_CALIB_SHIFT         12
+#define LED_CALIB_ONE           (1 << LED_CALIB_SHIFT)
+
+/**
+ * @brief Calibración de un segmento de la tira
+ */
+typedef struct {
+    uint16_t start;             ///< Primer LED del segmento
+    uint16_t count;             ///< Número de LEDs
+    int32_t matrix[3][3];       ///< Fila i: mezcla de (R, G, B) para el canal i (Q16.16)
+    int32_t white[3];           ///< Salida lineal para la entrada blanca (Q16.16, 1.0 = máximo)
+} led_calib_segment_t;
+
+/**
+ * @brief Estado de la calibración de una tira
+ */
+typedef struct {
+#ifdef CONFIG_LED_HDR
+    uint16_t lin[257];                              ///< Gamma: entrada / 256 -> lineal (Q16)
+#else
+    uint16_t lin[256];                              ///< Gamma: byte -> lineal (Q12)
+#endif
+    int16_t coef[LED_CALIB_MAX_SEGMENTS + 1][9];    ///< M normalizada (Q12); la 0 es la identidad
+    uint8_t seg_of[CONFIG_LED_NUM_LEDS];            ///< Índice en coef de cada LED
+} led_calib_t;
+
+/**
+ * @brief Inicializa la calibración sin segmentos
+ *
+ * @param cal        Calibración
+ * @param gamma_x100 Exponente de la gamma por 100 (100 = sin gamma)
+ */
+void led_calib_init(led_calib_t *cal, int gamma_x100);
+
+/**
+ * @brief Configura (o sustituye) la calibración de un segmento
+ *
+ * Los segmentos pueden solaparse: en los LEDs comunes manda el último
+ * configurado.
+ *
+ * @param cal   Calibración
+ * @param index Segmento (0 a LED_CALIB_MAX_SEGMENTS - 1)
+ * @param seg   Rango, matriz y blanco
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si el índice o el rango no son
+ *         válidos, una fila de la matriz suma cero o algún coeficiente
+ *         normalizado no está en (-8, 8)
+ */
+esp_err_t led_calib_set_segment(led_calib_t *cal, int index, const led_calib_segment_t *seg);
+
+/**
+ * @brief Quita todos los segmentos (solo queda la gamma)
+ */
+void led_calib_clear(led_calib_t *cal);
+
+#ifndef CONFIG_LED_HDR
+/**
+ * @brief Calcula el valor calibrado del LED i
+ *
+ * @param cal Calibración
+ * @param i   Índice del LED en la tira (< CONFIG_LED_NUM_LEDS)
+ * @param in  Color de entrada (R, G, B)
+ * @param out Color a enviar a la tira (R, G, B)
+ */
+static inline void led_calib_pixel(const led_calib_t *cal, size_t i, const uint8_t *in,
+                                   uint8_t *out)
+{
+    const int16_t *m = cal->coef[cal->seg_of[i]];
+    const int32_t r = cal->lin[in[0]];
+    const int32_t g = cal->lin[in[1]];
+    const int32_t b = cal->lin[in[2]];
+
+    for (int c = 0; c < 3; c++, m += 3) {
+        int32_t v = (m[0] * r + m[1] * g + m[2] * b + (LED_CALIB_ONE / 2)) >> LED_CALIB_SHIFT;
+        if (v < 0) {
+            v = 0;
+        } else if (v > LED_CALIB_ONE) {
+            v = LED_CALIB_ONE;
+        }
+        out[c] = (uint8_t)((v * 255 + (LED_CALIB_ONE / 2)) >> LED_CALIB_SHIFT);
+    }
+}
+
+/**
+ * @brief Valor a enviar a la tira para el canal blanco de un LED RGBW
+ */
+static inline uint8_t led_calib_white(const led_calib_t *cal, uint8_t w)
+{
+    return (uint8_t)((cal->lin[w] * 255 + (LED_CALIB_ONE / 2)) >> LED_CALIB_SHIFT);
+}
+
+#else
+/**
+ * @brief Gamma de un canal de 16 bits: luz lineal en Q16 (65535 = 1.0)
+ */
+static inline uint32_t led_calib_lin16(const led_calib_t *cal, uint16_t v)
+{
+    uint32_t k = v >> 8;
+    uint32_t a = cal->lin[k];
+    uint32_t b = cal->lin[k + 1];
+    return a + (((b - a) * (v & 0xFF)) >> 8);   // La tabla es creciente
+}
+
+/**
+ * @brief Calcula el valor calibrado del LED i con 16 bits por canal
+ *
+ * @param in  Color de entrada (R, G, B, 16 bits)
+ * @param out Luz lineal a enviar (R, G, B, 0-65535), sin cuantizar
+ */
+static inline void led_calib_pixel16(const led_calib_t *cal, size_t i, const uint16_t *in,
+                                     uint16_t *out)
+{
+    const int16_t *m = cal->coef[cal->seg_of[i]];
+    const int64_t r = led_calib_lin16(cal, in[0]);
+    const int64_t g = led_calib_lin16(cal, in[1]);
+    const int64_t b = led_calib_lin16(cal, in[2]);
+
+    for (int c = 0; c < 3; c++, m += 3) {
+        int32_t v = (int32_t)((m[0] * r + m[1] * g + m[2] * b + (LED_CALIB_ONE / 2))
+                              >> LED_CALIB_SHIFT);
+        out[c] = v < 0 ? 0 : (v > 0xFFFF ? 0xFFFF : v);
+    }
+}
+#endif
+
+#endif // LED_CALIB_H
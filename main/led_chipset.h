@@ -0,0 +1,260 @@
+/**
+ * @file led_chipset.h
+ * @brief Capa de chipset: formato del cable y periférico de salida
+ *
+ * led_control trabaja con frames en el formato de la tira (LED_CHANNELS
+ * bytes por píxel). Por debajo, el chipset elegido en menuconfig decide:
+ *
+ * - Cómo se codifica el frame en los bytes que viajan por el cable
+ *   (orden de canales, cabeceras, brillo global...)
+ * - Qué periférico los envía
+ *
+ * CHIPSETS:
+ * ========
+ * - WS2812B / SK6812 (RMT): un hilo a 800 kbit/s. Cable: G, R, B (y W)
+ *   por píxel; el RMT convierte cada bit en un pulso largo o corto.
+ *   Necesita un silencio de reset de al menos 80 us entre frames.
+ * - WS2812B en paralelo (I2S, LCD_CAM o PARLIO con DMA): la tira se
+ *   reparte en 2 a 16 tiras, una por línea de un bus paralelo; los bytes
+ *   de las tiras se trasponen para que cada palabra del bus lleve un bit
+ *   de cada una (ver led_chipset_parallel.c). En el cable va el frame
+ *   completo de todas, así que LED_CHIPSET_WIRE_BYTES no depende de n.
+ * - APA102 / SK9822 (SPI con DMA): datos y reloj, a varios MHz. Cable:
+ *   32 bits a cero de inicio, por píxel 0xE0 | brillo (5 bits), B, G, R,
+ *   y una cola de bits de reloj para que el dato llegue al último LED
+ *   (en SK9822 precedida de otros 32 bits a cero para que latche).
+ *
+ * El frame se codifica una sola vez y en la misma pasada se aplica la
+ * calibración de color (led_calib.h) si se pasa una. Con CONFIG_LED_HDR
+ * es también el único punto donde los canales de 16 bits se cuantizan a
+ * 8, opcionalmente con dither (CONFIG_LED_DITHER).
+ *
+ * El envío no bloquea: led_chipset_transmit() arranca el periférico y
+ * vuelve, y led_chipset_wait() espera a que el frame salga y pase el
+ * silencio de reset. Así led_control puede codificar el frame N+1 en otro
+ * buffer mientras el N está en el cable, y el N+1 sale en cuanto acaba el
+ * reset del N. El límite de fps es entonces el tiempo en el cable
+ * (led_chipset_wire_us()), no la suma de codificar y enviar.
+ *
+ * El orden de los canales en el cable (CONFIG_LED_COLOR_ORDER) es una
+ * constante de compilación. Con CONFIG_LED_STRIP_FIXED, además, los
+ * frames completos (led_control_show() de toda la tira) y los rellenos de
+ * un color (led_set_all(), led_clear()) van por versiones del encoder
+ * especializadas con longitud y paso constantes; el resto de llamadas
+ * sigue por la versión genérica. El benchmark de efectos compara ambas.
+ *
+ * En los chipsets de una sola cadena (WS2812B por RMT, APA102, SK9822) los
+ * datos pasan de LED en LED desde el principio de la tira: un frame con
+ * solo los n primeros LEDs cambia esos n y el resto conserva lo último que
+ * latchó. Lo indica LED_CHIPSET_PARTIAL y el render stage lo aprovecha
+ * para las actualizaciones parciales (led_render_update_pixels()). En
+ * paralelo cada línea lleva un trozo de la tira, así que se envía siempre
+ * el frame completo.
+ *
+ * Solo se compila el backend del chipset configurado; todos implementan
+ * las mismas funciones.
+ */
+
+#ifndef LED_CHIPSET_H
+#define LED_CHIPSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_calib.h"
+#include "led_control.h"
+#include "sdkconfig.h"
+
+#if defined(CONFIG_LED_CHIPSET_APA102) || defined(CONFIG_LED_CHIPSET_SK9822)
+#define LED_CHIPSET_CLOCKED 1
+// Inicio + píxeles + reset de SK9822 + medio bit de reloj por LED
+#define LED_CHIPSET_WIRE_BYTES(n)   (4 + (n) * 4 + 4 + ((n) + 15) / 16)
+#elif defined(CONFIG_LED_CHIPSET_WS2812_PARALLEL)
+// La tira se reparte en CONFIG_LED_PARALLEL_LANES tiras iguales
+#define LED_PARALLEL_PER_LANE   \
+    ((CONFIG_LED_NUM_LEDS + CONFIG_LED_PARALLEL_LANES - 1) / CONFIG_LED_PARALLEL_LANES)
+#define LED_PARALLEL_BUS_WIDTH  (CONFIG_LED_PARALLEL_LANES > 8 ? 16 : 8)
+// Tres palabras del bus por bit de WS2812B (1.25 us)
+#define LED_PARALLEL_SLOT_HZ    2400000
+// Palabras a 0 al final del frame: 80 us de reset
+#define LED_PARALLEL_RESET_SLOTS 192
+#if defined(CONFIG_IDF_TARGET_ESP32)
+#define LED_PARALLEL_PERIPH     "I2S"
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+#define LED_PARALLEL_PERIPH     "LCD_CAM"
+#else
+#define LED_PARALLEL_PERIPH     "PARLIO"
+#endif
+// Por LED de cada tira, 24 bits de 3 palabras; después el reset
+#define LED_CHIPSET_WIRE_BYTES(n)   \
+    ((LED_PARALLEL_PER_LANE * 24 * 3 + LED_PARALLEL_RESET_SLOTS) * (LED_PARALLEL_BUS_WIDTH / 8))
+#else
+#define LED_CHIPSET_WIRE_BYTES(n)   ((n) * LED_CHANNELS)
+#endif
+
+// Un frame de los primeros n LEDs deja los demás como estaban
+#ifndef CONFIG_LED_CHIPSET_WS2812_PARALLEL
+#define LED_CHIPSET_PARTIAL 1
+#endif
+
+// Orden de los canales en el cable: índice en R, G, B de cada byte enviado
+#if defined(CONFIG_LED_ORDER_RGB)
+#define LED_WIRE_C0 0
+#define LED_WIRE_C1 1
+#define LED_WIRE_C2 2
+#elif defined(CONFIG_LED_ORDER_RBG)
+#define LED_WIRE_C0 0
+#define LED_WIRE_C1 2
+#define LED_WIRE_C2 1
+#elif defined(CONFIG_LED_ORDER_BRG)
+#define LED_WIRE_C0 2
+#define LED_WIRE_C1 0
+#define LED_WIRE_C2 1
+#elif defined(CONFIG_LED_ORDER_BGR)
+#define LED_WIRE_C0 2
+#define LED_WIRE_C1 1
+#define LED_WIRE_C2 0
+#elif defined(CONFIG_LED_ORDER_GBR)
+#define LED_WIRE_C0 1
+#define LED_WIRE_C1 2
+#define LED_WIRE_C2 0
+#else   // GRB
+#define LED_WIRE_C0 1
+#define LED_WIRE_C1 0
+#define LED_WIRE_C2 2
+#endif
+
+// Con CONFIG_LED_STRIP_FIXED los backends instancian su encoder con la
+// longitud, el paso y la calibración constantes para los frames completos
+// de la tira, y desenrollan el bucle de píxeles
+#ifdef CONFIG_LED_STRIP_FIXED
+#define LED_CHIPSET_UNROLL  _Pragma("GCC unroll 4")
+#else
+#define LED_CHIPSET_UNROLL
+#endif
+
+/** Nombre del chipset configurado (para el log) */
+extern const char *const led_chipset_name;
+
+/**
+ * @brief Inicializa el periférico de salida
+ *
+ * @param max_bytes Tamaño máximo de un frame codificado
+ */
+esp_err_t led_chipset_init(size_t max_bytes);
+
+/**
+ * @brief Codifica un frame en el formato del cable
+ *
+ * @param wire     Destino, al menos LED_CHIPSET_WIRE_BYTES(num_leds) bytes
+ *                 (alineado a 4 bytes)
+ * @param px       Píxeles en el formato de la tira (LED_CHANNELS canales)
+ * @param stride   Canales entre píxeles de px (0 repite el mismo píxel)
+ * @param num_leds Número de píxeles
+ * @param cal      Calibración a aplicar, o NULL
+ * @param frame    Número de frame (fase del dither)
+ * @return Bytes escritos en wire
+ */
+size_t led_chipset_encode(uint8_t *wire, const led_chan_t *px, size_t stride,
+                          size_t num_leds, const led_calib_t *cal, uint32_t frame);
+
+/**
+ * @brief Empieza a enviar un frame codificado (no espera a que termine)
+ *
+ * Debe llamarse después de led_chipset_wait(). wire no puede modificarse
+ * hasta que la siguiente llamada a led_chipset_wait() devuelva.
+ *
+ * @param wire Frame codificado (en memoria con capacidad DMA)
+ * @param len  Bytes devueltos por led_chipset_encode()
+ */
+esp_err_t led_chipset_transmit(const uint8_t *wire, size_t len);
+
+/**
+ * @brief Espera a que el último frame salga y la tira esté lista
+ *
+ * Incluye el silencio de reset que necesitan los chips de un hilo para
+ * latchar. Vuelve enseguida si no hay nada en curso.
+ */
+esp_err_t led_chipset_wait(void);
+
+/**
+ * @brief Tiempo que ocupa en el cable un frame de len bytes (reset incluido)
+ *
+ * Es el mínimo entre dos frames: 1e6 / led_chipset_wire_us() es el
+ * máximo teórico de fps de la tira.
+ */
+uint32_t led_chipset_wire_us(size_t len);
+
+/**
+ * @brief Rellenos que llegaron tarde desde el arranque (frame corrupto)
+ *
+ * Solo puede ocurrir en el RMT, cuando la interrupción que rellena su
+ * memoria se retrasa más de lo que tarda en salir media memoria (ver
+ * led_chipset_rmt.c). En SPI es siempre 0.
+ */
+uint32_t led_chipset_underruns(void);
+
+#ifdef CONFIG_LED_HDR
+/**
+ * @brief Umbral de cuantización del LED i en un frame (Q16)
+ *
+ * Con dither es un patrón de Bayer 1D de 16 niveles que avanza un paso
+ * por frame: LEDs vecinos tienen umbrales lejanos y cada LED recorre los
+ * 16 en 16 frames, así que la media en el tiempo conserva 4 bits más de
+ * los que caben en el cable. Sin dither es un redondeo normal.
+ */
+static inline uint32_t led_chipset_threshold(size_t i, uint32_t frame)
+{
+#ifdef CONFIG_LED_DITHER
+    static const uint8_t bayer[16] = {
+        0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15,
+    };
+    // Entre 2048 y 63488: 65535 da siempre 255 y 0 siempre 0
+    return bayer[(i + frame) & 15] * 4096 + 2048;
+#else
+    return 32768;
+#endif
+}
+#endif
+
+/**
+ * @brief Bytes a enviar de un píxel: calibración (si hay) y cuantización
+ *
+ * @param cal   Calibración, o NULL
+ * @param i     Índice del LED
+ * @param px    Píxel en el formato de la tira
+ * @param frame Número de frame (fase del dither)
+ * @param out   LED_CHANNELS bytes en orden R, G, B (W)
+ */
+static inline void led_chipset_pixel(const led_calib_t *cal, size_t i, const led_chan_t *px,
+                                     uint32_t frame, uint8_t *out)
+{
+#ifdef CONFIG_LED_HDR
+    uint16_t lin[LED_CHANNELS];
+    const uint16_t *v = px;
+    if (cal != NULL) {
+        led_calib_pixel16(cal, i, px, lin);
+#if LED_CHANNELS == 4
+        lin[3] = led_calib_lin16(cal, px[3]);
+#endif
+        v = lin;
+    }
+    uint32_t d = led_chipset_threshold(i, frame);
+    for (int c = 0; c < LED_CHANNELS; c++) {
+        out[c] = (uint8_t)((v[c] * 255u + d) >> 16);
+    }
+#else
+    if (cal == NULL) {
+        for (int c = 0; c < LED_CHANNELS; c++) {
+            out[c] = px[c];
+        }
+        return;
+    }
+    led_calib_pixel(cal, i, px, out);
+#if LED_CHANNELS == 4
+    out[3] = led_calib_white(cal, px[3]);
+#endif
+#endif
+}
+
+#endif // LED_CHIPSET_H
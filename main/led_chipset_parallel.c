@@ -0,0 +1,297 @@
+/**
+ * @file led_chipset_parallel.c
+ * @brief Backend WS2812B en paralelo: hasta 16 tiras con un solo periférico
+ *
+ * Un canal RMT por tira se queda corto en instalaciones grandes. Aquí la
+ * tira configurada (LED_NUM_LEDS) se reparte en CONFIG_LED_PARALLEL_LANES
+ * tiras de LED_PARALLEL_PER_LANE LEDs, una por línea de datos de un bus
+ * paralelo de 8 o 16 bits con DMA:
+ *
+ * - ESP32: I2S en modo LCD; ESP32-S3: LCD_CAM (los dos con el bus i80
+ *   de esp_lcd)
+ * - ESP32-C6 / P4: PARLIO
+ *
+ * Cada bit de WS2812B (1.25 us) son tres palabras del bus a 2.4 MHz: todas
+ * las líneas a 1, el bit de cada tira, todas a 0. Un 0 queda alto 0.42 us
+ * y un 1, 0.83 us. La palabra del medio se obtiene trasponiendo los bytes
+ * de las tiras: transpose8() convierte 8 bytes (uno por tira) en 8
+ * palabras (una por bit) con unas pocas operaciones de 32 bits.
+ *
+ * El frame acaba con palabras a 0 que hacen de reset, así que la tira
+ * latcha sin esperas adicionales.
+ */
+
+#include "led_chipset.h"
+
+#ifdef CONFIG_LED_CHIPSET_WS2812_PARALLEL
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "soc/soc_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#if SOC_LCD_I80_SUPPORTED
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_io_i80.h"
+#else
+#include "driver/parlio_tx.h"
+#endif
+
+static const char *TAG = "LED_PARALLEL";
+
+const char *const led_chipset_name = "WS2812B paralelo (" LED_PARALLEL_PERIPH ")";
+
+#if LED_PARALLEL_BUS_WIDTH == 16
+typedef uint16_t slot_t;
+#else
+typedef uint8_t slot_t;
+#endif
+
+// Líneas con tira: todas a 1 en la primera palabra de cada bit
+#define LANE_MASK           ((slot_t)((1u << CONFIG_LED_PARALLEL_LANES) - 1))
+
+#if SOC_LCD_I80_SUPPORTED
+static esp_lcd_i80_bus_handle_t s_bus;
+static esp_lcd_panel_io_handle_t s_io;
+static SemaphoreHandle_t s_done;
+static bool s_pending;
+
+/**
+ * @brief Fin de la transferencia (ISR)
+ */
+static bool IRAM_ATTR tx_done_cb(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata,
+                                 void *user_ctx)
+{
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(s_done, &woken);
+    return woken == pdTRUE;
+}
+#else
+static parlio_tx_unit_handle_t s_unit;
+#endif
+
+/**
+ * @brief Lee las GPIO de datos de CONFIG_LED_PARALLEL_GPIOS ("13,12,...")
+ *
+ * @return Número de GPIO leídas
+ */
+static int parse_gpios(int *gpios, int max)
+{
+    const char *p = CONFIG_LED_PARALLEL_GPIOS;
+    int n = 0;
+    while (*p != '\0' && n < max) {
+        char *end;
+        long v = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        gpios[n++] = (int)v;
+        p = end;
+        while (*p == ',' || *p == ' ') {
+            p++;
+        }
+    }
+    return n;
+}
+
+esp_err_t led_chipset_init(size_t max_bytes)
+{
+    int gpios[LED_PARALLEL_BUS_WIDTH];
+    for (int i = 0; i < LED_PARALLEL_BUS_WIDTH; i++) {
+        gpios[i] = -1;
+    }
+    if (parse_gpios(gpios, LED_PARALLEL_BUS_WIDTH) != CONFIG_LED_PARALLEL_LANES) {
+        ESP_LOGE(TAG, "LED_PARALLEL_GPIOS debe tener %d GPIO", CONFIG_LED_PARALLEL_LANES);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if SOC_LCD_I80_SUPPORTED
+    // El bus i80 rechaza GPIO negativas en DC y en cualquiera de sus 8 o 16
+    // líneas: DC y las líneas sin tira van a la GPIO de reserva
+    for (int i = CONFIG_LED_PARALLEL_LANES; i < LED_PARALLEL_BUS_WIDTH; i++) {
+        gpios[i] = CONFIG_LED_PARALLEL_SPARE_GPIO;
+    }
+    esp_lcd_i80_bus_config_t bus_config = {
+        .dc_gpio_num = CONFIG_LED_PARALLEL_SPARE_GPIO,
+        .wr_gpio_num = CONFIG_LED_PARALLEL_CLOCK_GPIO,
+        .clk_src = LCD_CLK_SRC_DEFAULT,
+        .bus_width = LED_PARALLEL_BUS_WIDTH,
+        .max_transfer_bytes = max_bytes,
+    };
+    memcpy(bus_config.data_gpio_nums, gpios, sizeof(gpios));
+    esp_err_t err = esp_lcd_new_i80_bus(&bus_config, &s_bus);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    s_done = xSemaphoreCreateBinary();
+    const esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num = -1,
+        .pclk_hz = LED_PARALLEL_SLOT_HZ,
+        .trans_queue_depth = 1,
+        .on_color_trans_done = tx_done_cb,
+        .lcd_cmd_bits = 8,
+        .lcd_param_bits = 8,
+    };
+    err = esp_lcd_new_panel_io_i80(s_bus, &io_config, &s_io);
+#else
+    parlio_tx_unit_config_t config = {
+        .clk_src = PARLIO_CLK_SRC_DEFAULT,
+        .data_width = LED_PARALLEL_BUS_WIDTH,
+        .clk_in_gpio_num = -1,
+        .valid_gpio_num = -1,
+        .clk_out_gpio_num = CONFIG_LED_PARALLEL_CLOCK_GPIO,
+        .output_clk_freq_hz = LED_PARALLEL_SLOT_HZ,
+        .trans_queue_depth = 1,
+        .max_transfer_size = max_bytes,
+        .sample_edge = PARLIO_SAMPLE_EDGE_POS,
+        .bit_pack_order = PARLIO_BIT_PACK_ORDER_LSB,
+    };
+    memcpy(config.data_gpio_nums, gpios, sizeof(gpios));
+    esp_err_t err = parlio_new_tx_unit(&config, &s_unit);
+    if (err == ESP_OK) {
+        err = parlio_tx_unit_enable(s_unit);
+    }
+#endif
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ESP_LOGI(TAG, "%d tiras de %d LEDs por %s (%d bits), %u bytes por frame",
+             CONFIG_LED_PARALLEL_LANES, LED_PARALLEL_PER_LANE, LED_PARALLEL_PERIPH,
+             LED_PARALLEL_BUS_WIDTH, (unsigned)max_bytes);
+    return ESP_OK;
+}
+
+/**
+ * @brief Traspone una matriz de 8x8 bits
+ *
+ * in[k] es el byte de la tira k; out[b] lleva en el bit k el bit 7 - b de
+ * in[k] (out[0] son los bits más significativos, que salen primero). Es
+ * la trasposición de Hacker's Delight en tres pasos de intercambio sobre
+ * dos palabras de 32 bits.
+ */
+FORCE_INLINE_ATTR void transpose8(const uint8_t *in, uint8_t *out)
+{
+    // Orden inverso: la tira k acaba en el bit k y no en el 7 - k
+    uint32_t x = ((uint32_t)in[7] << 24) | (in[6] << 16) | (in[5] << 8) | in[4];
+    uint32_t y = ((uint32_t)in[3] << 24) | (in[2] << 16) | (in[1] << 8) | in[0];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x ^= t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC; x ^= t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC; y ^= t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+
+    out[0] = t >> 24; out[1] = t >> 16; out[2] = t >> 8; out[3] = t;
+    out[4] = y >> 24; out[5] = y >> 16; out[6] = y >> 8; out[7] = y;
+}
+
+/**
+ * @brief Cuerpo del encoder: píxeles de todas las tiras traspuestos y reset
+ *
+ * Se instancia con parámetros constantes para los frames completos en
+ * led_chipset_encode().
+ */
+FORCE_INLINE_ATTR size_t encode(uint8_t *wire, const led_chan_t *px, size_t stride,
+                                size_t num_leds, const led_calib_t *cal, uint32_t frame)
+{
+    static const uint8_t order[3] = { LED_WIRE_C0, LED_WIRE_C1, LED_WIRE_C2 };
+    slot_t *out = (slot_t *)wire;
+    uint8_t c[LED_PARALLEL_BUS_WIDTH][LED_CHANNELS];
+    uint8_t lanes[LED_PARALLEL_BUS_WIDTH];
+    uint8_t bits[LED_PARALLEL_BUS_WIDTH];
+
+    memset(c, 0, sizeof(c));
+    for (int j = 0; j < LED_PARALLEL_PER_LANE; j++) {
+        for (int k = 0; k < CONFIG_LED_PARALLEL_LANES; k++) {
+            size_t i = (size_t)k * LED_PARALLEL_PER_LANE + j;
+            if (i < num_leds) {
+                led_chipset_pixel(cal, i, px + i * stride, frame, c[k]);
+            } else {
+                memset(c[k], 0, LED_CHANNELS);
+            }
+        }
+
+        for (int ch = 0; ch < 3; ch++) {
+            for (int k = 0; k < LED_PARALLEL_BUS_WIDTH; k++) {
+                lanes[k] = c[k][order[ch]];
+            }
+            transpose8(lanes, bits);
+#if LED_PARALLEL_BUS_WIDTH == 16
+            transpose8(lanes + 8, bits + 8);
+#endif
+            for (int b = 0; b < 8; b++) {
+                out[0] = LANE_MASK;
+#if LED_PARALLEL_BUS_WIDTH == 16
+                out[1] = bits[b] | (bits[8 + b] << 8);
+#else
+                out[1] = bits[b];
+#endif
+                out[2] = 0;
+                out += 3;
+            }
+        }
+    }
+
+    memset(out, 0, LED_PARALLEL_RESET_SLOTS * sizeof(slot_t));
+    out += LED_PARALLEL_RESET_SLOTS;
+    return (uint8_t *)out - wire;
+}
+
+size_t IRAM_ATTR led_chipset_encode(uint8_t *wire, const led_chan_t *px, size_t stride,
+                                    size_t num_leds, const led_calib_t *cal, uint32_t frame)
+{
+#ifdef CONFIG_LED_STRIP_FIXED
+    if (num_leds == LED_NUM_LEDS && stride == LED_CHANNELS) {
+        return cal != NULL ? encode(wire, px, LED_CHANNELS, LED_NUM_LEDS, cal, frame)
+                           : encode(wire, px, LED_CHANNELS, LED_NUM_LEDS, NULL, frame);
+    }
+#endif
+    return encode(wire, px, stride, num_leds, cal, frame);
+}
+
+esp_err_t led_chipset_transmit(const uint8_t *wire, size_t len)
+{
+#if SOC_LCD_I80_SUPPORTED
+    // Sin fase de comando: solo los datos
+    esp_err_t err = esp_lcd_panel_io_tx_color(s_io, -1, wire, len);
+    s_pending = (err == ESP_OK);
+    return err;
+#else
+    const parlio_transmit_config_t config = { .idle_value = 0 };
+    return parlio_tx_unit_transmit(s_unit, wire, len * 8, &config);
+#endif
+}
+
+esp_err_t led_chipset_wait(void)
+{
+#if SOC_LCD_I80_SUPPORTED
+    if (s_pending) {
+        xSemaphoreTake(s_done, portMAX_DELAY);
+        s_pending = false;
+    }
+    return ESP_OK;
+#else
+    return parlio_tx_unit_wait_all_done(s_unit, -1);
+#endif
+}
+
+uint32_t led_chipset_wire_us(size_t len)
+{
+    size_t slots = len / sizeof(slot_t);
+    return (uint32_t)(((uint64_t)slots * 1000000 + LED_PARALLEL_SLOT_HZ - 1) /
+                      LED_PARALLEL_SLOT_HZ);
+}
+
+uint32_t led_chipset_underruns(void)
+{
+    // El DMA lee el frame entero de memoria
+    return 0;
+}
+
+#endif // CONFIG_LED_CHIPSET_WS2812_PARALLEL
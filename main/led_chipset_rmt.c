@@ -0,0 +1,245 @@
+/**
+ * @file led_chipset_rmt.c
+ * @brief Backend WS2812B / SK6812: un hilo generado con el RMT
+ *
+ * El frame codificado son los bytes G, R, B (W) de cada píxel y
+ * refill_cb() los convierte en pulsos: cada bit es un símbolo del RMT, un
+ * nivel alto seguido de uno bajo, con duraciones distintas para 0 y 1.
+ *
+ * En los chips sin DMA en el RMT (ESP32) la memoria del canal no da para
+ * una tira larga: se usa como ping-pong. El RMT envía una mitad mientras
+ * la ISR rellena la otra con refill_cb(), que está en IRAM y convierte
+ * bytes a símbolos directamente. Cuantos más bloques de memoria
+ * (CONFIG_LED_RMT_MEM_BLOCKS), más latencia de interrupción se tolera.
+ * Si un relleno llega tarde el RMT repite símbolos viejos y el frame sale
+ * corrupto: refill_cb() lo detecta comparando con el instante en que el
+ * RMT llega a esa posición y lo cuenta (led_chipset_underruns()).
+ *
+ * Para que los rellenos no se retrasen mientras se escribe la flash (NVS,
+ * OTA), la ISR del RMT tiene que poder ejecutarse con la caché apagada:
+ * sin DMA el Kconfig de este chipset activa CONFIG_RMT_ISR_IRAM_SAFE, y
+ * todo lo que toca refill_cb() está en IRAM o DRAM, incluidas las
+ * plantillas de símbolo s_bit0 y s_bit1.
+ *
+ * El fin de cada frame lo marca la interrupción de fin de transmisión del
+ * RMT, que guarda el instante: el siguiente frame sale justo al cumplirse
+ * el silencio de reset desde ese momento.
+ */
+
+#include "led_chipset.h"
+
+#ifdef CONFIG_LED_CHIPSET_WS2812
+
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "soc/soc_caps.h"
+#include "driver/rmt_tx.h"
+
+static const char *TAG = "LED_RMT";
+
+const char *const led_chipset_name = LED_CHANNELS == 4 ? "SK6812 RGBW (RMT)" : "WS2812B (RMT)";
+
+// Resolución del RMT: 10 MHz, 0.1 us por tick
+#define RMT_RESOLUTION_HZ   (10 * 1000 * 1000)
+
+// Duraciones de los bits en ticks (alto, bajo)
+#if LED_CHANNELS == 4
+#define T1H 6               // SK6812: 0.6 us / 0.6 us
+#define T1L 6
+#else
+#define T1H 9               // WS2812B: 0.9 us / 0.3 us
+#define T1L 3
+#endif
+#define T0H 3               // 0.3 us / 0.9 us
+#define T0L 9
+
+// Duración de un bit en el cable (igual para 0 y 1)
+#define BIT_TICKS           (T0H + T0L)
+
+// Memoria del canal en símbolos: con DMA es el buffer del DMA; sin DMA,
+// bloques de memoria del RMT (la mitad se rellena mientras sale la otra)
+#if SOC_RMT_SUPPORT_DMA
+#define RMT_MEM_SYMBOLS     1024
+#define RMT_WITH_DMA        1
+#else
+#define RMT_MEM_SYMBOLS     (CONFIG_LED_RMT_MEM_BLOCKS * SOC_RMT_MEM_WORDS_PER_CHANNEL)
+#define RMT_WITH_DMA        0
+#endif
+
+// Silencio mínimo entre frames para que los LEDs latchen (SK6812: 80 us)
+#define RESET_US            80
+
+static rmt_channel_handle_t s_chan;
+static rmt_encoder_handle_t s_encoder;
+static volatile int64_t s_done_us;  // Fin del último frame (lo escribe la ISR)
+static int64_t s_start_us;          // Primer relleno del frame en curso
+static volatile uint32_t s_underruns;
+
+static DRAM_ATTR const rmt_symbol_word_t s_bit0 = { .level0 = 1, .duration0 = T0H, .level1 = 0, .duration1 = T0L };
+static DRAM_ATTR const rmt_symbol_word_t s_bit1 = { .level0 = 1, .duration0 = T1H, .level1 = 0, .duration1 = T1L };
+
+/**
+ * @brief Rellena la memoria del RMT con los bits del frame (ISR)
+ *
+ * Escribe tantos bytes completos como quepan en symbols_free. El primer
+ * relleno (symbols_written == 0) se hace antes de arrancar; los demás,
+ * cada vez que el RMT termina de enviar media memoria. El relleno que
+ * empieza en la posición p tiene que estar escrito antes de que el RMT
+ * llegue a ella, p bits después del arranque.
+ */
+static size_t IRAM_ATTR refill_cb(const void *data, size_t data_size, size_t symbols_written,
+                                  size_t symbols_free, rmt_symbol_word_t *symbols, bool *done,
+                                  void *arg)
+{
+    const uint8_t *bytes = (const uint8_t *)data + symbols_written / 8;
+    size_t left = data_size - symbols_written / 8;
+    size_t n = symbols_free / 8;
+    if (n >= left) {
+        n = left;
+        *done = true;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b = bytes[i];
+        for (int bit = 0; bit < 8; bit++, b <<= 1) {
+            *symbols++ = (b & 0x80) ? s_bit1 : s_bit0;
+        }
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (symbols_written == 0) {
+        s_start_us = now;
+    } else if (now > s_start_us + (int64_t)symbols_written * BIT_TICKS /
+                                  (RMT_RESOLUTION_HZ / 1000000)) {
+        s_underruns++;
+    }
+    return n * 8;
+}
+
+/**
+ * @brief Fin de transmisión (ISR): marca el inicio del silencio de reset
+ */
+static bool IRAM_ATTR tx_done_cb(rmt_channel_handle_t chan, const rmt_tx_done_event_data_t *edata,
+                                 void *user_ctx)
+{
+    s_done_us = esp_timer_get_time();
+    return false;
+}
+
+esp_err_t led_chipset_init(size_t max_bytes)
+{
+    const rmt_tx_channel_config_t chan_config = {
+        .gpio_num = CONFIG_BLINK_GPIO,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = RMT_RESOLUTION_HZ,
+        .mem_block_symbols = RMT_MEM_SYMBOLS,
+        .trans_queue_depth = 1,
+        .flags.with_dma = RMT_WITH_DMA,
+    };
+    esp_err_t err = rmt_new_tx_channel(&chan_config, &s_chan);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const rmt_simple_encoder_config_t enc_config = {
+        .callback = refill_cb,
+        .min_chunk_size = 8,    // Un byte
+    };
+    err = rmt_new_simple_encoder(&enc_config, &s_encoder);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const rmt_tx_event_callbacks_t cbs = { .on_trans_done = tx_done_cb };
+    err = rmt_tx_register_event_callbacks(s_chan, &cbs, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ESP_LOGI(TAG, "%s en GPIO %d, %u bytes por frame, %s de %d símbolos", led_chipset_name,
+             CONFIG_BLINK_GPIO, (unsigned)max_bytes, RMT_WITH_DMA ? "DMA" : "ping-pong",
+             RMT_MEM_SYMBOLS);
+    return rmt_enable(s_chan);
+}
+
+/**
+ * @brief Cuerpo del encoder: G, R, B (W) de cada píxel en el orden del cable
+ *
+ * Se instancia con parámetros constantes para los casos especializados
+ * de led_chipset_encode().
+ */
+FORCE_INLINE_ATTR size_t encode(uint8_t *wire, const led_chan_t *px, size_t stride,
+                                size_t num_leds, const led_calib_t *cal, uint32_t frame)
+{
+    uint8_t *out = wire;
+    uint8_t c[LED_CHANNELS];
+
+    LED_CHIPSET_UNROLL
+    for (size_t i = 0; i < num_leds; i++, px += stride) {
+        led_chipset_pixel(cal, i, px, frame, c);
+        *out++ = c[LED_WIRE_C0];
+        *out++ = c[LED_WIRE_C1];
+        *out++ = c[LED_WIRE_C2];
+#if LED_CHANNELS == 4
+        *out++ = c[3];
+#endif
+    }
+    return out - wire;
+}
+
+size_t IRAM_ATTR led_chipset_encode(uint8_t *wire, const led_chan_t *px, size_t stride,
+                                    size_t num_leds, const led_calib_t *cal, uint32_t frame)
+{
+#ifdef CONFIG_LED_STRIP_FIXED
+    if (num_leds == LED_NUM_LEDS) {
+        if (stride == LED_CHANNELS) {
+            return cal != NULL ? encode(wire, px, LED_CHANNELS, LED_NUM_LEDS, cal, frame)
+                               : encode(wire, px, LED_CHANNELS, LED_NUM_LEDS, NULL, frame);
+        }
+#ifndef CONFIG_LED_DITHER
+        if (stride == 0 && cal == NULL) {
+            // Un color: se codifica un píxel y se copia (sin dither son iguales)
+            encode(wire, px, 0, 1, NULL, frame);
+            for (size_t i = 1; i < LED_NUM_LEDS; i++) {
+                memcpy(wire + i * LED_CHANNELS, wire, LED_CHANNELS);
+            }
+            return LED_NUM_LEDS * LED_CHANNELS;
+        }
+#endif
+    }
+#endif
+    return encode(wire, px, stride, num_leds, cal, frame);
+}
+
+esp_err_t led_chipset_transmit(const uint8_t *wire, size_t len)
+{
+    const rmt_transmit_config_t tx_config = { .loop_count = 0 };
+    return rmt_transmit(s_chan, s_encoder, wire, len, &tx_config);
+}
+
+esp_err_t led_chipset_wait(void)
+{
+    esp_err_t err = rmt_tx_wait_all_done(s_chan, -1);
+
+    int64_t idle = esp_timer_get_time() - s_done_us;
+    if (idle < RESET_US) {
+        esp_rom_delay_us(RESET_US - idle);
+    }
+    return err;
+}
+
+uint32_t led_chipset_wire_us(size_t len)
+{
+    return (uint32_t)(((uint64_t)len * 8 * BIT_TICKS * 1000000 + RMT_RESOLUTION_HZ - 1) /
+                      RMT_RESOLUTION_HZ) + RESET_US;
+}
+
+uint32_t led_chipset_underruns(void)
+{
+    return s_underruns;
+}
+
+#endif // CONFIG_LED_CHIPSET_WS2812
@@ -0,0 +1,188 @@
+/**
+ * @file led_chipset_spi.c
+ * @brief Backend APA102 / SK9822: datos y reloj por SPI con DMA
+ *
+ * Estos LEDs no tienen requisitos de tiempo: cada LED toma su píxel y
+ * reenvía el resto con el reloj. El bus puede ir a varios MHz, así que
+ * una tira larga se refresca en una fracción del tiempo de una WS2812.
+ *
+ * Cada píxel lleva un campo de brillo global de 5 bits
+ * (CONFIG_LED_CHIPSET_BRIGHTNESS). En SK9822 regula la corriente del
+ * LED; en APA102 es un PWM lento superpuesto al de los colores.
+ *
+ * Los frames se encolan en el driver (el DMA lee directamente del buffer
+ * codificado) y led_chipset_wait() recoge el resultado. No hay silencio
+ * de reset: el frame siguiente puede empezar en cuanto acaba la cola.
+ */
+
+#include "led_chipset.h"
+
+#ifdef LED_CHIPSET_CLOCKED
+
+#include <stdbool.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/spi_master.h"
+
+static const char *TAG = "LED_SPI";
+
+#ifdef CONFIG_LED_CHIPSET_SK9822
+const char *const led_chipset_name = "SK9822 (SPI)";
+#else
+const char *const led_chipset_name = "APA102 (SPI)";
+#endif
+
+#define LED_SPI_HOST        SPI2_HOST
+
+// Cabecera de cada píxel: tres bits a 1 y el brillo global
+#define PIXEL_HEADER        (0xE0 | CONFIG_LED_CHIPSET_BRIGHTNESS)
+
+static spi_device_handle_t s_dev;
+static spi_transaction_t s_trans;   // Transacción en curso (la lee el driver)
+static bool s_pending;              // Hay una transacción sin recoger
+
+esp_err_t led_chipset_init(size_t max_bytes)
+{
+    const spi_bus_config_t bus_config = {
+        .mosi_io_num = CONFIG_BLINK_GPIO,
+        .miso_io_num = -1,
+        .sclk_io_num = CONFIG_LED_SPI_CLOCK_GPIO,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = max_bytes,
+    };
+    esp_err_t err = spi_bus_initialize(LED_SPI_HOST, &bus_config, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const spi_device_interface_config_t dev_config = {
+        .clock_speed_hz = CONFIG_LED_SPI_CLOCK_HZ,
+        .mode = 0,
+        .spics_io_num = -1,
+        .queue_size = 1,
+    };
+    err = spi_bus_add_device(LED_SPI_HOST, &dev_config, &s_dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ESP_LOGI(TAG, "%s: datos GPIO %d, reloj GPIO %d a %d Hz, %u bytes por frame",
+             led_chipset_name, CONFIG_BLINK_GPIO, CONFIG_LED_SPI_CLOCK_GPIO,
+             CONFIG_LED_SPI_CLOCK_HZ, (unsigned)max_bytes);
+    return ESP_OK;
+}
+
+/**
+ * @brief Cuerpo del encoder: inicio, píxeles, reset (SK9822) y cola
+ *
+ * Se instancia con parámetros constantes para los casos especializados
+ * de led_chipset_encode().
+ */
+FORCE_INLINE_ATTR size_t encode(uint8_t *wire, const led_chan_t *px, size_t stride,
+                                size_t num_leds, const led_calib_t *cal, uint32_t frame)
+{
+    uint8_t *out = wire;
+    uint8_t c[LED_CHANNELS];
+
+    // Inicio de frame
+    memset(out, 0x00, 4);
+    out += 4;
+
+    LED_CHIPSET_UNROLL
+    for (size_t i = 0; i < num_leds; i++, px += stride) {
+        led_chipset_pixel(cal, i, px, frame, c);
+        *out++ = PIXEL_HEADER;
+        *out++ = c[LED_WIRE_C0];
+        *out++ = c[LED_WIRE_C1];
+        *out++ = c[LED_WIRE_C2];
+    }
+
+    return out - wire;
+}
+
+/**
+ * @brief Final del frame tras los píxeles: reset (SK9822) y cola de reloj
+ */
+FORCE_INLINE_ATTR size_t encode_end(uint8_t *wire, uint8_t *out, size_t num_leds)
+{
+#ifdef CONFIG_LED_CHIPSET_SK9822
+    // Reset: el SK9822 muestra los datos al recibir otros 32 bits a cero
+    memset(out, 0x00, 4);
+    out += 4;
+#endif
+
+    // Cola: cada LED retrasa el dato medio ciclo, hacen falta num_leds / 2
+    // flancos más para que llegue al último. Con ceros no hay riesgo de
+    // que un LED de más los tome como píxel.
+    size_t tail = (num_leds + 15) / 16;
+    memset(out, 0x00, tail);
+    out += tail;
+
+    return out - wire;
+}
+
+size_t IRAM_ATTR led_chipset_encode(uint8_t *wire, const led_chan_t *px, size_t stride,
+                                    size_t num_leds, const led_calib_t *cal, uint32_t frame)
+{
+#ifdef CONFIG_LED_STRIP_FIXED
+    if (num_leds == LED_NUM_LEDS) {
+        size_t len;
+        if (stride == LED_CHANNELS) {
+            len = cal != NULL ? encode(wire, px, LED_CHANNELS, LED_NUM_LEDS, cal, frame)
+                              : encode(wire, px, LED_CHANNELS, LED_NUM_LEDS, NULL, frame);
+            return encode_end(wire, wire + len, LED_NUM_LEDS);
+        }
+#ifndef CONFIG_LED_DITHER
+        if (stride == 0 && cal == NULL) {
+            // Un color: un píxel codificado (4 bytes alineados) y copias
+            uint32_t *word = (uint32_t *)wire + 1;
+            encode(wire, px, 0, 1, NULL, frame);
+            for (size_t i = 1; i < LED_NUM_LEDS; i++) {
+                word[i] = word[0];
+            }
+            return encode_end(wire, wire + 4 + LED_NUM_LEDS * 4, LED_NUM_LEDS);
+        }
+#endif
+    }
+#endif
+    size_t len = encode(wire, px, stride, num_leds, cal, frame);
+    return encode_end(wire, wire + len, num_leds);
+}
+
+esp_err_t led_chipset_transmit(const uint8_t *wire, size_t len)
+{
+    s_trans = (spi_transaction_t) {
+        .length = len * 8,
+        .tx_buffer = wire,
+    };
+    esp_err_t err = spi_device_queue_trans(s_dev, &s_trans, portMAX_DELAY);
+    s_pending = (err == ESP_OK);
+    return err;
+}
+
+esp_err_t led_chipset_wait(void)
+{
+    if (!s_pending) {
+        return ESP_OK;
+    }
+    spi_transaction_t *done;
+    s_pending = false;
+    return spi_device_get_trans_result(s_dev, &done, portMAX_DELAY);
+}
+
+uint32_t led_chipset_wire_us(size_t len)
+{
+    return (uint32_t)(((uint64_t)len * 8 * 1000000 + CONFIG_LED_SPI_CLOCK_HZ - 1) /
+                      CONFIG_LED_SPI_CLOCK_HZ);
+}
+
+uint32_t led_chipset_underruns(void)
+{
+    // El DMA lee el frame entero de memoria: no hay rellenos que lleguen tarde
+    return 0;
+}
+
+#endif // LED_CHIPSET_CLOCKED
@@ -0,0 +1,81 @@
+/**
+ * @file led_clock.c
+ * @brief Implementación del reloj de animación
+ *
+ * En tiempo real el reloj es esp_timer más un desplazamiento, que solo
+ * cambia al volver de un reloj congelado. El estado son enteros de 64
+ * bits, que en un core de 32 bits no se leen de una vez: se protegen con
+ * una sección crítica corta.
+ */
+
+#include "led_clock.h"
+#include "fx_math.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t s_offset_us;             // Reloj de animación - esp_timer
+static int64_t s_frozen_us;             // Valor del reloj congelado
+static bool s_frozen;
+
+int64_t led_clock_us(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_mux);
+    now = s_frozen ? s_frozen_us : now + s_offset_us;
+    portEXIT_CRITICAL(&s_mux);
+    return now;
+}
+
+uint32_t led_clock_ms(void)
+{
+    return (uint32_t)(led_clock_us() / 1000);
+}
+
+int32_t led_clock_t(void)
+{
+    return (int32_t)((led_clock_us() << FX_SHIFT) / 1000000);
+}
+
+int32_t led_clock_delta(int64_t *last_us, int64_t default_us)
+{
+    int64_t now = led_clock_us();
+    int64_t dt_us = *last_us != LED_CLOCK_NEVER ? now - *last_us : default_us;
+    *last_us = now;
+    return (int32_t)((dt_us << FX_SHIFT) / 1000000);
+}
+
+void led_clock_freeze(int64_t us)
+{
+    portENTER_CRITICAL(&s_mux);
+    s_frozen_us = us;
+    s_frozen = true;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void led_clock_advance(int64_t us)
+{
+    portENTER_CRITICAL(&s_mux);
+    if (s_frozen) {
+        s_frozen_us += us;
+    }
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void led_clock_resume(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_mux);
+    if (s_frozen) {
+        s_offset_us = s_frozen_us - now;
+        s_frozen = false;
+    }
+    portEXIT_CRITICAL(&s_mux);
+}
+
+bool led_clock_frozen(void)
+{
+    return s_frozen;
+}
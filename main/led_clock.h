@@ -0,0 +1,87 @@
+/**
+ * @file led_clock.h
+ * @brief Reloj de animación global
+ *
+ * Todas las animaciones miden el tiempo con este reloj en lugar de contar
+ * iteraciones o encadenar vTaskDelay(): la velocidad de un efecto depende
+ * solo del tiempo transcurrido, no de cuántos frames se han podido
+ * calcular. Si el sistema va cargado y se pierden frames, el siguiente
+ * llega con un dt mayor y la animación sigue en su sitio.
+ *
+ * - Tiempo absoluto: led_clock_us(), led_clock_ms() y led_clock_t()
+ *   (segundos en Q16.16, el formato de led_fx_ctx_t)
+ * - Tiempo relativo: led_clock_delta() devuelve el dt desde la llamada
+ *   anterior del mismo consumidor, que guarda su propio instante
+ *
+ * El render stage rellena led_fx_ctx_t con este reloj, así que los efectos
+ * lo usan a través de ctx->t y ctx->dt sin llamarlo directamente.
+ *
+ * Por defecto el reloj sigue a esp_timer. Para benchmarks y pruebas en el
+ * PC se puede congelar en un instante fijo (led_clock_freeze()) y avanzar
+ * a mano (led_clock_advance()): la animación es entonces determinista.
+ * Al volver al tiempo real (led_clock_resume()) el reloj continúa desde
+ * el último valor, sin saltos.
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef LED_CLOCK_H
+#define LED_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Valor inicial del instante de un consumidor de led_clock_delta()
+#define LED_CLOCK_NEVER INT64_MIN
+
+/**
+ * @brief Tiempo de animación en microsegundos
+ */
+int64_t led_clock_us(void);
+
+/**
+ * @brief Tiempo de animación en milisegundos (da la vuelta a los 49 días)
+ */
+uint32_t led_clock_ms(void);
+
+/**
+ * @brief Tiempo de animación en segundos (Q16.16, da la vuelta a las 9 h)
+ */
+int32_t led_clock_t(void);
+
+/**
+ * @brief Tiempo desde la llamada anterior del mismo consumidor
+ *
+ * @param[in,out] last_us Instante de la llamada anterior; LED_CLOCK_NEVER
+ *                        la primera vez, que devuelve default_us
+ * @param default_us      dt de la primera llamada
+ * @return dt en segundos (Q16.16)
+ */
+int32_t led_clock_delta(int64_t *last_us, int64_t default_us);
+
+/**
+ * @brief Congela el reloj en un instante fijo (tiempo determinista)
+ *
+ * @param us Tiempo de animación a partir del que se avanza a mano
+ */
+void led_clock_freeze(int64_t us);
+
+/**
+ * @brief Avanza el reloj congelado
+ *
+ * Sin efecto si el reloj sigue al tiempo real.
+ */
+void led_clock_advance(int64_t us);
+
+/**
+ * @brief Vuelve al tiempo real continuando desde el valor actual
+ */
+void led_clock_resume(void);
+
+/**
+ * @brief Indica si el reloj está congelado
+ */
+bool led_clock_frozen(void);
+
+#endif // LED_CLOCK_H
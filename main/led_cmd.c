@@ -0,0 +1,474 @@
+/**
+ * @file led_cmd.c
+ * @brief Implementación de la cola de comandos de control
+ *
+ * La cola copia los comandos por valor (sin memoria dinámica por
+ * comando). El estado aplicado y los contadores se comparten entre la
+ * tarea de render y las de las interfaces de control, y son pocos bytes:
+ * se protegen con un spinlock.
+ *
+ * Los valores agrupados ocupan un hueco por parámetro con una máscara de
+ * pendientes. La tarea de render se lleva todos los pendientes de una vez
+ * y los aplica ordenados por llegada.
+ */
+
+#include "led_cmd.h"
+#include "led_chipset.h"
+#include "led_control.h"
+#include "led_effects.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "sdkconfig.h"
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+static const char *TAG = "LED_CMD";
+
+#define PRESET_NAMESPACE    "led_presets"
+#define PRESET_NAME_LEN     16      // Nombre de efecto más largo + '\0'
+
+// Huecos de último valor: color, efecto, brillo y uno por segmento
+#define SLOT_COLOR          0
+#define SLOT_EFFECT         1
+#define SLOT_BRIGHTNESS     2
+#define SLOT_SEGMENT        3
+#define NUM_SLOTS           (SLOT_SEGMENT + LED_RENDER_MAX_SEGMENTS)
+
+/**
+ * Formato de un preset en NVS. El efecto va por nombre: su índice en la
+ * tabla de efectos cambia al añadir o quitar efectos en otra versión del
+ * firmware. El tamaño distinto del de led_cmd_state_t hace que los presets
+ * guardados por índice no pasen la comprobación de longitud al leerlos.
+ */
+typedef struct {
+    char effect[PRESET_NAME_LEN];   ///< "" sin efecto
+    uint8_t rgb[3];
+    uint8_t brightness;
+    led_cmd_segment_t segments[LED_RENDER_MAX_SEGMENTS];
+} preset_blob_t;
+
+static QueueHandle_t s_queue;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static led_cmd_state_t s_state = {
+    .effect = LED_FX_NONE,
+    .rgb = { 255, 255, 255 },
+    .brightness = 255,
+};
+static led_cmd_state_t s_preset;        // Último preset leído, pendiente de aplicar
+static led_cmd_stats_t s_stats;
+static uint32_t s_histogram[LED_CMD_LATENCY_BUCKETS];
+
+static led_cmd_t s_latest[NUM_SLOTS];   // Último valor de cada parámetro
+static uint32_t s_latest_pending;       // Máscara de huecos sin aplicar
+static int s_solid = LED_FX_NONE;       // Identificador del efecto "solid"
+
+// Llegada del comando más antiguo aplicado y aún no enviado (solo render)
+static int64_t s_pending_us;
+static bool s_pending;
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+static void apply_segment(int index, const led_cmd_segment_t *seg)
+{
+    led_render_set_segment(index, seg->start, seg->len, seg->rgb);
+}
+
+static void apply_effect(int id)
+{
+    if (led_effects_get(id) == NULL) {
+        id = LED_FX_NONE;
+    }
+    if (led_effects_selected() != id) {
+        led_effects_select(id);
+    }
+}
+
+/**
+ * @brief Aplica un comando y lo refleja en el estado
+ */
+static void apply(const led_cmd_t *cmd)
+{
+    led_cmd_state_t preset;
+
+    switch (cmd->type) {
+        case LED_CMD_COLOR:
+            led_effects_set_color(cmd->rgb[0], cmd->rgb[1], cmd->rgb[2]);
+            apply_effect(s_solid);
+            portENTER_CRITICAL(&s_mux);
+            memcpy(s_state.rgb, cmd->rgb, 3);
+            portEXIT_CRITICAL(&s_mux);
+            break;
+
+        case LED_CMD_EFFECT:
+            apply_effect(cmd->effect);
+            break;
+
+        case LED_CMD_BRIGHTNESS:
+            led_render_set_brightness(cmd->brightness);
+            portENTER_CRITICAL(&s_mux);
+            s_state.brightness = cmd->brightness;
+            portEXIT_CRITICAL(&s_mux);
+            break;
+
+        case LED_CMD_SEGMENT: {
+            const led_cmd_segment_t seg = {
+                .start = cmd->start, .len = cmd->len,
+                .rgb = { cmd->rgb[0], cmd->rgb[1], cmd->rgb[2] },
+            };
+            apply_segment(cmd->index, &seg);
+            portENTER_CRITICAL(&s_mux);
+            s_state.segments[cmd->index] = seg;
+            portEXIT_CRITICAL(&s_mux);
+            break;
+        }
+
+        case LED_CMD_PRESET:
+            portENTER_CRITICAL(&s_mux);
+            preset = s_preset;
+            portEXIT_CRITICAL(&s_mux);
+
+            led_effects_set_color(preset.rgb[0], preset.rgb[1], preset.rgb[2]);
+            apply_effect(preset.effect);
+            led_render_set_brightness(preset.brightness);
+            for (int i = 0; i < LED_RENDER_MAX_SEGMENTS; i++) {
+                apply_segment(i, &preset.segments[i]);
+            }
+            portENTER_CRITICAL(&s_mux);
+            s_state = preset;
+            portEXIT_CRITICAL(&s_mux);
+            break;
+    }
+}
+
+/**
+ * @brief Comprueba los campos que usa cada tipo de comando
+ */
+static bool valid(const led_cmd_t *cmd)
+{
+    switch (cmd->type) {
+        case LED_CMD_COLOR:
+        case LED_CMD_BRIGHTNESS:
+        case LED_CMD_PRESET:
+            return true;
+        case LED_CMD_EFFECT:
+            return cmd->effect == LED_FX_NONE || led_effects_get(cmd->effect) != NULL;
+        case LED_CMD_SEGMENT:
+            return cmd->index < LED_RENDER_MAX_SEGMENTS &&
+                   (cmd->len == 0 || (uint32_t)cmd->start + cmd->len <= LED_NUM_LEDS);
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Hueco de último valor de un comando (-1 si no tiene)
+ */
+static int latest_slot(const led_cmd_t *cmd)
+{
+    switch (cmd->type) {
+        case LED_CMD_COLOR:      return SLOT_COLOR;
+        case LED_CMD_EFFECT:     return SLOT_EFFECT;
+        case LED_CMD_BRIGHTNESS: return SLOT_BRIGHTNESS;
+        case LED_CMD_SEGMENT:    return SLOT_SEGMENT + cmd->index;
+        default:                 return -1;
+    }
+}
+
+/**
+ * @brief Aplica un comando de la tarea de render y lo cuenta
+ */
+static void apply_counted(const led_cmd_t *cmd)
+{
+    apply(cmd);
+    if (!s_pending || cmd->t_us < s_pending_us) {
+        s_pending_us = cmd->t_us;
+        s_pending = true;
+    }
+    portENTER_CRITICAL(&s_mux);
+    s_stats.applied++;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+/**
+ * @brief Latencia por debajo de la que queda el p por mil de las muestras
+ */
+static uint32_t percentile(const uint32_t *hist, uint32_t samples, int permille)
+{
+    uint32_t target = (uint32_t)(((uint64_t)samples * permille + 999) / 1000);
+    uint32_t acc = 0;
+    for (int i = 0; i < LED_CMD_LATENCY_BUCKETS; i++) {
+        acc += hist[i];
+        if (acc >= target) {
+            return (i + 1) * LED_CMD_LATENCY_BUCKET_US;
+        }
+    }
+    return LED_CMD_LATENCY_BUCKETS * LED_CMD_LATENCY_BUCKET_US;
+}
+
+static void preset_key(int slot, char *key, size_t size)
+{
+    snprintf(key, size, "preset%d", slot);
+}
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+void led_cmd_init(void)
+{
+    s_queue = xQueueCreate(CONFIG_LED_CMD_QUEUE_LEN, sizeof(led_cmd_t));
+    s_solid = led_effects_find("solid");
+    s_state.effect = led_effects_selected();
+
+    ESP_LOGI(TAG, "Cola de %d comandos (%u bytes)", CONFIG_LED_CMD_QUEUE_LEN,
+             (unsigned)(CONFIG_LED_CMD_QUEUE_LEN * sizeof(led_cmd_t)));
+}
+
+esp_err_t led_cmd_post(led_cmd_t *cmd)
+{
+    if (s_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!valid(cmd)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cmd->t_us = esp_timer_get_time();
+    if (xQueueSend(s_queue, cmd, 0) != pdTRUE) {
+        portENTER_CRITICAL(&s_mux);
+        s_stats.dropped++;
+        portEXIT_CRITICAL(&s_mux);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    portENTER_CRITICAL(&s_mux);
+    s_stats.received++;
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
+
+esp_err_t led_cmd_post_latest(led_cmd_t *cmd)
+{
+    int slot = latest_slot(cmd);
+    if (slot < 0) {
+        return led_cmd_post(cmd);
+    }
+    if (s_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!valid(cmd)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cmd->t_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_mux);
+    if (s_latest_pending & (1u << slot)) {
+        s_stats.coalesced++;
+    }
+    s_latest[slot] = *cmd;
+    s_latest_pending |= 1u << slot;
+    s_stats.received++;
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
+
+void led_cmd_process(void)
+{
+    led_cmd_t cmd;
+
+    if (s_queue == NULL) {
+        return;
+    }
+    // Los últimos valores, ordenados por llegada (inserción: son pocos)
+    led_cmd_t latest[NUM_SLOTS];
+    int n = 0;
+    portENTER_CRITICAL(&s_mux);
+    for (uint32_t mask = s_latest_pending; mask; mask &= mask - 1) {
+        const led_cmd_t *c = &s_latest[__builtin_ctz(mask)];
+        int k = n++;
+        for (; k > 0 && latest[k - 1].t_us > c->t_us; k--) {
+            latest[k] = latest[k - 1];
+        }
+        latest[k] = *c;
+    }
+    s_latest_pending = 0;
+    portEXIT_CRITICAL(&s_mux);
+
+    // Se intercalan con la cola para respetar el orden de llegada
+    int i = 0;
+    while (xQueueReceive(s_queue, &cmd, 0) == pdTRUE) {
+        for (; i < n && latest[i].t_us <= cmd.t_us; i++) {
+            apply_counted(&latest[i]);
+        }
+        apply_counted(&cmd);
+    }
+    for (; i < n; i++) {
+        apply_counted(&latest[i]);
+    }
+}
+
+esp_err_t led_cmd_apply(const led_cmd_t *cmd)
+{
+    if (cmd->type == LED_CMD_PRESET || !valid(cmd)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    apply(cmd);
+    return ESP_OK;
+}
+
+void led_cmd_presented(size_t num_leds)
+{
+    if (!s_pending) {
+        return;
+    }
+    s_pending = false;
+
+    // El frame acaba de empezar a salir: la luz está completa cuando termina
+    uint32_t wire_us = led_chipset_wire_us(LED_CHIPSET_WIRE_BYTES(num_leds));
+    uint32_t latency = (uint32_t)(esp_timer_get_time() + wire_us - s_pending_us);
+
+    portENTER_CRITICAL(&s_mux);
+    s_stats.latency_samples++;
+    s_stats.latency_last_us = latency;
+    s_stats.latency_sum_us += latency;
+    if (latency > s_stats.latency_max_us) {
+        s_stats.latency_max_us = latency;
+    }
+    uint32_t bucket = latency / LED_CMD_LATENCY_BUCKET_US;
+    s_histogram[bucket < LED_CMD_LATENCY_BUCKETS ? bucket : LED_CMD_LATENCY_BUCKETS - 1]++;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void led_cmd_get_state(led_cmd_state_t *state)
+{
+    portENTER_CRITICAL(&s_mux);
+    *state = s_state;
+    portEXIT_CRITICAL(&s_mux);
+    state->effect = led_effects_selected();
+}
+
+void led_cmd_get_stats(led_cmd_stats_t *stats)
+{
+    uint32_t hist[LED_CMD_LATENCY_BUCKETS];
+
+    portENTER_CRITICAL(&s_mux);
+    *stats = s_stats;
+    memcpy(hist, s_histogram, sizeof(hist));
+    portEXIT_CRITICAL(&s_mux);
+
+    if (stats->latency_samples > 0) {
+        stats->latency_p50_us = percentile(hist, stats->latency_samples, 500);
+        stats->latency_p90_us = percentile(hist, stats->latency_samples, 900);
+        stats->latency_p99_us = percentile(hist, stats->latency_samples, 990);
+    }
+}
+
+void led_cmd_reset_latency(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    s_stats.latency_samples = 0;
+    s_stats.latency_last_us = 0;
+    s_stats.latency_max_us = 0;
+    s_stats.latency_sum_us = 0;
+    memset(s_histogram, 0, sizeof(s_histogram));
+    portEXIT_CRITICAL(&s_mux);
+}
+
+esp_err_t led_cmd_preset_save(int slot)
+{
+    if (slot < 0 || slot >= LED_CMD_PRESETS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_cmd_state_t state;
+    led_cmd_get_state(&state);
+
+    preset_blob_t blob = { .brightness = state.brightness };
+    const led_effect_t *fx = led_effects_get(state.effect);
+    if (fx != NULL) {
+        snprintf(blob.effect, sizeof(blob.effect), "%s", fx->name);
+    }
+    memcpy(blob.rgb, state.rgb, sizeof(blob.rgb));
+    memcpy(blob.segments, state.segments, sizeof(blob.segments));
+
+    char key[16];
+    preset_key(slot, key, sizeof(key));
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(PRESET_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(nvs, key, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Preset %d guardado", slot);
+    }
+    return err;
+}
+
+esp_err_t led_cmd_preset_load(int slot)
+{
+    if (slot < 0 || slot >= LED_CMD_PRESETS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char key[16];
+    preset_key(slot, key, sizeof(key));
+
+    preset_blob_t blob;
+    size_t len = sizeof(blob);
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(PRESET_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) {
+        return err;     // ESP_ERR_NVS_NOT_FOUND si nunca se guardó ninguno
+    }
+    err = nvs_get_blob(nvs, key, &blob, &len);
+    nvs_close(nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (len != sizeof(blob)) {
+        return ESP_ERR_NVS_NOT_FOUND;   // Guardado con otro formato
+    }
+
+    led_cmd_state_t state = { .brightness = blob.brightness, .effect = LED_FX_NONE };
+    blob.effect[sizeof(blob.effect) - 1] = '\0';
+    if (blob.effect[0] != '\0') {
+        state.effect = led_effects_find(blob.effect);
+        if (state.effect == LED_FX_NONE) {
+            ESP_LOGW(TAG, "Preset %d: el efecto \"%s\" ya no existe", slot, blob.effect);
+        }
+    }
+    memcpy(state.rgb, blob.rgb, sizeof(state.rgb));
+    memcpy(state.segments, blob.segments, sizeof(state.segments));
+
+    // Segmentos que ya no caben en la tira
+    for (int i = 0; i < LED_RENDER_MAX_SEGMENTS; i++) {
+        led_cmd_segment_t *seg = &state.segments[i];
+        if ((uint32_t)seg->start + seg->len > LED_NUM_LEDS) {
+            seg->len = 0;
+        }
+    }
+
+    portENTER_CRITICAL(&s_mux);
+    s_preset = state;
+    portEXIT_CRITICAL(&s_mux);
+
+    led_cmd_t cmd = { .type = LED_CMD_PRESET };
+    return led_cmd_post(&cmd);
+}
@@ -0,0 +1,212 @@
+/**
+ * @file led_cmd.h
+ * @brief Comandos de control remoto aplicados por el render stage
+ *
+ * Las interfaces de control (HTTP, ...) no tocan la tira ni el motor de
+ * efectos: validan la petición, la convierten en un led_cmd_t y la dejan
+ * en una cola. La tarea de render vacía la cola al empezar cada tick, así
+ * que los cambios se aplican siempre entre dos frames, en orden, y desde
+ * una sola tarea.
+ *
+ * - Color: selecciona el efecto "solid" con ese color
+ * - Efecto: selecciona un efecto por identificador (o ninguno)
+ * - Brillo: escala global de la salida (led_render_set_brightness())
+ * - Segmento: rango de LEDs de un color fijo sobre lo que se esté
+ *   mostrando (led_render_set_segment())
+ * - Preset: el estado completo guardado en NVS, en LED_CMD_PRESETS huecos
+ *
+ * Cada comando lleva el instante en que llegó. Cuando el primer frame que
+ * lo incluye se envía a la tira, el render stage llama a
+ * led_cmd_presented(): la latencia petición-luz es el tiempo desde la
+ * llegada hasta que ese frame termina de salir por el cable. Si en un
+ * tick se aplican varios comandos cuenta el más antiguo.
+ *
+ * La cola es de tamaño fijo (CONFIG_LED_CMD_QUEUE_LEN) y no se espera si
+ * está llena: el comando se descarta y se cuenta.
+ *
+ * Para controles continuos (deslizadores, selectores de color) hay una
+ * segunda entrada, led_cmd_post_latest(), que no encola: cada parámetro
+ * (color, efecto, brillo, cada segmento) tiene un hueco con el último
+ * valor recibido. Una ráfaga de valores entre dos ticks se queda en el
+ * último, que se aplica una sola vez; los demás cuentan como agrupados
+ * (coalesced). Huecos y cola se aplican juntos por orden de llegada.
+ *
+ * Las latencias se acumulan además en un histograma de LED_CMD_LATENCY_BUCKET_US
+ * por intervalo, del que salen los percentiles de led_cmd_get_stats().
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef LED_CMD_H
+#define LED_CMD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_render.h"
+
+// Huecos de preset en NVS
+#define LED_CMD_PRESETS 8
+
+// Histograma de latencias: intervalos de 0,5 ms hasta 64 ms (el último acumula el resto)
+#define LED_CMD_LATENCY_BUCKET_US   500
+#define LED_CMD_LATENCY_BUCKETS     128
+
+/**
+ * @brief Tipo de comando
+ */
+typedef enum {
+    LED_CMD_COLOR = 0,      ///< rgb
+    LED_CMD_EFFECT,         ///< effect (LED_FX_NONE para detenerlo)
+    LED_CMD_BRIGHTNESS,     ///< brightness
+    LED_CMD_SEGMENT,        ///< index, start, len (0 lo borra), rgb
+    LED_CMD_PRESET,         ///< Estado cargado con led_cmd_preset_load()
+} led_cmd_type_t;
+
+/**
+ * @brief Un comando de control
+ */
+typedef struct {
+    uint8_t type;           ///< led_cmd_type_t
+    uint8_t index;          ///< Segmento
+    uint8_t rgb[3];
+    uint8_t brightness;     ///< 0-255
+    int16_t effect;         ///< Identificador de led_effects.h
+    uint16_t start;         ///< Primer LED del segmento
+    uint16_t len;           ///< LEDs del segmento
+    int64_t t_us;           ///< Llegada (esp_timer), lo pone led_cmd_post()
+} led_cmd_t;
+
+/**
+ * @brief Segmento de color fijo
+ */
+typedef struct {
+    uint16_t start;
+    uint16_t len;           ///< 0 si el segmento no está en uso
+    uint8_t rgb[3];
+} led_cmd_segment_t;
+
+/**
+ * @brief Estado aplicado por los comandos
+ *
+ * Es también el contenido de un preset, aunque en NVS el efecto se guarda
+ * por nombre y no por identificador.
+ */
+typedef struct {
+    int16_t effect;         ///< Efecto activo
+    uint8_t rgb[3];         ///< Color del efecto "solid"
+    uint8_t brightness;
+    led_cmd_segment_t segments[LED_RENDER_MAX_SEGMENTS];
+} led_cmd_state_t;
+
+/**
+ * @brief Contadores de comandos y latencia petición-luz
+ */
+typedef struct {
+    uint32_t received;          ///< Comandos aceptados (cola o último valor)
+    uint32_t dropped;           ///< Comandos descartados con la cola llena
+    uint32_t coalesced;         ///< Valores sustituidos por otro antes de aplicarse
+    uint32_t applied;           ///< Comandos aplicados por el render stage
+    uint32_t latency_samples;   ///< Frames enviados con comandos nuevos
+    uint32_t latency_last_us;   ///< Latencia de la última muestra
+    uint32_t latency_max_us;    ///< Latencia máxima desde el arranque o el último reinicio
+    uint64_t latency_sum_us;    ///< Suma de todas las muestras (media = sum / samples)
+    uint32_t latency_p50_us;    ///< Percentiles (límite superior de su intervalo)
+    uint32_t latency_p90_us;
+    uint32_t latency_p99_us;
+} led_cmd_stats_t;
+
+/**
+ * @brief Crea la cola de comandos
+ *
+ * @note Debe llamarse antes que led_render_init()
+ */
+void led_cmd_init(void);
+
+/**
+ * @brief Valida un comando y lo deja en la cola del render stage
+ *
+ * @param cmd Comando; se marca con el instante de llegada
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si algún campo está fuera de rango,
+ *         ESP_ERR_TIMEOUT si la cola está llena o ESP_ERR_INVALID_STATE si
+ *         no se ha inicializado
+ */
+esp_err_t led_cmd_post(led_cmd_t *cmd);
+
+/**
+ * @brief Deja el último valor de un parámetro para el próximo tick
+ *
+ * Sustituye al valor anterior del mismo parámetro si aún no se había
+ * aplicado. Nunca se rechaza por falta de sitio. Los presets no son un
+ * parámetro continuo: van a la cola como con led_cmd_post().
+ *
+ * @param cmd Comando; se marca con el instante de llegada
+ * @return ESP_OK, ESP_ERR_INVALID_ARG o ESP_ERR_INVALID_STATE
+ */
+esp_err_t led_cmd_post_latest(led_cmd_t *cmd);
+
+/**
+ * @brief Aplica los comandos pendientes (solo desde la tarea de render)
+ */
+void led_cmd_process(void);
+
+/**
+ * @brief Aplica un comando enseguida (solo desde la tarea de render)
+ *
+ * Para las fuentes que ya corren en el tick de render, como la lista de
+ * cues (led_cue.h): no pasa por la cola, no cuenta como recibido ni en la
+ * latencia petición-luz. Los presets no se aceptan.
+ *
+ * @return ESP_OK o ESP_ERR_INVALID_ARG
+ */
+esp_err_t led_cmd_apply(const led_cmd_t *cmd);
+
+/**
+ * @brief Avisa de que un frame ha empezado a salir hacia la tira (solo
+ * desde la tarea de render, justo después de led_control_show())
+ *
+ * @param num_leds LEDs enviados en ese frame: en actualizaciones parciales
+ *                 el frame tarda menos en salir que la tira completa
+ */
+void led_cmd_presented(size_t num_leds);
+
+/**
+ * @brief Obtiene una copia del estado aplicado
+ */
+void led_cmd_get_state(led_cmd_state_t *state);
+
+/**
+ * @brief Obtiene una copia de los contadores
+ */
+void led_cmd_get_stats(led_cmd_stats_t *stats);
+
+/**
+ * @brief Reinicia las muestras de latencia (media, máximo y percentiles)
+ */
+void led_cmd_reset_latency(void);
+
+/**
+ * @brief Guarda el estado aplicado en un hueco de preset
+ *
+ * Escribe en NVS desde la tarea que llama. Los comandos que aún estén en
+ * la cola no se incluyen.
+ *
+ * @param slot Hueco (0 a LED_CMD_PRESETS - 1)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG o el error de NVS
+ */
+esp_err_t led_cmd_preset_save(int slot);
+
+/**
+ * @brief Lee un preset de NVS y encola su aplicación
+ *
+ * Si el efecto guardado ya no existe en este firmware se aplica el resto
+ * del preset sin efecto.
+ *
+ * @param slot Hueco (0 a LED_CMD_PRESETS - 1)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NVS_NOT_FOUND si el hueco
+ *         está vacío o el error de led_cmd_post()
+ */
+esp_err_t led_cmd_preset_load(int slot);
+
+#endif // LED_CMD_H
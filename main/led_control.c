@@ -1,41 +1,96 @@
 #include "led_control.h"
+#include "led_chipset.h"
+#include "led_clock.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
 #include "sdkconfig.h"
 
 static const char *TAG = "LED_CONTROL";
-static led_strip_handle_t led_strip;
+static SemaphoreHandle_t s_strip_lock;
+#ifdef CONFIG_LED_CALIBRATION
+static led_calib_t s_calib;
+#define CALIB (&s_calib)
+#else
+#define CALIB NULL
+#endif
 
 #define BLINK_GPIO CONFIG_BLINK_GPIO
-#define NUM_LEDS 5
+#define NUM_LEDS LED_NUM_LEDS
+
+// Duración de cada color de led_blink_sequence()
+#define BLINK_STEP_MS 5000
+
+// Múltiplo de 4 para que los dos buffers queden alineados para el DMA
+#define WIRE_BYTES ((LED_CHIPSET_WIRE_BYTES(NUM_LEDS) + 3) & ~3)
+
+// Frames codificados en el formato del cable (los lee el DMA en SPI). Son
+// dos: uno se codifica mientras el otro está en el cable
+static DMA_ATTR WORD_ALIGNED_ATTR uint8_t s_wire[2][WIRE_BYTES];
+static int s_wire_next;     // Buffer libre para el siguiente frame
+static uint32_t s_frame;    // Frames enviados (fase del dither)
+
+/**
+ * @brief Codifica y envía un frame (con el mutex de la tira tomado)
+ *
+ * No espera a que el frame salga: la codificación del siguiente se solapa
+ * con el envío de este, que solo se espera justo antes de transmitir.
+ */
+static void show_locked(const led_chan_t *px, size_t stride, size_t num_leds,
+                        const led_calib_t *cal)
+{
+    uint8_t *wire = s_wire[s_wire_next];
+    size_t len = led_chipset_encode(wire, px, stride, num_leds, cal, s_frame++);
+    esp_err_t err = led_chipset_wait();
+    if (err == ESP_OK) {
+        err = led_chipset_transmit(wire, len);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Error enviando el frame: %s", esp_err_to_name(err));
+    }
+    s_wire_next ^= 1;
+}
 
 /**
  * @brief Configura e inicializa la tira LED addressable
  * 
- * Inicializa el driver RMT (Remote Control) para controlar la tira LED.
- * El protocolo RMT permite generar las señales de timing precisas que
- * requieren los LEDs WS2812B.
+ * Inicializa el periférico del chipset configurado (RMT para WS2812B y
+ * SK6812, SPI con DMA para APA102 y SK9822), ver led_chipset.h.
  * 
  * @note Esta función debe llamarse antes de usar cualquier función de LED
  */
 void led_control_init(void)
 {
-    ESP_LOGI(TAG, "Configurando LED addressable en GPIO %d", BLINK_GPIO);
-    
-    led_strip_config_t strip_config = {
-        .strip_gpio_num = BLINK_GPIO,
-        .max_leds = NUM_LEDS,
-    };
-
-    led_strip_rmt_config_t rmt_config = {
-        .resolution_hz = 10 * 1000 * 1000,
-        .flags.with_dma = false,
-    };
-    
-    ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip));
-    led_strip_clear(led_strip);
+    ESP_LOGI(TAG, "Configurando %d LEDs %s (%s)", NUM_LEDS, led_chipset_name,
+             LED_CHANNELS == 4 ? "RGBW" : "RGB");
+
+    s_strip_lock = xSemaphoreCreateMutex();
+#ifdef CONFIG_LED_CALIBRATION
+    led_calib_init(&s_calib, CONFIG_LED_GAMMA_X100);
+#endif
+    ESP_ERROR_CHECK(led_chipset_init(WIRE_BYTES));
+    ESP_LOGI(TAG, "Frame en el cable: %u us (máximo teórico %u fps)",
+             (unsigned)led_control_frame_us(), (unsigned)(1000000 / led_control_frame_us()));
+    led_clear();
+}
+
+/**
+ * @brief Tiempo mínimo entre dos frames de la tira completa
+ */
+uint32_t led_control_frame_us(void)
+{
+    return led_chipset_wire_us(LED_CHIPSET_WIRE_BYTES(NUM_LEDS));
+}
+
+/**
+ * @brief Frames que salieron corruptos por falta de datos en el periférico
+ */
+uint32_t led_control_underruns(void)
+{
+    return led_chipset_underruns();
 }
 
 /**
@@ -48,15 +103,82 @@ void led_control_init(void)
  * @param g Componente verde (0-255)
  * @param b Componente azul (0-255)
  * 
- * @note Los LEDs WS2812B usan formato GRB internamente, pero esta
- *       función acepta RGB y el driver realiza la conversión
+ * @note El orden de los canales en el cable lo fija
+ *       CONFIG_LED_COLOR_ORDER (GRB en WS2812B, BGR en APA102 por
+ *       defecto); esta función acepta RGB y el encoder de cada chipset
+ *       los reordena. En tiras RGBW el blanco se extrae como en
+ *       led_rgbw_extract()
  */
 void led_set_all(uint8_t r, uint8_t g, uint8_t b)
 {
-    for (int i = 0; i < NUM_LEDS; i++) {
-        led_strip_set_pixel(led_strip, i, r, g, b);
+    const led_chan_t rgb[3] = { LED_CHAN_FROM_U8(r), LED_CHAN_FROM_U8(g), LED_CHAN_FROM_U8(b) };
+#ifdef CONFIG_LED_PIXEL_RGBW
+    led_chan_t px[4];
+    led_rgbw_extract(px, rgb, 1);
+#else
+    const led_chan_t *px = rgb;
+#endif
+
+    // Los colores de estado se envían sin calibrar
+    xSemaphoreTake(s_strip_lock, portMAX_DELAY);
+    show_locked(px, 0, NUM_LEDS, NULL);
+    xSemaphoreGive(s_strip_lock);
+}
+
+/**
+ * @brief Envía un frame completo a la tira (commit)
+ * 
+ * @param px       Buffer de píxeles en el formato de la tira (LED_CHANNELS canales por LED)
+ * @param num_leds Número de píxeles del buffer (se recorta a LED_NUM_LEDS)
+ */
+void led_control_show(const led_chan_t *px, size_t num_leds)
+{
+    if (num_leds > NUM_LEDS) {
+        num_leds = NUM_LEDS;
+    }
+
+    xSemaphoreTake(s_strip_lock, portMAX_DELAY);
+    show_locked(px, LED_CHANNELS, num_leds, CALIB);
+    xSemaphoreGive(s_strip_lock);
+}
+
+#ifdef CONFIG_LED_CALIBRATION
+/**
+ * @brief Configura la calibración de color de un segmento de la tira
+ */
+esp_err_t led_control_set_calibration(int index, const led_calib_segment_t *seg)
+{
+    xSemaphoreTake(s_strip_lock, portMAX_DELAY);
+    esp_err_t err = led_calib_set_segment(&s_calib, index, seg);
+    xSemaphoreGive(s_strip_lock);
+    return err;
+}
+
+/**
+ * @brief Quita la calibración de todos los segmentos
+ */
+void led_control_clear_calibration(void)
+{
+    xSemaphoreTake(s_strip_lock, portMAX_DELAY);
+    led_calib_clear(&s_calib);
+    xSemaphoreGive(s_strip_lock);
+}
+#endif
+
+/**
+ * @brief Convierte píxeles RGB a RGBW extrayendo el blanco
+ */
+void IRAM_ATTR led_rgbw_extract(led_chan_t *rgbw, const led_chan_t *rgb, size_t num_leds)
+{
+    for (size_t i = 0; i < num_leds; i++, rgb += 3, rgbw += 4) {
+        led_chan_t r = rgb[0], g = rgb[1], b = rgb[2];
+        led_chan_t w = r < g ? r : g;   // Sin saltos: MINU en Xtensa
+        w = w < b ? w : b;
+        rgbw[0] = r - w;
+        rgbw[1] = g - w;
+        rgbw[2] = b - w;
+        rgbw[3] = w;
     }
-    led_strip_refresh(led_strip);
 }
 
 /**
@@ -72,8 +194,29 @@ void led_set_color_orange(void) { led_set_all(ORANGE_R, ORANGE_G, ORANGE_B); }
  */
 void led_clear(void)
 {
-    led_strip_clear(led_strip);
-    led_strip_refresh(led_strip);
+    static const led_chan_t off[LED_CHANNELS] = { 0 };
+
+    xSemaphoreTake(s_strip_lock, portMAX_DELAY);
+    show_locked(off, 0, NUM_LEDS, NULL);
+    xSemaphoreGive(s_strip_lock);
+}
+
+/**
+ * @brief Espera hasta un instante del reloj de animación
+ *
+ * Con el reloj congelado no se llega nunca: se espera el tiempo que falta
+ * en el momento de la llamada.
+ */
+static void wait_until_ms(uint32_t target)
+{
+    int32_t left = (int32_t)(target - led_clock_ms());
+    while (left > 0) {
+        vTaskDelay(pdMS_TO_TICKS(left) ? pdMS_TO_TICKS(left) : 1);
+        if (led_clock_frozen()) {
+            return;
+        }
+        left = (int32_t)(target - led_clock_ms());
+    }
 }
 
 /**
@@ -84,18 +227,23 @@ void led_clear(void)
  * - AZUL durante 5 segundos
  * - VERDE durante 5 segundos
  * 
+ * Los cambios se programan sobre el reloj de animación: si una espera se
+ * alarga, la siguiente se acorta y el ciclo no se retrasa.
+ *
  * @note Esta función es bloqueante (usa vTaskDelay)
  */
 void led_blink_sequence(void)
 {
+    uint32_t start = led_clock_ms();
+
     led_set_color_red();
-    vTaskDelay(pdMS_TO_TICKS(5000));
+    wait_until_ms(start + BLINK_STEP_MS);
 
     led_set_color_blue();
-    vTaskDelay(pdMS_TO_TICKS(5000));
+    wait_until_ms(start + 2 * BLINK_STEP_MS);
 
     led_set_color_green();
-    vTaskDelay(pdMS_TO_TICKS(5000));
+    wait_until_ms(start + 3 * BLINK_STEP_MS);
 }
 
 /**
@@ -1,8 +1,34 @@
 #ifndef LED_CONTROL_H
 #define LED_CONTROL_H
 
+#include <stddef.h>
 #include <stdint.h>
-#include "led_strip.h"
+#include "esp_err.h"
+#include "led_calib.h"
+#include "sdkconfig.h"
+
+// Número de LEDs de la tira (configurable en menuconfig)
+#define LED_NUM_LEDS CONFIG_LED_NUM_LEDS
+
+// Bytes por píxel de los frames de la tira: R, G, B y, en tiras RGBW, W
+#ifdef CONFIG_LED_PIXEL_RGBW
+#define LED_CHANNELS 4
+#else
+#define LED_CHANNELS 3
+#endif
+
+// Canal de los frames internos: 8 bits, o 16 con CONFIG_LED_HDR (la
+// cuantización a los bytes del cable se hace una sola vez al enviar)
+#ifdef CONFIG_LED_HDR
+typedef uint16_t led_chan_t;
+#define LED_CHAN_MAX 65535
+#else
+typedef uint8_t led_chan_t;
+#define LED_CHAN_MAX 255
+#endif
+
+// Convierte un canal de 8 bits al formato interno (255 -> LED_CHAN_MAX)
+#define LED_CHAN_FROM_U8(v) ((led_chan_t)((v) * (LED_CHAN_MAX / 255)))
 
 // Definición de colores RGB
 #define BLUE_R  184
@@ -26,9 +52,8 @@
 /**
  * @brief Configura e inicializa la tira LED addressable
  * 
- * Inicializa el driver RMT (Remote Control) para controlar la tira LED.
- * El protocolo RMT permite generar las señales de timing precisas que
- * requieren los LEDs WS2812B.
+ * Inicializa el periférico del chipset configurado (RMT para WS2812B y
+ * SK6812, SPI con DMA para APA102 y SK9822), ver led_chipset.h.
  * 
  * @note Esta función debe llamarse antes de usar cualquier función de LED
  */
@@ -44,11 +69,88 @@ void led_control_init(void);
  * @param g Componente verde (0-255)
  * @param b Componente azul (0-255)
  * 
- * @note Los LEDs WS2812B usan formato GRB internamente, pero esta
- *       función acepta RGB y el driver realiza la conversión
+ * @note El orden de los canales en el cable lo fija
+ *       CONFIG_LED_COLOR_ORDER (GRB en WS2812B, BGR en APA102 por
+ *       defecto); esta función acepta RGB y el encoder de cada chipset
+ *       los reordena. En tiras RGBW el blanco se extrae como en
+ *       led_rgbw_extract()
  */
 void led_set_all(uint8_t r, uint8_t g, uint8_t b);
 
+/**
+ * @brief Envía un frame completo a la tira (commit)
+ * 
+ * Copia el buffer a la tira y la refresca. Es el único punto por el que
+ * los frames del render stage llegan al hardware. Con
+ * CONFIG_LED_CALIBRATION cada píxel se calibra en la misma copia.
+ * 
+ * @param px       Buffer de píxeles en el formato de la tira: R, G, B
+ *                 (y W en tiras RGBW), LED_CHANNELS canales por LED
+ * @param num_leds Número de píxeles del buffer (se recorta a LED_NUM_LEDS)
+ * 
+ * El envío es asíncrono: la función vuelve en cuanto el frame empieza a
+ * salir, y el siguiente se codifica mientras tanto. Solo espera si el
+ * frame anterior sigue en el cable (ver led_control_frame_us()).
+ * 
+ * @note Es seguro llamarla desde varias tareas: el acceso a la tira está
+ *       protegido por un mutex interno
+ */
+void led_control_show(const led_chan_t *px, size_t num_leds);
+
+/**
+ * @brief Tiempo que ocupa un frame de toda la tira en el cable
+ * 
+ * Incluye el reset entre frames de los chips de un hilo (WS2812B: unos
+ * 30 us por píxel más 80 us). 1e6 / led_control_frame_us() es el máximo
+ * teórico de fps para la tira configurada.
+ * 
+ * @return Microsegundos por frame
+ */
+uint32_t led_control_frame_us(void);
+
+/**
+ * @brief Frames que salieron corruptos por falta de datos en el periférico
+ * 
+ * En tiras de un hilo sin DMA el RMT se rellena por interrupciones; si
+ * una llega tarde el frame se corrompe y se cuenta aquí (ver
+ * CONFIG_LED_RMT_MEM_BLOCKS).
+ * 
+ * @return Contador desde el arranque
+ */
+uint32_t led_control_underruns(void);
+
+/**
+ * @brief Convierte píxeles RGB a RGBW extrayendo el blanco
+ * 
+ * La parte común de los tres canales, min(R, G, B), pasa al LED blanco y
+ * se resta de R, G y B: el color es el mismo y se gana eficiencia y
+ * pureza en los tonos pastel.
+ * 
+ * @param rgbw     Destino (4 canales por LED)
+ * @param rgb      Origen (3 canales por LED), no puede solaparse con rgbw
+ * @param num_leds Número de píxeles
+ */
+void led_rgbw_extract(led_chan_t *rgbw, const led_chan_t *rgb, size_t num_leds);
+
+#ifdef CONFIG_LED_CALIBRATION
+/**
+ * @brief Configura la calibración de color de un segmento de la tira
+ * 
+ * Se aplica a partir del siguiente frame de led_control_show(), junto con
+ * la gamma de CONFIG_LED_GAMMA_X100 (ver led_calib.h).
+ * 
+ * @param index Segmento (0 a LED_CALIB_MAX_SEGMENTS - 1)
+ * @param seg   Rango de LEDs, matriz de corrección y blanco objetivo
+ * @return Resultado de led_calib_set_segment()
+ */
+esp_err_t led_control_set_calibration(int index, const led_calib_segment_t *seg);
+
+/**
+ * @brief Quita la calibración de todos los segmentos (se mantiene la gamma)
+ */
+void led_control_clear_calibration(void);
+#endif
+
 /**
  * @brief Funciones helper para colores predefinidos
  */
@@ -70,6 +172,9 @@ void led_clear(void);
  * - AZUL durante 5 segundos
  * - VERDE durante 5 segundos
  * 
+ * Los tiempos se miden con el reloj de animación (led_clock.h), así que
+ * la carga del sistema no alarga el ciclo.
+ *
  * @note Esta función es bloqueante (usa vTaskDelay)
  */
 void led_blink_sequence(void);
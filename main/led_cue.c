@@ -0,0 +1,453 @@
+/**
+ * @file led_cue.c
+ * @brief Implementación de la lista de cues
+ *
+ * Hay dos listas estáticas: la que reproduce la tarea de render y la que
+ * se está cargando. Al confirmar una carga su índice queda pendiente y la
+ * tarea de render la adopta al empezar el tick siguiente; hasta entonces
+ * no se puede empezar otra carga, así que nadie escribe en la lista que se
+ * está leyendo.
+ *
+ * La fuente de tiempo (posición y reloj de referencia) la escriben las
+ * tareas de red y la lee la de render: son pocos bytes bajo un spinlock,
+ * como los contadores. Lo demás (cue activo, cue preparado, transición)
+ * solo lo toca la tarea de render.
+ */
+
+#include "led_cue.h"
+#include "led_clock.h"
+#include "led_cmd.h"
+#include "led_control.h"
+#include "led_effects.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+static const char *TAG = "LED_CUE";
+
+#define FREEWHEEL_US        ((int64_t)CONFIG_LED_CUE_FREEWHEEL_MS * 1000)
+
+// Diferencia entre un código de tiempo y la posición extrapolada a partir
+// de la que se considera un salto y se busca de nuevo el cue
+#define SEEK_THRESHOLD_US   100000
+
+/**
+ * @brief Cue preparado para activarse: comandos ya validados
+ */
+typedef struct {
+    int index;                  ///< Posición en la lista
+    int64_t t_us;
+    uint32_t fade_us;
+    bool has_effect;            ///< effect_cmd se aplica al activarse
+    led_cmd_t effect_cmd;
+    uint8_t flags;              ///< LED_CUE_COLOR | LED_CUE_BRIGHTNESS
+    uint8_t rgb[3];             ///< Destino de la transición
+    uint8_t brightness;
+    uint8_t from_rgb[3];        ///< Valores al activarse
+    uint8_t from_brightness;
+} stage_t;
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Listas: la de reproducción, la de carga y la pendiente de adoptar
+static led_cue_t s_lists[2][CONFIG_LED_CUE_MAX];
+static uint16_t s_counts[2];
+static int s_list;                      // Lista de la tarea de render
+static int s_loading = -1;              // Lista en carga (-1 ninguna)
+static int s_pending = -1;              // Lista confirmada sin adoptar
+
+// Fuente de tiempo (bajo s_mux)
+static uint8_t s_source = LED_CUE_STOPPED;
+static int64_t s_base_pos;              // Posición en s_base_clock
+static int64_t s_base_clock;            // led_clock_us() de la referencia
+static bool s_seek;                     // Salto pendiente de buscar
+
+static led_cue_status_t s_status = { .active = -1 };
+
+// Solo tarea de render
+static const led_cue_t *s_cues = s_lists[0];
+static int s_num;
+static stage_t s_stage[2];
+static stage_t *s_active;               // Último cue activado
+static stage_t *s_next;                 // Cue preparado (NULL al final)
+static bool s_located;                  // s_next corresponde a la posición
+static bool s_fading;
+static uint8_t s_last_rgb[3];           // Último valor aplicado de la transición
+static uint8_t s_last_brightness;
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)rd16(p) | ((uint32_t)rd16(p + 2) << 16);
+}
+
+/**
+ * @brief Primer cue con tiempo posterior a pos_us (búsqueda binaria)
+ */
+static int upper_bound(int64_t pos_us)
+{
+    int lo = 0;
+    int hi = s_num;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if ((int64_t)s_cues[mid].t_ms * 1000 <= pos_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Prepara el cue index en el hueco libre (el que no está activo)
+ */
+static void stage(int index)
+{
+    if (index >= s_num) {
+        s_next = NULL;
+        return;
+    }
+
+    const led_cue_t *cue = &s_cues[index];
+    stage_t *st = s_active == &s_stage[0] ? &s_stage[1] : &s_stage[0];
+
+    memset(st, 0, sizeof(*st));
+    st->index = index;
+    st->t_us = (int64_t)cue->t_ms * 1000;
+    st->fade_us = (uint32_t)cue->fade_ms * 1000;
+    st->flags = cue->flags;
+    memcpy(st->rgb, cue->rgb, 3);
+    st->brightness = cue->brightness;
+    if (!(cue->flags & LED_CUE_COLOR) && cue->effect != LED_CUE_KEEP) {
+        st->has_effect = true;
+        st->effect_cmd.type = LED_CMD_EFFECT;
+        st->effect_cmd.effect = cue->effect;
+    }
+    s_next = st;
+}
+
+static uint8_t lerp(uint8_t from, uint8_t to, int64_t num, int64_t den)
+{
+    return (uint8_t)(from + (to - from) * num / den);
+}
+
+/**
+ * @brief Aplica el color y el brillo del cue activo en la posición pos_us
+ */
+static void fade(int64_t pos_us)
+{
+    const stage_t *st = s_active;
+    int64_t elapsed = pos_us - st->t_us;
+    int64_t span = st->fade_us;
+
+    if (elapsed < 0) {
+        elapsed = 0;
+    }
+    if (span == 0 || elapsed >= span) {
+        elapsed = span = 1;
+        s_fading = false;
+    }
+
+    if (st->flags & LED_CUE_COLOR) {
+        led_cmd_t cmd = { .type = LED_CMD_COLOR };
+        for (int c = 0; c < 3; c++) {
+            cmd.rgb[c] = lerp(st->from_rgb[c], st->rgb[c], elapsed, span);
+        }
+        if (memcmp(cmd.rgb, s_last_rgb, 3) != 0) {
+            led_cmd_apply(&cmd);
+            memcpy(s_last_rgb, cmd.rgb, 3);
+        }
+    }
+    if (st->flags & LED_CUE_BRIGHTNESS) {
+        led_cmd_t cmd = {
+            .type = LED_CMD_BRIGHTNESS,
+            .brightness = lerp(st->from_brightness, st->brightness, elapsed, span),
+        };
+        if (cmd.brightness != s_last_brightness) {
+            led_cmd_apply(&cmd);
+            s_last_brightness = cmd.brightness;
+        }
+    }
+}
+
+/**
+ * @brief Activa el cue preparado y prepara el siguiente
+ *
+ * @param chase Activado al buscar tras un salto (no cuenta el retraso)
+ */
+static void activate(int64_t pos_us, bool chase)
+{
+    stage_t *st = s_next;
+    s_active = st;
+
+    if (st->has_effect) {
+        led_cmd_apply(&st->effect_cmd);
+    }
+    if (st->flags & (LED_CUE_COLOR | LED_CUE_BRIGHTNESS)) {
+        led_cmd_state_t state;
+        led_cmd_get_state(&state);
+        memcpy(st->from_rgb, state.rgb, 3);
+        st->from_brightness = state.brightness;
+        // Fuerza la primera aplicación aunque coincida con el estado
+        s_last_rgb[0] = (uint8_t)~state.rgb[0];
+        s_last_brightness = (uint8_t)~state.brightness;
+        s_fading = true;
+        fade(pos_us);
+    } else {
+        s_fading = false;
+    }
+
+    uint32_t late = (uint32_t)(pos_us - st->t_us);
+    portENTER_CRITICAL(&s_mux);
+    s_status.active = st->index;
+    if (!chase) {
+        s_status.activations++;
+        s_status.late_last_us = late;
+        s_status.late_sum_us += late;
+        if (late > s_status.late_max_us) {
+            s_status.late_max_us = late;
+        }
+    }
+    portEXIT_CRITICAL(&s_mux);
+
+    stage(st->index + 1);
+}
+
+/**
+ * @brief Busca el cue de la posición pos_us tras una carga o un salto
+ *
+ * Activa el último cue anterior a la posición si no es ya el activo. Antes
+ * del primer cue no queda ninguno activo: una transición a medias del que
+ * lo estaba no puede seguir con una posición anterior a su inicio.
+ */
+static void locate(int64_t pos_us)
+{
+    int next = upper_bound(pos_us);
+    int prev = next - 1;
+
+    if (prev < 0) {
+        s_active = NULL;
+        s_fading = false;
+        portENTER_CRITICAL(&s_mux);
+        s_status.active = -1;
+        portEXIT_CRITICAL(&s_mux);
+    } else if (s_active == NULL || s_active->index != prev) {
+        stage(prev);
+        activate(pos_us, true);
+    }
+    stage(next);
+    s_located = true;
+
+    portENTER_CRITICAL(&s_mux);
+    s_status.seeks++;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+esp_err_t led_cue_load_begin(void)
+{
+    esp_err_t err = ESP_OK;
+
+    portENTER_CRITICAL(&s_mux);
+    if (s_loading >= 0 || s_pending >= 0) {
+        err = ESP_ERR_INVALID_STATE;
+    } else {
+        s_loading = 1 - s_list;
+        s_counts[s_loading] = 0;
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return err;
+}
+
+esp_err_t led_cue_load_add(const led_cue_t *cue)
+{
+    if (s_loading < 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((cue->flags & ~(LED_CUE_COLOR | LED_CUE_BRIGHTNESS)) ||
+        (!(cue->flags & LED_CUE_COLOR) && cue->effect != LED_CUE_KEEP &&
+         cue->effect != LED_FX_NONE && led_effects_get(cue->effect) == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_counts[s_loading] >= CONFIG_LED_CUE_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_lists[s_loading][s_counts[s_loading]++] = *cue;
+    return ESP_OK;
+}
+
+esp_err_t led_cue_load_commit(void)
+{
+    if (s_loading < 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Inserción estable: con el mismo tiempo gana el último de la lista, y
+    // una lista que llega ordenada se recorre una sola vez
+    led_cue_t *list = s_lists[s_loading];
+    int n = s_counts[s_loading];
+    for (int i = 1; i < n; i++) {
+        led_cue_t cue = list[i];
+        int k = i;
+        for (; k > 0 && list[k - 1].t_ms > cue.t_ms; k--) {
+            list[k] = list[k - 1];
+        }
+        list[k] = cue;
+    }
+
+    portENTER_CRITICAL(&s_mux);
+    s_pending = s_loading;
+    s_loading = -1;
+    portEXIT_CRITICAL(&s_mux);
+
+    ESP_LOGI(TAG, "Lista de %d cues cargada", n);
+    return ESP_OK;
+}
+
+void led_cue_load_abort(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    s_loading = -1;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+bool led_cue_decode(const uint8_t *rec, led_cue_t *cue)
+{
+    cue->t_ms = rd32(rec);
+    cue->effect = (int16_t)rd16(rec + 4);
+    cue->flags = rec[6];
+    cue->brightness = rec[7];
+    memcpy(cue->rgb, rec + 8, 3);
+    cue->fade_ms = rd16(rec + 12);
+    return rec[11] == 0 && rd16(rec + 14) == 0;
+}
+
+int led_cue_decode_header(const uint8_t *hdr, size_t len)
+{
+    if (len < LED_CUE_HEADER_SIZE || memcmp(hdr, LED_CUE_MAGIC, 4) != 0 ||
+        rd16(hdr + 6) != 0) {
+        return -1;
+    }
+    return rd16(hdr + 4);
+}
+
+void led_cue_play(uint32_t from_ms)
+{
+    int64_t now = led_clock_us();
+
+    portENTER_CRITICAL(&s_mux);
+    s_source = LED_CUE_LOCAL;
+    s_base_pos = (int64_t)from_ms * 1000;
+    s_base_clock = now;
+    s_seek = true;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void led_cue_stop(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    s_source = LED_CUE_STOPPED;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void led_cue_timecode(int64_t position_us)
+{
+    int64_t now = led_clock_us();
+
+    portENTER_CRITICAL(&s_mux);
+    if (s_source == LED_CUE_TIMECODE) {
+        int64_t elapsed = now - s_base_clock;
+        int64_t expected = s_base_pos + (elapsed < FREEWHEEL_US ? elapsed : FREEWHEEL_US);
+        if (llabs(position_us - expected) > SEEK_THRESHOLD_US) {
+            s_seek = true;
+        }
+    } else {
+        s_source = LED_CUE_TIMECODE;
+        s_seek = true;
+    }
+    s_base_pos = position_us;
+    s_base_clock = now;
+    s_status.timecodes++;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void led_cue_process(void)
+{
+    // Instante en que el frame de este tick termina de salir por el cable
+    int64_t clock = led_clock_us() + led_control_frame_us();
+    bool adopt = false;
+    bool seek;
+    int64_t pos;
+
+    portENTER_CRITICAL(&s_mux);
+    uint8_t source = s_source;
+    if (s_pending >= 0) {
+        s_list = s_pending;
+        s_pending = -1;
+        adopt = true;
+    }
+    seek = s_seek;
+    s_seek = false;
+
+    int64_t elapsed = clock - s_base_clock;
+    bool freewheel = source == LED_CUE_TIMECODE && elapsed > FREEWHEEL_US;
+    pos = s_base_pos + (freewheel ? FREEWHEEL_US : elapsed);
+
+    s_status.source = source;
+    s_status.freewheel = freewheel;
+    if (source != LED_CUE_STOPPED) {
+        s_status.position_us = pos;
+    }
+    if (adopt) {
+        s_status.cues = s_counts[s_list];
+        s_status.active = -1;
+    }
+    portEXIT_CRITICAL(&s_mux);
+
+    if (adopt) {
+        s_cues = s_lists[s_list];
+        s_num = s_counts[s_list];
+        s_active = NULL;
+        s_next = NULL;
+        s_fading = false;
+        s_located = false;
+    }
+    if (source == LED_CUE_STOPPED) {
+        return;
+    }
+
+    if (seek || !s_located) {
+        locate(pos);
+    }
+    while (s_next != NULL && pos >= s_next->t_us) {
+        activate(pos, false);
+    }
+    if (s_fading) {
+        fade(pos);
+    }
+}
+
+void led_cue_get_status(led_cue_status_t *status)
+{
+    portENTER_CRITICAL(&s_mux);
+    *status = s_status;
+    portEXIT_CRITICAL(&s_mux);
+}
@@ -0,0 +1,198 @@
+/**
+ * @file led_cue.h
+ * @brief Lista de cues sincronizada con un código de tiempo
+ *
+ * Un cue es una escena colocada en una línea de tiempo: un efecto o un
+ * color fijo, un brillo y el tiempo de transición hacia ellos. La lista se
+ * carga entera de una vez (por HTTP, ver http_api.h) y se reproduce
+ * contra una de dos fuentes de tiempo:
+ *
+ * - Local: led_cue_play() arranca la línea de tiempo en una posición y la
+ *   avanza con el reloj de animación (led_clock.h)
+ * - Código de tiempo: cada led_cue_timecode() recibido de la red (OSC o
+ *   HTTP) fija la posición; entre dos mensajes se extrapola con el reloj
+ *   local, y si dejan de llegar se sigue como máximo
+ *   CONFIG_LED_CUE_FREEWHEEL_MS antes de detenerse en el sitio
+ *
+ * La tarea de render llama a led_cue_process() al empezar cada tick, antes
+ * que a led_cmd_process(): los comandos de las interfaces de control se
+ * aplican encima del cue activo. La posición que se compara con los cues
+ * es la del instante en que el frame de este tick termina de salir por el
+ * cable, así que un cue se ve en el primer frame que llega a la tira
+ * después de su tiempo, y nunca antes.
+ *
+ * La lista está ordenada por tiempo. El siguiente cue se busca con una
+ * búsqueda binaria solo al cargar la lista o cuando la posición salta
+ * (un seek, un código de tiempo que no cuadra con el extrapolado); en
+ * reproducción normal es siempre el que sigue al activo. Ese siguiente
+ * cue se prepara con un tick de antelación (comandos validados y listos
+ * para aplicar), de modo que activarlo en su frame es cambiar un puntero
+ * y aplicar lo ya preparado.
+ *
+ * Tras un salto se aplica el último cue anterior a la nueva posición, con
+ * su transición en el punto que le corresponda.
+ *
+ * FORMATO BINARIO (led_cue_decode()):
+ * ==================================
+ *   Cabecera de 8 bytes: "CUE1", número de cues (uint16), reservado (uint16)
+ *   Un registro de 16 bytes por cue, en little endian:
+ *     0  uint32  t_ms        Posición en la línea de tiempo
+ *     4  int16   effect      Identificador de /api/effects, -1 detiene el
+ *                            efecto, -2 no lo cambia
+ *     6  uint8   flags       LED_CUE_COLOR | LED_CUE_BRIGHTNESS
+ *     7  uint8   brightness
+ *     8  uint8   r, g, b     Color del efecto "solid" (con LED_CUE_COLOR)
+ *    11  uint8   reservado
+ *    12  uint16  fade_ms     Transición del color y el brillo (0: corte)
+ *    14  uint16  reservado
+ *
+ * Con LED_CUE_COLOR el cue selecciona el efecto "solid" con ese color,
+ * como LED_CMD_COLOR, y el campo effect no se usa. Los efectos cambian
+ * siempre en corte; la transición funde el color y el brillo desde los
+ * valores que había al activarse el cue.
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef LED_CUE_H
+#define LED_CUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define LED_CUE_MAGIC           "CUE1"
+#define LED_CUE_HEADER_SIZE     8
+#define LED_CUE_RECORD_SIZE     16
+
+// Valor de effect que deja el efecto como esté
+#define LED_CUE_KEEP            (-2)
+
+// flags
+#define LED_CUE_COLOR           0x01
+#define LED_CUE_BRIGHTNESS      0x02
+
+/**
+ * @brief Un cue de la lista
+ */
+typedef struct {
+    uint32_t t_ms;          ///< Posición en la línea de tiempo
+    int16_t effect;         ///< Efecto, LED_FX_NONE o LED_CUE_KEEP
+    uint8_t flags;          ///< LED_CUE_COLOR | LED_CUE_BRIGHTNESS
+    uint8_t brightness;
+    uint8_t rgb[3];
+    uint16_t fade_ms;       ///< Transición del color y el brillo (0: corte)
+} led_cue_t;
+
+/**
+ * @brief Fuente de la línea de tiempo
+ */
+typedef enum {
+    LED_CUE_STOPPED = 0,    ///< Sin reproducción: los cues no se activan
+    LED_CUE_LOCAL,          ///< Reloj de animación desde led_cue_play()
+    LED_CUE_TIMECODE,       ///< Código de tiempo de la red
+} led_cue_source_t;
+
+/**
+ * @brief Estado de la reproducción y contadores
+ */
+typedef struct {
+    uint8_t source;             ///< led_cue_source_t
+    bool freewheel;             ///< Código de tiempo perdido, detenido en el sitio
+    uint16_t cues;              ///< Cues de la lista cargada
+    int16_t active;             ///< Índice del último cue activado (-1 ninguno)
+    int64_t position_us;        ///< Posición del último tick
+    uint32_t activations;       ///< Cues activados desde el arranque
+    uint32_t seeks;             ///< Búsquedas por salto de posición o carga
+    uint32_t timecodes;         ///< Mensajes de código de tiempo recibidos
+    uint32_t late_last_us;      ///< Posición del frame menos la del cue al activarlo
+    uint32_t late_max_us;
+    uint64_t late_sum_us;       ///< Media = late_sum_us / activations
+} led_cue_status_t;
+
+/**
+ * @brief Empieza a cargar una lista nueva
+ *
+ * La lista se construye en un segundo buffer mientras la anterior sigue
+ * reproduciéndose, y se cambia por ella en led_cue_load_commit(). Solo
+ * una tarea puede estar cargando a la vez.
+ *
+ * @return ESP_OK o ESP_ERR_INVALID_STATE si hay otra carga en curso o la
+ *         anterior aún no la ha recogido la tarea de render
+ */
+esp_err_t led_cue_load_begin(void);
+
+/**
+ * @brief Añade un cue a la lista en carga (en cualquier orden)
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si el efecto no existe,
+ *         ESP_ERR_NO_MEM con CONFIG_LED_CUE_MAX cues o
+ *         ESP_ERR_INVALID_STATE sin led_cue_load_begin()
+ */
+esp_err_t led_cue_load_add(const led_cue_t *cue);
+
+/**
+ * @brief Ordena la lista en carga y la entrega a la tarea de render
+ *
+ * La tarea de render la adopta en su siguiente tick y busca en ella la
+ * posición actual. La reproducción sigue con la misma fuente.
+ *
+ * @return ESP_OK o ESP_ERR_INVALID_STATE sin led_cue_load_begin()
+ */
+esp_err_t led_cue_load_commit(void);
+
+/**
+ * @brief Abandona la carga en curso sin cambiar la lista
+ */
+void led_cue_load_abort(void);
+
+/**
+ * @brief Decodifica un registro de LED_CUE_RECORD_SIZE bytes
+ *
+ * @return true si los campos reservados están a cero
+ */
+bool led_cue_decode(const uint8_t *rec, led_cue_t *cue);
+
+/**
+ * @brief Comprueba la cabecera del formato binario
+ *
+ * @return Número de cues que la siguen, o -1 si no es una cabecera válida
+ */
+int led_cue_decode_header(const uint8_t *hdr, size_t len);
+
+/**
+ * @brief Reproduce la lista con el reloj local desde una posición
+ */
+void led_cue_play(uint32_t from_ms);
+
+/**
+ * @brief Detiene la reproducción (el último cue se queda aplicado)
+ */
+void led_cue_stop(void);
+
+/**
+ * @brief Posición recibida de un código de tiempo de la red
+ *
+ * Pasa la reproducción a LED_CUE_TIMECODE. Si la posición se aleja más de
+ * 100 ms de la extrapolada desde el mensaje anterior, se trata como un
+ * salto; las diferencias menores (el jitter de la red) solo corrigen la
+ * posición.
+ *
+ * @param position_us Posición en la línea de tiempo
+ */
+void led_cue_timecode(int64_t position_us);
+
+/**
+ * @brief Activa los cues que tocan en este frame (solo desde la tarea de
+ * render, al empezar el tick)
+ */
+void led_cue_process(void);
+
+/**
+ * @brief Obtiene una copia del estado y los contadores
+ */
+void led_cue_get_status(led_cue_status_t *status);
+
+#endif // LED_CUE_H
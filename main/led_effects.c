@@ -0,0 +1,1392 @@
+/**
+ * @file led_effects.c
+ * @brief Implementación del motor de efectos
+ *
+ * Contiene el registro de efectos, los efectos nativos básicos, los de
+ * ruido, partículas y texto, y el efecto "vm" que ejecuta bytecode. Los efectos nativos "rainbow" y
+ * "plasma" tienen un programa de bytecode equivalente (misma matemática
+ * y mismas constantes) que sirve como referencia para el benchmark.
+ */
+
+#include "led_effects.h"
+#include "led_control.h"
+#include "led_chipset.h"
+#include "fx_math.h"
+#include "fx_vm.h"
+#include "fx_particles.h"
+#include "fx_noise.h"
+#include "fx_gfx.h"
+#include "fx_draw.h"
+#include <stdbool.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+static const char *TAG = "LED_EFFECTS";
+
+// Tamaño del frame de prueba del benchmark (independiente de la tira)
+#define BENCH_LEDS      256
+#define BENCH_FRAMES    20
+
+// Muestras de ruido calculadas de una vez en los efectos (buffer en el stack)
+#define NOISE_CHUNK     64
+
+// Velocidad del texto de "scroller" en columnas por segundo
+#define SCROLL_SPEED    12
+
+// Presupuesto de CPU por frame de efecto. Sin CONFIG_FX_BUDGET solo se
+// mide, contra el periodo completo
+#define FRAME_US            (1000000 / CONFIG_LED_RENDER_FPS)
+#ifdef CONFIG_FX_BUDGET
+#define BUDGET_US           (FRAME_US * CONFIG_FX_BUDGET_PERCENT / 100)
+#else
+#define BUDGET_US           FRAME_US
+#endif
+
+// Frames entre dos cambios de nivel: la media se asienta al nivel nuevo
+#define BUDGET_SETTLE       32
+
+// Se recupera un nivel cuando la media baja de este porcentaje del
+// presupuesto: al doblar el coste sigue sobrando margen
+#define BUDGET_RECOVER_PCT  40
+
+#ifdef CONFIG_FX_MULTICORE
+// Trabajador que calcula la segunda mitad de cada frame
+#define WORKER_CORE         1
+#define WORKER_TASK_STACK   3072
+#define WORKER_TASK_PRIO    5       // La misma que la tarea de render
+
+// Por debajo de este tamaño de trozo despertar al trabajador cuesta más
+// de lo que ahorra
+#define MIN_SLICE_LEDS      32
+#endif
+
+static SemaphoreHandle_t s_lock;
+static int s_selected = LED_FX_NONE;
+
+// VM duplicada: s_vm[s_vm_active] es la que se ejecuta
+static fx_vm_t s_vm[2];
+static int s_vm_active;
+
+// Pool compartido por los efectos de partículas (solo hay uno activo)
+static fx_particles_t s_particles;
+static int32_t s_emit;                  // Partículas pendientes de emitir (Q16.16)
+
+// Texto de "scroller"
+static char s_text[LED_FX_TEXT_MAX] = CONFIG_LED_MATRIX_TEXT;
+
+// Color de "solid"
+static uint8_t s_color[3] = { 255, 255, 255 };
+
+// Estado del cohete de "fireworks"
+static int32_t s_rocket_pos;
+static int32_t s_rocket_vel;
+static bool s_rocket_active;
+static int32_t s_next_launch;           // Segundos hasta el próximo lanzamiento (Q16.16)
+
+// Presupuesto de CPU del efecto activo
+static led_fx_budget_t s_budget = { .budget_us = BUDGET_US };
+static uint32_t s_avg_q4;               // Media móvil del coste (µs, Q28.4)
+static int s_settle;                    // Frames hasta poder cambiar de nivel
+static bool s_skip_phase;               // Alterna los frames a media frecuencia
+static int32_t s_skipped_dt;            // dt de los frames saltados (Q16.16)
+
+#ifdef CONFIG_FX_MULTICORE
+/**
+ * @brief Trozo del frame que calcula el trabajador
+ *
+ * Lo escribe la tarea de render antes de despertarlo y no lo vuelve a
+ * tocar hasta que el trabajador da s_slice_done.
+ */
+typedef struct {
+    const led_effect_t *fx;
+    void *rgb;
+    bool wide;
+    int start;
+    int end;
+    const led_fx_ctx_t *ctx;
+} fx_slice_t;
+
+static TaskHandle_t s_worker;
+static SemaphoreHandle_t s_slice_done;
+static fx_slice_t s_slice;
+#endif
+
+// ============================================================================
+// PROGRAMAS DE BYTECODE DE REFERENCIA
+// ============================================================================
+
+/**
+ * rainbow: hsv(x + t * 0.25, 1, 1)
+ */
+static const uint8_t s_rainbow_program[] = {
+    FXB_HEADER(0, 6, FX_VM_NO_ENTRY, 0),
+    FXB_LDI(4, 0x0040),                 // r4 = 0.25
+    FXB_OP(FX_OP_MUL, 4, 2, 4),         // r4 = t * 0.25
+    FXB_OP(FX_OP_ADD, 4, 1, 4),         // r4 = x + t * 0.25
+    FXB_LDI(5, 0x0100),                 // r5 = 1.0
+    FXB_OP(FX_OP_OUTHSV, 4, 5, 5),
+    FXB_OP(FX_OP_END, 0, 0, 0),
+};
+
+/**
+ * plasma: v1 = sin(2x + 0.5t), v2 = sin(5x - 0.3t)
+ *         rgb(v1 / 2 + 0.5, v2 / 2 + 0.5, (v1 + v2) / 4 + 0.5)
+ */
+static const uint8_t s_plasma_program[] = {
+    FXB_HEADER(0, 21, FX_VM_NO_ENTRY, 0),
+    FXB_LDI(4, 0x0200),                 // r4 = 2.0
+    FXB_OP(FX_OP_MUL, 4, 1, 4),         // r4 = 2x
+    FXB_LDI(5, 0x0080),                 // r5 = 0.5
+    FXB_OP(FX_OP_MAD, 4, 2, 5),         // r4 += 0.5t
+    FXB_OP(FX_OP_SIN, 4, 4, 0),         // r4 = v1
+    FXB_LDI(6, 0x0500),                 // r6 = 5.0
+    FXB_OP(FX_OP_MUL, 6, 1, 6),         // r6 = 5x
+    FXB_LDI(7, 0x004D),                 // r7 = 0.3
+    FXB_OP(FX_OP_MUL, 7, 2, 7),         // r7 = 0.3t
+    FXB_OP(FX_OP_SUB, 6, 6, 7),         // r6 = 5x - 0.3t
+    FXB_OP(FX_OP_SIN, 6, 6, 0),         // r6 = v2
+    FXB_OP(FX_OP_ADD, 7, 4, 6),         // r7 = v1 + v2
+    FXB_OP(FX_OP_MUL, 4, 4, 5),
+    FXB_OP(FX_OP_ADD, 4, 4, 5),         // r4 = v1 / 2 + 0.5
+    FXB_OP(FX_OP_MUL, 6, 6, 5),
+    FXB_OP(FX_OP_ADD, 6, 6, 5),         // r6 = v2 / 2 + 0.5
+    FXB_OP(FX_OP_MUL, 7, 7, 5),
+    FXB_OP(FX_OP_MUL, 7, 7, 5),
+    FXB_OP(FX_OP_ADD, 7, 7, 5),         // r7 = (v1 + v2) / 4 + 0.5
+    FXB_OP(FX_OP_OUT, 4, 6, 7),
+    FXB_OP(FX_OP_END, 0, 0, 0),
+};
+
+// ============================================================================
+// SPRITES (generados con tools/gfxpack.py)
+// ============================================================================
+
+// Corazón 7x6 de 2 bpp con bordes suavizados
+static const uint8_t s_heart_data[12] = {
+    0x78, 0xB4, 0xFF, 0xFC, 0xFF, 0xFC, 0x7F, 0xF4, 0x1F, 0xD0, 0x07, 0x40,
+};
+
+static const fx_bitmap_t s_heart = {
+    .data = s_heart_data,
+    .width = 7,
+    .height = 6,
+    .bpp = 2,
+    .stride = 2,
+};
+
+// ============================================================================
+// EFECTOS NATIVOS
+// ============================================================================
+
+/*
+ * Los efectos de degradados suaves (donde más se notan los escalones de 8
+ * bits) tienen versión de 16 bits por canal para CONFIG_LED_HDR. El cuerpo
+ * se escribe una vez como *_pixels() con put_pixel()/put_hsv() y
+ * FX_RENDER_PAIR() genera las dos funciones render; al ser inline forzado,
+ * cada una queda especializada sin comprobar "wide" por píxel.
+ */
+
+/**
+ * @brief Escribe el píxel i (canales Q16.16 en [0, 1]) en un frame de 8 o 16 bits
+ */
+FORCE_INLINE_ATTR void put_pixel(void *rgb, bool wide, int i,
+                                 int32_t r, int32_t g, int32_t b)
+{
+    if (wide) {
+        uint16_t *out = (uint16_t *)rgb + i * 3;
+        out[0] = fx_to_u16(r);
+        out[1] = fx_to_u16(g);
+        out[2] = fx_to_u16(b);
+    } else {
+        uint8_t *out = (uint8_t *)rgb + i * 3;
+        out[0] = fx_to_u8(r);
+        out[1] = fx_to_u8(g);
+        out[2] = fx_to_u8(b);
+    }
+}
+
+/**
+ * @brief Escribe el píxel i a partir de HSV en un frame de 8 o 16 bits
+ */
+FORCE_INLINE_ATTR void put_hsv(void *rgb, bool wide, int i,
+                               int32_t h, int32_t s, int32_t v)
+{
+    if (wide) {
+        fx_hsv_to_rgb16(h, s, v, (uint16_t *)rgb + i * 3);
+    } else {
+        fx_hsv_to_rgb(h, s, v, (uint8_t *)rgb + i * 3);
+    }
+}
+
+#define FX_RENDER_PAIR(name)                                                        \
+    static void name##_render(uint8_t *rgb, int start, int end,                     \
+                              const led_fx_ctx_t *ctx)                              \
+    {                                                                               \
+        name##_pixels(rgb, false, start, end, ctx);                                 \
+    }                                                                               \
+    static void name##_render16(uint16_t *rgb, int start, int end,                  \
+                                const led_fx_ctx_t *ctx)                            \
+    {                                                                               \
+        name##_pixels(rgb, true, start, end, ctx);                                  \
+    }
+
+FORCE_INLINE_ATTR void rainbow_pixels(void *rgb, bool wide, int start, int end,
+                                      const led_fx_ctx_t *ctx)
+{
+    int32_t step = fx_div(FX_ONE, FX_FROM_INT(ctx->num_leds));
+    int32_t offset = fx_mul(ctx->t, FX_FROM_Q8(0x0040));
+
+    for (int i = start; i < end; i++) {
+        put_hsv(rgb, wide, i, step * i + offset, FX_ONE, FX_ONE);
+    }
+}
+FX_RENDER_PAIR(rainbow)
+
+FORCE_INLINE_ATTR void plasma_pixels(void *rgb, bool wide, int start, int end,
+                                     const led_fx_ctx_t *ctx)
+{
+    int32_t step = fx_div(FX_ONE, FX_FROM_INT(ctx->num_leds));
+    int32_t phase1 = fx_mul(ctx->t, FX_FROM_Q8(0x0080));
+    int32_t phase2 = fx_mul(ctx->t, FX_FROM_Q8(0x004D));
+
+    for (int i = start; i < end; i++) {
+        int32_t x = step * i;
+        int32_t v1 = fx_sin(fx_mul(x, FX_FROM_Q8(0x0200)) + phase1);
+        int32_t v2 = fx_sin(fx_mul(x, FX_FROM_Q8(0x0500)) - phase2);
+        put_pixel(rgb, wide, i, (v1 >> 1) + FX_HALF, (v2 >> 1) + FX_HALF,
+                  ((v1 + v2) >> 2) + FX_HALF);
+    }
+}
+FX_RENDER_PAIR(plasma)
+
+/**
+ * @brief Analizador de espectro: la tira se reparte entre las bandas de
+ * audio, cada una con su color y con el brillo de su energía. El beat
+ * añade un destello blanco que decae con la envolvente.
+ */
+static void spectrum_render(uint8_t *rgb, int start, int end, const led_fx_ctx_t *ctx)
+{
+    if (ctx->audio == NULL) {
+        memset(rgb + start * 3, 0, (end - start) * 3);
+        return;
+    }
+
+    int32_t beat = ctx->audio->v[AUDIO_FEATURE_BEAT] >> 2;
+
+    for (int i = start; i < end; i++) {
+        int band = i * AUDIO_NUM_BANDS / ctx->num_leds;
+        int32_t hue = FX_FROM_INT(band) / AUDIO_NUM_BANDS;
+        int32_t v = ctx->audio->v[AUDIO_FEATURE_BAND0 + band];
+        fx_hsv_to_rgb(hue, FX_ONE - beat, fx_clamp01(v + beat), rgb + i * 3);
+    }
+}
+
+// --- Efectos de ruido ---
+
+/**
+ * @brief fire: llamas que suben desde el píxel 0 y se enfrían hacia el final
+ *
+ * Dos octavas de ruido 2D desplazándose hacia arriba, atenuadas con la
+ * altura y pasadas por la paleta negro -> rojo -> amarillo -> blanco.
+ */
+FORCE_INLINE_ATTR void fire_pixels(void *rgb, bool wide, int start, int end,
+                                   const led_fx_ctx_t *ctx)
+{
+    int32_t step = fx_div(FX_ONE, FX_FROM_INT(ctx->num_leds));
+    int32_t dx1 = step * 4;
+    int32_t dx2 = step * 8;
+    int32_t scroll = -fx_mul(ctx->t, FX_FROM_Q8(0x0180));
+    int32_t y = fx_mul(ctx->t, FX_FROM_Q8(0x00B3));
+
+    for (int i = start; i < end; i += NOISE_CHUNK) {
+        int32_t n1[NOISE_CHUNK], n2[NOISE_CHUNK];
+        int count = end - i < NOISE_CHUNK ? end - i : NOISE_CHUNK;
+        fx_noise2_row(scroll + dx1 * i, dx1, y, n1, count);
+        fx_noise2_row(2 * scroll + dx2 * i, dx2, y + FX_FROM_INT(37), n2, count);
+
+        for (int k = 0; k < count; k++) {
+            int32_t heat = ((n1[k] + (n2[k] >> 1)) >> 1) + FX_HALF;
+            heat = fx_mul(heat, fx_mul(FX_ONE - step * (i + k), FX_FROM_Q8(0x0180)));
+            int32_t h3 = heat * 3;
+            put_pixel(rgb, wide, i + k, h3, h3 - FX_ONE, h3 - 2 * FX_ONE);
+        }
+    }
+}
+FX_RENDER_PAIR(fire)
+
+/**
+ * @brief clouds: nubes blancas que se deforman lentamente sobre azul
+ */
+FORCE_INLINE_ATTR void clouds_pixels(void *rgb, bool wide, int start, int end,
+                                     const led_fx_ctx_t *ctx)
+{
+    int32_t step = fx_div(FX_ONE, FX_FROM_INT(ctx->num_leds));
+    int32_t dx = step * 3;
+    int32_t drift = fx_mul(ctx->t, FX_FROM_Q8(0x0026));
+    int32_t y = fx_mul(ctx->t, FX_FROM_Q8(0x001A));
+    int32_t z = fx_mul(ctx->t, FX_FROM_Q8(0x000D));
+
+    for (int i = start; i < end; i += NOISE_CHUNK) {
+        int32_t n[NOISE_CHUNK];
+        int count = end - i < NOISE_CHUNK ? end - i : NOISE_CHUNK;
+        fx_noise3_row(drift + dx * i, dx, y, z, n, count);
+
+        for (int k = 0; k < count; k++) {
+            // Cobertura: solo la parte alta del ruido forma nube
+            int32_t c = fx_clamp01(n[k] * 2);
+            put_pixel(rgb, wide, i + k,
+                      FX_FROM_Q8(0x0010) + fx_mul(c, FX_FROM_Q8(0x00F0)),
+                      FX_FROM_Q8(0x0040) + fx_mul(c, FX_FROM_Q8(0x00C0)),
+                      FX_FROM_Q8(0x00E0) + fx_mul(c, FX_FROM_Q8(0x0020)));
+        }
+    }
+}
+FX_RENDER_PAIR(clouds)
+
+/**
+ * @brief plasma3d: el tono sigue un campo de ruido 3D que evoluciona
+ */
+FORCE_INLINE_ATTR void plasma3d_pixels(void *rgb, bool wide, int start, int end,
+                                       const led_fx_ctx_t *ctx)
+{
+    int32_t step = fx_div(FX_ONE, FX_FROM_INT(ctx->num_leds));
+    int32_t dx = step * 2;
+    int32_t y = fx_mul(ctx->t, FX_FROM_Q8(0x004D));
+    int32_t z = fx_mul(ctx->t, FX_FROM_Q8(0x0033));
+    int32_t shift = fx_mul(ctx->t, FX_FROM_Q8(0x000D));
+
+    for (int i = start; i < end; i += NOISE_CHUNK) {
+        int32_t n[NOISE_CHUNK];
+        int count = end - i < NOISE_CHUNK ? end - i : NOISE_CHUNK;
+        fx_noise3_row(dx * i, dx, y, z, n, count);
+
+        for (int k = 0; k < count; k++) {
+            put_hsv(rgb, wide, i + k, n[k] + shift, FX_ONE, FX_ONE);
+        }
+    }
+}
+FX_RENDER_PAIR(plasma3d)
+
+// --- Efectos con posición sub-píxel ---
+
+/**
+ * @brief comet: una cabeza con estela recorre la tira cada 4 s
+ *
+ * La posición es continua (fx_draw.h): a cualquier velocidad la cabeza se
+ * desliza entre LEDs en lugar de saltar de uno a otro.
+ */
+static void comet_render(uint8_t *rgb, int start, int end, const led_fx_ctx_t *ctx)
+{
+    static const uint8_t black[3] = { 0, 0, 0 };
+    const fx_canvas_t cv = { .rgb = rgb, .start = start, .end = end };
+    int32_t len = FX_FROM_INT(ctx->num_leds);
+    int32_t head = fx_mul(fx_frac(fx_mul(ctx->t, FX_FROM_Q8(0x0040))), len);
+    int32_t tail = len / 8 > FX_FROM_INT(3) ? len / 8 : FX_FROM_INT(3);
+    uint8_t color[3];
+    fx_hsv_to_rgb(fx_mul(ctx->t, FX_FROM_Q8(0x0010)), FX_FROM_Q8(0x00C0), FX_ONE, color);
+
+    memset(rgb + start * 3, 0, (end - start) * 3);
+
+    // Al dar la vuelta, lo que sale por un extremo entra por el otro
+    for (int32_t shift = -len; shift <= len; shift += len) {
+        fx_draw_gradient(&cv, head - tail + shift, head + shift, black, color, FX_DRAW_ADD);
+        fx_draw_point(&cv, head + shift, color, FX_DRAW_ADD);
+    }
+}
+
+// --- Color fijo ---
+
+/**
+ * @brief solid: toda la tira de un color (led_effects_set_color())
+ */
+static void solid_render(uint8_t *rgb, int start, int end, const led_fx_ctx_t *ctx)
+{
+    for (int i = start; i < end; i++) {
+        memcpy(rgb + i * 3, s_color, 3);
+    }
+}
+
+// --- Efectos de matriz ---
+
+/**
+ * @brief scroller: icono y texto desplazándose de derecha a izquierda
+ * sobre un arcoíris tenue
+ */
+static void scroller_render(uint8_t *rgb, int start, int end, const led_fx_ctx_t *ctx)
+{
+    static const uint8_t white[3] = { 255, 255, 255 };
+    static const uint8_t red[3] = { 255, 20, 40 };
+
+    rainbow_render(rgb, start, end, ctx);
+    for (int i = start * 3; i < end * 3; i++) {
+        rgb[i] >>= 3;
+    }
+
+    const fx_canvas_t cv = { .rgb = rgb, .start = start, .end = end };
+    const int icon = s_heart.width + 2;
+    const int len = icon + fx_gfx_text_width(&fx_font_5x7, s_text);
+
+    // Entra por la derecha y sale por la izquierda, con posición sub-píxel
+    int32_t travel = FX_FROM_INT(FX_GFX_WIDTH + len);
+    int32_t x = FX_FROM_INT(FX_GFX_WIDTH) - (int32_t)(((int64_t)ctx->t * SCROLL_SPEED) % travel);
+    int y = (FX_GFX_HEIGHT - fx_font_5x7.height) / 2;
+
+    fx_gfx_blit(&cv, &s_heart, x, y, red);
+    fx_gfx_text(&cv, &fx_font_5x7, s_text, x + FX_FROM_INT(icon), y, white);
+}
+
+// --- Efectos de partículas ---
+
+/**
+ * @brief Acumula rate * dt y devuelve cuántas partículas emitir este frame
+ *
+ * Con el efecto degradado se emite la mitad.
+ *
+ * @param rate Partículas por segundo (Q16.16)
+ */
+static int particles_to_emit(int32_t rate, const led_fx_ctx_t *ctx)
+{
+    if (ctx->degrade != LED_FX_DEGRADE_NONE) {
+        rate >>= 1;
+    }
+    s_emit += fx_mul(rate, ctx->dt);
+    int n = s_emit >> FX_SHIFT;
+    s_emit &= FX_ONE - 1;
+    return n;
+}
+
+static void particles_start(void)
+{
+    fx_particles_init(&s_particles, 0, 0);
+    s_emit = 0;
+}
+
+static void particles_render(uint8_t *rgb, int start, int end, const led_fx_ctx_t *ctx)
+{
+    memset(rgb + start * 3, 0, (end - start) * 3);
+    fx_particles_render(&s_particles, rgb, start, end);
+}
+
+/**
+ * @brief sparks: chispas que salen del píxel 0 y caen por la gravedad
+ */
+static void sparks_frame(const led_fx_ctx_t *ctx)
+{
+    fx_particles_t *ps = &s_particles;
+    int32_t len = FX_FROM_INT(ctx->num_leds);
+
+    ps->gravity = -2 * len;
+    ps->drag = FX_HALF;
+    fx_particles_update(ps, ctx->dt, ctx->num_leds);
+
+    // 2 chispas por LED y segundo
+    int n = particles_to_emit(2 * len, ctx);
+    for (int k = 0; k < n; k++) {
+        uint8_t rgb[3] = { 255, 80 + (fx_particles_rand(ps) & 0x7F), 20 };
+        int32_t vel = fx_mul(len, fx_particles_rand_range(ps, FX_FROM_Q8(0x00CC), FX_FROM_Q8(0x01CC)));
+        int32_t life = fx_particles_rand_range(ps, FX_ONE, 2 * FX_ONE);
+        fx_particles_spawn(ps, 0, vel, life, rgb);
+    }
+}
+
+/**
+ * @brief rain: gotas que aparecen en el último píxel y caen hacia el 0
+ */
+static void rain_frame(const led_fx_ctx_t *ctx)
+{
+    fx_particles_t *ps = &s_particles;
+    int32_t len = FX_FROM_INT(ctx->num_leds);
+    static const uint8_t drop[3] = { 40, 90, 255 };
+
+    ps->gravity = -len;
+    ps->drag = 0;
+    fx_particles_update(ps, ctx->dt, ctx->num_leds);
+
+    // Una gota cada 10 LEDs por segundo
+    int n = particles_to_emit(len / 10, ctx);
+    for (int k = 0; k < n; k++) {
+        int32_t vel = -fx_mul(len, fx_particles_rand_range(ps, FX_FROM_Q8(0x001A), FX_FROM_Q8(0x0066)));
+        fx_particles_spawn(ps, len - FX_ONE, vel, 3 * FX_ONE, drop);
+    }
+}
+
+static void fireworks_start(void)
+{
+    particles_start();
+    s_rocket_active = false;
+    s_next_launch = FX_HALF;
+}
+
+/**
+ * @brief fireworks: un cohete sube desde el píxel 0 y al llegar arriba
+ * estalla en partículas de un color aleatorio que se frenan y caen
+ */
+static void fireworks_frame(const led_fx_ctx_t *ctx)
+{
+    fx_particles_t *ps = &s_particles;
+    int32_t len = FX_FROM_INT(ctx->num_leds);
+
+    ps->gravity = -len / 2;
+    ps->drag = FX_FROM_Q8(0x0180);
+    fx_particles_update(ps, ctx->dt, ctx->num_leds);
+
+    if (!s_rocket_active) {
+        s_next_launch -= ctx->dt;
+        if (s_next_launch <= 0) {
+            s_rocket_active = true;
+            s_rocket_pos = 0;
+            s_rocket_vel = fx_mul(len, fx_particles_rand_range(ps, FX_FROM_Q8(0x0133), FX_FROM_Q8(0x019A)));
+        }
+        return;
+    }
+
+    // El cohete sigue su propia balística (más gravedad, sin rozamiento)
+    s_rocket_vel -= fx_mul(2 * len, ctx->dt);
+    s_rocket_pos += fx_mul(s_rocket_vel, ctx->dt);
+
+    if (s_rocket_vel > 0) {
+        // Estela: chispas tenues y cortas
+        static const uint8_t trail[3] = { 120, 60, 10 };
+        fx_particles_spawn(ps, s_rocket_pos, 0, FX_FROM_Q8(0x0040), trail);
+        return;
+    }
+
+    // Apogeo: explosión
+    uint8_t color[3];
+    fx_hsv_to_rgb(fx_particles_rand_range(ps, 0, FX_ONE), FX_FROM_Q8(0x00C0), FX_ONE, color);
+    int n = (16 + (fx_particles_rand(ps) & 15)) >> (ctx->degrade != LED_FX_DEGRADE_NONE);
+    for (int k = 0; k < n; k++) {
+        int32_t vel = fx_mul(len, fx_particles_rand_range(ps, -FX_FROM_Q8(0x0099), FX_FROM_Q8(0x0099)));
+        int32_t life = fx_particles_rand_range(ps, FX_FROM_Q8(0x00CC), FX_FROM_Q8(0x01A0));
+        fx_particles_spawn(ps, s_rocket_pos, vel, life, color);
+    }
+    s_rocket_active = false;
+    s_next_launch = fx_particles_rand_range(ps, FX_FROM_Q8(0x0080), 2 * FX_ONE);
+}
+
+static void vm_frame(const led_fx_ctx_t *ctx)
+{
+    fx_vm_run_frame(&s_vm[s_vm_active], ctx);
+}
+
+static void vm_render(uint8_t *rgb, int start, int end, const led_fx_ctx_t *ctx)
+{
+    fx_vm_run_pixels(&s_vm[s_vm_active], rgb, start, end, ctx);
+}
+
+static bool vm_serial(void)
+{
+    return s_vm[s_vm_active].carries_state;
+}
+
+// ============================================================================
+// REGISTRO DE EFECTOS
+// ============================================================================
+
+static const led_effect_t s_effects[] = {
+    { .name = "rainbow",   .render = rainbow_render, .render16 = rainbow_render16,
+      .scalable = true },
+    { .name = "plasma",    .render = plasma_render, .render16 = plasma_render16,
+      .scalable = true },
+    { .name = "spectrum",  .render = spectrum_render, .scalable = true },
+    { .name = "fire",      .render = fire_render, .render16 = fire_render16,
+      .scalable = true },
+    { .name = "clouds",    .render = clouds_render, .render16 = clouds_render16,
+      .scalable = true },
+    { .name = "plasma3d",  .render = plasma3d_render, .render16 = plasma3d_render16,
+      .scalable = true },
+    { .name = "scroller",  .render = scroller_render },
+    { .name = "sparks",    .start = particles_start, .frame = sparks_frame,
+      .render = particles_render },
+    { .name = "rain",      .start = particles_start, .frame = rain_frame,
+      .render = particles_render },
+    { .name = "fireworks", .start = fireworks_start, .frame = fireworks_frame,
+      .render = particles_render },
+    { .name = "vm",        .frame = vm_frame, .render = vm_render, .serial = vm_serial,
+      .scalable = true },
+    { .name = "comet",     .render = comet_render, .scalable = true },
+    { .name = "solid",     .render = solid_render },
+};
+
+#define NUM_EFFECTS ((int)(sizeof(s_effects) / sizeof(s_effects[0])))
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+/**
+ * @brief Calcula los píxeles [start, end) de un efecto en 8 o 16 bits
+ *
+ * Sin render16() el efecto calcula en 8 bits en la parte alta del propio
+ * rango y se expande hacia delante: el byte k se lee antes de que la
+ * escritura del canal k lo pise, y nada se sale de los bytes del rango en
+ * 16 bits, así que dos rangos disjuntos pueden calcularse a la vez.
+ */
+static void render_range(const led_effect_t *fx, void *rgb, bool wide, int start, int end,
+                         const led_fx_ctx_t *ctx)
+{
+    if (!wide) {
+        fx->render(rgb, start, end, ctx);
+        return;
+    }
+
+    uint16_t *rgb16 = rgb;
+    if (fx->render16) {
+        fx->render16(rgb16, start, end, ctx);
+        return;
+    }
+
+    uint8_t *rgb8 = (uint8_t *)rgb + end * 3;
+    fx->render(rgb8, start, end, ctx);
+    for (int k = start * 3; k < end * 3; k++) {
+        rgb16[k] = rgb8[k] * 257;
+    }
+}
+
+#ifdef CONFIG_FX_MULTICORE
+/**
+ * @brief Trabajador del segundo core: espera un trozo, lo calcula y avisa
+ */
+static void worker_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        render_range(s_slice.fx, s_slice.rgb, s_slice.wide, s_slice.start, s_slice.end,
+                     s_slice.ctx);
+        xSemaphoreGive(s_slice_done);
+    }
+}
+#endif
+
+/**
+ * @brief Calcula un frame completo, repartido entre los dos cores si se puede
+ *
+ * El que llama calcula la primera mitad mientras el trabajador calcula la
+ * segunda, y no vuelve hasta que los dos han terminado.
+ */
+static void render_frame(const led_effect_t *fx, void *rgb, bool wide, const led_fx_ctx_t *ctx)
+{
+    int n = ctx->num_leds;
+
+#ifdef CONFIG_FX_MULTICORE
+    if (s_worker && n >= 2 * MIN_SLICE_LEDS && !(fx->serial && fx->serial())) {
+        int split = n / 2;
+        s_slice = (fx_slice_t){ .fx = fx, .rgb = rgb, .wide = wide,
+                                .start = split, .end = n, .ctx = ctx };
+        xTaskNotifyGive(s_worker);
+        render_range(fx, rgb, wide, 0, split, ctx);
+        xSemaphoreTake(s_slice_done, portMAX_DELAY);
+        return;
+    }
+#endif
+
+    render_range(fx, rgb, wide, 0, n, ctx);
+}
+
+/**
+ * @brief Calcula un frame al nivel de degradación de ctx
+ *
+ * Desde LED_FX_DEGRADE_DETAIL los efectos escalables se calculan con la
+ * mitad de píxeles y se duplican hacia atrás en el mismo buffer: el píxel
+ * i sale del i / 2, que todavía no se ha pisado.
+ */
+static void render_degraded(const led_effect_t *fx, void *rgb, bool wide,
+                            const led_fx_ctx_t *ctx)
+{
+    int n = ctx->num_leds;
+
+    if (ctx->degrade == LED_FX_DEGRADE_NONE || !fx->scalable || n < 2) {
+        render_frame(fx, rgb, wide, ctx);
+        return;
+    }
+
+    led_fx_ctx_t half = *ctx;
+    half.num_leds = (n + 1) / 2;
+    render_frame(fx, rgb, wide, &half);
+
+    const size_t px = wide ? 3 * sizeof(uint16_t) : 3;
+    uint8_t *p = rgb;
+    for (int i = n - 1; i > 0; i--) {
+        memcpy(p + i * px, p + (i / 2) * px, px);
+    }
+}
+
+/**
+ * @brief Vuelve a calidad completa y reinicia la medida (cambio de efecto)
+ */
+static void budget_reset(void)
+{
+    s_budget.avg_us = 0;
+    s_budget.max_us = 0;
+    s_budget.level = LED_FX_DEGRADE_NONE;
+    s_avg_q4 = 0;
+    s_settle = BUDGET_SETTLE;
+    s_skip_phase = false;
+    s_skipped_dt = 0;
+}
+
+/**
+ * @brief Prepara el contexto del frame según el nivel de degradación
+ *
+ * @return false si a media frecuencia este frame no se calcula; su dt se
+ *         suma al del siguiente para que la animación no se frene
+ */
+static bool budget_begin(const led_fx_ctx_t *ctx, led_fx_ctx_t *out)
+{
+    *out = *ctx;
+    out->degrade = s_budget.level;
+
+    if (s_budget.level >= LED_FX_DEGRADE_FPS) {
+        s_skip_phase = !s_skip_phase;
+        if (s_skip_phase) {
+            s_skipped_dt += ctx->dt;
+            s_budget.skipped++;
+            return false;
+        }
+    }
+    out->dt += s_skipped_dt;
+    s_skipped_dt = 0;
+    return true;
+}
+
+/**
+ * @brief Registra el coste de un frame y cambia de nivel si hace falta
+ *
+ * A media frecuencia cada frame calculado dispone de dos periodos. Se baja
+ * un nivel cuando la media supera el presupuesto del nivel actual y se
+ * sube cuando queda por debajo de BUDGET_RECOVER_PCT del presupuesto; entre
+ * dos cambios pasan al menos BUDGET_SETTLE frames.
+ */
+static void budget_end(const led_effect_t *fx, uint32_t cost_us)
+{
+    uint32_t budget = BUDGET_US << (s_budget.level >= LED_FX_DEGRADE_FPS);
+
+    // Media móvil exponencial con peso 1/8
+    s_avg_q4 += ((int32_t)(cost_us << 4) - (int32_t)s_avg_q4) / 8;
+    s_budget.avg_us = s_avg_q4 >> 4;
+    if (cost_us > s_budget.max_us) {
+        s_budget.max_us = cost_us;
+    }
+    if (cost_us > budget) {
+        s_budget.over_budget++;
+    }
+
+#ifdef CONFIG_FX_BUDGET
+    if (s_settle > 0) {
+        s_settle--;
+        return;
+    }
+
+    if (s_budget.avg_us > budget && s_budget.level < LED_FX_DEGRADE_FPS) {
+        s_budget.level++;
+        s_budget.degrades++;
+    } else if (s_budget.level > LED_FX_DEGRADE_NONE &&
+               s_budget.avg_us < BUDGET_US * BUDGET_RECOVER_PCT / 100) {
+        s_budget.level--;
+        s_budget.recovers++;
+    } else {
+        return;
+    }
+    s_settle = BUDGET_SETTLE;
+
+    ESP_LOGW(TAG, "%s: %lu us por frame (presupuesto %lu us), nivel de degradación %d",
+             fx->name, (unsigned long)s_budget.avg_us, (unsigned long)BUDGET_US,
+             s_budget.level);
+#endif
+}
+
+/**
+ * @brief Calcula un frame del efecto activo (8 o 16 bits) midiendo su coste
+ */
+static bool render_selected(void *rgb, bool wide, const led_fx_ctx_t *ctx)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    if (s_selected == LED_FX_NONE) {
+        xSemaphoreGive(s_lock);
+        return false;
+    }
+
+    const led_effect_t *fx = &s_effects[s_selected];
+    led_fx_ctx_t c;
+    bool run = budget_begin(ctx, &c);
+    if (run) {
+        int64_t start = esp_timer_get_time();
+        if (fx->frame) {
+            fx->frame(&c);
+        }
+        render_degraded(fx, rgb, wide, &c);
+        budget_end(fx, (uint32_t)(esp_timer_get_time() - start));
+    }
+
+    xSemaphoreGive(s_lock);
+    return run;
+}
+
+/**
+ * @brief Ciclos por píxel de un efecto sobre el frame de prueba
+ */
+static uint32_t bench_effect(const led_effect_t *fx, uint8_t *rgb)
+{
+    led_fx_ctx_t ctx = { .num_leds = BENCH_LEDS };
+    uint32_t total = 0;
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        ctx.frame = f;
+        ctx.t = f * (FX_ONE / 60);
+        uint32_t start = esp_cpu_get_cycle_count();
+        if (fx->frame) {
+            fx->frame(&ctx);
+        }
+        fx->render(rgb, 0, BENCH_LEDS, &ctx);
+        total += esp_cpu_get_cycle_count() - start;
+    }
+    return total / (BENCH_FRAMES * BENCH_LEDS);
+}
+
+/**
+ * @brief Ciclos por muestra de las funciones de ruido
+ *
+ * Una fila de BENCH_LEDS muestras que cruza 4 celdas, como una tira con
+ * escala 4: el caso en el que las versiones _row() reutilizan más.
+ */
+static void bench_noise(void)
+{
+    static int32_t row[BENCH_LEDS];
+    const int32_t dx = FX_FROM_INT(4) / BENCH_LEDS;
+    const uint32_t samples = BENCH_FRAMES * BENCH_LEDS;
+    volatile int32_t sink = 0;
+    uint32_t start, value2 = 0, noise2 = 0, noise2_row = 0, noise3 = 0, noise3_row = 0;
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        int32_t y = f * (FX_ONE / 60);
+
+        start = esp_cpu_get_cycle_count();
+        for (int k = 0; k < BENCH_LEDS; k++) {
+            sink += fx_value_noise2(k * dx, y);
+        }
+        value2 += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        for (int k = 0; k < BENCH_LEDS; k++) {
+            sink += fx_noise2(k * dx, y);
+        }
+        noise2 += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        fx_noise2_row(0, dx, y, row, BENCH_LEDS);
+        noise2_row += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        for (int k = 0; k < BENCH_LEDS; k++) {
+            sink += fx_noise3(k * dx, y, y >> 1);
+        }
+        noise3 += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        fx_noise3_row(0, dx, y, y >> 1, row, BENCH_LEDS);
+        noise3_row += esp_cpu_get_cycle_count() - start;
+    }
+
+    ESP_LOGI(TAG, "  ruido (ciclos/muestra): valor2d %lu | perlin2d %lu, fila %lu | "
+             "perlin3d %lu, fila %lu",
+             (unsigned long)(value2 / samples), (unsigned long)(noise2 / samples),
+             (unsigned long)(noise2_row / samples), (unsigned long)(noise3 / samples),
+             (unsigned long)(noise3_row / samples));
+}
+
+/**
+ * @brief Ciclos por píxel de la versión de 16 bits de un efecto
+ */
+static uint32_t bench_effect16(const led_effect_t *fx, uint16_t *rgb)
+{
+    led_fx_ctx_t ctx = { .num_leds = BENCH_LEDS };
+    uint32_t total = 0;
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        ctx.frame = f;
+        ctx.t = f * (FX_ONE / 60);
+        uint32_t start = esp_cpu_get_cycle_count();
+        if (fx->frame) {
+            fx->frame(&ctx);
+        }
+        fx->render16(rgb, 0, BENCH_LEDS, &ctx);
+        total += esp_cpu_get_cycle_count() - start;
+    }
+    return total / (BENCH_FRAMES * BENCH_LEDS);
+}
+
+/**
+ * @brief Ciclos por píxel de la codificación de un frame para la tira
+ *
+ * Incluye la calibración si se pasa y, con CONFIG_LED_HDR, la cuantización
+ * a 8 bits con dither, y en el backend paralelo la trasposición. n no
+ * puede pasar de LED_NUM_LEDS porque la calibración tiene una entrada por
+ * LED de la tira.
+ *
+ * @param stride Canales entre píxeles de px (0: relleno de un color)
+ * @param n      Píxeles (con stride != 0, como mucho BENCH_LEDS)
+ */
+static uint32_t bench_commit(const led_chan_t *px, size_t stride, int n, const led_calib_t *cal)
+{
+    static WORD_ALIGNED_ATTR uint8_t wire[LED_CHIPSET_WIRE_BYTES(BENCH_LEDS)];
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        led_chipset_encode(wire, px, stride, n, cal, f);
+    }
+    return (esp_cpu_get_cycle_count() - start) / (BENCH_FRAMES * n);
+}
+
+/**
+ * @brief Ciclos por frame de "scroller" (fondo + icono + texto)
+ */
+static uint32_t bench_scroller(uint8_t *rgb)
+{
+    led_fx_ctx_t ctx = { .num_leds = BENCH_LEDS };
+    uint32_t total = 0;
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        ctx.t = f * (FX_ONE / 60);
+        uint32_t start = esp_cpu_get_cycle_count();
+        scroller_render(rgb, 0, BENCH_LEDS, &ctx);
+        total += esp_cpu_get_cycle_count() - start;
+    }
+    return total / BENCH_FRAMES;
+}
+
+/**
+ * @brief Ciclos por píxel pintado de las primitivas sub-píxel frente a un
+ * relleno en posiciones enteras
+ *
+ * Barras de 16 LEDs (17 píxeles tocados con x fraccionaria) en posiciones
+ * que recorren el frame de prueba.
+ */
+static void bench_draw(uint8_t *rgb)
+{
+    static const uint8_t color[3] = { 255, 128, 32 };
+    static const uint8_t black[3] = { 0, 0, 0 };
+    const fx_canvas_t cv = { .rgb = rgb, .start = 0, .end = BENCH_LEDS };
+    const int bar = 16, count = BENCH_LEDS - bar - 1;
+    uint32_t start, fill = 0, over = 0, add = 0, grad = 0;
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        start = esp_cpu_get_cycle_count();
+        for (int x = 0; x < count; x++) {
+            for (int i = x; i < x + bar; i++) {
+                memcpy(rgb + i * 3, color, 3);
+            }
+        }
+        fill += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        for (int x = 0; x < count; x++) {
+            int32_t x0 = FX_FROM_INT(x) + f * (FX_ONE / BENCH_FRAMES);
+            fx_draw_bar(&cv, x0, x0 + FX_FROM_INT(bar), color, FX_DRAW_OVER);
+        }
+        over += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        for (int x = 0; x < count; x++) {
+            int32_t x0 = FX_FROM_INT(x) + f * (FX_ONE / BENCH_FRAMES);
+            fx_draw_bar(&cv, x0, x0 + FX_FROM_INT(bar), color, FX_DRAW_ADD);
+        }
+        add += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        for (int x = 0; x < count; x++) {
+            int32_t x0 = FX_FROM_INT(x) + f * (FX_ONE / BENCH_FRAMES);
+            fx_draw_gradient(&cv, x0, x0 + FX_FROM_INT(bar), black, color, FX_DRAW_OVER);
+        }
+        grad += esp_cpu_get_cycle_count() - start;
+    }
+
+    const uint32_t pixels = BENCH_FRAMES * count * bar;
+    ESP_LOGI(TAG, "  dibujo (ciclos/píxel): relleno entero %lu | barra sub-píxel %lu, "
+             "sumando %lu | degradado %lu",
+             (unsigned long)(fill / pixels), (unsigned long)(over / pixels),
+             (unsigned long)(add / pixels), (unsigned long)(grad / pixels));
+}
+
+/**
+ * @brief Ciclos por partícula (física + render) con el pool lleno
+ */
+static uint32_t bench_particles(uint8_t *rgb)
+{
+    static fx_particles_t pool;
+    static const uint8_t white[3] = { 255, 255, 255 };
+
+    fx_particles_init(&pool, -FX_FROM_INT(BENCH_LEDS), FX_HALF);
+    while (pool.count < FX_PARTICLES_MAX) {
+        // Vida larga y velocidad baja: ninguna muere durante la medida
+        int32_t pos = fx_particles_rand_range(&pool, FX_FROM_INT(BENCH_LEDS / 4),
+                                              FX_FROM_INT(BENCH_LEDS * 3 / 4));
+        fx_particles_spawn(&pool, pos, FX_FROM_INT(10), FX_FROM_INT(100), white);
+    }
+
+    uint32_t total = 0;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        fx_particles_update(&pool, FX_ONE / 100, BENCH_LEDS);
+        fx_particles_render(&pool, rgb, 0, BENCH_LEDS);
+        total += esp_cpu_get_cycle_count() - start;
+    }
+    return total / (BENCH_FRAMES * FX_PARTICLES_MAX);
+}
+
+#ifdef CONFIG_FX_MULTICORE
+/**
+ * @brief Ciclos por frame de cada efecto en un core y repartido en dos
+ *
+ * Usa el estado real de los efectos (pool de partículas, VM activa), así
+ * que se hace con el mutex tomado y al terminar se reinicia el efecto
+ * seleccionado. La VM solo se mide si tiene un programa cargado; sus
+ * registros globales se restauran.
+ */
+static void bench_scaling(uint8_t *rgb)
+{
+    led_fx_ctx_t ctx = { .num_leds = BENCH_LEDS, .dt = FX_ONE / 60 };
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    for (int id = 0; id < NUM_EFFECTS; id++) {
+        const led_effect_t *fx = &s_effects[id];
+        fx_vm_t *vm = &s_vm[s_vm_active];
+        int32_t globals[FX_VM_NUM_REGS - FX_VM_FIRST_GLOBAL];
+
+        if (fx->render == vm_render) {
+            if (!vm->loaded) {
+                continue;
+            }
+            memcpy(globals, vm->globals, sizeof(globals));
+        }
+        if (fx->start) {
+            fx->start();
+        }
+
+        uint32_t one = 0, two = 0;
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            ctx.frame = f;
+            ctx.t = f * (FX_ONE / 60);
+            if (fx->frame) {
+                fx->frame(&ctx);
+            }
+            uint32_t start = esp_cpu_get_cycle_count();
+            render_range(fx, rgb, false, 0, BENCH_LEDS, &ctx);
+            one += esp_cpu_get_cycle_count() - start;
+
+            start = esp_cpu_get_cycle_count();
+            render_frame(fx, rgb, false, &ctx);
+            two += esp_cpu_get_cycle_count() - start;
+        }
+
+        if (fx->render == vm_render) {
+            memcpy(vm->globals, globals, sizeof(globals));
+        }
+
+        bool serial = fx->serial && fx->serial();
+        ESP_LOGI(TAG, "  %-9s 1 core %6lu ciclos/frame | 2 cores %6lu (eficiencia %3lu %%)%s",
+                 fx->name, (unsigned long)(one / BENCH_FRAMES), (unsigned long)(two / BENCH_FRAMES),
+                 (unsigned long)((uint64_t)one * 100 / (2 * (uint64_t)(two ? two : 1))),
+                 serial ? " un solo core" : "");
+    }
+
+    if (s_selected != LED_FX_NONE && s_effects[s_selected].start) {
+        s_effects[s_selected].start();
+    }
+    xSemaphoreGive(s_lock);
+}
+#endif
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+void led_effects_render_table(const led_fx_table_t *table, uint8_t *rgb,
+                              int start, int end, const led_fx_ctx_t *ctx)
+{
+    uint32_t phase = ctx->t_ms % table->period_ms;
+    uint32_t index = (uint32_t)(((uint64_t)phase * table->num_frames) / table->period_ms);
+    const uint8_t *frame = table->frames + index * table->num_leds * 3;
+
+    int i = start;
+    while (i < end) {
+        int src = i % table->num_leds;
+        int run = table->num_leds - src;
+        if (run > end - i) {
+            run = end - i;
+        }
+        memcpy(rgb + i * 3, frame + src * 3, run * 3);
+        i += run;
+    }
+}
+
+void led_effects_init(void)
+{
+    s_lock = xSemaphoreCreateMutex();
+
+#ifdef CONFIG_FX_MULTICORE
+    s_slice_done = xSemaphoreCreateBinary();
+    if (xTaskCreatePinnedToCore(worker_task, "FX_WORKER", WORKER_TASK_STACK, NULL,
+                                WORKER_TASK_PRIO, &s_worker, WORKER_CORE) != pdPASS) {
+        // Sin trabajador todo el frame se calcula en el core de render
+        s_worker = NULL;
+        ESP_LOGW(TAG, "No se pudo crear el trabajador del core %d", WORKER_CORE);
+    }
+#endif
+}
+
+int led_effects_count(void)
+{
+    return NUM_EFFECTS;
+}
+
+const led_effect_t *led_effects_get(int id)
+{
+    return (id >= 0 && id < NUM_EFFECTS) ? &s_effects[id] : NULL;
+}
+
+int led_effects_find(const char *name)
+{
+    for (int i = 0; i < NUM_EFFECTS; i++) {
+        if (strcmp(s_effects[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return LED_FX_NONE;
+}
+
+esp_err_t led_effects_select(int id)
+{
+    if (id != LED_FX_NONE && led_effects_get(id) == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_selected = id;
+    if (id != LED_FX_NONE && s_effects[id].start) {
+        s_effects[id].start();
+    }
+    budget_reset();
+    xSemaphoreGive(s_lock);
+
+    ESP_LOGI(TAG, "Efecto activo: %s", id == LED_FX_NONE ? "ninguno" : s_effects[id].name);
+    return ESP_OK;
+}
+
+int led_effects_selected(void)
+{
+    return s_selected;
+}
+
+bool led_effects_render(uint8_t *rgb, const led_fx_ctx_t *ctx)
+{
+    return render_selected(rgb, false, ctx);
+}
+
+bool led_effects_render16(uint16_t *rgb, const led_fx_ctx_t *ctx)
+{
+    return render_selected(rgb, true, ctx);
+}
+
+esp_err_t led_effects_set_text(const char *text)
+{
+    if (text == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t len = strlen(text);
+    if (len >= LED_FX_TEXT_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    memcpy(s_text, text, len + 1);
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+void led_effects_set_color(uint8_t r, uint8_t g, uint8_t b)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_color[0] = r;
+    s_color[1] = g;
+    s_color[2] = b;
+    xSemaphoreGive(s_lock);
+}
+
+esp_err_t led_effects_load_program(const uint8_t *bin, size_t len)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    int spare = s_vm_active ^ 1;
+    esp_err_t err = fx_vm_load(&s_vm[spare], bin, len);
+    if (err == ESP_OK) {
+        s_vm_active = spare;
+    }
+
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+void led_effects_get_budget(led_fx_budget_t *budget)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *budget = s_budget;
+    xSemaphoreGive(s_lock);
+}
+
+void led_effects_benchmark(void)
+{
+    static uint8_t native_rgb[BENCH_LEDS * 3];
+    static uint8_t vm_rgb[BENCH_LEDS * 3];
+    static uint16_t hdr_rgb[BENCH_LEDS * 3];
+    static led_chan_t chan_rgb[BENCH_LEDS * 3];
+    static led_chan_t chan_px[BENCH_LEDS * LED_CHANNELS];
+    static fx_vm_t bench_vm;
+
+    static const struct {
+        const char *name;
+        const uint8_t *program;
+        size_t len;
+    } pairs[] = {
+        { "rainbow", s_rainbow_program, sizeof(s_rainbow_program) },
+        { "plasma",  s_plasma_program,  sizeof(s_plasma_program) },
+    };
+
+    ESP_LOGI(TAG, "Benchmark de efectos (%d píxeles, %d frames):", BENCH_LEDS, BENCH_FRAMES);
+
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        const led_effect_t *native = &s_effects[led_effects_find(pairs[i].name)];
+        if (fx_vm_load(&bench_vm, pairs[i].program, pairs[i].len) != ESP_OK) {
+            ESP_LOGE(TAG, "  %s: programa de referencia no válido", pairs[i].name);
+            continue;
+        }
+
+        uint32_t native_cpp = bench_effect(native, native_rgb);
+
+        led_fx_ctx_t ctx = { .num_leds = BENCH_LEDS };
+        uint32_t total = 0;
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            ctx.frame = f;
+            ctx.t = f * (FX_ONE / 60);
+            uint32_t start = esp_cpu_get_cycle_count();
+            fx_vm_run_frame(&bench_vm, &ctx);
+            fx_vm_run_pixels(&bench_vm, vm_rgb, 0, BENCH_LEDS, &ctx);
+            total += esp_cpu_get_cycle_count() - start;
+        }
+        uint32_t vm_cpp = total / (BENCH_FRAMES * BENCH_LEDS);
+
+        bool match = memcmp(native_rgb, vm_rgb, sizeof(native_rgb)) == 0;
+        ESP_LOGI(TAG, "  %-8s nativo %4lu ciclos/píxel | vm %4lu ciclos/píxel (x%lu.%lu) %s",
+                 pairs[i].name, (unsigned long)native_cpp, (unsigned long)vm_cpp,
+                 (unsigned long)(vm_cpp / (native_cpp ? native_cpp : 1)),
+                 (unsigned long)((vm_cpp * 10 / (native_cpp ? native_cpp : 1)) % 10),
+                 match ? "" : "¡SALIDA DISTINTA!");
+
+        if (native->render16) {
+            ESP_LOGI(TAG, "  %-8s 16 bits %4lu ciclos/píxel", pairs[i].name,
+                     (unsigned long)bench_effect16(native, hdr_rgb));
+        }
+    }
+
+    bench_noise();
+    bench_draw(native_rgb);
+
+#ifdef CONFIG_FX_MULTICORE
+    ESP_LOGI(TAG, "  reparto del frame entre los dos cores (%d píxeles):", BENCH_LEDS);
+    bench_scaling(native_rgb);
+#endif
+
+    uint32_t text_cycles = bench_scroller(native_rgb);
+    ESP_LOGI(TAG, "  scroller %lu ciclos/frame (%dx%d, %lu.%02lu %% de CPU a %d fps)",
+             (unsigned long)text_cycles, FX_GFX_WIDTH, FX_GFX_HEIGHT,
+             (unsigned long)(text_cycles * CONFIG_LED_RENDER_FPS /
+                             (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 10000u)),
+             (unsigned long)(text_cycles * CONFIG_LED_RENDER_FPS /
+                             (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 100u) % 100),
+             CONFIG_LED_RENDER_FPS);
+
+    // Extracción del blanco que se añade a cada frame en tiras RGBW
+    static led_chan_t rgbw[BENCH_LEDS * 4];
+    for (int k = 0; k < BENCH_LEDS * 3; k++) {
+        chan_rgb[k] = LED_CHAN_FROM_U8(native_rgb[k]);
+    }
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        led_rgbw_extract(rgbw, chan_rgb, BENCH_LEDS);
+    }
+    uint32_t rgbw_cpp = (esp_cpu_get_cycle_count() - start) / (BENCH_FRAMES * BENCH_LEDS);
+    ESP_LOGI(TAG, "  rgbw     %lu ciclos/píxel (extracción del blanco%s)",
+             (unsigned long)rgbw_cpp, LED_CHANNELS == 4 ? "" : ", tira RGB: no se usa");
+
+    // Codificación para la tira: el coste fijo por píxel de cada frame
+#if LED_CHANNELS == 4
+    memcpy(chan_px, rgbw, sizeof(chan_px));
+#else
+    memcpy(chan_px, chan_rgb, sizeof(chan_px));
+#endif
+#ifdef CONFIG_LED_HDR
+    const char *depth = "16 bits";
+#ifdef CONFIG_LED_DITHER
+    const char *quant = ", cuantización con dither";
+#else
+    const char *quant = ", cuantización";
+#endif
+#else
+    const char *depth = "8 bits";
+    const char *quant = "";
+#endif
+#ifdef CONFIG_LED_CHIPSET_WS2812_PARALLEL
+    // El frame paralelo es siempre el de todas las tiras: se codifica la
+    // tira completa repitiendo el primer píxel de prueba
+    const int commit_n = LED_NUM_LEDS;
+    const size_t commit_stride = 0;
+#else
+    const int commit_n = LED_NUM_LEDS < BENCH_LEDS ? LED_NUM_LEDS : BENCH_LEDS;
+    const size_t commit_stride = LED_CHANNELS;
+#endif
+    ESP_LOGI(TAG, "  commit   %lu ciclos/píxel (%s %s%s)",
+             (unsigned long)bench_commit(chan_px, commit_stride, commit_n, NULL),
+             led_chipset_name, depth, quant);
+#ifdef CONFIG_LED_CALIBRATION
+    static led_calib_t cal;
+    led_calib_init(&cal, CONFIG_LED_GAMMA_X100);
+    ESP_LOGI(TAG, "  commit   %lu ciclos/píxel con calibración",
+             (unsigned long)bench_commit(chan_px, commit_stride, commit_n, &cal));
+#endif
+#ifdef CONFIG_LED_STRIP_FIXED
+    // La tira completa va por el encoder especializado; con un LED menos,
+    // por el genérico
+    if (LED_NUM_LEDS > 1 && LED_NUM_LEDS <= BENCH_LEDS) {
+        ESP_LOGI(TAG, "  commit   %lu ciclos/píxel especializado, %lu genérico",
+                 (unsigned long)bench_commit(chan_px, LED_CHANNELS, LED_NUM_LEDS, NULL),
+                 (unsigned long)bench_commit(chan_px, LED_CHANNELS, LED_NUM_LEDS - 1, NULL));
+#ifndef CONFIG_LED_CHIPSET_WS2812_PARALLEL
+        ESP_LOGI(TAG, "  relleno  %lu ciclos/píxel especializado, %lu genérico",
+                 (unsigned long)bench_commit(chan_px, 0, LED_NUM_LEDS, NULL),
+                 (unsigned long)bench_commit(chan_px, 0, LED_NUM_LEDS - 1, NULL));
+#endif
+    } else {
+        ESP_LOGI(TAG, "  (la comparación con el encoder genérico necesita LED_NUM_LEDS <= %d)",
+                 BENCH_LEDS);
+    }
+#endif
+
+    // Partículas: máximo que cabe en un frame usando un core completo
+    uint32_t ppc = bench_particles(native_rgb);
+    uint32_t frame_cycles = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000u / CONFIG_LED_RENDER_FPS;
+    ESP_LOGI(TAG, "  partículas %lu ciclos/partícula -> máx. %lu a %d fps (pool de %d)",
+             (unsigned long)ppc, (unsigned long)(frame_cycles / (ppc ? ppc : 1)),
+             CONFIG_LED_RENDER_FPS, FX_PARTICLES_MAX);
+}
@@ -0,0 +1,269 @@
+/**
+ * @file led_effects.h
+ * @brief Motor de efectos: registro de efectos y renderizado por frame
+ *
+ * Un efecto es un par de funciones:
+ * - frame():  se llama una vez por frame (estado global del efecto)
+ * - render(): calcula un rango de píxeles [start, end) del frame
+ *
+ * El render stage llama a led_effects_render() en cada tick del reloj
+ * local cuando no hay ninguna fuente de red activa. Si no hay efecto
+ * seleccionado (LED_FX_NONE) la tira queda para los colores de estado.
+ *
+ * Los efectos "fire", "clouds" y "plasma3d" se basan en ruido de Perlin
+ * (fx_noise.h), calculado por filas de píxeles.
+ *
+ * El efecto "scroller" trata la tira como una matriz (fx_gfx.h) y desplaza
+ * un texto que se cambia con led_effects_set_text().
+ *
+ * Los efectos "sparks", "rain" y "fireworks" usan el motor de partículas
+ * (fx_particles.h) con un pool compartido que se vacía al cambiar de efecto.
+ *
+ * El efecto "comet" dibuja con las primitivas sub-píxel de fx_draw.h.
+ *
+ * El efecto "solid" pinta toda la tira del color de led_effects_set_color();
+ * es el que seleccionan los comandos de color de led_cmd.h.
+ *
+ * Además de los efectos nativos (compilados en el firmware) existe el
+ * efecto "vm", que ejecuta un programa de bytecode cargado en tiempo de
+ * ejecución con led_effects_load_program() (ver fx_vm.h). Los programas
+ * se compilan en el PC con tools/fxc.py, que también puede generar
+ * tablas precalculadas (led_fx_table_t) para efectos sin estado.
+ *
+ * Con CONFIG_FX_MULTICORE el frame se reparte entre los dos cores: la
+ * tarea de render calcula la primera mitad de los píxeles y un trabajador
+ * fijo en el otro core la segunda, con una barrera al final del frame.
+ * frame() se sigue llamando una sola vez y antes del reparto, así que
+ * render() solo debe leer el estado del efecto y escribir en su rango. Los
+ * efectos que no lo cumplen lo indican con serial().
+ *
+ * El motor mide lo que tarda cada frame del efecto activo (frame() más
+ * render()) frente a un presupuesto, CONFIG_FX_BUDGET_PERCENT del periodo
+ * del reloj local. Con CONFIG_FX_BUDGET, si la media se pasa, el efecto
+ * se degrada por niveles (led_fx_degrade_t) y recupera la calidad cuando
+ * vuelve a sobrar tiempo, con histéresis entre ambos umbrales. Los
+ * contadores se leen con led_effects_get_budget().
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef LED_EFFECTS_H
+#define LED_EFFECTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "audio_reactive.h"
+
+#define LED_FX_NONE (-1)
+
+// Longitud máxima del texto de "scroller" (con el terminador)
+#define LED_FX_TEXT_MAX 64
+
+/**
+ * @brief Niveles de degradación por presupuesto de CPU
+ */
+typedef enum {
+    LED_FX_DEGRADE_NONE = 0,    ///< Calidad completa
+    LED_FX_DEGRADE_DETAIL,      ///< Media resolución (píxeles dobles) o menos partículas
+    LED_FX_DEGRADE_FPS,         ///< Además, el efecto se calcula uno de cada dos frames
+} led_fx_degrade_t;
+
+/**
+ * @brief Contexto de un frame, común a todos los efectos
+ */
+typedef struct {
+    uint32_t frame;         ///< Número de frame desde el arranque
+    uint32_t t_ms;          ///< Tiempo de animación en milisegundos (led_clock.h)
+    int32_t t;              ///< Tiempo de animación en segundos (Q16.16)
+    int32_t dt;             ///< Tiempo desde el frame anterior en segundos (Q16.16)
+    uint16_t num_leds;      ///< Píxeles del frame
+    uint8_t degrade;        ///< Nivel de degradación (led_fx_degrade_t), lo pone el motor
+    /** Características de audio del frame (NULL si el audio está desactivado) */
+    const audio_features_t *audio;
+} led_fx_ctx_t;
+
+/**
+ * @brief Descriptor de un efecto
+ */
+typedef struct {
+    const char *name;
+    /** Opcional: reinicia el estado del efecto al seleccionarlo */
+    void (*start)(void);
+    /** Opcional: actualiza el estado del efecto una vez por frame */
+    void (*frame)(const led_fx_ctx_t *ctx);
+    /** Calcula los píxeles [start, end) en rgb (3 bytes por píxel) */
+    void (*render)(uint8_t *rgb, int start, int end, const led_fx_ctx_t *ctx);
+    /** Opcional: igual que render() con 16 bits por canal (CONFIG_LED_HDR) */
+    void (*render16)(uint16_t *rgb, int start, int end, const led_fx_ctx_t *ctx);
+    /** Opcional: true si render() no admite rangos en paralelo (un solo core) */
+    bool (*serial)(void);
+    /** El efecto se puede calcular con menos píxeles (num_leds) y duplicarlos */
+    bool scalable;
+} led_effect_t;
+
+/**
+ * @brief Coste del efecto activo frente al presupuesto de CPU
+ */
+typedef struct {
+    uint32_t budget_us;     ///< Presupuesto por frame calculado
+    uint32_t avg_us;        ///< Coste medio por frame del efecto activo
+    uint32_t max_us;        ///< Coste máximo desde que se seleccionó el efecto
+    uint8_t level;          ///< Nivel de degradación actual (led_fx_degrade_t)
+    uint32_t over_budget;   ///< Frames que se pasaron del presupuesto
+    uint32_t degrades;      ///< Veces que se ha bajado de nivel
+    uint32_t recovers;      ///< Veces que se ha vuelto a subir
+    uint32_t skipped;       ///< Frames no calculados a media frecuencia
+} led_fx_budget_t;
+
+/**
+ * @brief Efecto precalculado: todos los frames de un periodo
+ *
+ * Lo genera tools/fxc.py (comando "table") cuando el efecto es una
+ * función pura de la posición y de un tiempo periódico. Renderizarlo es
+ * solo copiar bytes desde flash.
+ */
+typedef struct {
+    const uint8_t *frames;  ///< num_frames * num_leds * 3 bytes (R, G, B)
+    uint16_t num_frames;    ///< Frames por periodo
+    uint16_t num_leds;      ///< Píxeles por frame (se repiten si la tira es más larga)
+    uint32_t period_ms;     ///< Duración del periodo
+} led_fx_table_t;
+
+/**
+ * @brief Renderiza los píxeles [start, end) de un efecto precalculado
+ *
+ * Pensada para usarse desde la función render() de un efecto nativo:
+ * @code
+ * #include "fx_rainbow_table.h"   // generado con tools/fxc.py table
+ * static void rainbow_table_render(uint8_t *rgb, int start, int end,
+ *                                  const led_fx_ctx_t *ctx)
+ * {
+ *     led_effects_render_table(&fx_rainbow_table, rgb, start, end, ctx);
+ * }
+ * @endcode
+ */
+void led_effects_render_table(const led_fx_table_t *table, uint8_t *rgb,
+                              int start, int end, const led_fx_ctx_t *ctx);
+
+/**
+ * @brief Inicializa el motor de efectos (mutex interno y, con
+ * CONFIG_FX_MULTICORE, el trabajador del segundo core)
+ *
+ * @note Debe llamarse antes que led_render_init()
+ */
+void led_effects_init(void);
+
+/**
+ * @brief Número de efectos registrados
+ */
+int led_effects_count(void);
+
+/**
+ * @brief Descriptor del efecto con identificador id (NULL si no existe)
+ */
+const led_effect_t *led_effects_get(int id);
+
+/**
+ * @brief Busca un efecto por nombre
+ *
+ * @return Identificador del efecto o LED_FX_NONE si no existe
+ */
+int led_effects_find(const char *name);
+
+/**
+ * @brief Selecciona el efecto activo
+ *
+ * @param id Identificador del efecto, o LED_FX_NONE para detenerlo
+ * @return ESP_OK o ESP_ERR_INVALID_ARG si el id no existe
+ */
+esp_err_t led_effects_select(int id);
+
+/**
+ * @brief Identificador del efecto activo (LED_FX_NONE si no hay)
+ */
+int led_effects_selected(void);
+
+/**
+ * @brief Renderiza un frame completo con el efecto activo
+ *
+ * @param rgb Frame destino (ctx->num_leds * 3 bytes)
+ * @param ctx Contexto del frame
+ * @return true si hay efecto activo y el frame se ha calculado; false
+ *         también en los frames que se saltan con LED_FX_DEGRADE_FPS (la
+ *         tira conserva el anterior)
+ */
+bool led_effects_render(uint8_t *rgb, const led_fx_ctx_t *ctx);
+
+/**
+ * @brief Renderiza un frame completo con 16 bits por canal
+ *
+ * Usa render16() si el efecto la tiene; si no, calcula el frame de 8 bits
+ * y lo expande (v * 257), sin buffers adicionales.
+ *
+ * @param rgb Frame destino (ctx->num_leds * 3 canales de 16 bits)
+ * @param ctx Contexto del frame
+ * @return Igual que led_effects_render()
+ */
+bool led_effects_render16(uint16_t *rgb, const led_fx_ctx_t *ctx);
+
+/**
+ * @brief Cambia el texto del efecto "scroller"
+ *
+ * @param text Texto ASCII (los caracteres fuera de la fuente salen como espacio)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si text es NULL o ESP_ERR_INVALID_SIZE
+ *         si no cabe en LED_FX_TEXT_MAX (se mantiene el anterior)
+ */
+esp_err_t led_effects_set_text(const char *text);
+
+/**
+ * @brief Cambia el color del efecto "solid"
+ */
+void led_effects_set_color(uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * @brief Carga un programa de bytecode en el efecto "vm"
+ *
+ * La VM está duplicada: el programa se valida y carga en la copia
+ * inactiva y después se intercambia, de modo que el frame en curso no
+ * ve nunca un programa a medio copiar. No usa memoria dinámica.
+ *
+ * @param bin Programa en formato FXB1 (ver fx_vm.h)
+ * @param len Tamaño en bytes
+ * @return Resultado de fx_vm_load(); si falla sigue el programa anterior
+ */
+esp_err_t led_effects_load_program(const uint8_t *bin, size_t len);
+
+/**
+ * @brief Obtiene el coste del efecto activo y los contadores de degradación
+ *
+ * La media, el máximo y el nivel se reinician al seleccionar un efecto;
+ * los contadores son acumulados desde el arranque.
+ *
+ * @param[out] budget Estructura donde copiar los datos
+ */
+void led_effects_get_budget(led_fx_budget_t *budget);
+
+/**
+ * @brief Mide el coste por píxel de los efectos nativos frente a la VM
+ *
+ * Ejecuta cada efecto nativo y su equivalente en bytecode sobre un frame
+ * de prueba, comprueba que generan la misma imagen y muestra en el log
+ * los ciclos de CPU por píxel de cada uno. Mide también los ciclos por
+ * muestra del ruido (muestra a muestra y por filas), el coste por frame
+ * del texto en la matriz, el de la extracción del blanco para tiras RGBW,
+ * el de las versiones de 16 bits de los efectos, el de codificar cada
+ * píxel para la tira (con y sin calibración; con CONFIG_LED_STRIP_FIXED,
+ * el encoder especializado frente al genérico), el coste por partícula del
+ * motor de partículas y el máximo de partículas que cabe en un frame a
+ * CONFIG_LED_RENDER_FPS. Con CONFIG_FX_MULTICORE mide además, para cada
+ * efecto, el frame en un core frente al repartido en dos y la eficiencia
+ * del reparto (100 % es el doble de rápido).
+ *
+ * @note Bloquea la tarea que la llama durante unos milisegundos
+ */
+void led_effects_benchmark(void);
+
+#endif // LED_EFFECTS_H
@@ -0,0 +1,612 @@
+/**
+ * @file led_render.c
+ * @brief Implementación del render stage
+ *
+ * Mantiene los dos últimos frames recibidos (anterior y último) con su
+ * instante de llegada. En cada tick del reloj local calcula la posición
+ * relativa del tick dentro del intervalo de la fuente y mezcla ambos
+ * frames en punto fijo (alpha de 0 a 256).
+ *
+ * Los segmentos se guardan ya convertidos al formato de la tira, así que
+ * pintarlos es copiar un píxel. El brillo es un factor de 0 a 256 que se
+ * aplica en la misma pasada por el frame; a 256 no se toca.
+ */
+
+#include "led_render.h"
+#include "led_control.h"
+#include "led_chipset.h"
+#include "led_effects.h"
+#include "led_clock.h"
+#include "led_cmd.h"
+#include "led_cue.h"
+#include "fx_math.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+static const char *TAG = "LED_RENDER";
+
+#define FRAME_LEN           (LED_NUM_LEDS * LED_CHANNELS)     // Canales por frame
+#define FRAME_PERIOD_US     (1000000 / CONFIG_LED_RENDER_FPS)
+
+#ifdef CONFIG_LED_RENDER_INTERPOLATION
+#define MOTION_CUTOFF       (CONFIG_LED_RENDER_MOTION_CUTOFF * (LED_CHAN_MAX / 255))
+#else
+#define MOTION_CUTOFF       LED_CHAN_MAX
+#endif
+
+// Sin frames nuevos durante este tiempo se considera que la fuente paró
+#define SOURCE_TIMEOUT_US   (1000 * 1000)
+
+// Intervalos mayores son pausas de la fuente, no un stream: no se interpolan
+#define MAX_INTERP_US       (250 * 1000)
+
+// Ventana de medida de los fps conseguidos
+#define FPS_WINDOW_US       (1000 * 1000)
+
+// Alpha en punto fijo: 256 equivale a 1.0 (frame último completo)
+#define ALPHA_ONE           256
+
+#define RENDER_TASK_STACK   3072
+#define RENDER_TASK_PRIO    5
+#ifdef CONFIG_FX_MULTICORE
+#define RENDER_TASK_CORE    0       // El trabajador de efectos está en el core 1
+#else
+#define RENDER_TASK_CORE    tskNO_AFFINITY
+#endif
+
+static led_chan_t s_frames[2][FRAME_LEN];
+static led_chan_t s_out[FRAME_LEN];
+#if LED_CHANNELS == 4
+static led_chan_t s_fx_rgb[LED_NUM_LEDS * 3];   // Frame RGB de los efectos
+#endif
+static int s_last = 0;                  // Índice del último frame recibido
+static int64_t s_prev_us;               // Llegada del frame anterior
+static int64_t s_last_us;               // Llegada del último frame
+static uint32_t s_shown;                // frames_received ya presentado completo
+static int64_t s_source_us;             // Último frame o actualización parcial
+
+// LEDs cambiados por actualizaciones parciales desde el último envío, y si
+// s_out (y la tira) tienen ya el último frame completo recompuesto
+static uint16_t s_dirty_lo = LED_NUM_LEDS;
+static uint16_t s_dirty_hi;
+static bool s_out_valid;
+
+static bool s_interpolation =
+#ifdef CONFIG_LED_RENDER_INTERPOLATION
+    true;
+#else
+    false;
+#endif
+
+static led_fx_ctx_t s_fx_ctx;
+static int64_t s_fx_last_us = LED_CLOCK_NEVER;
+#ifdef CONFIG_AUDIO_ENABLE
+static audio_features_t s_fx_audio;
+#endif
+
+// Segmento de color fijo, con el color en el formato de la tira
+typedef struct {
+    uint16_t start;
+    uint16_t end;           ///< start si no está en uso
+    led_chan_t px[LED_CHANNELS];
+} segment_t;
+
+static segment_t s_segments[LED_RENDER_MAX_SEGMENTS];
+static uint16_t s_brightness = 256;     // Factor de brillo, 256 = sin escalar
+static bool s_refresh;                  // Reenviar el frame de la fuente ya mostrado
+
+static led_render_stats_t s_stats;
+static int64_t s_fps_start_us;          // Inicio de la ventana de fps
+static uint32_t s_fps_frames;           // frames_rendered al inicio de la ventana
+static SemaphoreHandle_t s_lock;
+static TaskHandle_t s_render_task;
+static esp_timer_handle_t s_frame_timer;
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+/**
+ * @brief Mezcla dos frames píxel a píxel
+ *
+ * out = a + (b - a) * alpha / 256 en cada canal. Si el mayor cambio por
+ * canal de un píxel supera MOTION_CUTOFF, el píxel toma directamente el
+ * valor de b.
+ *
+ * @return Número de píxeles que superaron el corte de movimiento
+ */
+static uint32_t blend_frames(led_chan_t *out, const led_chan_t *a, const led_chan_t *b,
+                             int alpha)
+{
+    uint32_t cut = 0;
+
+    for (int i = 0; i < LED_NUM_LEDS; i++, a += LED_CHANNELS, b += LED_CHANNELS,
+                                       out += LED_CHANNELS) {
+        int d[LED_CHANNELS];
+        int motion = 0;
+        for (int c = 0; c < LED_CHANNELS; c++) {
+            d[c] = b[c] - a[c];
+            if (abs(d[c]) > motion) motion = abs(d[c]);
+        }
+
+        if (motion > MOTION_CUTOFF) {
+            memcpy(out, b, sizeof(led_chan_t) * LED_CHANNELS);
+            cut++;
+            continue;
+        }
+
+        for (int c = 0; c < LED_CHANNELS; c++) {
+            out[c] = a[c] + ((d[c] * alpha) >> 8);
+        }
+    }
+    return cut;
+}
+
+/**
+ * @brief Copia píxeles de una fuente (8 bits) al formato de la tira
+ *
+ * Extrae el blanco de los frames RGB en tiras RGBW, suma el blanco de los
+ * frames RGBW en tiras RGB y expande los canales con CONFIG_LED_HDR.
+ *
+ * @param dst      Frame en el formato de la tira
+ * @param src      Píxeles de la fuente
+ * @param channels Bytes por píxel de src (3 o 4)
+ */
+static void copy_pixels(led_chan_t *dst, const uint8_t *src, size_t num_leds, int channels)
+{
+#ifndef CONFIG_LED_HDR
+    if (channels == LED_CHANNELS) {
+        memcpy(dst, src, num_leds * LED_CHANNELS);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < num_leds; i++, src += channels, dst += LED_CHANNELS) {
+        int r = src[0], g = src[1], b = src[2];
+        int w = channels == 4 ? src[3] : 0;
+#if LED_CHANNELS == 4
+        if (channels == 3) {
+            w = r < g ? r : g;
+            w = w < b ? w : b;
+            r -= w;
+            g -= w;
+            b -= w;
+        }
+        dst[3] = LED_CHAN_FROM_U8(w);
+#else
+        r = r + w > 255 ? 255 : r + w;
+        g = g + w > 255 ? 255 : g + w;
+        b = b + w > 255 ? 255 : b + w;
+#endif
+        dst[0] = LED_CHAN_FROM_U8(r);
+        dst[1] = LED_CHAN_FROM_U8(g);
+        dst[2] = LED_CHAN_FROM_U8(b);
+    }
+}
+
+/**
+ * @brief Calcula el frame RGB del efecto activo con la profundidad interna
+ */
+static bool render_effect_rgb(led_chan_t *rgb)
+{
+#ifdef CONFIG_LED_HDR
+    return led_effects_render16(rgb, &s_fx_ctx);
+#else
+    return led_effects_render(rgb, &s_fx_ctx);
+#endif
+}
+
+/**
+ * @brief Calcula un frame con el efecto activo (si lo hay)
+ *
+ * @return true si el frame se ha calculado y hay que enviarlo a la tira
+ */
+static bool render_effect(void)
+{
+    // t y dt salen de la misma lectura del reloj de animación
+    s_fx_ctx.dt = led_clock_delta(&s_fx_last_us, FRAME_PERIOD_US);
+    int64_t now = s_fx_last_us;
+
+    s_fx_ctx.frame++;
+    s_fx_ctx.t_ms = (uint32_t)(now / 1000);
+    s_fx_ctx.t = (int32_t)((now << FX_SHIFT) / 1000000);
+    s_fx_ctx.num_leds = LED_NUM_LEDS;
+#ifdef CONFIG_AUDIO_ENABLE
+    audio_reactive_get_features(&s_fx_audio);
+    s_fx_ctx.audio = &s_fx_audio;
+#endif
+
+#if LED_CHANNELS == 4
+    if (!render_effect_rgb(s_fx_rgb)) {
+        return false;
+    }
+    led_rgbw_extract(s_out, s_fx_rgb, LED_NUM_LEDS);
+    return true;
+#else
+    return render_effect_rgb(s_out);
+#endif
+}
+
+/**
+ * @brief Pinta los segmentos y aplica el brillo a los LEDs [lo, hi) de
+ * s_out (con s_lock tomado)
+ */
+static void finish_range(int lo, int hi)
+{
+    for (int k = 0; k < LED_RENDER_MAX_SEGMENTS; k++) {
+        const segment_t *seg = &s_segments[k];
+        int start = seg->start > lo ? seg->start : lo;
+        int end = seg->end < hi ? seg->end : hi;
+        for (int i = start; i < end; i++) {
+            memcpy(s_out + i * LED_CHANNELS, seg->px, sizeof(seg->px));
+        }
+    }
+
+    if (s_brightness < 256) {
+        const uint32_t scale = s_brightness;
+        for (int i = lo * LED_CHANNELS; i < hi * LED_CHANNELS; i++) {
+            s_out[i] = (led_chan_t)((s_out[i] * scale) >> 8);
+        }
+    }
+}
+
+/**
+ * @brief Pinta los segmentos y aplica el brillo a s_out (con s_lock tomado)
+ */
+static void finish_frame(void)
+{
+    finish_range(0, LED_NUM_LEDS);
+    s_refresh = false;
+}
+
+/**
+ * @brief Envía s_out a la tira y actualiza los contadores de salida
+ *
+ * @param num_leds LEDs desde el principio de la tira que se envían
+ * @param t0       Inicio de la composición del frame
+ */
+static void output_frame(size_t num_leds, int64_t t0)
+{
+    led_control_show(s_out, num_leds);
+    led_cmd_presented(num_leds);
+
+    int64_t us = esp_timer_get_time() - t0;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.wire_bytes += LED_CHIPSET_WIRE_BYTES(num_leds);
+    s_stats.output_sum_us += us;
+    xSemaphoreGive(s_lock);
+}
+
+/**
+ * @brief Actualiza los fps conseguidos una vez por ventana
+ */
+static void update_fps(int64_t now)
+{
+    int64_t elapsed = now - s_fps_start_us;
+    if (elapsed < FPS_WINDOW_US) {
+        return;
+    }
+    uint32_t frames = s_stats.frames_rendered - s_fps_frames;
+    s_stats.fps = (uint16_t)((frames * 1000000LL + elapsed / 2) / elapsed);
+    s_fps_start_us = now;
+    s_fps_frames = s_stats.frames_rendered;
+}
+
+/**
+ * @brief Callback del reloj local: despierta a la tarea de render
+ */
+static void frame_timer_cb(void *arg)
+{
+    xTaskNotifyGive(s_render_task);
+}
+
+/**
+ * @brief Tarea de render: un frame por tick del reloj local
+ *
+ * Una fuente de red activa tiene prioridad: solo envía a la tira cuando
+ * hay algo nuevo que mostrar (mientras dura una mezcla, o una vez cuando
+ * el último frame se alcanza por completo). Con CONFIG_LED_DITHER, en
+ * cambio, envía el frame completo en cada tick: la fase del dither avanza
+ * por frame y una imagen quieta sin reenviar se quedaría en una sola fase.
+ * Sin fuente, se calcula el efecto activo del motor de efectos.
+ *
+ * Los comandos de control pendientes (led_cmd.h) se aplican al empezar el
+ * tick, antes de calcular el frame, y encima de los cues que tocan en este
+ * frame (led_cue.h).
+ */
+static void render_task(void *pvParameter)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        led_cue_process();
+        led_cmd_process();
+        int64_t now = esp_timer_get_time();
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        update_fps(now);
+
+        if ((s_stats.frames_received == 0 && s_stats.updates_received == 0) ||
+            now - s_source_us > SOURCE_TIMEOUT_US) {
+            s_out_valid = false;
+            xSemaphoreGive(s_lock);
+            if (render_effect()) {
+                xSemaphoreTake(s_lock, portMAX_DELAY);
+                finish_frame();
+                s_stats.frames_rendered++;
+                xSemaphoreGive(s_lock);
+                output_frame(LED_NUM_LEDS, now);
+            }
+            continue;
+        }
+
+        int alpha = ALPHA_ONE;
+        int64_t interval = s_last_us - s_prev_us;
+        if (s_interpolation && s_stats.frames_received > 1 &&
+            interval > 0 && interval <= MAX_INTERP_US) {
+            int64_t elapsed = now - s_last_us;
+            if (elapsed < interval) {
+                alpha = (int)((elapsed * ALPHA_ONE) / interval);
+            }
+        }
+
+        size_t num_leds = LED_NUM_LEDS;
+        if (alpha < ALPHA_ONE) {
+            s_stats.pixels_cut += blend_frames(s_out, s_frames[s_last ^ 1],
+                                               s_frames[s_last], alpha);
+            s_stats.frames_interpolated++;
+            finish_frame();
+            s_out_valid = false;
+        } else if (s_shown != s_stats.frames_received || s_refresh || !s_out_valid) {
+            memcpy(s_out, s_frames[s_last], sizeof(s_out));
+            s_shown = s_stats.frames_received;
+            finish_frame();
+            s_out_valid = true;
+        } else if (s_dirty_lo < s_dirty_hi) {
+            // Solo cambiaron algunos LEDs: el resto de s_out ya es el frame
+            // recompuesto, y en la tira también
+            const int lo = s_dirty_lo, hi = s_dirty_hi;
+            memcpy(s_out + lo * LED_CHANNELS, s_frames[s_last] + lo * LED_CHANNELS,
+                   (hi - lo) * LED_CHANNELS * sizeof(led_chan_t));
+            finish_range(lo, hi);
+            s_stats.frames_partial++;
+#if defined(LED_CHIPSET_PARTIAL) && !defined(CONFIG_LED_DITHER)
+            // Con dither los LEDs de después de hi también tienen que
+            // cambiar de fase: se envía la tira entera
+            num_leds = hi;
+#endif
+        } else {
+#ifdef CONFIG_LED_DITHER
+            // Nada nuevo, pero s_out sigue siendo el frame recompuesto: se
+            // reenvía para que el dither avance
+#else
+            xSemaphoreGive(s_lock);
+            continue;
+#endif
+        }
+        s_dirty_lo = LED_NUM_LEDS;
+        s_dirty_hi = 0;
+        s_stats.frames_rendered++;
+
+        xSemaphoreGive(s_lock);
+
+        output_frame(num_leds, now);
+    }
+}
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+/**
+ * @brief Inicializa el render stage y arranca el reloj de frames
+ */
+void led_render_init(void)
+{
+    s_lock = xSemaphoreCreateMutex();
+    s_stats.max_fps = (uint16_t)(1000000 / led_control_frame_us());
+    s_fps_start_us = esp_timer_get_time();
+
+    xTaskCreatePinnedToCore(render_task, "LED_RENDER", RENDER_TASK_STACK, NULL,
+                            RENDER_TASK_PRIO, &s_render_task, RENDER_TASK_CORE);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = frame_timer_cb,
+        .name = "led_frame_clock",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_frame_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(s_frame_timer, FRAME_PERIOD_US));
+
+    ESP_LOGI(TAG, "Render stage a %d fps (interpolación %s)",
+             CONFIG_LED_RENDER_FPS, s_interpolation ? "activada" : "desactivada");
+    if (CONFIG_LED_RENDER_FPS > s_stats.max_fps) {
+        ESP_LOGW(TAG, "La tira no admite más de %u fps: los frames saldrán seguidos a ese ritmo",
+                 s_stats.max_fps);
+    }
+    ESP_LOGI(TAG, "Frames de %d bits por canal: %u bytes de RAM",
+             (int)sizeof(led_chan_t) * 8, (unsigned)led_render_frame_memory());
+}
+
+/**
+ * @brief Guarda un frame de una fuente como último frame recibido
+ *
+ * @param px       Píxeles de la fuente
+ * @param num_leds Número de píxeles
+ * @param channels Bytes por píxel de px: 3 (RGB) o 4 (RGBW)
+ */
+static esp_err_t submit_frame(const uint8_t *px, size_t num_leds, int channels)
+{
+    if (px == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (num_leds > LED_NUM_LEDS) {
+        num_leds = LED_NUM_LEDS;
+    }
+    size_t len = num_leds * LED_CHANNELS;
+
+    int64_t now = esp_timer_get_time();
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    // El frame anterior se descarta: su buffer pasa a ser el último
+    int slot = s_last ^ 1;
+    copy_pixels(s_frames[slot], px, num_leds, channels);
+    memset(s_frames[slot] + len, 0, (FRAME_LEN - len) * sizeof(led_chan_t));
+
+    s_prev_us = s_last_us;
+    s_last_us = now;
+    s_source_us = now;
+    s_last = slot;
+    s_stats.frames_received++;
+    if (s_stats.frames_received > 1) {
+        s_stats.source_interval_us = (uint32_t)(s_last_us - s_prev_us);
+    }
+
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief Entrega un frame completo recibido de una fuente
+ */
+esp_err_t led_render_submit_frame(const uint8_t *rgb, size_t num_leds)
+{
+    return submit_frame(rgb, num_leds, 3);
+}
+
+/**
+ * @brief Entrega un frame RGBW completo recibido de una fuente
+ */
+esp_err_t led_render_submit_frame_rgbw(const uint8_t *rgbw, size_t num_leds)
+{
+    return submit_frame(rgbw, num_leds, 4);
+}
+
+/**
+ * @brief Cambia algunos píxeles del último frame recibido
+ */
+esp_err_t led_render_update_pixels(const led_render_span_t *spans, size_t n)
+{
+    if (spans == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t k = 0; k < n; k++) {
+        if (spans[k].len == 0 || (uint32_t)spans[k].start + spans[k].len > LED_NUM_LEDS) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint32_t pixels = 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    // Sin fuente activa los frames guardados son viejos: se parte de negro
+    if ((s_stats.frames_received == 0 && s_stats.updates_received == 0) ||
+        now - s_source_us > SOURCE_TIMEOUT_US) {
+        memset(s_frames, 0, sizeof(s_frames));
+        s_out_valid = false;
+    }
+
+    for (size_t k = 0; k < n; k++) {
+        const led_render_span_t *sp = &spans[k];
+        led_chan_t px[LED_CHANNELS];
+        copy_pixels(px, sp->rgb, 1, 3);
+
+        // En los dos frames: el cambio no se interpola con el anterior
+        for (int f = 0; f < 2; f++) {
+            led_chan_t *dst = s_frames[f] + sp->start * LED_CHANNELS;
+            for (int i = 0; i < sp->len; i++, dst += LED_CHANNELS) {
+                memcpy(dst, px, sizeof(px));
+            }
+        }
+        if (sp->start < s_dirty_lo) {
+            s_dirty_lo = sp->start;
+        }
+        if (sp->start + sp->len > s_dirty_hi) {
+            s_dirty_hi = sp->start + sp->len;
+        }
+        pixels += sp->len;
+    }
+
+    s_source_us = now;
+    s_stats.updates_received++;
+    s_stats.pixels_updated += pixels;
+
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief Activa o desactiva la interpolación entre frames
+ */
+void led_render_set_interpolation(bool enable)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_interpolation = enable;
+    xSemaphoreGive(s_lock);
+}
+
+/**
+ * @brief Cambia el brillo global de la salida
+ */
+void led_render_set_brightness(uint8_t level)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_brightness = level + (level >> 7);    // 0-255 -> 0-256
+    s_refresh = true;
+    xSemaphoreGive(s_lock);
+}
+
+/**
+ * @brief Define un segmento de color fijo sobre la salida
+ */
+esp_err_t led_render_set_segment(int index, uint16_t start, uint16_t len, const uint8_t *rgb)
+{
+    if (index < 0 || index >= LED_RENDER_MAX_SEGMENTS || rgb == NULL ||
+        (uint32_t)start + len > LED_NUM_LEDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    segment_t seg = { .start = start, .end = start + len };
+    copy_pixels(seg.px, rgb, 1, 3);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_segments[index] = seg;
+    s_refresh = true;
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief Memoria de los frames del render stage
+ */
+size_t led_render_frame_memory(void)
+{
+    size_t bytes = sizeof(s_frames) + sizeof(s_out);
+#if LED_CHANNELS == 4
+    bytes += sizeof(s_fx_rgb);
+#endif
+    return bytes;
+}
+
+/**
+ * @brief Obtiene una copia de las estadísticas del render stage
+ */
+void led_render_get_stats(led_render_stats_t *stats)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+    stats->wire_underruns = led_control_underruns();
+}
@@ -0,0 +1,191 @@
+/**
+ * @file led_render.h
+ * @brief Render stage: presentación de frames sobre un reloj local
+ *
+ * Las fuentes de red (streaming de píxeles) suelen enviar a 20-30 fps,
+ * mientras que la tira puede refrescarse bastante más rápido. El render
+ * stage desacopla ambas frecuencias:
+ *
+ * - Las fuentes entregan frames completos con led_render_submit_frame()
+ * - Un reloj local (esp_timer) marca los ticks de refresco de la tira
+ * - En cada tick se interpola linealmente entre los dos últimos frames
+ *   recibidos, píxel a píxel, según el instante del reloj local
+ * - Los píxeles con un cambio demasiado grande entre frames (cortes de
+ *   escena, bordes que se mueven rápido) no se mezclan: saltan
+ *   directamente al frame nuevo para evitar "fantasmas"
+ *
+ * La interpolación presenta la fuente con un frame de retraso: el frame
+ * N se alcanza por completo justo cuando debería llegar el N+1.
+ *
+ * Si no hay ninguna fuente activa el render stage no toca la tira, de
+ * modo que los colores de estado (WiFi, OTA) siguen funcionando.
+ *
+ * Los frames se guardan en el formato de la tira (LED_CHANNELS bytes por
+ * píxel). Las fuentes pueden entregar RGB o RGBW: lo que no coincide con
+ * la tira se convierte al recibirlo (extracción del blanco o suma del
+ * blanco a R, G y B). Los efectos siempre calculan RGB.
+ *
+ * El envío a la tira se solapa con el cálculo: mientras el frame N está en
+ * el cable se calcula y codifica el N+1 (ver led_control_show()). El
+ * máximo de fps lo marca el tiempo en el cable de la tira; se registra al
+ * arrancar junto a los fps conseguidos en las estadísticas.
+ *
+ * Con CONFIG_LED_HDR los frames internos son de 16 bits por canal: los
+ * efectos que lo soportan calculan en 16 bits, la interpolación mezcla en
+ * 16 bits y solo se cuantiza a 8 al codificar para la tira (led_chipset.h).
+ * Las fuentes siguen entregando 8 bits. Cuesta el doble de RAM en frames
+ * (ver led_render_frame_memory()).
+ *
+ * Las fuentes que cambian pocos píxeles por frame (indicadores, cursores)
+ * pueden entregar solo esos píxeles con led_render_update_pixels(): se
+ * escriben directamente en el último frame recibido y se acumula el rango
+ * de LEDs cambiados. Si el frame ya estaba presentado completo, el tick
+ * siguiente recompone (segmentos y brillo) solo ese rango y, en los
+ * chipsets que lo admiten (LED_CHIPSET_PARTIAL), envía solo los LEDs
+ * hasta el último cambiado.
+ *
+ * Justo antes de enviar cada frame, sea de una fuente o de un efecto, se
+ * pintan encima los segmentos de color fijo y se aplica el brillo global.
+ * Ambos se cambian normalmente con comandos (led_cmd.h), que la tarea de
+ * render aplica al empezar cada tick. Sin fuente ni efecto activo no hay
+ * frame, así que tampoco se ven los segmentos.
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef LED_RENDER_H
+#define LED_RENDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Segmentos de color fijo simultáneos
+#define LED_RENDER_MAX_SEGMENTS 8
+
+/**
+ * @brief Estadísticas del render stage
+ */
+typedef struct {
+    uint32_t frames_received;       ///< Frames entregados por las fuentes
+    uint32_t frames_rendered;       ///< Frames enviados a la tira
+    uint32_t frames_interpolated;   ///< Frames enviados que fueron una mezcla
+    uint32_t pixels_cut;            ///< Píxeles que superaron el corte de movimiento
+    uint32_t source_interval_us;    ///< Último intervalo medido entre frames de la fuente
+    uint16_t fps;                   ///< Frames enviados a la tira en el último segundo
+    uint16_t max_fps;               ///< Máximo teórico de la tira (tiempo en el cable)
+    uint32_t wire_underruns;        ///< Rellenos tardíos del periférico (led_control_underruns())
+    uint32_t updates_received;      ///< Actualizaciones parciales (led_render_update_pixels())
+    uint32_t pixels_updated;        ///< Píxeles escritos por esas actualizaciones
+    uint32_t frames_partial;        ///< Frames recompuestos solo en el rango cambiado
+    uint64_t wire_bytes;            ///< Bytes enviados por el cable
+    uint64_t output_sum_us;         ///< Composición, codificación y envío de todos los frames
+} led_render_stats_t;
+
+/**
+ * @brief Rango de LEDs de un color, para led_render_update_pixels()
+ */
+typedef struct {
+    uint16_t start;
+    uint16_t len;
+    uint8_t rgb[3];
+} led_render_span_t;
+
+/**
+ * @brief Inicializa el render stage y arranca el reloj de frames
+ *
+ * Crea la tarea de render y el timer periódico a CONFIG_LED_RENDER_FPS.
+ *
+ * @note Debe llamarse después de led_control_init()
+ */
+void led_render_init(void);
+
+/**
+ * @brief Entrega un frame completo recibido de una fuente (p.ej. red)
+ *
+ * El frame se copia internamente y se marca con el instante de llegada,
+ * que es el que se usa para interpolar sobre el reloj local.
+ *
+ * @param rgb      Buffer de píxeles R, G, B (3 bytes por LED)
+ * @param num_leds Número de píxeles del buffer. Si es menor que
+ *                 LED_NUM_LEDS el resto de la tira se apaga; si es
+ *                 mayor se ignora el exceso
+ * @return ESP_OK, o ESP_ERR_INVALID_ARG si rgb es NULL
+ */
+esp_err_t led_render_submit_frame(const uint8_t *rgb, size_t num_leds);
+
+/**
+ * @brief Entrega un frame RGBW completo recibido de una fuente
+ *
+ * Igual que led_render_submit_frame() con 4 bytes por píxel (R, G, B, W).
+ * En tiras RGB el blanco se suma a los tres canales.
+ *
+ * @return ESP_OK, o ESP_ERR_INVALID_ARG si rgbw es NULL
+ */
+esp_err_t led_render_submit_frame_rgbw(const uint8_t *rgbw, size_t num_leds);
+
+/**
+ * @brief Cambia algunos píxeles del último frame recibido
+ *
+ * Los rangos se escriben en los dos frames que se interpolan, así que se
+ * ven en el siguiente tick sin mezcla, y mantienen la fuente activa como
+ * un frame completo. Sin fuente activa se parte de un frame negro.
+ *
+ * @param spans Rangos a escribir, en orden (si se solapan gana el último)
+ * @param n     Número de rangos
+ * @return ESP_OK, o ESP_ERR_INVALID_ARG si algún rango está vacío o se
+ *         sale de la tira (entonces no se escribe ninguno)
+ */
+esp_err_t led_render_update_pixels(const led_render_span_t *spans, size_t n);
+
+/**
+ * @brief Activa o desactiva la interpolación entre frames
+ *
+ * Desactivada, cada frame recibido se presenta tal cual en el siguiente
+ * tick del reloj local (sin latencia añadida).
+ *
+ * @param enable true para interpolar
+ */
+void led_render_set_interpolation(bool enable);
+
+/**
+ * @brief Cambia el brillo global de la salida
+ *
+ * Escala todos los canales justo antes de enviar el frame. Un frame de
+ * una fuente que ya se había mostrado se vuelve a enviar con el brillo
+ * nuevo.
+ *
+ * @param level 0 (apagado) a 255 (sin escalar)
+ */
+void led_render_set_brightness(uint8_t level);
+
+/**
+ * @brief Define un segmento de color fijo sobre la salida
+ *
+ * @param index Segmento (0 a LED_RENDER_MAX_SEGMENTS - 1); si se solapan
+ *              gana el de índice mayor
+ * @param start Primer LED
+ * @param len   LEDs del segmento; 0 lo borra
+ * @param rgb   Color R, G, B
+ * @return ESP_OK, o ESP_ERR_INVALID_ARG si el índice no existe o el
+ *         segmento se sale de la tira
+ */
+esp_err_t led_render_set_segment(int index, uint16_t start, uint16_t len, const uint8_t *rgb);
+
+/**
+ * @brief Bytes de RAM que ocupan los frames del render stage
+ *
+ * Depende del número de LEDs, del formato de píxel y de CONFIG_LED_HDR.
+ */
+size_t led_render_frame_memory(void);
+
+/**
+ * @brief Obtiene una copia de las estadísticas del render stage
+ *
+ * @param[out] stats Estructura donde copiar las estadísticas
+ */
+void led_render_get_stats(led_render_stats_t *stats);
+
+#endif // LED_RENDER_H
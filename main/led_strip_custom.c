@@ -14,6 +14,9 @@
  * 
  * - main.c:          Punto de entrada, inicialización y orquestación
  * - led_control:     Gestión de la tira LED y efectos visuales
+ * - led_render:      Render stage (reloj local de frames, interpolación)
+ * - led_effects:     Motor de efectos y VM de bytecode (fx_vm, fx_math)
+ * - audio_reactive:  Análisis de audio para efectos reactivos (audio_fft)
  * - wifi_manager:    Conexión y mantenimiento de WiFi
  * - ota_manager:     Descarga e instalación de actualizaciones OTA
  * 
@@ -78,6 +81,13 @@
 // ============================================================================
 
 #include "led_control.h"            // Control de tira LED
+#include "led_render.h"             // Render stage (reloj de frames, interpolación)
+#include "led_effects.h"            // Motor de efectos (nativos y bytecode)
+#include "led_cmd.h"                // Cola de comandos de control remoto
+#include "http_api.h"               // API REST de control
+#include "mqtt_api.h"               // Cliente MQTT de control
+#include "osc_api.h"                // Receptor OSC de control
+#include "audio_reactive.h"         // Análisis de audio (FFT, bandas, beat)
 #include "wifi_manager.h"           // Gestión de WiFi
 #include "ota_manager.h"            // Gestión de actualizaciones OTA
 
@@ -345,6 +355,24 @@ void app_main(void)
     led_control_init();
     
     ESP_LOGI(TAG, "✓ LEDs inicializados (GPIO %d)", CONFIG_BLINK_GPIO);
+
+    // Render stage: presenta los frames de las fuentes de red sobre el
+    // reloj local (CONFIG_LED_RENDER_FPS), interpolando entre frames.
+    // Mientras no llegue ningún frame ni haya efecto activo no toca la tira.
+    led_effects_init();
+    led_cmd_init();
+    led_render_init();
+
+#ifdef CONFIG_AUDIO_ENABLE
+    // Análisis de audio para los efectos reactivos (micrófono I2S o feed)
+    if (audio_reactive_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Audio no disponible, los efectos reactivos quedan en silencio");
+    }
+#endif
+
+#ifdef CONFIG_LED_BENCHMARK_AT_BOOT
+    led_effects_benchmark();
+#endif
     
     // NOTA: En este punto los LEDs están apagados
     // Los módulos siguientes (WiFi, OTA) los controlarán según necesiten
@@ -392,6 +420,27 @@ void app_main(void)
     // IMPORTANTE: A partir de aquí, el sistema tiene conectividad
     // Ya podemos usar HTTP, MQTT, NTP, OTA, etc.
 
+#ifdef CONFIG_HTTP_API_ENABLE
+    // API REST de control: los comandos entran en la cola del render stage
+    if (http_api_start() != ESP_OK) {
+        ESP_LOGW(TAG, "API de control no disponible");
+    }
+#endif
+
+#ifdef CONFIG_MQTT_API_ENABLE
+    // Cliente MQTT: comandos de domótica por dispositivo y por grupo
+    if (mqtt_api_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Cliente MQTT no disponible");
+    }
+#endif
+
+#ifdef CONFIG_OSC_API_ENABLE
+    // Receptor OSC: faders de tabletas y mesas de luces por UDP
+    if (osc_api_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Receptor OSC no disponible");
+    }
+#endif
+
     // ------------------------------------------------------------------------
     // SUBSISTEMA 3: SISTEMA OTA
     // ------------------------------------------------------------------------
@@ -0,0 +1,371 @@
+/**
+ * @file mqtt_api.c
+ * @brief Implementación del cliente MQTT de control
+ *
+ * Los mensajes llegan en la tarea del cliente MQTT: se copian a un buffer
+ * de la pila, se convierten en un led_cmd_t y se dejan en su hueco de
+ * último valor, sin esperar a la tarea de render.
+ *
+ * El estado lo revisa un temporizador cada STATE_POLL_MS: compara el
+ * estado aplicado con el último publicado y, si cambió y ya pasó el
+ * intervalo mínimo, lo deja en la cola de salida del cliente
+ * (esp_mqtt_client_enqueue() no bloquea la tarea de los temporizadores).
+ */
+
+#include "mqtt_api.h"
+#include "led_cmd.h"
+#include "led_effects.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_MQTT_API_ENABLE
+#include "esp_mac.h"
+#include "mqtt_client.h"
+#endif
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+#ifdef CONFIG_MQTT_API_ENABLE
+
+static const char *TAG = "MQTT_API";
+
+#define BASE                CONFIG_MQTT_API_BASE_TOPIC
+#define STATE_INTERVAL_US   ((int64_t)CONFIG_MQTT_API_STATE_INTERVAL_MS * 1000)
+#define STATE_POLL_MS       50
+
+#define MAX_TOPIC           128
+#define MAX_PAYLOAD         64          // Carga más larga: "65535,65535,255,255,255"
+#define STATE_SIZE          768         // Estado con 8 segmentos, como en /api/state
+
+static esp_mqtt_client_handle_t s_client;
+static esp_timer_handle_t s_state_timer;
+static volatile bool s_connected;
+
+static char s_device[32];
+static char s_dev_prefix[MAX_TOPIC];    // <base>/<id>/set/
+static char s_group_prefix[MAX_TOPIC];  // <base>/group/<grupo>/set/
+static char s_state_topic[MAX_TOPIC];
+static char s_status_topic[MAX_TOPIC];
+
+// Solo el temporizador
+static led_cmd_state_t s_published;
+static bool s_published_valid;          // false: publicar en la próxima revisión
+static int64_t s_published_us;
+static char s_state_json[STATE_SIZE];
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+/**
+ * @brief Lee un entero decimal que ocupa todo el texto, dentro de [lo, hi]
+ */
+static bool parse_int(const char *s, long lo, long hi, long *v)
+{
+    char *end;
+    if (*s == '\0') {
+        return false;
+    }
+    *v = strtol(s, &end, 10);
+    return *end == '\0' && *v >= lo && *v <= hi;
+}
+
+/**
+ * @brief Lee un color: "#rrggbb" o "r,g,b"
+ */
+static bool parse_color(const char *s, uint8_t *rgb)
+{
+    if (s[0] == '#') {
+        for (int k = 1; k <= 6; k++) {
+            if (!isxdigit((unsigned char)s[k])) {
+                return false;
+            }
+        }
+        if (s[7] != '\0') {
+            return false;
+        }
+        unsigned long v = strtoul(s + 1, NULL, 16);
+        rgb[0] = (uint8_t)(v >> 16);
+        rgb[1] = (uint8_t)(v >> 8);
+        rgb[2] = (uint8_t)v;
+        return true;
+    }
+
+    for (int k = 0; k < 3; k++) {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 0 || v > 255 || *end != (k < 2 ? ',' : '\0')) {
+            return false;
+        }
+        rgb[k] = (uint8_t)v;
+        s = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Lee un segmento: "start,len,<color>" o "off"
+ */
+static bool parse_segment(const char *s, led_cmd_t *cmd)
+{
+    if (*s == '\0' || strcmp(s, "off") == 0) {
+        cmd->len = 0;
+        return true;
+    }
+
+    long v[2];
+    for (int k = 0; k < 2; k++) {
+        char *end;
+        v[k] = strtol(s, &end, 10);
+        if (end == s || *end != ',' || v[k] < 0 || v[k] > UINT16_MAX) {
+            return false;
+        }
+        s = end + 1;
+    }
+    cmd->start = (uint16_t)v[0];
+    cmd->len = (uint16_t)v[1];
+    return cmd->len == 0 || parse_color(s, cmd->rgb);
+}
+
+/**
+ * @brief Ejecuta un comando: param es lo que sigue a ".../set/"
+ */
+static esp_err_t handle_command(const char *param, const char *payload)
+{
+    led_cmd_t cmd = { 0 };
+    long v;
+
+    if (strcmp(param, "color") == 0) {
+        if (!parse_color(payload, cmd.rgb)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        cmd.type = LED_CMD_COLOR;
+    } else if (strcmp(param, "effect") == 0) {
+        cmd.type = LED_CMD_EFFECT;
+        cmd.effect = LED_FX_NONE;
+        if (*payload != '\0' && strcmp(payload, "none") != 0) {
+            cmd.effect = led_effects_find(payload);
+            if (cmd.effect == LED_FX_NONE) {
+                return ESP_ERR_NOT_FOUND;
+            }
+        }
+    } else if (strcmp(param, "brightness") == 0) {
+        if (!parse_int(payload, 0, 255, &v)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        cmd.type = LED_CMD_BRIGHTNESS;
+        cmd.brightness = (uint8_t)v;
+    } else if (strncmp(param, "segment/", 8) == 0) {
+        if (!parse_int(param + 8, 0, LED_RENDER_MAX_SEGMENTS - 1, &v) ||
+            !parse_segment(payload, &cmd)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        cmd.type = LED_CMD_SEGMENT;
+        cmd.index = (uint8_t)v;
+    } else if (strcmp(param, "preset") == 0) {
+        if (!parse_int(payload, 0, LED_CMD_PRESETS - 1, &v)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        return led_cmd_preset_load((int)v);
+    } else if (strcmp(param, "preset/save") == 0) {
+        if (!parse_int(payload, 0, LED_CMD_PRESETS - 1, &v)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        return led_cmd_preset_save((int)v);
+    } else {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return led_cmd_post_latest(&cmd);
+}
+
+/**
+ * @brief Mensaje recibido en uno de los temas suscritos
+ */
+static void on_data(const esp_mqtt_event_t *ev)
+{
+    char topic[MAX_TOPIC];
+    char payload[MAX_PAYLOAD];
+
+    // Los comandos caben en un solo fragmento; los mensajes largos se ignoran
+    if (ev->current_data_offset != 0 || ev->data_len != ev->total_data_len ||
+        ev->topic_len >= (int)sizeof(topic) || ev->data_len >= (int)sizeof(payload)) {
+        ESP_LOGW(TAG, "Mensaje demasiado largo (%d bytes), ignorado", ev->total_data_len);
+        return;
+    }
+    memcpy(topic, ev->topic, ev->topic_len);
+    topic[ev->topic_len] = '\0';
+    memcpy(payload, ev->data, ev->data_len);
+    payload[ev->data_len] = '\0';
+
+    const char *param;
+    size_t dev_len = strlen(s_dev_prefix);
+    size_t group_len = strlen(s_group_prefix);
+    if (strncmp(topic, s_dev_prefix, dev_len) == 0) {
+        param = topic + dev_len;
+    } else if (strncmp(topic, s_group_prefix, group_len) == 0) {
+        param = topic + group_len;
+    } else {
+        return;
+    }
+
+    esp_err_t err = handle_command(param, payload);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s = \"%s\": %s", topic, payload, esp_err_to_name(err));
+    }
+}
+
+static void mqtt_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    esp_mqtt_event_handle_t ev = data;
+    char filter[MAX_TOPIC + 1];
+
+    switch ((esp_mqtt_event_id_t)id) {
+        case MQTT_EVENT_CONNECTED:
+            snprintf(filter, sizeof(filter), "%s#", s_dev_prefix);
+            esp_mqtt_client_subscribe_single(s_client, filter, 0);
+            snprintf(filter, sizeof(filter), "%s#", s_group_prefix);
+            esp_mqtt_client_subscribe_single(s_client, filter, 0);
+            esp_mqtt_client_publish(s_client, s_status_topic, "online", 0, 1, 1);
+            s_published_valid = false;
+            s_connected = true;
+            ESP_LOGI(TAG, "Conectado como %s", s_device);
+            break;
+
+        case MQTT_EVENT_DISCONNECTED:
+            s_connected = false;
+            ESP_LOGW(TAG, "Desconectado del broker");
+            break;
+
+        case MQTT_EVENT_DATA:
+            on_data(ev);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Estado aplicado en el formato de GET /api/state
+ */
+static int format_state(const led_cmd_state_t *st, char *buf, size_t size)
+{
+    const led_effect_t *fx = led_effects_get(st->effect);
+    int len = fx ? snprintf(buf, size, "{\"effect\":\"%s\"", fx->name)
+                 : snprintf(buf, size, "{\"effect\":null");
+    len += snprintf(buf + len, size - len,
+                    ",\"color\":[%u,%u,%u],\"brightness\":%u,\"segments\":[",
+                    st->rgb[0], st->rgb[1], st->rgb[2], st->brightness);
+
+    bool first = true;
+    for (int i = 0; i < LED_RENDER_MAX_SEGMENTS; i++) {
+        const led_cmd_segment_t *seg = &st->segments[i];
+        if (seg->len == 0) {
+            continue;
+        }
+        len += snprintf(buf + len, size - len,
+                        "%s{\"index\":%d,\"start\":%u,\"len\":%u,\"color\":[%u,%u,%u]}",
+                        first ? "" : ",", i, seg->start, seg->len,
+                        seg->rgb[0], seg->rgb[1], seg->rgb[2]);
+        first = false;
+    }
+    len += snprintf(buf + len, size - len, "]}");
+    return len;
+}
+
+/**
+ * @brief Publica el estado si cambió y ya pasó el intervalo mínimo
+ */
+static void state_timer_cb(void *arg)
+{
+    if (!s_connected) {
+        return;
+    }
+
+    led_cmd_state_t st;
+    led_cmd_get_state(&st);
+    if (s_published_valid && memcmp(&st, &s_published, sizeof(st)) == 0) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (s_published_valid && now - s_published_us < STATE_INTERVAL_US) {
+        return;
+    }
+
+    int len = format_state(&st, s_state_json, sizeof(s_state_json));
+    if (esp_mqtt_client_enqueue(s_client, s_state_topic, s_state_json, len, 0, 1, true) < 0) {
+        return;     // Cola de salida llena: se reintenta en la próxima revisión
+    }
+    s_published = st;
+    s_published_valid = true;
+    s_published_us = now;
+}
+
+#endif // CONFIG_MQTT_API_ENABLE
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+esp_err_t mqtt_api_start(void)
+{
+#ifdef CONFIG_MQTT_API_ENABLE
+    if (CONFIG_MQTT_API_DEVICE_ID[0] != '\0') {
+        snprintf(s_device, sizeof(s_device), "%s", CONFIG_MQTT_API_DEVICE_ID);
+    } else {
+        uint8_t mac[6];
+        esp_read_mac(mac, ESP_MAC_WIFI_STA);
+        snprintf(s_device, sizeof(s_device), "led-%02x%02x%02x", mac[3], mac[4], mac[5]);
+    }
+    snprintf(s_dev_prefix, sizeof(s_dev_prefix), BASE "/%s/set/", s_device);
+    snprintf(s_group_prefix, sizeof(s_group_prefix), BASE "/group/%s/set/",
+             CONFIG_MQTT_API_GROUP);
+    snprintf(s_state_topic, sizeof(s_state_topic), BASE "/%s/state", s_device);
+    snprintf(s_status_topic, sizeof(s_status_topic), BASE "/%s/status", s_device);
+
+    const esp_mqtt_client_config_t config = {
+        .broker.address.uri = CONFIG_MQTT_API_BROKER_URI,
+        .credentials.client_id = s_device,
+        .session.last_will = {
+            .topic = s_status_topic,
+            .msg = "offline",
+            .qos = 1,
+            .retain = 1,
+        },
+    };
+    s_client = esp_mqtt_client_init(&config);
+    if (s_client == NULL) {
+        return ESP_FAIL;
+    }
+    esp_mqtt_client_register_event(s_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = state_timer_cb,
+        .name = "mqtt_state",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_state_timer);
+    if (err == ESP_OK) {
+        err = esp_timer_start_periodic(s_state_timer, STATE_POLL_MS * 1000);
+    }
+    if (err == ESP_OK) {
+        err = esp_mqtt_client_start(s_client);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo arrancar el cliente: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Broker %s, temas %s# y %s#", CONFIG_MQTT_API_BROKER_URI,
+             s_dev_prefix, s_group_prefix);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
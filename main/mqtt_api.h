@@ -0,0 +1,54 @@
+/**
+ * @file mqtt_api.h
+ * @brief Cliente MQTT de control para domótica
+ *
+ * Se conecta al broker de CONFIG_MQTT_API_BROKER_URI y atiende los
+ * comandos de dos temas: el del dispositivo y el de su grupo, para mandar
+ * la misma orden a varias tiras con un solo mensaje.
+ *
+ * TEMAS (<base> = CONFIG_MQTT_API_BASE_TOPIC):
+ * ===========================================
+ *   <base>/<id>/set/<param>                 Comando para este dispositivo
+ *   <base>/group/<grupo>/set/<param>        Comando para todo el grupo
+ *   <base>/<id>/state                       Estado aplicado (JSON de /api/state, retenido)
+ *   <base>/<id>/status                      "online" u "offline" (última voluntad, retenido)
+ *
+ * PARÁMETROS (carga en texto plano):
+ * =================================
+ *   color          "#rrggbb" o "r,g,b"
+ *   effect         Nombre del efecto; "none" o vacío lo detiene
+ *   brightness     0-255
+ *   segment/<i>    "start,len,#rrggbb" o "start,len,r,g,b"; "off" o vacío lo borra
+ *   preset         Hueco a cargar
+ *   preset/save    Hueco donde guardar el estado aplicado
+ *
+ * Los comandos van a led_cmd_post_latest(): de una ráfaga de mensajes
+ * entre dos ticks solo se aplica el último valor de cada parámetro.
+ *
+ * El estado se publica solo cuando cambia y como mucho una vez cada
+ * CONFIG_MQTT_API_STATE_INTERVAL_MS: un cambio aislado sale enseguida,
+ * una ráfaga de cambios sale al principio y al final del intervalo.
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef MQTT_API_H
+#define MQTT_API_H
+
+#include "esp_err.h"
+
+/**
+ * @brief Arranca el cliente MQTT
+ *
+ * La conexión, las reconexiones y los mensajes los atiende la tarea del
+ * cliente MQTT de ESP-IDF.
+ *
+ * @note Necesita la red ya configurada (después de wifi_init_sta()) y
+ *       led_cmd_init()
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED sin CONFIG_MQTT_API_ENABLE o el
+ *         error del cliente
+ */
+esp_err_t mqtt_api_start(void);
+
+#endif // MQTT_API_H
@@ -0,0 +1,347 @@
+/**
+ * @file osc.c
+ * @brief Implementación del análisis de paquetes OSC
+ *
+ * Los enteros se leen byte a byte en big endian, así que el buffer no
+ * necesita ninguna alineación. Un mismo recorrido sirve para validar y
+ * para decodificar: sin array de salida solo se comprueban los tamaños.
+ */
+
+#include "osc.h"
+#include <string.h>
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t rd64(const uint8_t *p)
+{
+    return ((uint64_t)rd32(p) << 32) | rd32(p + 4);
+}
+
+static void wr32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * @brief Salta una cadena OSC (terminada en '\0' y rellena hasta 4 bytes)
+ *
+ * @return Posición siguiente, o NULL si no está terminada dentro de [p, end)
+ */
+static const uint8_t *skip_string(const uint8_t *p, const uint8_t *end)
+{
+    const uint8_t *nul = memchr(p, '\0', end - p);
+    if (nul == NULL) {
+        return NULL;
+    }
+    size_t padded = ((size_t)(nul - p) + 4) & ~(size_t)3;
+    return padded <= (size_t)(end - p) ? p + padded : NULL;
+}
+
+/**
+ * @brief Recorre los argumentos; con out == NULL solo los valida
+ */
+static int decode_args(const osc_msg_t *msg, osc_arg_t *out, int max)
+{
+    const uint8_t *p = msg->args;
+    const uint8_t *end = msg->end;
+    int n = 0;
+
+    for (const char *t = msg->types; *t; t++) {
+        osc_arg_t a = { .type = *t };
+        size_t need = 0;
+
+        switch (*t) {
+            case 'i': case 'c': case 'r': case 'm': case 'f':
+                need = 4;
+                break;
+            case 'h': case 'd': case 't':
+                need = 8;
+                break;
+            case 's': case 'S': {
+                const uint8_t *next = skip_string(p, end);
+                if (next == NULL) {
+                    return OSC_ERR_INVALID;
+                }
+                a.s = (const char *)p;
+                p = next;
+                break;
+            }
+            case 'b': {
+                if (end - p < 4) {
+                    return OSC_ERR_INVALID;
+                }
+                uint32_t len = rd32(p);
+                size_t padded = ((size_t)len + 3) & ~(size_t)3;
+                if (len > (size_t)(end - p) - 4 || padded > (size_t)(end - p) - 4) {
+                    return OSC_ERR_INVALID;
+                }
+                a.b.data = p + 4;
+                a.b.len = len;
+                p += 4 + padded;
+                break;
+            }
+            case 'T': case 'F':
+                a.i = *t == 'T';
+                break;
+            case 'N': case 'I': case '[': case ']':
+                break;
+            default:
+                return OSC_ERR_INVALID;
+        }
+
+        if (need) {
+            if ((size_t)(end - p) < need) {
+                return OSC_ERR_INVALID;
+            }
+            if (need == 4) {
+                uint32_t v = rd32(p);
+                if (*t == 'f') {
+                    memcpy(&a.f, &v, sizeof(a.f));
+                } else {
+                    a.i = (int32_t)v;
+                }
+            } else {
+                uint64_t v = rd64(p);
+                if (*t == 'd') {
+                    memcpy(&a.d, &v, sizeof(a.d));
+                } else {
+                    a.t = v;
+                }
+            }
+            p += need;
+        }
+
+        if (out) {
+            if (n == max) {
+                return OSC_ERR_NOMEM;
+            }
+            out[n] = a;
+        }
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Recorre un elemento (mensaje o bundle); con fn == NULL solo valida
+ */
+static int walk(const uint8_t *buf, size_t len, uint64_t timetag, int depth,
+                osc_msg_fn_t fn, void *arg)
+{
+    static const char bundle_tag[8] = "#bundle";
+
+    if (len < 4 || (len & 3) != 0) {
+        return OSC_ERR_INVALID;
+    }
+
+    if (buf[0] == '/') {
+        osc_msg_t msg;
+        if (!osc_parse_message(buf, len, &msg)) {
+            return OSC_ERR_INVALID;
+        }
+        msg.timetag = timetag;
+        if (fn) {
+            fn(&msg, arg);
+        }
+        return 1;
+    }
+
+    if (len < 16 || memcmp(buf, bundle_tag, sizeof(bundle_tag)) != 0 ||
+        depth >= OSC_MAX_DEPTH) {
+        return OSC_ERR_INVALID;
+    }
+
+    uint64_t tag = rd64(buf + 8);
+    size_t pos = 16;
+    int count = 0;
+    while (pos < len) {
+        if (len - pos < 4) {
+            return OSC_ERR_INVALID;
+        }
+        uint32_t size = rd32(buf + pos);
+        pos += 4;
+        if (size > len - pos) {
+            return OSC_ERR_INVALID;
+        }
+        int n = walk(buf + pos, size, tag, depth + 1, fn, arg);
+        if (n < 0) {
+            return n;
+        }
+        count += n;
+        pos += size;
+    }
+    return count;
+}
+
+static bool match(const char *p, const char *a)
+{
+    while (*p) {
+        switch (*p) {
+            case '?':
+                if (*a == '\0' || *a == '/') {
+                    return false;
+                }
+                p++;
+                a++;
+                break;
+
+            case '*':
+                while (*p == '*') {
+                    p++;
+                }
+                for (;; a++) {
+                    if (match(p, a)) {
+                        return true;
+                    }
+                    if (*a == '\0' || *a == '/') {
+                        return false;
+                    }
+                }
+
+            case '[': {
+                if (*a == '\0' || *a == '/') {
+                    return false;
+                }
+                bool negate = p[1] == '!';
+                bool found = false;
+                p += negate ? 2 : 1;
+                for (; *p && *p != ']'; p++) {
+                    if (p[1] == '-' && p[2] && p[2] != ']') {
+                        found |= *a >= p[0] && *a <= p[2];
+                        p += 2;
+                    } else {
+                        found |= *a == *p;
+                    }
+                }
+                if (*p != ']' || found == negate) {
+                    return false;
+                }
+                p++;
+                a++;
+                break;
+            }
+
+            case '{': {
+                const char *close = strchr(p, '}');
+                if (close == NULL) {
+                    return false;
+                }
+                const char *alt = p + 1;
+                while (alt <= close) {
+                    const char *stop = alt;
+                    while (stop < close && *stop != ',') {
+                        stop++;
+                    }
+                    size_t n = stop - alt;
+                    if (strncmp(alt, a, n) == 0 && match(close + 1, a + n)) {
+                        return true;
+                    }
+                    alt = stop + 1;
+                }
+                return false;
+            }
+
+            default:
+                if (*p != *a) {
+                    return false;
+                }
+                p++;
+                a++;
+                break;
+        }
+    }
+    return *a == '\0';
+}
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+bool osc_parse_message(const uint8_t *buf, size_t len, osc_msg_t *msg)
+{
+    const uint8_t *end = buf + len;
+
+    if (len < 4 || (len & 3) != 0 || buf[0] != '/') {
+        return false;
+    }
+    const uint8_t *p = skip_string(buf, end);
+    if (p == NULL) {
+        return false;
+    }
+
+    msg->address = (const char *)buf;
+    msg->timetag = OSC_TIMETAG_NOW;
+    msg->end = end;
+
+    // Sin cadena de tipos (emisores OSC antiguos): sin argumentos
+    if (p == end) {
+        msg->types = "";
+        msg->args = end;
+        return true;
+    }
+    if (*p != ',') {
+        return false;
+    }
+    const uint8_t *args = skip_string(p, end);
+    if (args == NULL) {
+        return false;
+    }
+    msg->types = (const char *)p + 1;
+    msg->args = args;
+    return decode_args(msg, NULL, 0) >= 0;
+}
+
+int osc_parse_packet(const uint8_t *buf, size_t len, osc_msg_fn_t fn, void *arg)
+{
+    int n = walk(buf, len, OSC_TIMETAG_NOW, 0, NULL, NULL);
+    if (n < 0 || fn == NULL) {
+        return n;
+    }
+    return walk(buf, len, OSC_TIMETAG_NOW, 0, fn, arg);
+}
+
+int osc_args(const osc_msg_t *msg, osc_arg_t *out, int max)
+{
+    return decode_args(msg, out, max);
+}
+
+bool osc_pattern_match(const char *pattern, const char *address)
+{
+    return match(pattern, address);
+}
+
+bool osc_is_pattern(const char *address)
+{
+    return strpbrk(address, "*?[]{}") != NULL;
+}
+
+size_t osc_write_ints(uint8_t *buf, size_t size, const char *address,
+                      const int32_t *v, int n)
+{
+    size_t alen = (strlen(address) + 4) & ~(size_t)3;
+    size_t tlen = ((size_t)n + 1 + 4) & ~(size_t)3;
+    size_t total = alen + tlen + (size_t)n * 4;
+    if (total > size) {
+        return 0;
+    }
+
+    memset(buf, 0, alen + tlen);
+    memcpy(buf, address, strlen(address));
+    uint8_t *t = buf + alen;
+    t[0] = ',';
+    memset(t + 1, 'i', n);
+    for (int k = 0; k < n; k++) {
+        wr32(buf + alen + tlen + k * 4, (uint32_t)v[k]);
+    }
+    return total;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file osc.h
+ * @brief Análisis de paquetes OSC (Open Sound Control 1.0) en el propio buffer
+ *
+ * Un paquete OSC es un mensaje o un bundle. Un mensaje es una dirección
+ * ("/led/brightness"), una cadena de tipos (",f") y los argumentos en big
+ * endian, todo alineado a 4 bytes. Un bundle es "#bundle", una marca de
+ * tiempo y una lista de elementos con su tamaño, que a su vez son
+ * mensajes o bundles.
+ *
+ * No se copia nada: osc_parse_packet() recorre el paquete y entrega cada
+ * mensaje con punteros al buffer de recepción, y osc_args() decodifica
+ * los argumentos en un array que pone quien llama (cadenas y blobs siguen
+ * apuntando al buffer). Solo se comprueba que todo esté dentro del
+ * paquete y bien terminado; el buffer no se modifica.
+ *
+ * La dirección de un mensaje puede ser un patrón (*, ?, [a-z], [!0-9],
+ * {uno,otro}) que se compara con las direcciones del receptor con
+ * osc_pattern_match().
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef OSC_H
+#define OSC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bundles anidados admitidos
+#define OSC_MAX_DEPTH 4
+
+// Errores de osc_parse_packet() y osc_args()
+#define OSC_ERR_INVALID    (-1)    ///< El paquete no es OSC válido
+#define OSC_ERR_NOMEM      (-2)    ///< Más argumentos que el array de salida
+
+// Marca de tiempo "inmediatamente" de los bundles
+#define OSC_TIMETAG_NOW    1ULL
+
+/**
+ * @brief Un mensaje dentro del paquete
+ */
+typedef struct {
+    const char *address;        ///< Dirección o patrón, terminada en '\0'
+    const char *types;          ///< Tipos sin la coma inicial, terminados en '\0'
+    const uint8_t *args;        ///< Primer argumento
+    const uint8_t *end;         ///< Fin del mensaje
+    uint64_t timetag;           ///< Del bundle que lo contiene (OSC_TIMETAG_NOW si no hay)
+} osc_msg_t;
+
+/**
+ * @brief Un argumento decodificado
+ */
+typedef struct {
+    char type;                  ///< Carácter de la cadena de tipos
+    union {
+        int32_t i;              ///< i, c (carácter), r (RGBA), m (MIDI), T/F (1/0)
+        float f;                ///< f
+        int64_t h;              ///< h
+        double d;               ///< d
+        uint64_t t;             ///< t
+        const char *s;          ///< s, S
+        struct {
+            const uint8_t *data;
+            uint32_t len;
+        } b;                    ///< b
+    };
+} osc_arg_t;
+
+/**
+ * @brief Función llamada por cada mensaje de un paquete
+ */
+typedef void (*osc_msg_fn_t)(const osc_msg_t *msg, void *arg);
+
+/**
+ * @brief Analiza un mensaje suelto
+ *
+ * @param buf Mensaje (empieza por '/')
+ * @param len Tamaño en bytes (múltiplo de 4)
+ * @param[out] msg Mensaje con punteros a buf
+ * @return false si el mensaje está mal formado
+ */
+bool osc_parse_message(const uint8_t *buf, size_t len, osc_msg_t *msg);
+
+/**
+ * @brief Recorre un paquete y llama a fn con cada mensaje, en orden
+ *
+ * Todo el paquete se valida antes de entregar el primer mensaje: uno mal
+ * formado no deja el paquete aplicado a medias.
+ *
+ * @return Número de mensajes, o OSC_ERR_INVALID
+ */
+int osc_parse_packet(const uint8_t *buf, size_t len, osc_msg_fn_t fn, void *arg);
+
+/**
+ * @brief Decodifica los argumentos de un mensaje
+ *
+ * @param msg Mensaje de osc_parse_message() u osc_parse_packet()
+ * @param out Array de salida
+ * @param max Elementos del array
+ * @return Número de argumentos, o OSC_ERR_*
+ */
+int osc_args(const osc_msg_t *msg, osc_arg_t *out, int max);
+
+/**
+ * @brief Compara un patrón OSC con una dirección completa
+ *
+ * '*' y '?' no cruzan el separador '/'.
+ */
+bool osc_pattern_match(const char *pattern, const char *address);
+
+/**
+ * @brief Indica si una dirección tiene caracteres de patrón
+ */
+bool osc_is_pattern(const char *address);
+
+/**
+ * @brief Escribe un mensaje con argumentos enteros
+ *
+ * @param buf   Destino
+ * @param size  Tamaño de buf
+ * @param address Dirección
+ * @param v     Argumentos (tipo i)
+ * @param n     Número de argumentos
+ * @return Bytes escritos, o 0 si no cabe
+ */
+size_t osc_write_ints(uint8_t *buf, size_t size, const char *address,
+                      const int32_t *v, int n);
+
+#endif // OSC_H
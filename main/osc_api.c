@@ -0,0 +1,582 @@
+/**
+ * @file osc_api.c
+ * @brief Implementación del receptor OSC
+ *
+ * Una tarea bloqueada en recvfrom() sobre un buffer estático del tamaño de
+ * un datagrama sin fragmentar. Los contadores solo los toca esa tarea.
+ *
+ * La tabla de direcciones tiene una entrada por dirección (los segmentos
+ * se expanden a /led/segment/0 ... /led/segment/7) con su hash FNV-1a;
+ * osc_api_start() la ordena por hash una sola vez.
+ */
+
+#include "osc_api.h"
+#include "osc.h"
+#include "led_cmd.h"
+#include "led_cue.h"
+#include "led_effects.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_OSC_API_ENABLE
+#include <errno.h>
+#include <unistd.h>
+#include "lwip/sockets.h"
+#endif
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+#ifdef CONFIG_OSC_API_ENABLE
+
+static const char *TAG = "OSC_API";
+
+#define OSC_TASK_STACK      3072
+#define OSC_TASK_PRIO       4           // Por debajo de la tarea de render
+
+#define MAX_PACKET          1472        // Datagrama sin fragmentar en Ethernet/WiFi
+#define MAX_ARGS            8
+
+// Posición máxima de un código de tiempo en segundos: en us cabe en int64_t
+#define POSITION_MAX_S      9000000000LL
+
+// Campos de la respuesta a /led/stats
+#define NUM_STATS           13
+
+/**
+ * @brief Llamada a una dirección: el mensaje y sus argumentos ya decodificados
+ */
+typedef struct {
+    const osc_msg_t *msg;
+    const osc_arg_t *args;
+    int n;
+} call_t;
+
+typedef esp_err_t (*route_fn_t)(const call_t *c, int index);
+
+/**
+ * @brief Entrada de la tabla de direcciones
+ */
+typedef struct {
+    const char *address;
+    route_fn_t fn;
+    uint8_t index;              ///< Componente de color o segmento
+    uint32_t hash;
+} route_t;
+
+/**
+ * @brief Contadores del receptor
+ */
+typedef struct {
+    uint32_t packets;
+    uint32_t messages;
+    uint32_t bundles;
+    uint32_t errors;            ///< Paquetes mal formados
+    uint32_t unmatched;         ///< Mensajes sin ninguna dirección
+    uint32_t rejected;          ///< Mensajes con argumentos no válidos
+    uint64_t handle_sum_us;     ///< Análisis y reparto por paquete
+    uint32_t handle_max_us;
+} osc_stats_t;
+
+static int s_sock = -1;
+static struct sockaddr_storage s_from;  // Origen del datagrama en curso
+static socklen_t s_from_len;
+
+static uint8_t s_rx[MAX_PACKET];
+static uint8_t s_tx[MAX_PACKET];
+
+static uint8_t s_rgb[3] = { 255, 255, 255 };    // Último color recibido por OSC
+static osc_stats_t s_stats;
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+static uint32_t fnv1a(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h = (h ^ (uint8_t)*s++) * 16777619u;
+    }
+    return h;
+}
+
+static void reply(const uint8_t *data, size_t len)
+{
+    if (len > 0) {
+        sendto(s_sock, data, len, 0, (const struct sockaddr *)&s_from, s_from_len);
+    }
+}
+
+/**
+ * @brief Lee un nivel 0-255: entero, float 0.0-1.0 o T/F
+ */
+static bool arg_level(const osc_arg_t *a, uint8_t *v)
+{
+    int32_t x;
+    switch (a->type) {
+        case 'i':
+            x = a->i;
+            break;
+        case 'f':
+            // Se satura antes de convertir: NaN o 1e20 no caben en un entero
+            if (isnan(a->f)) {
+                return false;
+            }
+            x = a->f <= 0.0f ? 0 : a->f >= 1.0f ? 255 : (int32_t)(a->f * 255.0f + 0.5f);
+            break;
+        case 'T':
+        case 'F':
+            x = a->i ? 255 : 0;
+            break;
+        default:
+            return false;
+    }
+    *v = (uint8_t)(x < 0 ? 0 : x > 255 ? 255 : x);
+    return true;
+}
+
+/**
+ * @brief Lee un color desde args: un RGBA o tres niveles
+ */
+static bool arg_color(const osc_arg_t *args, int n, uint8_t *rgb)
+{
+    if (n >= 1 && args[0].type == 'r') {
+        rgb[0] = (uint8_t)((uint32_t)args[0].i >> 24);
+        rgb[1] = (uint8_t)((uint32_t)args[0].i >> 16);
+        rgb[2] = (uint8_t)((uint32_t)args[0].i >> 8);
+        return true;
+    }
+    return n >= 3 && arg_level(&args[0], &rgb[0]) && arg_level(&args[1], &rgb[1]) &&
+           arg_level(&args[2], &rgb[2]);
+}
+
+static bool arg_int(const osc_arg_t *a, int32_t *v)
+{
+    if (a->type == 'i') {
+        *v = a->i;
+        return true;
+    }
+    if (a->type == 'f' && !isnan(a->f)) {
+        *v = a->f >= 2147483648.0f ? INT32_MAX :
+             a->f < -2147483648.0f ? INT32_MIN : (int32_t)a->f;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Segundos en us, o false si es negativo, NaN o no cabe en int64_t
+ */
+static bool seconds_us(double s, int64_t *us)
+{
+    if (!isfinite(s) || s < 0.0 || s > POSITION_MAX_S) {
+        return false;
+    }
+    *us = (int64_t)(s * 1e6);
+    return true;
+}
+
+/**
+ * @brief Lee una posición: ms (i, h) o segundos (f, d)
+ */
+static bool arg_position(const osc_arg_t *a, int64_t *us)
+{
+    switch (a->type) {
+        case 'i':
+            *us = (int64_t)a->i * 1000;
+            return *us >= 0;
+        case 'h':
+            if (a->h < 0 || a->h > (int64_t)POSITION_MAX_S * 1000) {
+                return false;
+            }
+            *us = a->h * 1000;
+            return true;
+        case 'f':
+            return seconds_us(a->f, us);
+        case 'd':
+            return seconds_us(a->d, us);
+        default:
+            return false;
+    }
+}
+
+// --- Direcciones ---
+
+static esp_err_t post_color(void)
+{
+    led_cmd_t cmd = { .type = LED_CMD_COLOR };
+    memcpy(cmd.rgb, s_rgb, 3);
+    return led_cmd_post_latest(&cmd);
+}
+
+static esp_err_t on_color(const call_t *c, int index)
+{
+    uint8_t rgb[3];
+    if (!arg_color(c->args, c->n, rgb)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(s_rgb, rgb, 3);
+    return post_color();
+}
+
+static esp_err_t on_component(const call_t *c, int index)
+{
+    if (c->n < 1 || !arg_level(&c->args[0], &s_rgb[index])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return post_color();
+}
+
+static esp_err_t on_brightness(const call_t *c, int index)
+{
+    led_cmd_t cmd = { .type = LED_CMD_BRIGHTNESS };
+    if (c->n < 1 || !arg_level(&c->args[0], &cmd.brightness)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return led_cmd_post_latest(&cmd);
+}
+
+static esp_err_t on_effect(const call_t *c, int index)
+{
+    led_cmd_t cmd = { .type = LED_CMD_EFFECT, .effect = LED_FX_NONE };
+    int32_t id;
+
+    if (c->n < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (c->args[0].type == 's' || c->args[0].type == 'S') {
+        if (strcmp(c->args[0].s, "none") != 0) {
+            cmd.effect = led_effects_find(c->args[0].s);
+            if (cmd.effect == LED_FX_NONE) {
+                return ESP_ERR_NOT_FOUND;
+            }
+        }
+    } else if (arg_int(&c->args[0], &id)) {
+        if (id >= 0) {
+            if (id >= led_effects_count()) {
+                return ESP_ERR_NOT_FOUND;
+            }
+            cmd.effect = (int16_t)id;
+        }
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return led_cmd_post_latest(&cmd);
+}
+
+static esp_err_t on_segment(const call_t *c, int index)
+{
+    led_cmd_t cmd = { .type = LED_CMD_SEGMENT, .index = (uint8_t)index };
+    int32_t start, len;
+
+    if (c->n < 2 || !arg_int(&c->args[0], &start) || !arg_int(&c->args[1], &len) ||
+        start < 0 || start > UINT16_MAX || len < 0 || len > UINT16_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > 0 && !arg_color(c->args + 2, c->n - 2, cmd.rgb)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cmd.start = (uint16_t)start;
+    cmd.len = (uint16_t)len;
+    return led_cmd_post_latest(&cmd);
+}
+
+static esp_err_t on_preset(const call_t *c, int index)
+{
+    int32_t slot;
+    if (c->n < 1 || !arg_int(&c->args[0], &slot) || slot < 0 || slot >= LED_CMD_PRESETS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return led_cmd_preset_load(slot);
+}
+
+/**
+ * @brief Posición de un código de tiempo: una posición (arg_position) o
+ * horas, minutos, segundos y frames a CONFIG_LED_CUE_TIMECODE_FPS
+ */
+static esp_err_t on_timecode(const call_t *c, int index)
+{
+    int64_t us;
+
+    if (c->n >= 4) {
+        int32_t f[4];
+        for (int k = 0; k < 4; k++) {
+            if (!arg_int(&c->args[k], &f[k]) || f[k] < 0) {
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+        us = ((int64_t)f[0] * 3600 + (int64_t)f[1] * 60 + f[2]) * 1000000 +
+             (int64_t)f[3] * 1000000 / CONFIG_LED_CUE_TIMECODE_FPS;
+    } else if (c->n < 1 || !arg_position(&c->args[0], &us)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    led_cue_timecode(us);
+    return ESP_OK;
+}
+
+static esp_err_t on_cue_play(const call_t *c, int index)
+{
+    int64_t us = 0;
+    if (c->n >= 1 && !arg_position(&c->args[0], &us)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    led_cue_play(us / 1000 > UINT32_MAX ? UINT32_MAX : (uint32_t)(us / 1000));
+    return ESP_OK;
+}
+
+static esp_err_t on_cue_stop(const call_t *c, int index)
+{
+    led_cue_stop();
+    return ESP_OK;
+}
+
+/**
+ * @brief Responde /led/pong con la cadena de tipos y los argumentos del ping
+ */
+static esp_err_t on_ping(const call_t *c, int index)
+{
+    static const char pong[12] = "/led/pong";
+    const uint8_t *rest = NULL;
+    size_t len = 0;
+
+    // Sin argumentos la respuesta va sin cadena de tipos
+    if (*c->msg->types != '\0') {
+        rest = (const uint8_t *)c->msg->types - 1;
+        len = c->msg->end - rest;
+    }
+    if (sizeof(pong) + len > sizeof(s_tx)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(s_tx, pong, sizeof(pong));
+    if (len > 0) {
+        memcpy(s_tx + sizeof(pong), rest, len);
+    }
+    reply(s_tx, sizeof(pong) + len);
+    return ESP_OK;
+}
+
+/**
+ * @brief Responde /led/stats
+ *
+ * Orden: paquetes, mensajes, bundles, errores, sin dirección, rechazados,
+ * tiempo medio y máximo por paquete (µs), comandos agrupados, muestras
+ * de latencia petición-luz y sus p50, p90 y p99 (µs).
+ */
+static esp_err_t on_stats(const call_t *c, int index)
+{
+    led_cmd_stats_t cmd;
+    led_cmd_get_stats(&cmd);
+
+    const int32_t v[NUM_STATS] = {
+        (int32_t)s_stats.packets, (int32_t)s_stats.messages, (int32_t)s_stats.bundles,
+        (int32_t)s_stats.errors, (int32_t)s_stats.unmatched, (int32_t)s_stats.rejected,
+        s_stats.packets ? (int32_t)(s_stats.handle_sum_us / s_stats.packets) : 0,
+        (int32_t)s_stats.handle_max_us, (int32_t)cmd.coalesced,
+        (int32_t)cmd.latency_samples, (int32_t)cmd.latency_p50_us,
+        (int32_t)cmd.latency_p90_us, (int32_t)cmd.latency_p99_us,
+    };
+    reply(s_tx, osc_write_ints(s_tx, sizeof(s_tx), "/led/stats", v, NUM_STATS));
+
+    int32_t flags;
+    if (c->n >= 1 && arg_int(&c->args[0], &flags) && (flags & 1)) {
+        led_cmd_reset_latency();
+        s_stats.handle_max_us = 0;
+    }
+    return ESP_OK;
+}
+
+// --- Tabla de direcciones ---
+
+static const route_t s_fixed[] = {
+    { .address = "/led/color",         .fn = on_color,       .index = 0 },
+    { .address = "/led/color/red",     .fn = on_component,   .index = 0 },
+    { .address = "/led/color/green",   .fn = on_component,   .index = 1 },
+    { .address = "/led/color/blue",    .fn = on_component,   .index = 2 },
+    { .address = "/led/brightness",    .fn = on_brightness,  .index = 0 },
+    { .address = "/led/effect",        .fn = on_effect,      .index = 0 },
+    { .address = "/led/preset",        .fn = on_preset,      .index = 0 },
+    { .address = "/led/timecode",      .fn = on_timecode,    .index = 0 },
+    { .address = "/led/cue/play",      .fn = on_cue_play,    .index = 0 },
+    { .address = "/led/cue/stop",      .fn = on_cue_stop,    .index = 0 },
+    { .address = "/led/ping",          .fn = on_ping,        .index = 0 },
+    { .address = "/led/stats",         .fn = on_stats,       .index = 0 },
+};
+
+#define NUM_FIXED   ((int)(sizeof(s_fixed) / sizeof(s_fixed[0])))
+#define NUM_ROUTES  (NUM_FIXED + LED_RENDER_MAX_SEGMENTS)
+
+static char s_segment_address[LED_RENDER_MAX_SEGMENTS][24];
+static route_t s_routes[NUM_ROUTES];    // Ordenada por hash
+
+/**
+ * @brief Construye la tabla de direcciones y la ordena por hash
+ */
+static void compile_routes(void)
+{
+    memcpy(s_routes, s_fixed, sizeof(s_fixed));
+    for (int i = 0; i < LED_RENDER_MAX_SEGMENTS; i++) {
+        snprintf(s_segment_address[i], sizeof(s_segment_address[i]), "/led/segment/%d", i);
+        s_routes[NUM_FIXED + i] = (route_t){
+            .address = s_segment_address[i], .fn = on_segment, .index = (uint8_t)i,
+        };
+    }
+    for (int i = 0; i < NUM_ROUTES; i++) {
+        s_routes[i].hash = fnv1a(s_routes[i].address);
+    }
+
+    // Inserción: una sola vez y con pocas entradas
+    for (int i = 1; i < NUM_ROUTES; i++) {
+        route_t r = s_routes[i];
+        int k = i;
+        for (; k > 0 && s_routes[k - 1].hash > r.hash; k--) {
+            s_routes[k] = s_routes[k - 1];
+        }
+        s_routes[k] = r;
+    }
+}
+
+/**
+ * @brief Entrada de una dirección literal (NULL si no existe)
+ */
+static const route_t *find_route(const char *address)
+{
+    uint32_t h = fnv1a(address);
+    int lo = 0, hi = NUM_ROUTES;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (s_routes[mid].hash < h) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < NUM_ROUTES && s_routes[lo].hash == h; lo++) {
+        if (strcmp(s_routes[lo].address, address) == 0) {
+            return &s_routes[lo];
+        }
+    }
+    return NULL;
+}
+
+static void call(const route_t *r, const call_t *c)
+{
+    esp_err_t err = r->fn(c, r->index);
+    if (err != ESP_OK) {
+        s_stats.rejected++;
+        ESP_LOGD(TAG, "%s: %s", r->address, esp_err_to_name(err));
+    }
+}
+
+/**
+ * @brief Reparte un mensaje (llamada de osc_parse_packet())
+ */
+static void on_message(const osc_msg_t *msg, void *arg)
+{
+    osc_arg_t args[MAX_ARGS];
+    call_t c = { .msg = msg, .args = args };
+
+    s_stats.messages++;
+    c.n = osc_args(msg, args, MAX_ARGS);
+    if (c.n < 0) {
+        s_stats.rejected++;
+        return;
+    }
+
+    if (!osc_is_pattern(msg->address)) {
+        const route_t *r = find_route(msg->address);
+        if (r == NULL) {
+            s_stats.unmatched++;
+            return;
+        }
+        call(r, &c);
+        return;
+    }
+
+    bool matched = false;
+    for (int i = 0; i < NUM_ROUTES; i++) {
+        if (osc_pattern_match(msg->address, s_routes[i].address)) {
+            call(&s_routes[i], &c);
+            matched = true;
+        }
+    }
+    if (!matched) {
+        s_stats.unmatched++;
+    }
+}
+
+static void osc_task(void *arg)
+{
+    for (;;) {
+        s_from_len = sizeof(s_from);
+        int len = recvfrom(s_sock, s_rx, sizeof(s_rx), 0,
+                           (struct sockaddr *)&s_from, &s_from_len);
+        if (len < 0) {
+            ESP_LOGW(TAG, "recvfrom: errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        s_stats.packets++;
+        if (osc_parse_packet(s_rx, len, on_message, NULL) < 0) {
+            s_stats.errors++;
+        } else if (s_rx[0] == '#') {
+            s_stats.bundles++;
+        }
+
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+        s_stats.handle_sum_us += us;
+        if (us > s_stats.handle_max_us) {
+            s_stats.handle_max_us = us;
+        }
+    }
+}
+
+#endif // CONFIG_OSC_API_ENABLE
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+esp_err_t osc_api_start(void)
+{
+#ifdef CONFIG_OSC_API_ENABLE
+    compile_routes();
+
+    led_cmd_state_t st;
+    led_cmd_get_state(&st);
+    memcpy(s_rgb, st.rgb, 3);
+
+    s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_sock < 0) {
+        ESP_LOGE(TAG, "No se pudo crear el socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CONFIG_OSC_API_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(s_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "No se pudo abrir el puerto %d: errno %d", CONFIG_OSC_API_PORT, errno);
+        close(s_sock);
+        s_sock = -1;
+        return ESP_FAIL;
+    }
+
+    xTaskCreate(osc_task, "OSC_RX", OSC_TASK_STACK, NULL, OSC_TASK_PRIO, NULL);
+
+    ESP_LOGI(TAG, "OSC en el puerto UDP %d (%d direcciones)", CONFIG_OSC_API_PORT, NUM_ROUTES);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
@@ -0,0 +1,61 @@
+/**
+ * @file osc_api.h
+ * @brief Receptor OSC (Open Sound Control) por UDP
+ *
+ * Para tabletas, mesas y DAW que hablan OSC. Cada datagrama se analiza en
+ * el buffer de recepción (osc.h) y sus mensajes se reparten por una tabla
+ * de direcciones que se prepara al arrancar: ordenada por el hash de cada
+ * dirección, una dirección literal se resuelve con una búsqueda binaria y
+ * un strcmp. Solo las direcciones con patrón (con * ? [ ] { }) recorren
+ * la tabla entera con osc_pattern_match().
+ *
+ * DIRECCIONES:
+ * ===========
+ *   /led/color             r g b, o un argumento RGBA (tipo r)
+ *   /led/color/red         v   (también green y blue: un componente del
+ *                              último color recibido por OSC)
+ *   /led/brightness        v
+ *   /led/effect            Nombre (s) o índice (i) de /api/effects;
+ *                          "none" o -1 lo detiene
+ *   /led/segment/<i>       start len r g b, o start len RGBA; len 0 lo borra
+ *   /led/preset            Hueco a cargar
+ *   /led/timecode          Posición de la lista de cues (led_cue.h): ms
+ *                          (i, h), segundos (f, d) o h m s frames a
+ *                          CONFIG_LED_CUE_TIMECODE_FPS
+ *   /led/cue/play          Reproduce la lista con el reloj local desde una
+ *                          posición (ms o segundos, por defecto 0)
+ *   /led/cue/stop          Detiene la lista
+ *   /led/ping              Se responde /led/pong con los mismos argumentos
+ *   /led/stats             Se responde /led/stats con los contadores
+ *                          (ver osc_api.c); el argumento 1 reinicia
+ *                          latencias y máximos después de leerlos
+ *
+ * Los valores de color y brillo pueden ser enteros 0-255 o floats 0.0-1.0
+ * (lo habitual en los faders); fuera de rango se recortan.
+ *
+ * Los comandos van a led_cmd_post_latest(): de una ráfaga de un fader solo
+ * se aplica el último valor de cada tick. Los mensajes de un bundle se
+ * aplican en orden y enseguida; su marca de tiempo no se usa. Las
+ * respuestas van a la dirección y puerto de origen del datagrama.
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef OSC_API_H
+#define OSC_API_H
+
+#include "esp_err.h"
+
+/**
+ * @brief Prepara la tabla de direcciones, abre el puerto UDP
+ * CONFIG_OSC_API_PORT y arranca la tarea de recepción
+ *
+ * @note Necesita la red ya configurada (después de wifi_init_sta()) y
+ *       led_cmd_init()
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED sin CONFIG_OSC_API_ENABLE o
+ *         ESP_FAIL si no se puede abrir el puerto
+ */
+esp_err_t osc_api_start(void);
+
+#endif // OSC_API_H
@@ -0,0 +1,284 @@
+/**
+ * @file ws_api.c
+ * @brief Implementación del canal WebSocket de control
+ *
+ * El servidor atiende todas las conexiones desde una sola tarea, así que
+ * el buffer de recepción es uno solo y estático: cabe un frame RGBW de
+ * toda la tira con su código. Los mensajes más grandes cierran la
+ * conexión (el servidor no permite descartar solo el mensaje).
+ */
+
+#include "ws_api.h"
+#include "led_cmd.h"
+#include "led_control.h"
+#include "led_effects.h"
+#include "led_render.h"
+#include <string.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_HTTP_API_WS
+
+// ============================================================================
+// DEFINICIONES Y CONFIGURACIÓN
+// ============================================================================
+
+static const char *TAG = "WS_API";
+
+#define MAX_MESSAGE         (1 + LED_NUM_LEDS * 4)
+
+// Campos de la respuesta a WS_OP_STATS
+#define NUM_STATS           14
+
+static uint8_t s_rx[MAX_MESSAGE < 64 ? 64 : MAX_MESSAGE];
+
+// Contadores del canal
+static uint32_t s_messages;
+static uint32_t s_frames;
+static uint32_t s_errors;
+
+// ============================================================================
+// FUNCIONES PRIVADAS (STATIC)
+// ============================================================================
+
+/**
+ * @brief Bytes de argumentos de un comando de tamaño fijo (-1 si no lo es)
+ */
+static int arg_len(uint8_t op)
+{
+    switch (op) {
+        case WS_OP_COLOR:      return 3;
+        case WS_OP_EFFECT:     return 1;
+        case WS_OP_BRIGHTNESS: return 1;
+        case WS_OP_SEGMENT:    return 7;
+        case WS_OP_PRESET:     return 1;
+        case WS_OP_STATS:      return 1;
+        default:               return -1;
+    }
+}
+
+static esp_err_t send_binary(httpd_req_t *req, const uint8_t *data, size_t len)
+{
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = (uint8_t *)data,
+        .len = len,
+    };
+    return httpd_ws_send_frame(req, &frame);
+}
+
+static esp_err_t send_error(httpd_req_t *req, uint8_t op)
+{
+    const uint8_t msg[2] = { WS_OP_ERROR, op };
+    s_errors++;
+    return send_binary(req, msg, sizeof(msg));
+}
+
+/**
+ * @brief Responde a WS_OP_STATS
+ *
+ * Orden de los campos: recibidos, descartados, agrupados, aplicados,
+ * muestras de latencia, última, media, máxima, p50, p90, p99 (µs),
+ * mensajes, frames y errores del canal.
+ */
+static esp_err_t send_stats(httpd_req_t *req, uint8_t flags)
+{
+    led_cmd_stats_t st;
+    led_cmd_get_stats(&st);
+    if (flags & 1) {
+        led_cmd_reset_latency();
+    }
+
+    const uint32_t v[NUM_STATS] = {
+        st.received, st.dropped, st.coalesced, st.applied,
+        st.latency_samples, st.latency_last_us,
+        st.latency_samples ? (uint32_t)(st.latency_sum_us / st.latency_samples) : 0,
+        st.latency_max_us, st.latency_p50_us, st.latency_p90_us, st.latency_p99_us,
+        s_messages, s_frames, s_errors,
+    };
+    uint8_t out[1 + NUM_STATS * 4] = { WS_OP_STATS };
+    for (int i = 0; i < NUM_STATS; i++) {
+        out[1 + i * 4] = (uint8_t)v[i];
+        out[2 + i * 4] = (uint8_t)(v[i] >> 8);
+        out[3 + i * 4] = (uint8_t)(v[i] >> 16);
+        out[4 + i * 4] = (uint8_t)(v[i] >> 24);
+    }
+    return send_binary(req, out, sizeof(out));
+}
+
+/**
+ * @brief Entrega las entradas de PIXELS o RANGES al render stage
+ *
+ * @param p     Entradas (n de size bytes)
+ * @param n     Número de entradas
+ * @param range true para RANGES (con len), false para PIXELS
+ */
+static esp_err_t update_pixels(const uint8_t *p, size_t n, bool range)
+{
+    const size_t size = range ? 7 : 5;
+    led_render_span_t spans[WS_UPDATE_CHUNK];
+
+    while (n > 0) {
+        size_t k = n < WS_UPDATE_CHUNK ? n : WS_UPDATE_CHUNK;
+        for (size_t i = 0; i < k; i++, p += size) {
+            spans[i].start = (uint16_t)(p[0] | (p[1] << 8));
+            spans[i].len = range ? (uint16_t)(p[2] | (p[3] << 8)) : 1;
+            memcpy(spans[i].rgb, p + size - 3, 3);
+        }
+        esp_err_t err = led_render_update_pixels(spans, k);
+        if (err != ESP_OK) {
+            return err;
+        }
+        n -= k;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Ejecuta los comandos de un mensaje
+ */
+static esp_err_t handle_message(httpd_req_t *req, const uint8_t *msg, size_t len)
+{
+    size_t pos = 0;
+
+    while (pos < len) {
+        const uint8_t op = msg[pos++];
+        const uint8_t *p = msg + pos;
+        const size_t rest = len - pos;
+        esp_err_t err = ESP_OK;
+
+        // Los que ocupan el resto del mensaje
+        switch (op) {
+            case WS_OP_ECHO:
+                return send_binary(req, msg + pos - 1, rest + 1);
+            case WS_OP_FRAME_RGB:
+            case WS_OP_FRAME_RGBW: {
+                const size_t ch = op == WS_OP_FRAME_RGB ? 3 : 4;
+                if (rest == 0 || rest % ch != 0) {
+                    return send_error(req, op);
+                }
+                s_frames++;
+                err = ch == 3 ? led_render_submit_frame(p, rest / 3)
+                              : led_render_submit_frame_rgbw(p, rest / 4);
+                return err == ESP_OK ? ESP_OK : send_error(req, op);
+            }
+            case WS_OP_PIXELS:
+            case WS_OP_RANGES: {
+                const size_t size = op == WS_OP_PIXELS ? 5 : 7;
+                if (rest < 2) {
+                    return send_error(req, op);
+                }
+                const size_t n = p[0] | (p[1] << 8);
+                if (rest - 2 < n * size ||
+                    update_pixels(p + 2, n, op == WS_OP_RANGES) != ESP_OK) {
+                    return send_error(req, op);
+                }
+                pos += 2 + n * size;
+                continue;
+            }
+            default:
+                break;
+        }
+
+        const int need = arg_len(op);
+        if (need < 0 || rest < (size_t)need) {
+            return send_error(req, op);
+        }
+        pos += need;
+
+        led_cmd_t cmd = { 0 };
+        switch (op) {
+            case WS_OP_COLOR:
+                cmd.type = LED_CMD_COLOR;
+                memcpy(cmd.rgb, p, 3);
+                err = led_cmd_post_latest(&cmd);
+                break;
+            case WS_OP_EFFECT:
+                cmd.type = LED_CMD_EFFECT;
+                cmd.effect = p[0] == 0xFF ? LED_FX_NONE : p[0];
+                err = led_cmd_post_latest(&cmd);
+                break;
+            case WS_OP_BRIGHTNESS:
+                cmd.type = LED_CMD_BRIGHTNESS;
+                cmd.brightness = p[0];
+                err = led_cmd_post_latest(&cmd);
+                break;
+            case WS_OP_SEGMENT:
+                cmd.type = LED_CMD_SEGMENT;
+                cmd.index = p[0];
+                cmd.start = (uint16_t)(p[1] | (p[2] << 8));
+                cmd.len = (uint16_t)(p[3] | (p[4] << 8));
+                memcpy(cmd.rgb, p + 5, 3);
+                err = led_cmd_post_latest(&cmd);
+                break;
+            case WS_OP_PRESET:
+                err = led_cmd_preset_load(p[0]);
+                break;
+            case WS_OP_STATS:
+                err = send_stats(req, p[0]);
+                break;
+        }
+        if (err != ESP_OK) {
+            return send_error(req, op);
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Manejador de /ws: la negociación y después un mensaje por llamada
+ */
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        ESP_LOGI(TAG, "Cliente conectado");
+        return ESP_OK;
+    }
+
+    // Primero solo la cabecera, para saber si el mensaje cabe
+    httpd_ws_frame_t frame = { 0 };
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (frame.len > sizeof(s_rx)) {
+        ESP_LOGW(TAG, "Mensaje de %u bytes (máximo %u): se cierra la conexión",
+                 (unsigned)frame.len, (unsigned)sizeof(s_rx));
+        return ESP_FAIL;
+    }
+    if (frame.len > 0) {
+        frame.payload = s_rx;
+        err = httpd_ws_recv_frame(req, &frame, frame.len);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (frame.type != HTTPD_WS_TYPE_BINARY || frame.len == 0) {
+        return ESP_OK;
+    }
+
+    s_messages++;
+    return handle_message(req, s_rx, frame.len);
+}
+
+#endif // CONFIG_HTTP_API_WS
+
+// ============================================================================
+// FUNCIONES PÚBLICAS
+// ============================================================================
+
+esp_err_t ws_api_register(httpd_handle_t server)
+{
+#ifdef CONFIG_HTTP_API_WS
+    static const httpd_uri_t uri = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .is_websocket = true,
+    };
+    return httpd_register_uri_handler(server, &uri);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
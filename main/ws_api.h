@@ -0,0 +1,83 @@
+/**
+ * @file ws_api.h
+ * @brief Canal WebSocket de control para controles interactivos
+ *
+ * Cada petición HTTP cuesta una cabecera, un análisis de JSON y una
+ * respuesta; para un deslizador que manda decenas de valores por segundo
+ * es demasiado. El endpoint /ws (en el mismo servidor que http_api.h)
+ * mantiene la conexión abierta y acepta mensajes binarios con comandos de
+ * pocos bytes o frames completos.
+ *
+ * Los comandos van a led_cmd_post_latest(): en una ráfaga entre dos ticks
+ * solo se aplica el último valor de cada parámetro. No hay respuesta por
+ * comando; los errores se notifican con un mensaje de error.
+ *
+ * PROTOCOLO (mensajes binarios, enteros little endian):
+ * ====================================================
+ * Un mensaje puede llevar varios comandos seguidos. ECHO y los frames
+ * ocupan el resto del mensaje; PIXELS y RANGES llevan su número de
+ * entradas y pueden ir seguidos de otros comandos.
+ *
+ *   0x00 ECHO        datos...             Se devuelve el mensaje tal cual
+ *   0x01 COLOR       r g b
+ *   0x02 EFFECT      id                   Índice de /api/effects; 0xFF lo detiene
+ *   0x03 BRIGHTNESS  v
+ *   0x04 SEGMENT     i start(2) len(2) r g b   len 0 lo borra
+ *   0x05 PRESET      slot                 Carga un preset
+ *   0x10 FRAME_RGB   r g b ...            Frame completo para el render stage
+ *   0x11 FRAME_RGBW  r g b w ...
+ *   0x12 PIXELS      n(2), n x [index(2) r g b]    Píxeles sueltos
+ *   0x13 RANGES      n(2), n x [start(2) len(2) r g b]   Rangos de un color
+ *   0x20 STATS       flags                Responde WS_OP_STATS y 14 uint32 (ver
+ *                                         ws_api.c); bit 0 de flags reinicia
+ *                                         las latencias después de leerlas
+ *
+ * PIXELS y RANGES cambian solo esos LEDs del último frame
+ * (led_render_update_pixels()); el render stage recompone y envía solo el
+ * rango cambiado. Se entregan en bloques de WS_UPDATE_CHUNK entradas: uno
+ * más grande puede repartirse entre dos frames.
+ *
+ * Un comando desconocido o incompleto descarta el resto del mensaje y se
+ * responde con WS_OP_ERROR y el código del comando.
+ *
+ * @author Tu Nombre
+ * @date 2025
+ */
+
+#ifndef WS_API_H
+#define WS_API_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+// Entradas de PIXELS o RANGES por llamada a led_render_update_pixels()
+#define WS_UPDATE_CHUNK 32
+
+/**
+ * @brief Códigos de comando
+ */
+typedef enum {
+    WS_OP_ECHO = 0x00,
+    WS_OP_COLOR = 0x01,
+    WS_OP_EFFECT = 0x02,
+    WS_OP_BRIGHTNESS = 0x03,
+    WS_OP_SEGMENT = 0x04,
+    WS_OP_PRESET = 0x05,
+    WS_OP_FRAME_RGB = 0x10,
+    WS_OP_FRAME_RGBW = 0x11,
+    WS_OP_PIXELS = 0x12,
+    WS_OP_RANGES = 0x13,
+    WS_OP_STATS = 0x20,
+    WS_OP_ERROR = 0xFF,
+} ws_op_t;
+
+/**
+ * @brief Registra el endpoint /ws en el servidor de la API
+ *
+ * @param server Servidor arrancado por http_api_start()
+ * @return Resultado de httpd_register_uri_handler(), o
+ *         ESP_ERR_NOT_SUPPORTED sin CONFIG_HTTP_API_WS
+ */
+esp_err_t ws_api_register(httpd_handle_t server);
+
+#endif // WS_API_H
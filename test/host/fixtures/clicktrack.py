@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""
+clicktrack.py - Genera clicktrack.wav, el audio de test_audio.c
+
+PCM de 16 bits, mono, a 16 kHz (CONFIG_AUDIO_SAMPLE_RATE por defecto):
+
+    0.00 - 0.50 s   Tono de 1 kHz a -12 dBFS (bin 16 de la FFT, banda 4),
+                    con rampas de 10 ms para que su final no sea un golpe
+    0.50 - 0.75 s   Silencio
+    0.75 - 4.75 s   8 bombos a 120 bpm: 70 Hz con caída de 60 ms (banda 0)
+                    y, a contratiempo, un golpe de 4 kHz de 20 ms (banda 7)
+    4.75 - 5.00 s   Silencio
+
+Los golpes agudos no deben contar como beat: el detector solo mira los
+graves. Si se cambia el fichero hay que revisar las comprobaciones de
+test_audio.c.
+
+USO:
+====
+    clicktrack.py test/host/fixtures/clicktrack.wav
+"""
+
+import math
+import struct
+import sys
+import wave
+
+RATE = 16000
+
+
+def tone(samples, t0, seconds, freq, amp, decay=None, ramp=0.0):
+    start = int(t0 * RATE)
+    for n in range(int(seconds * RATE)):
+        t = n / RATE
+        env = math.exp(-t / decay) if decay else 1.0
+        edge = min(t, seconds - t)
+        if edge < ramp:
+            env *= 0.5 - 0.5 * math.cos(math.pi * edge / ramp)
+        samples[start + n] += amp * env * math.sin(2 * math.pi * freq * t)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+
+    samples = [0.0] * (5 * RATE)
+    tone(samples, 0.0, 0.5, 1000, 0.25, ramp=0.01)
+    for beat in range(8):
+        t = 0.75 + beat * 0.5
+        tone(samples, t, 0.2, 70, 0.8, decay=0.06)
+        tone(samples, t + 0.25, 0.02, 4000, 0.5)
+
+    pcm = b"".join(struct.pack("<h", max(-32768, min(32767, round(s * 32767))))
+                   for s in samples)
+    with wave.open(sys.argv[1], "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(RATE)
+        w.writeframes(pcm)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
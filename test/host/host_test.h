@@ -0,0 +1,84 @@
+/**
+ * @file host_test.h
+ * @brief Comprobaciones y medida de tiempo comunes a los tests en host
+ *
+ * Los tests compilan los módulos de main/ tal cual, con las cabeceras de
+ * ESP-IDF sustituidas por las de stubs/. Cada uno es un ejecutable que
+ * devuelve 0 si todas las comprobaciones pasan; CTest los lanza
+ * (test/host/CMakeLists.txt). Los que miden rendimiento solo imprimen
+ * los números con --bench, no los comprueban.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static int g_failures;
+
+/**
+ * @brief Comprueba una condición; si falla, muestra el mensaje y sigue
+ */
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("FALLO %s:%d: %s: ", __FILE__, __LINE__, #cond);         \
+            printf(__VA_ARGS__);                                            \
+            printf("\n");                                                   \
+            g_failures++;                                                   \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief Resultado del test para main()
+ */
+static inline int host_test_result(const char *name)
+{
+    if (g_failures > 0) {
+        printf("%s: %d comprobaciones fallidas\n", name, g_failures);
+        return 1;
+    }
+    printf("%s: OK\n", name);
+    return 0;
+}
+
+/**
+ * @brief true si se ha pasado --bench en la línea de comandos
+ */
+static inline int host_test_bench(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Contador de ciclos del host (TSC en x86), o ns si no hay
+ */
+static inline uint64_t host_test_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+static inline uint64_t host_test_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+#endif // HOST_TEST_H
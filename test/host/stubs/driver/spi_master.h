@@ -0,0 +1,50 @@
+/**
+ * @file spi_master.h
+ * @brief Lo que usa led_chipset_spi.c del driver SPI (las funciones las
+ *        implementa el test)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    SPI1_HOST,
+    SPI2_HOST,
+    SPI3_HOST,
+} spi_host_device_t;
+
+#define SPI_DMA_CH_AUTO 3
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+
+typedef struct {
+    uint8_t mode;
+    int clock_speed_hz;
+    int spics_io_num;
+    int queue_size;
+} spi_device_interface_config_t;
+
+typedef struct {
+    size_t length;          ///< En bits
+    const void *tx_buffer;
+} spi_transaction_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config,
+                             spi_device_handle_t *dev);
+esp_err_t spi_device_queue_trans(spi_device_handle_t dev, spi_transaction_t *trans,
+                                 uint32_t timeout);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t dev, spi_transaction_t **trans,
+                                      uint32_t timeout);
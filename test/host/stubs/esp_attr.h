@@ -0,0 +1,5 @@
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define FORCE_INLINE_ATTR static inline __attribute__((always_inline))
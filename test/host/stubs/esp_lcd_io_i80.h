@@ -0,0 +1,40 @@
+/**
+ * @file esp_lcd_io_i80.h
+ * @brief Bus i80 de esp_lcd (las funciones las implementa el test)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_lcd_panel_io.h"
+#include "soc/soc_caps.h"
+
+#define LCD_CLK_SRC_DEFAULT     0
+
+typedef struct esp_lcd_i80_bus_t *esp_lcd_i80_bus_handle_t;
+
+typedef struct {
+    int dc_gpio_num;
+    int wr_gpio_num;
+    int clk_src;
+    int data_gpio_nums[SOC_LCD_I80_BUS_WIDTH];
+    size_t bus_width;
+    size_t max_transfer_bytes;
+} esp_lcd_i80_bus_config_t;
+
+typedef struct {
+    int cs_gpio_num;
+    uint32_t pclk_hz;
+    size_t trans_queue_depth;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void *user_ctx;
+    int lcd_cmd_bits;
+    int lcd_param_bits;
+} esp_lcd_panel_io_i80_config_t;
+
+esp_err_t esp_lcd_new_i80_bus(const esp_lcd_i80_bus_config_t *config,
+                              esp_lcd_i80_bus_handle_t *bus);
+esp_err_t esp_lcd_new_panel_io_i80(esp_lcd_i80_bus_handle_t bus,
+                                   const esp_lcd_panel_io_i80_config_t *config,
+                                   esp_lcd_panel_io_handle_t *io);
@@ -0,0 +1,24 @@
+/**
+ * @file esp_lcd_panel_io.h
+ * @brief Lo que usa led_chipset_parallel.c de esp_lcd (las funciones las
+ *        implementa el test)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef struct esp_lcd_panel_io_t *esp_lcd_panel_io_handle_t;
+
+typedef struct {
+    int unused;
+} esp_lcd_panel_io_event_data_t;
+
+typedef bool (*esp_lcd_panel_io_color_trans_done_cb_t)(esp_lcd_panel_io_handle_t io,
+                                                      esp_lcd_panel_io_event_data_t *edata,
+                                                      void *user_ctx);
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color,
+                                    size_t color_size);
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Lo implementa cada test
+void esp_rom_delay_us(uint32_t us);
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Lo implementa cada test: reloj real o simulado
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,28 @@
+/**
+ * @file sdkconfig.h
+ * @brief Configuración de los tests en host
+ *
+ * Cada test define en test/host/CMakeLists.txt las opciones booleanas de
+ * su configuración (chipset, formato de píxel...). Aquí solo van los
+ * valores por defecto de menuconfig que no cambian entre tests.
+ */
+
+#pragma once
+
+#ifndef CONFIG_LED_NUM_LEDS
+#define CONFIG_LED_NUM_LEDS         60
+#endif
+#define CONFIG_IDF_TARGET_ESP32     1   // Como soc/soc_caps.h
+#define CONFIG_BLINK_GPIO           15
+
+#define CONFIG_LED_RMT_MEM_BLOCKS   2
+#define CONFIG_LED_SPI_CLOCK_GPIO   14
+#define CONFIG_LED_SPI_CLOCK_HZ     8000000
+#ifndef CONFIG_LED_CHIPSET_BRIGHTNESS
+#define CONFIG_LED_CHIPSET_BRIGHTNESS 31
+#endif
+#define CONFIG_LED_PARALLEL_CLOCK_GPIO  4
+#define CONFIG_LED_PARALLEL_SPARE_GPIO  18
+
+#define CONFIG_AUDIO_SAMPLE_RATE    16000
+#define CONFIG_AUDIO_CPU_BUDGET_PCT 25
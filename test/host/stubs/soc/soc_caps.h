@@ -0,0 +1,14 @@
+/**
+ * @file soc_caps.h
+ * @brief Capacidades del chip en los tests en host: las de un ESP32
+ *
+ * El RMT sin DMA obliga a rellenar la memoria por mitades, que es el caso
+ * que más interesa probar en led_chipset_rmt.c.
+ */
+
+#pragma once
+
+#define SOC_RMT_MEM_WORDS_PER_CHANNEL   64
+#define SOC_RMT_SUPPORT_DMA             0
+#define SOC_LCD_I80_SUPPORTED           1
+#define SOC_LCD_I80_BUS_WIDTH           24
@@ -0,0 +1,290 @@
+/**
+ * @file test_audio.c
+ * @brief Cadena de audio en host: de un WAV a las bandas y los beats
+ *
+ * Lee un WAV mono de 16 bits a CONFIG_AUDIO_SAMPLE_RATE y lo entrega con
+ * audio_reactive_feed() en trozos de 10 ms, como llegaría de la red. La
+ * tarea de análisis se ejecuta en el sitio cada vez que se completa un
+ * bloque (xTaskNotifyGive()), así que no se descarta ninguno, y el reloj
+ * de esp_timer_get_time() avanza con las muestras entregadas.
+ *
+ * Comprueba, sobre fixtures/clicktrack.wav (ver clicktrack.py):
+ *
+ * - audio_fft() contra una DFT en float del primer bloque del tono
+ * - El tono de 1 kHz lleva la banda 4 al máximo y deja las otras bajas
+ * - Cada bombo da exactamente un beat, en el bloque en que empieza o el
+ *   siguiente, con la banda 0 arriba; los golpes agudos a contratiempo
+ *   suben la banda 7 pero no cuentan como beat
+ */
+
+#include <math.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include "host_test.h"
+
+// El módulo entero en esta unidad: el test llama a analysis_task()
+#include "audio_reactive.c"
+
+#define CHUNK_SAMPLES       (SAMPLE_RATE / 100)
+#define MAX_BLOCKS          1024
+
+// Contenido de clicktrack.wav
+#define TONE_BIN            16
+#define TONE_BAND           4
+#define TONE_END_S          0.5
+#define KICKS               8
+#define KICK_START_S        0.75
+#define KICK_PERIOD_S       0.5
+#define HAT_OFFSET_S        0.25
+
+#define FX(x)               ((int32_t)((x) * FX_ONE))
+
+// --- FreeRTOS y reloj simulados ---
+
+static TaskFunction_t s_task_fn;
+static jmp_buf s_task_exit;
+static bool s_notified;
+static int64_t s_now_us;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle)
+{
+    s_task_fn = fn;
+    if (handle != NULL) {
+        *handle = (TaskHandle_t)&s_task_fn;
+    }
+    return pdPASS;
+}
+
+/**
+ * @brief Ejecuta la tarea de análisis hasta que vuelve a esperar
+ */
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    s_notified = true;
+    if (setjmp(s_task_exit) == 0) {
+        s_task_fn(NULL);
+    }
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+    if (!s_notified) {
+        longjmp(s_task_exit, 1);
+    }
+    s_notified = false;
+    return 1;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+// --- WAV ---
+
+static uint32_t le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Lee un WAV PCM mono de 16 bits a SAMPLE_RATE
+ *
+ * @return Muestras (malloc) o NULL, con el número en *count
+ */
+static int16_t *read_wav(const char *path, size_t *count)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("no se puede abrir %s\n", path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(size);
+    size_t got = fread(data, 1, size, f);
+    fclose(f);
+    if (got != (size_t)size || size < 12 || memcmp(data, "RIFF", 4) != 0 ||
+        memcmp(data + 8, "WAVE", 4) != 0) {
+        printf("%s no es un WAV\n", path);
+        free(data);
+        return NULL;
+    }
+
+    bool fmt_ok = false;
+    int16_t *pcm = NULL;
+    for (long pos = 12; pos + 8 <= size;) {
+        uint32_t len = le32(data + pos + 4);
+        const uint8_t *body = data + pos + 8;
+        if (pos + 8 + (long)len > size) {
+            break;
+        }
+        if (memcmp(data + pos, "fmt ", 4) == 0 && len >= 16) {
+            // PCM, 1 canal, SAMPLE_RATE, 16 bits
+            fmt_ok = body[0] == 1 && body[1] == 0 && body[2] == 1 && body[3] == 0 &&
+                     le32(body + 4) == SAMPLE_RATE && body[14] == 16;
+        } else if (memcmp(data + pos, "data", 4) == 0 && fmt_ok) {
+            *count = len / 2;
+            pcm = malloc(len);
+            for (size_t i = 0; i < *count; i++) {
+                pcm[i] = (int16_t)(body[2 * i] | (body[2 * i + 1] << 8));
+            }
+            break;
+        }
+        pos += 8 + len + (len & 1);
+    }
+    if (pcm == NULL) {
+        printf("%s: se espera PCM mono de 16 bits a %d Hz\n", path, SAMPLE_RATE);
+    }
+    free(data);
+    return pcm;
+}
+
+// --- Comprobaciones ---
+
+/**
+ * @brief La FFT en punto fijo contra una DFT en float del mismo bloque
+ */
+static void check_fft(const int16_t *block)
+{
+    static int32_t re[AUDIO_FFT_SIZE], im[AUDIO_FFT_SIZE];
+    static uint16_t mag[AUDIO_FFT_BINS];
+
+    audio_fft_window(block, re, im);
+    audio_fft(re, im);
+    audio_fft_magnitude(re, im, mag);
+
+    int peak = 0;
+    double max_err = 0;
+    for (int k = 0; k < AUDIO_FFT_BINS; k++) {
+        double sr = 0, si = 0;
+        for (int n = 0; n < AUDIO_FFT_SIZE; n++) {
+            double w = 0.5 - 0.5 * cos(2 * M_PI * n / AUDIO_FFT_SIZE);
+            sr += block[n] * w * cos(2 * M_PI * k * n / AUDIO_FFT_SIZE);
+            si -= block[n] * w * sin(2 * M_PI * k * n / AUDIO_FFT_SIZE);
+        }
+        // La FFT escala por 1 / N
+        double ref = sqrt(sr * sr + si * si) / AUDIO_FFT_SIZE;
+        // max + 3/8 min se pasa como mucho un 7 %; lo demás es redondeo Q15
+        double err = fabs(mag[k] - ref) - 0.07 * ref;
+        CHECK(err <= 4, "bin %d: FFT %u, referencia %.1f", k, mag[k], ref);
+        if (err > max_err) {
+            max_err = err;
+        }
+        if (mag[k] > mag[peak]) {
+            peak = k;
+        }
+    }
+    CHECK(peak == TONE_BIN, "pico en el bin %d", peak);
+    printf("FFT: pico en el bin %d (%u), error máximo %.1f sobre el 7 %%\n", peak, mag[peak],
+           max_err);
+}
+
+static int block_at(double seconds)
+{
+    return (int)(seconds * SAMPLE_RATE) / AUDIO_FFT_SIZE;
+}
+
+/**
+ * @brief Máximo de una banda en el bloque i y el siguiente
+ */
+static int32_t peak_band(const audio_features_t *blocks, int i, int band)
+{
+    int32_t a = blocks[i].v[AUDIO_FEATURE_BAND0 + band];
+    int32_t b = blocks[i + 1].v[AUDIO_FEATURE_BAND0 + band];
+    return a > b ? a : b;
+}
+
+int main(int argc, char **argv)
+{
+    static audio_features_t blocks[MAX_BLOCKS];
+    size_t count = 0;
+
+    if (argc < 2) {
+        printf("uso: %s clicktrack.wav\n", argv[0]);
+        return 2;
+    }
+    int16_t *pcm = read_wav(argv[1], &count);
+    if (pcm == NULL || count < AUDIO_FFT_SIZE) {
+        return 1;
+    }
+
+    check_fft(pcm);
+
+    // --- Cadena completa ---
+    CHECK(audio_reactive_feed(pcm, 1) == ESP_ERR_INVALID_STATE, "feed antes de init");
+    audio_reactive_init();
+
+    int num_blocks = 0;
+    for (size_t pos = 0; pos < count; pos += CHUNK_SAMPLES) {
+        size_t n = count - pos < CHUNK_SAMPLES ? count - pos : CHUNK_SAMPLES;
+        s_now_us = (int64_t)(pos + n) * 1000000 / SAMPLE_RATE;
+        audio_reactive_feed(pcm + pos, n);
+
+        audio_features_t f;
+        audio_reactive_get_features(&f);
+        while (num_blocks < (int)f.block_seq && num_blocks < MAX_BLOCKS) {
+            blocks[num_blocks++] = f;
+        }
+    }
+
+    audio_stats_t stats;
+    audio_reactive_get_stats(&stats);
+    CHECK(num_blocks == (int)(count / AUDIO_FFT_SIZE), "%d bloques", num_blocks);
+    CHECK(stats.blocks_analyzed == (uint32_t)num_blocks, "%u analizados",
+          (unsigned)stats.blocks_analyzed);
+    CHECK(stats.blocks_dropped == 0, "%u descartados", (unsigned)stats.blocks_dropped);
+
+    // Tono: la banda 4 llena, las demás por debajo de la mitad
+    const audio_features_t *tone = &blocks[block_at(TONE_END_S) - 1];
+    for (int b = 0; b < AUDIO_NUM_BANDS; b++) {
+        int32_t v = tone->v[AUDIO_FEATURE_BAND0 + b];
+        if (b == TONE_BAND) {
+            CHECK(v >= FX(0.9), "tono: banda %d a %.2f", b, v / (double)FX_ONE);
+        } else {
+            CHECK(v < FX(0.5), "tono: banda %d a %.2f", b, v / (double)FX_ONE);
+        }
+    }
+    CHECK(tone->beat_count == 0, "%u beats en el tono", (unsigned)tone->beat_count);
+
+    // Bombos: un beat cada uno, en su bloque o el siguiente
+    uint32_t beats = tone->beat_count;
+    for (int k = 0; k < KICKS; k++) {
+        double t = KICK_START_S + k * KICK_PERIOD_S;
+        int first = block_at(t);
+        int hat = block_at(t + HAT_OFFSET_S);
+        int next = block_at(t + KICK_PERIOD_S);
+
+        int beat_block = -1;
+        for (int i = first; i < next && i < num_blocks; i++) {
+            if (blocks[i].beat_count != beats) {
+                CHECK(beat_block < 0, "bombo %d: más de un beat", k);
+                beat_block = beat_block < 0 ? i : beat_block;
+                beats = blocks[i].beat_count;
+            }
+        }
+        CHECK(beat_block >= first && beat_block <= first + 1,
+              "bombo %d en el bloque %d, beat en el %d", k, first, beat_block);
+        if (beat_block >= 0) {
+            CHECK(blocks[beat_block].v[AUDIO_FEATURE_BEAT] == FX_ONE,
+                  "bombo %d: envolvente %d", k, (int)blocks[beat_block].v[AUDIO_FEATURE_BEAT]);
+        }
+
+        // El golpe puede empezar al final de un bloque: manda el siguiente
+        int32_t kick0 = peak_band(blocks, first, 0);
+        int32_t kick7 = peak_band(blocks, first, 7);
+        CHECK(kick0 >= FX(0.9) && kick7 < FX(0.5), "bombo %d: bandas 0 y 7 a %.2f y %.2f",
+              k, kick0 / (double)FX_ONE, kick7 / (double)FX_ONE);
+        int32_t hat7 = peak_band(blocks, hat, 7);
+        CHECK(hat7 >= FX(0.5), "golpe %d: banda 7 a %.2f", k, hat7 / (double)FX_ONE);
+    }
+    CHECK(blocks[num_blocks - 1].beat_count == KICKS, "%u beats en total",
+          (unsigned)blocks[num_blocks - 1].beat_count);
+
+    printf("%d bloques, %u beats\n", num_blocks, (unsigned)blocks[num_blocks - 1].beat_count);
+    free(pcm);
+    return host_test_result("audio");
+}
@@ -0,0 +1,206 @@
+/**
+ * @file test_calib.c
+ * @brief Calibración de color en host: punto fijo contra referencia en float
+ *
+ * Configura un segmento con una matriz que mezcla canales y un blanco
+ * distinto de (1, 1, 1) y recorre una rejilla de colores en todos los
+ * LEDs de la tira (CONFIG_LED_NUM_LEDS pequeño). La referencia hace lo
+ * mismo que documenta led_calib.h, en double:
+ *
+ *   lineal = (entrada / máximo) ^ gamma
+ *   salida = blanco[c] * (M[c] · lineal) / suma(M[c])   (dentro del segmento)
+ *   salida = lineal                                     (fuera)
+ *
+ * recortada a [0, 1] y redondeada. Sin CONFIG_LED_HDR la salida de 8 bits
+ * no puede apartarse más de 1 LSB; con CONFIG_LED_HDR la de 16 bits no
+ * más de HDR_MAX_ERR (la gamma se interpola entre 257 puntos).
+ *
+ * Además: gamma 1.0 sin segmentos es la identidad exacta (en HDR, salvo
+ * 1 en el último tramo de la tabla, que acaba en 65535), los rangos
+ * fuera de la tira se rechazan y, en LEDs comunes a dos segmentos, manda
+ * el último configurado.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "led_calib.h"
+
+#define FX16(x)         ((int32_t)lround((x) * 65536.0))
+
+// Segmento 2 en los LEDs 1 a 3: la tira de pruebas tiene 5
+#define SEG_START       1
+#define SEG_COUNT       3
+
+#ifdef CONFIG_LED_HDR
+#define IN_MAX          65535
+#define IN_STEP         {771, 1285, 1799}
+#define HDR_MAX_ERR     16      // 1/16 de LSB a 8 bits
+typedef uint16_t chan_t;
+#else
+#define IN_MAX          255
+#define IN_STEP         {3, 5, 7}
+typedef uint8_t chan_t;
+#endif
+
+static const double s_matrix[3][3] = {
+    {0.92, 0.10, -0.02},
+    {-0.05, 1.00, 0.05},
+    {0.00, -0.08, 1.08},
+};
+static const double s_white[3] = {1.0, 0.86, 0.72};
+
+static led_calib_t s_cal;
+
+static void calibrate(const led_calib_t *cal, size_t led, const chan_t *in, chan_t *out)
+{
+#ifdef CONFIG_LED_HDR
+    led_calib_pixel16(cal, led, in, out);
+#else
+    led_calib_pixel(cal, led, in, out);
+#endif
+}
+
+static led_calib_segment_t make_segment(uint16_t start, uint16_t count)
+{
+    led_calib_segment_t seg = {.start = start, .count = count};
+    for (int i = 0; i < 3; i++) {
+        seg.white[i] = FX16(s_white[i]);
+        for (int j = 0; j < 3; j++) {
+            seg.matrix[i][j] = FX16(s_matrix[i][j]);
+        }
+    }
+    return seg;
+}
+
+static int reference(const chan_t *in, int c, bool in_segment, double gamma)
+{
+    double lin[3];
+    for (int k = 0; k < 3; k++) {
+        lin[k] = pow(in[k] / (double)IN_MAX, gamma);
+    }
+    double v = lin[c];
+    if (in_segment) {
+        const double *m = s_matrix[c];
+        v = s_white[c] * (m[0] * lin[0] + m[1] * lin[1] + m[2] * lin[2]) / (m[0] + m[1] + m[2]);
+    }
+    v = v < 0 ? 0 : (v > 1 ? 1 : v);
+    return (int)lround(v * IN_MAX);
+}
+
+/**
+ * @brief Error máximo contra la referencia en una rejilla de colores
+ */
+static void check_gamma(int gamma_x100)
+{
+    static const int step[3] = IN_STEP;
+    const double gamma = gamma_x100 / 100.0;
+    int max_err = 0;
+    long samples = 0, off = 0;
+
+    led_calib_init(&s_cal, gamma_x100);
+    led_calib_segment_t seg = make_segment(SEG_START, SEG_COUNT);
+    CHECK(led_calib_set_segment(&s_cal, 2, &seg) == ESP_OK, "segmento válido");
+
+    for (int led = 0; led < CONFIG_LED_NUM_LEDS; led++) {
+        const bool in_segment = led >= SEG_START && led < SEG_START + SEG_COUNT;
+        for (int r = 0; r <= IN_MAX; r += step[0]) {
+            for (int g = 0; g <= IN_MAX; g += step[1]) {
+                for (int b = 0; b <= IN_MAX; b += step[2]) {
+                    chan_t in[3] = {r, g, b}, out[3];
+                    calibrate(&s_cal, led, in, out);
+                    for (int c = 0; c < 3; c++) {
+                        int err = abs(out[c] - reference(in, c, in_segment, gamma));
+                        max_err = err > max_err ? err : max_err;
+                        off += err != 0;
+                        samples++;
+                    }
+                }
+            }
+        }
+    }
+#ifdef CONFIG_LED_HDR
+    CHECK(max_err <= HDR_MAX_ERR, "gamma %.2f: error máximo %d", gamma, max_err);
+#else
+    CHECK(max_err <= 1, "gamma %.2f: error máximo %d LSB", gamma, max_err);
+#endif
+    printf("gamma %.2f: error máximo %d, %.2f %% de canales distintos\n", gamma, max_err,
+           100.0 * off / samples);
+}
+
+static void check_identity(void)
+{
+    led_calib_init(&s_cal, 100);
+    int mismatches = 0;
+    for (int v = 0; v <= IN_MAX; v++) {
+        chan_t in[3] = {v, v, v}, out[3];
+        calibrate(&s_cal, 0, in, out);
+#ifdef CONFIG_LED_HDR
+        const int tol = v > 0xFF00 ? 1 : 0;
+#else
+        const int tol = 0;
+#endif
+        for (int c = 0; c < 3; c++) {
+            mismatches += abs(out[c] - v) > tol;
+        }
+    }
+    CHECK(mismatches == 0, "gamma 1.0: %d canales cambian", mismatches);
+
+#ifndef CONFIG_LED_HDR
+    for (int w = 0; w <= IN_MAX; w++) {
+        CHECK(led_calib_white(&s_cal, w) == w, "blanco %d -> %d", w, led_calib_white(&s_cal, w));
+    }
+#endif
+}
+
+static void check_segments(void)
+{
+    led_calib_init(&s_cal, 100);
+
+    led_calib_segment_t seg = make_segment(CONFIG_LED_NUM_LEDS - 1, 2);
+    CHECK(led_calib_set_segment(&s_cal, 0, &seg) == ESP_ERR_INVALID_ARG, "fuera de la tira");
+    seg = make_segment(0, CONFIG_LED_NUM_LEDS);
+    CHECK(led_calib_set_segment(&s_cal, LED_CALIB_MAX_SEGMENTS, &seg) == ESP_ERR_INVALID_ARG,
+          "índice %d", LED_CALIB_MAX_SEGMENTS);
+    seg.matrix[1][0] = FX16(1.0);
+    seg.matrix[1][1] = FX16(-1.0);
+    seg.matrix[1][2] = 0;
+    CHECK(led_calib_set_segment(&s_cal, 0, &seg) == ESP_ERR_INVALID_ARG, "fila que suma cero");
+
+    // Segmento 0 en toda la tira y el 1 encima de los LEDs 1 y 2
+    seg = make_segment(0, CONFIG_LED_NUM_LEDS);
+    CHECK(led_calib_set_segment(&s_cal, 0, &seg) == ESP_OK, "segmento 0");
+    seg = make_segment(1, 2);
+    CHECK(led_calib_set_segment(&s_cal, 1, &seg) == ESP_OK, "segmento 1");
+    CHECK(s_cal.seg_of[0] == 1 && s_cal.seg_of[1] == 2 && s_cal.seg_of[2] == 2 &&
+          s_cal.seg_of[3] == 1, "solapados: %u %u %u %u", s_cal.seg_of[0], s_cal.seg_of[1],
+          s_cal.seg_of[2], s_cal.seg_of[3]);
+
+    // Reconfigurar el 1 más corto libera el LED 2, que no vuelve al 0
+    seg = make_segment(1, 1);
+    CHECK(led_calib_set_segment(&s_cal, 1, &seg) == ESP_OK, "segmento 1 de nuevo");
+    CHECK(s_cal.seg_of[1] == 2 && s_cal.seg_of[2] == 0, "reconfigurado: %u %u",
+          s_cal.seg_of[1], s_cal.seg_of[2]);
+
+    led_calib_clear(&s_cal);
+    int used = 0;
+    for (int k = 0; k < CONFIG_LED_NUM_LEDS; k++) {
+        used += s_cal.seg_of[k] != 0;
+    }
+    CHECK(used == 0, "%d LEDs en algún segmento tras clear", used);
+}
+
+int main(void)
+{
+    check_gamma(100);
+    check_gamma(180);
+    check_gamma(260);
+    check_identity();
+    check_segments();
+#ifdef CONFIG_LED_HDR
+    return host_test_result("calib_hdr");
+#else
+    return host_test_result("calib");
+#endif
+}
@@ -0,0 +1,495 @@
+/**
+ * @file test_chipset.c
+ * @brief Formato del cable de los chipsets en host: codificar y decodificar
+ *
+ * Se compila una vez por configuración (test/host/CMakeLists.txt): WS2812B
+ * y SK6812 RGBW por RMT, APA102 y SK9822 por SPI, con y sin
+ * CONFIG_LED_STRIP_FIXED y CONFIG_LED_HDR. Cada frame pasa por
+ * led_chipset_encode() y led_chipset_transmit() y lo que "sale por el
+ * cable" se decodifica de vuelta a píxeles con los formatos de las hojas
+ * de datos, no con los del backend:
+ *
+ * - RMT: los drivers simulados llaman a refill_cb() como el RMT sin DMA
+ *   (la memoria entera al arrancar y luego por mitades). Cada símbolo
+ *   tiene que ser un pulso alto y uno bajo con los tiempos del chip
+ *   (WS2812B: 0 = 0.3 / 0.9 us, 1 = 0.9 / 0.3 us; SK6812: 1 = 0.6 / 0.6 us)
+ *   y los bits van del más al menos significativo.
+ * - SPI: 32 bits a cero, por píxel 0xE0 | brillo y los tres colores, 32
+ *   bits a cero más en SK9822 y la cola de medio bit de reloj por LED.
+ *
+ * Los colores decodificados, puestos en orden R, G, B (W) según
+ * CONFIG_LED_COLOR_ORDER, tienen que ser los de entrada, calibrados si
+ * se pasa calibración y cuantizados a 8 bits en HDR. Se prueban frames
+ * completos, de un solo color (paso 0), parciales y vacíos, y en el RMT
+ * un relleno tardío y el silencio de reset.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "led_chipset.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#ifdef LED_CHIPSET_CLOCKED
+#include "driver/spi_master.h"
+#else
+#include "driver/rmt_tx.h"
+#endif
+
+#define FRAMES          8
+#define PARTIAL_LEDS    7
+
+// Segmento calibrado en medio de la tira
+#define SEG_START       10
+#define SEG_COUNT       20
+
+#define FX16(x)         ((int32_t)lround((x) * 65536.0))
+
+static uint32_t s_wire[(LED_CHIPSET_WIRE_BYTES(LED_NUM_LEDS) + 3) / 4];
+static uint8_t s_sent[LED_CHIPSET_WIRE_BYTES(LED_NUM_LEDS)];    // Lo que salió por el cable
+static size_t s_sent_len;
+static int64_t s_now_us;
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    s_now_us += us;
+}
+
+// --- Periférico simulado ---
+
+#ifndef LED_CHIPSET_CLOCKED
+
+// Tiempos de las hojas de datos en ticks de 0.1 us (alto, bajo)
+#define BIT0_HIGH       3
+#define BIT0_LOW        9
+#if LED_CHANNELS == 4
+#define BIT1_HIGH       6
+#define BIT1_LOW        6
+#else
+#define BIT1_HIGH       9
+#define BIT1_LOW        3
+#endif
+#define RESET_US        80
+
+static size_t s_mem_symbols;
+static rmt_encode_simple_cb_t s_refill;
+static void *s_refill_arg;
+static rmt_tx_done_callback_t s_on_done;
+static rmt_symbol_word_t s_symbols[sizeof(s_sent) * 8];
+static int64_t s_end_us;            // Fin del último frame en el cable
+static bool s_late_refill;          // El próximo relleno llega tarde
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config, rmt_channel_handle_t *chan)
+{
+    s_mem_symbols = config->mem_block_symbols;
+    *chan = (rmt_channel_handle_t)&s_mem_symbols;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t *config,
+                                 rmt_encoder_handle_t *encoder)
+{
+    s_refill = config->callback;
+    s_refill_arg = config->arg;
+    *encoder = (rmt_encoder_handle_t)&s_refill;
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_register_event_callbacks(rmt_channel_handle_t chan,
+                                          const rmt_tx_event_callbacks_t *cbs, void *user_data)
+{
+    s_on_done = cbs->on_trans_done;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t chan)
+{
+    return ESP_OK;
+}
+
+static int decode_bit(rmt_symbol_word_t s)
+{
+    if (s.level0 != 1 || s.level1 != 0) {
+        return -1;
+    }
+    if (s.duration0 == BIT0_HIGH && s.duration1 == BIT0_LOW) {
+        return 0;
+    }
+    if (s.duration0 == BIT1_HIGH && s.duration1 == BIT1_LOW) {
+        return 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief Envía el frame como el RMT sin DMA y decodifica los símbolos
+ *
+ * El primer relleno ocupa toda la memoria del canal y los siguientes, la
+ * mitad que acaba de salir. Con s_late_refill el segundo llega cuando el
+ * RMT ya ha pasado por esa posición.
+ */
+esp_err_t rmt_transmit(rmt_channel_handle_t chan, rmt_encoder_handle_t encoder, const void *data,
+                       size_t size, const rmt_transmit_config_t *config)
+{
+    size_t written = 0;
+    size_t free_symbols = s_mem_symbols;
+    bool done = false;
+    int64_t start = s_now_us;
+
+    while (!done) {
+        if (written > 0 && s_late_refill) {
+            s_now_us = start + written * (BIT0_HIGH + BIT0_LOW) / 10 + 1;
+            s_late_refill = false;
+        }
+        size_t n = s_refill(data, size, written, free_symbols, s_symbols + written, &done,
+                            s_refill_arg);
+        if (n == 0 && !done) {
+            printf("refill_cb no avanza en el símbolo %zu\n", written);
+            return ESP_FAIL;
+        }
+        written += n;
+        free_symbols = s_mem_symbols / 2;
+    }
+
+    int bad = 0;
+    s_sent_len = written / 8;
+    for (size_t i = 0; i < s_sent_len; i++) {
+        uint8_t b = 0;
+        for (int k = 0; k < 8; k++) {
+            int bit = decode_bit(s_symbols[i * 8 + k]);
+            bad += bit < 0;
+            b = (uint8_t)(b << 1 | (bit > 0));
+        }
+        s_sent[i] = b;
+    }
+    CHECK(written % 8 == 0 && bad == 0, "%zu símbolos, %d con tiempos incorrectos", written, bad);
+
+    s_end_us = start + written * (BIT0_HIGH + BIT0_LOW) / 10;
+    s_now_us = s_end_us > s_now_us ? s_end_us : s_now_us;
+    const rmt_tx_done_event_data_t edata = { .num_symbols = written };
+    s_on_done(chan, &edata, NULL);
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t chan, int timeout_ms)
+{
+    return ESP_OK;
+}
+
+#else
+
+static spi_transaction_t *s_trans;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config,
+                             spi_device_handle_t *dev)
+{
+    *dev = (spi_device_handle_t)&s_trans;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t dev, spi_transaction_t *trans,
+                                 uint32_t timeout)
+{
+    CHECK(s_trans == NULL, "transacción encolada sin recoger la anterior");
+    CHECK(trans->length % 8 == 0 && trans->length / 8 <= sizeof(s_sent), "%zu bits",
+          trans->length);
+    s_sent_len = trans->length / 8;
+    memcpy(s_sent, trans->tx_buffer, s_sent_len);
+    s_trans = trans;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t dev, spi_transaction_t **trans,
+                                      uint32_t timeout)
+{
+    CHECK(s_trans != NULL, "no hay transacción que recoger");
+    *trans = s_trans;
+    s_trans = NULL;
+    return ESP_OK;
+}
+
+#endif
+
+// --- Decodificación ---
+
+// Orden del cable según menuconfig, sin pasar por LED_WIRE_C0..C2
+#if defined(CONFIG_LED_ORDER_RGB)
+#define WIRE_ORDER      "RGB"
+#elif defined(CONFIG_LED_ORDER_RBG)
+#define WIRE_ORDER      "RBG"
+#elif defined(CONFIG_LED_ORDER_BRG)
+#define WIRE_ORDER      "BRG"
+#elif defined(CONFIG_LED_ORDER_BGR)
+#define WIRE_ORDER      "BGR"
+#elif defined(CONFIG_LED_ORDER_GBR)
+#define WIRE_ORDER      "GBR"
+#else
+#define WIRE_ORDER      "GRB"
+#endif
+
+static int wire_channel(int k)
+{
+    return WIRE_ORDER[k] == 'R' ? 0 : (WIRE_ORDER[k] == 'G' ? 1 : 2);
+}
+
+/**
+ * @brief Píxeles (R, G, B, W) de lo que salió por el cable
+ *
+ * @return Número de píxeles, o -1 si el frame no tiene el formato del chip
+ */
+static int decode(const uint8_t *wire, size_t len, uint8_t (*out)[LED_CHANNELS])
+{
+#ifdef LED_CHIPSET_CLOCKED
+#ifdef CONFIG_LED_CHIPSET_SK9822
+    const size_t latch = 4;
+#else
+    const size_t latch = 0;
+#endif
+    // 4 + 4 n + latch + (n + 15) / 16: se busca el n que da len
+    int n = -1;
+    for (size_t k = 0; 4 + 4 * k + latch <= len; k++) {
+        if (4 + 4 * k + latch + (k + 15) / 16 == len) {
+            n = (int)k;
+        }
+    }
+    if (n < 0) {
+        printf("%zu bytes no es un frame válido\n", len);
+        return -1;
+    }
+    for (size_t k = 0; k < 4; k++) {
+        if (wire[k] != 0) {
+            printf("inicio de frame: byte %zu = 0x%02x\n", k, wire[k]);
+            return -1;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        const uint8_t *p = wire + 4 + 4 * i;
+        if (p[0] != (0xE0 | CONFIG_LED_CHIPSET_BRIGHTNESS)) {
+            printf("píxel %d: cabecera 0x%02x\n", i, p[0]);
+            return -1;
+        }
+        for (int c = 0; c < 3; c++) {
+            out[i][wire_channel(c)] = p[1 + c];
+        }
+    }
+    for (size_t k = 4 + 4 * n; k < len; k++) {
+        if (wire[k] != 0) {
+            printf("final de frame: byte %zu = 0x%02x\n", k, wire[k]);
+            return -1;
+        }
+    }
+    return n;
+#else
+    if (len % LED_CHANNELS != 0) {
+        printf("%zu bytes no son píxeles enteros\n", len);
+        return -1;
+    }
+    int n = (int)(len / LED_CHANNELS);
+    for (int i = 0; i < n; i++) {
+        const uint8_t *p = wire + i * LED_CHANNELS;
+        for (int c = 0; c < 3; c++) {
+            out[i][wire_channel(c)] = p[c];
+        }
+#if LED_CHANNELS == 4
+        out[i][3] = p[3];
+#endif
+    }
+    return n;
+#endif
+}
+
+// --- Referencia ---
+
+/**
+ * @brief Lo que tiene que llegar al LED i: calibración y cuantización
+ */
+static void expected(const led_calib_t *cal, size_t i, const led_chan_t *px, uint32_t frame,
+                     uint8_t *out)
+{
+#ifdef CONFIG_LED_HDR
+    uint16_t v[LED_CHANNELS];
+    memcpy(v, px, sizeof(v));
+    if (cal != NULL) {
+        led_calib_pixel16(cal, i, px, v);
+#if LED_CHANNELS == 4
+        v[3] = led_calib_lin16(cal, px[3]);
+#endif
+    }
+    for (int c = 0; c < LED_CHANNELS; c++) {
+        out[c] = (uint8_t)((v[c] * 255u + led_chipset_threshold(i, frame)) >> 16);
+    }
+#else
+    if (cal == NULL) {
+        memcpy(out, px, LED_CHANNELS);
+        return;
+    }
+    led_calib_pixel(cal, i, px, out);
+#if LED_CHANNELS == 4
+    out[3] = led_calib_white(cal, px[3]);
+#endif
+#endif
+}
+
+static uint32_t s_rng = 0x2545F491;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+/**
+ * @brief Codifica, envía y decodifica un frame; compara con la referencia
+ */
+static void check_frame(const char *what, const led_chan_t *px, size_t stride, size_t num_leds,
+                        const led_calib_t *cal, uint32_t frame)
+{
+    static uint8_t got[LED_NUM_LEDS][LED_CHANNELS];
+    uint8_t *wire = (uint8_t *)s_wire;
+
+    size_t len = led_chipset_encode(wire, px, stride, num_leds, cal, frame);
+    CHECK(len <= LED_CHIPSET_WIRE_BYTES(num_leds), "%s: %zu bytes para %zu LEDs", what, len,
+          num_leds);
+    CHECK(led_chipset_wait() == ESP_OK, "%s: wait", what);
+    CHECK(led_chipset_transmit(wire, len) == ESP_OK, "%s: transmit", what);
+    CHECK(led_chipset_wait() == ESP_OK, "%s: wait", what);
+#ifndef LED_CHIPSET_CLOCKED
+    CHECK(s_now_us - s_end_us >= RESET_US, "%s: reset de %d us", what, (int)(s_now_us - s_end_us));
+#endif
+    CHECK(s_sent_len == len, "%s: %zu bytes en el cable de %zu", what, s_sent_len, len);
+
+    int n = decode(s_sent, s_sent_len, got);
+    CHECK(n == (int)num_leds, "%s: %d píxeles decodificados de %zu", what, n, num_leds);
+    int wrong = 0;
+    for (int i = 0; i < n && i < (int)num_leds; i++) {
+        uint8_t want[LED_CHANNELS];
+        expected(cal, i, px + i * stride, frame, want);
+        if (memcmp(want, got[i], LED_CHANNELS) != 0 && wrong++ < 3) {
+            CHECK(false, "%s, frame %u, LED %d: %02x %02x %02x en vez de %02x %02x %02x", what,
+                  (unsigned)frame, i, got[i][0], got[i][1], got[i][2], want[0], want[1], want[2]);
+        }
+    }
+}
+
+static void init_calib(led_calib_t *cal)
+{
+    static const double matrix[3][3] = {
+        {0.92, 0.10, -0.02},
+        {-0.05, 1.00, 0.05},
+        {0.00, -0.08, 1.08},
+    };
+    static const double white[3] = {1.0, 0.86, 0.72};
+    led_calib_segment_t seg = {.start = SEG_START, .count = SEG_COUNT};
+    for (int i = 0; i < 3; i++) {
+        seg.white[i] = FX16(white[i]);
+        for (int j = 0; j < 3; j++) {
+            seg.matrix[i][j] = FX16(matrix[i][j]);
+        }
+    }
+    led_calib_init(cal, 220);
+    CHECK(led_calib_set_segment(cal, 0, &seg) == ESP_OK, "segmento");
+}
+
+#if defined(CONFIG_LED_HDR) && defined(CONFIG_LED_DITHER)
+/**
+ * @brief En 16 frames la media del dither conserva el valor de 16 bits
+ */
+static void check_dither(void)
+{
+    static const uint16_t values[] = {1, 200, 257, 4000, 32767, 40001, 65000, 65535};
+    uint8_t out[LED_CHANNELS];
+
+    for (size_t k = 0; k < sizeof(values) / sizeof(values[0]); k++) {
+        led_chan_t px[LED_CHANNELS];
+        for (int c = 0; c < LED_CHANNELS; c++) {
+            px[c] = values[k];
+        }
+        for (size_t i = 0; i < 4; i++) {
+            int sum = 0;
+            for (uint32_t f = 0; f < 16; f++) {
+                led_chipset_pixel(NULL, i, px, f, out);
+                sum += out[0];
+            }
+            // Umbrales centrados: la suma es el valor redondeado
+            double want = 16.0 * values[k] * 255 / 65535;
+            CHECK(fabs(sum - want) <= 0.6, "dither de %u en el LED %zu: suma %d, se espera %.1f",
+                  values[k], i, sum, want);
+        }
+    }
+}
+#endif
+
+int main(void)
+{
+    static led_chan_t px[LED_NUM_LEDS * LED_CHANNELS];
+    static led_calib_t cal;
+
+    printf("%s, %d LEDs, %d canales%s%s\n", led_chipset_name, LED_NUM_LEDS, LED_CHANNELS,
+#ifdef CONFIG_LED_STRIP_FIXED
+           ", tira fija",
+#else
+           "",
+#endif
+#ifdef CONFIG_LED_HDR
+           ", HDR"
+#else
+           ""
+#endif
+    );
+    CHECK(led_chipset_init(LED_CHIPSET_WIRE_BYTES(LED_NUM_LEDS)) == ESP_OK, "init");
+    init_calib(&cal);
+
+    for (uint32_t f = 0; f < FRAMES; f++) {
+        for (size_t k = 0; k < LED_NUM_LEDS * LED_CHANNELS; k++) {
+            px[k] = (led_chan_t)(rnd() & LED_CHAN_MAX);
+        }
+        // Extremos: los 0 y los máximos no pueden moverse
+        for (int c = 0; c < LED_CHANNELS; c++) {
+            px[c] = 0;
+            px[LED_CHANNELS + c] = LED_CHAN_MAX;
+        }
+        check_frame("tira", px, LED_CHANNELS, LED_NUM_LEDS, NULL, f);
+        check_frame("tira calibrada", px, LED_CHANNELS, LED_NUM_LEDS, &cal, f);
+        check_frame("un color", px + 2 * LED_CHANNELS, 0, LED_NUM_LEDS, NULL, f);
+        check_frame("un color calibrado", px + 2 * LED_CHANNELS, 0, LED_NUM_LEDS, &cal, f);
+        check_frame("parcial", px, LED_CHANNELS, PARTIAL_LEDS, NULL, f);
+        check_frame("parcial calibrado", px, LED_CHANNELS, PARTIAL_LEDS, &cal, f);
+    }
+    check_frame("vacío", px, LED_CHANNELS, 0, NULL, 0);
+
+#ifndef LED_CHIPSET_CLOCKED
+    // Un relleno tardío se cuenta y el frame se sigue decodificando igual
+    uint32_t underruns = led_chipset_underruns();
+    s_late_refill = true;
+    check_frame("relleno tardío", px, LED_CHANNELS, LED_NUM_LEDS, NULL, 0);
+    CHECK(led_chipset_underruns() == underruns + 1, "%u rellenos tardíos",
+          (unsigned)(led_chipset_underruns() - underruns));
+    CHECK(underruns == 0, "%u rellenos tardíos sin simularlos", (unsigned)underruns);
+
+    // 1.2 us por bit más el reset
+    CHECK(led_chipset_wire_us(100) == 960 + RESET_US, "100 bytes: %u us",
+          (unsigned)led_chipset_wire_us(100));
+#else
+    CHECK(led_chipset_underruns() == 0, "rellenos tardíos en SPI");
+    CHECK(led_chipset_wire_us(1000) == 1000 * 8 / (CONFIG_LED_SPI_CLOCK_HZ / 1000000),
+          "1000 bytes: %u us", (unsigned)led_chipset_wire_us(1000));
+#endif
+
+#if defined(CONFIG_LED_HDR) && defined(CONFIG_LED_DITHER)
+    check_dither();
+#endif
+    return host_test_result("chipset");
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_cue.c
+ * @brief Lista de cues en host: activación, transiciones y saltos
+ *
+ * Reproduce una lista de dos cues de color con un reloj simulado y los
+ * comandos de led_cmd registrados en un estado local. Comprueba:
+ *
+ * - El primer cue se activa en su instante y su transición avanza con la
+ *   posición
+ * - Un salto atrás a antes del primer cue, a media transición, deja la
+ *   lista sin cue activo y no devuelve el color al de partida del cue
+ * - Al volver a pasar por el cue se activa de nuevo desde el color que
+ *   hay en ese momento
+ * - Un salto adelante activa el último cue anterior a la posición
+ */
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "led_clock.h"
+#include "led_cmd.h"
+#include "led_control.h"
+#include "led_cue.h"
+#include "led_effects.h"
+
+#define FADE_MS         2000
+
+// --- Reloj, led_cmd y efectos simulados ---
+
+static int64_t s_clock_us;
+static led_cmd_state_t s_state = { .brightness = 255 };
+static int s_applied;
+
+int64_t led_clock_us(void)
+{
+    return s_clock_us;
+}
+
+uint32_t led_control_frame_us(void)
+{
+    return 0;
+}
+
+esp_err_t led_cmd_apply(const led_cmd_t *cmd)
+{
+    if (cmd->type == LED_CMD_COLOR) {
+        memcpy(s_state.rgb, cmd->rgb, 3);
+    } else if (cmd->type == LED_CMD_BRIGHTNESS) {
+        s_state.brightness = cmd->brightness;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_applied++;
+    return ESP_OK;
+}
+
+void led_cmd_get_state(led_cmd_state_t *state)
+{
+    *state = s_state;
+}
+
+const led_effect_t *led_effects_get(int id)
+{
+    return NULL;
+}
+
+// --- Comprobaciones ---
+
+static void tick(int64_t clock_ms)
+{
+    s_clock_us = clock_ms * 1000;
+    led_cue_process();
+}
+
+static int active(void)
+{
+    led_cue_status_t st;
+    led_cue_get_status(&st);
+    return st.active;
+}
+
+int main(void)
+{
+    // Cue 0: rojo en 2 s desde t = 1 s; cue 1: azul de golpe en t = 5 s
+    const led_cue_t cues[] = {
+        { .t_ms = 1000, .effect = LED_CUE_KEEP, .flags = LED_CUE_COLOR, .rgb = {255, 0, 0},
+          .fade_ms = FADE_MS },
+        { .t_ms = 5000, .effect = LED_CUE_KEEP, .flags = LED_CUE_COLOR, .rgb = {0, 0, 255} },
+    };
+    CHECK(led_cue_load_begin() == ESP_OK, "load_begin");
+    for (size_t i = 0; i < sizeof(cues) / sizeof(cues[0]); i++) {
+        CHECK(led_cue_load_add(&cues[i]) == ESP_OK, "cue %zu", i);
+    }
+    CHECK(led_cue_load_commit() == ESP_OK, "commit");
+
+    led_cue_play(0);
+    tick(0);
+    CHECK(active() == -1, "cue %d activo en t = 0", active());
+    tick(500);
+    CHECK(active() == -1 && s_applied == 0, "cue %d activo en t = 0.5 s", active());
+
+    // A mitad de la transición del cue 0
+    tick(2000);
+    CHECK(active() == 0, "cue %d activo en t = 2 s", active());
+    CHECK(abs(s_state.rgb[0] - 127) <= 1, "rojo a %u a mitad de transición", s_state.rgb[0]);
+
+    // Salto atrás a antes del primer cue: nada activo y el color se queda
+    const uint8_t held = s_state.rgb[0];
+    const int applied = s_applied;
+    led_cue_play(500);
+    tick(2000);
+    CHECK(active() == -1, "cue %d activo tras saltar a t = 0.5 s", active());
+    tick(2400);
+    CHECK(active() == -1, "cue %d activo en t = 0.9 s", active());
+    CHECK(s_applied == applied && s_state.rgb[0] == held,
+          "%d comandos tras el salto, rojo a %u (era %u)", s_applied - applied, s_state.rgb[0],
+          held);
+
+    // El cue 0 vuelve a activarse desde el color actual: un cuarto de
+    // transición de held a 255
+    tick(3000);
+    CHECK(active() == 0, "cue %d activo en t = 1.5 s", active());
+    int want = held + (255 - held) / 4;
+    CHECK(abs(s_state.rgb[0] - want) <= 1, "rojo a %u, se espera %d", s_state.rgb[0], want);
+
+    // Salto adelante: el cue 1 se activa y corta
+    led_cue_play(6000);
+    tick(3000);
+    CHECK(active() == 1, "cue %d activo tras saltar a t = 6 s", active());
+    CHECK(s_state.rgb[0] == 0 && s_state.rgb[2] == 255, "color %u %u %u en el cue 1",
+          s_state.rgb[0], s_state.rgb[1], s_state.rgb[2]);
+
+    led_cue_status_t st;
+    led_cue_get_status(&st);
+    CHECK(st.activations == 2, "%u activaciones", (unsigned)st.activations);
+    CHECK(st.seeks == 3, "%u búsquedas", (unsigned)st.seeks);
+    return host_test_result("cue");
+}
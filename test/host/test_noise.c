@@ -0,0 +1,158 @@
+/**
+ * @file test_noise.c
+ * @brief Ruido de Perlin en host: filas contra muestras sueltas y benchmark
+ *
+ * fx_noise2_row() y fx_noise3_row() tienen que dar exactamente lo mismo
+ * que fx_noise2() y fx_noise3() muestra a muestra: los efectos pueden
+ * usar cualquiera de las dos. Se comprueba sobre filas pseudoaleatorias
+ * (pasos positivos, negativos, mayores que una celda, coordenadas junto
+ * al periodo de 256 unidades) y, además, el rango y la continuidad.
+ *
+ * Con --bench mide ciclos por muestra (TSC en x86) en el mismo caso que
+ * bench_noise() de led_effects.c en el dispositivo: una fila de
+ * BENCH_LEDS muestras que cruza 4 celdas.
+ */
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "fx_math.h"
+#include "fx_noise.h"
+
+#define ROWS            400
+#define MAX_ROW         512
+#define BENCH_LEDS      256
+#define BENCH_FRAMES    20000
+
+static uint32_t s_rng = 0x12345678;
+
+static int32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return (int32_t)s_rng;
+}
+
+static void check_rows(void)
+{
+    static int32_t row[MAX_ROW];
+    long mismatches = 0;
+    int32_t lo = 0, hi = 0;
+
+    for (int r = 0; r < ROWS; r++) {
+        // Sin desbordar x0 + k * dx: hasta 2^30 más 512 pasos de 2 celdas
+        int32_t x0 = rnd() >> 1;
+        int32_t y = rnd();
+        int32_t z = rnd();
+        // Pasos de hasta 2 celdas en los dos sentidos; algunos de 0
+        int32_t dx = r % 16 == 0 ? 0 : rnd() % (2 * FX_ONE);
+        int count = 1 + (uint32_t)rnd() % MAX_ROW;
+
+        fx_noise2_row(x0, dx, y, row, count);
+        for (int k = 0; k < count; k++) {
+            int32_t v = fx_noise2(x0 + k * dx, y);
+            if (v != row[k] && mismatches++ < 5) {
+                CHECK(v == row[k], "2D x0 %d dx %d y %d, muestra %d: %d != %d", (int)x0,
+                      (int)dx, (int)y, k, (int)row[k], (int)v);
+            }
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+
+        fx_noise3_row(x0, dx, y, z, row, count);
+        for (int k = 0; k < count; k++) {
+            int32_t v = fx_noise3(x0 + k * dx, y, z);
+            if (v != row[k] && mismatches++ < 5) {
+                CHECK(v == row[k], "3D x0 %d dx %d y %d z %d, muestra %d: %d != %d", (int)x0,
+                      (int)dx, (int)y, (int)z, k, (int)row[k], (int)v);
+            }
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+    }
+    CHECK(mismatches == 0, "%ld muestras distintas", mismatches);
+    CHECK(lo >= -FX_ONE && hi <= FX_ONE, "rango [%.3f, %.3f]", lo / (double)FX_ONE,
+          hi / (double)FX_ONE);
+    CHECK(hi - lo > FX_ONE, "rango [%.3f, %.3f] demasiado estrecho", lo / (double)FX_ONE,
+          hi / (double)FX_ONE);
+    printf("filas: %d de hasta %d muestras, rango [%.3f, %.3f]\n", ROWS, MAX_ROW,
+           lo / (double)FX_ONE, hi / (double)FX_ONE);
+}
+
+/**
+ * @brief Sin saltos: entre muestras a 1/4096 de celda cambia muy poco
+ */
+static void check_continuity(void)
+{
+    const int32_t step = FX_ONE / 4096;
+    int32_t max2 = 0, max3 = 0;
+    int32_t prev2 = fx_noise2(0, 12345);
+    int32_t prev3 = fx_noise3(0, 12345, 54321);
+
+    for (int32_t x = step; x < FX_FROM_INT(16); x += step) {
+        int32_t v2 = fx_noise2(x, 12345);
+        int32_t v3 = fx_noise3(x, 12345, 54321);
+        max2 = abs(v2 - prev2) > max2 ? abs(v2 - prev2) : max2;
+        max3 = abs(v3 - prev3) > max3 ? abs(v3 - prev3) : max3;
+        prev2 = v2;
+        prev3 = v3;
+    }
+    // La pendiente no pasa de ~2.5 por celda: 1/4096 de celda son < 0.001
+    CHECK(max2 < FX_ONE / 1000 && max3 < FX_ONE / 1000, "saltos de %.4f (2D) y %.4f (3D)",
+          max2 / (double)FX_ONE, max3 / (double)FX_ONE);
+}
+
+static void bench(void)
+{
+    static int32_t row[BENCH_LEDS];
+    const int32_t dx = FX_FROM_INT(4) / BENCH_LEDS;
+    const double samples = (double)BENCH_FRAMES * BENCH_LEDS;
+    volatile int32_t sink = 0;
+    uint64_t start, value2 = 0, noise2 = 0, noise2_row = 0, noise3 = 0, noise3_row = 0;
+
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        int32_t y = f * (FX_ONE / 60);
+
+        start = host_test_cycles();
+        for (int k = 0; k < BENCH_LEDS; k++) {
+            sink += fx_value_noise2(k * dx, y);
+        }
+        value2 += host_test_cycles() - start;
+
+        start = host_test_cycles();
+        for (int k = 0; k < BENCH_LEDS; k++) {
+            sink += fx_noise2(k * dx, y);
+        }
+        noise2 += host_test_cycles() - start;
+
+        start = host_test_cycles();
+        fx_noise2_row(0, dx, y, row, BENCH_LEDS);
+        noise2_row += host_test_cycles() - start;
+
+        start = host_test_cycles();
+        for (int k = 0; k < BENCH_LEDS; k++) {
+            sink += fx_noise3(k * dx, y, y >> 1);
+        }
+        noise3 += host_test_cycles() - start;
+
+        start = host_test_cycles();
+        fx_noise3_row(0, dx, y, y >> 1, row, BENCH_LEDS);
+        noise3_row += host_test_cycles() - start;
+        sink += row[f % BENCH_LEDS];
+    }
+
+    printf("ruido (ciclos/muestra): valor2d %.1f | perlin2d %.1f, fila %.1f | "
+           "perlin3d %.1f, fila %.1f\n",
+           value2 / samples, noise2 / samples, noise2_row / samples, noise3 / samples,
+           noise3_row / samples);
+}
+
+int main(int argc, char **argv)
+{
+    check_rows();
+    check_continuity();
+    if (host_test_bench(argc, argv)) {
+        bench();
+    }
+    return host_test_result("noise");
+}
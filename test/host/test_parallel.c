@@ -0,0 +1,257 @@
+/**
+ * @file test_parallel.c
+ * @brief WS2812B en paralelo en host: trasposición, frame y benchmark
+ *
+ * Se compila con 8, 16 y un número de tiras que no llena el bus
+ * (test/host/CMakeLists.txt). Comprueba:
+ *
+ * - transpose8() contra la definición bit a bit: out[b] lleva en el bit k
+ *   el bit 7 - b de in[k]
+ * - led_chipset_init(): ninguna GPIO del bus i80 es negativa (DC y las
+ *   líneas sin tira van a CONFIG_LED_PARALLEL_SPARE_GPIO)
+ * - El frame que sale por el bus simulado, decodificado línea a línea:
+ *   cada bit son tres palabras (todas las tiras a 1, el dato, todo a 0),
+ *   las líneas sin tira no se mueven, cada tira lleva sus
+ *   LED_PARALLEL_PER_LANE LEDs en el orden del cable y el frame acaba con
+ *   LED_PARALLEL_RESET_SLOTS palabras a 0
+ *
+ * Con --bench mide ns por píxel de led_chipset_encode() con la tira
+ * completa y ns por llamada de transpose8().
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include "host_test.h"
+
+// El módulo entero en esta unidad: el test llama a transpose8()
+#include "led_chipset_parallel.c"
+
+#define FRAMES          4
+#define BENCH_FRAMES    200
+#define TRANSPOSES      10000
+
+#define SLOT_BYTES      (LED_PARALLEL_BUS_WIDTH / 8)
+
+static uint32_t s_wire[(LED_CHIPSET_WIRE_BYTES(LED_NUM_LEDS) + 3) / 4];
+static uint8_t s_sent[LED_CHIPSET_WIRE_BYTES(LED_NUM_LEDS)];    // Lo que salió por el bus
+static size_t s_sent_len;
+
+static uint32_t s_rng = 0x9E3779B9;
+
+static uint32_t rnd(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// --- esp_lcd y FreeRTOS simulados ---
+
+static esp_lcd_i80_bus_config_t s_bus_config;
+static esp_lcd_panel_io_color_trans_done_cb_t s_on_done;
+static bool s_given;
+
+esp_err_t esp_lcd_new_i80_bus(const esp_lcd_i80_bus_config_t *config,
+                              esp_lcd_i80_bus_handle_t *bus)
+{
+    s_bus_config = *config;
+    *bus = (esp_lcd_i80_bus_handle_t)&s_bus_config;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_io_i80(esp_lcd_i80_bus_handle_t bus,
+                                   const esp_lcd_panel_io_i80_config_t *config,
+                                   esp_lcd_panel_io_handle_t *io)
+{
+    s_on_done = config->on_color_trans_done;
+    *io = (esp_lcd_panel_io_handle_t)&s_on_done;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color,
+                                    size_t color_size)
+{
+    CHECK(lcd_cmd == -1, "fase de comando %d", lcd_cmd);
+    CHECK(color_size <= sizeof(s_sent), "%zu bytes", color_size);
+    s_sent_len = color_size;
+    memcpy(s_sent, color, color_size);
+    s_on_done(io, NULL, NULL);
+    return ESP_OK;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return (SemaphoreHandle_t)&s_given;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    CHECK(s_given, "wait sin fin de transferencia");
+    s_given = false;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    s_given = true;
+    return pdTRUE;
+}
+
+// --- Comprobaciones ---
+
+static void check_transpose(void)
+{
+    int wrong = 0;
+    for (int n = 0; n < TRANSPOSES; n++) {
+        uint8_t in[8], out[8];
+        for (int k = 0; k < 8; k++) {
+            // Los primeros, un solo bit a 1 en cada posición
+            in[k] = n < 64 ? (n / 8 == k ? 1 << (n % 8) : 0) : (uint8_t)rnd();
+        }
+        transpose8(in, out);
+        for (int b = 0; b < 8; b++) {
+            uint8_t want = 0;
+            for (int k = 0; k < 8; k++) {
+                want |= ((in[k] >> (7 - b)) & 1) << k;
+            }
+            if (out[b] != want && wrong++ < 3) {
+                CHECK(out[b] == want, "entrada %d, bit %d: %02x en vez de %02x", n, b, out[b],
+                      want);
+            }
+        }
+    }
+}
+
+static void check_gpios(void)
+{
+    const esp_lcd_i80_bus_config_t *c = &s_bus_config;
+    CHECK(c->bus_width == LED_PARALLEL_BUS_WIDTH, "bus de %zu bits", c->bus_width);
+    CHECK(c->dc_gpio_num == CONFIG_LED_PARALLEL_SPARE_GPIO, "DC en la GPIO %d", c->dc_gpio_num);
+    CHECK(c->wr_gpio_num == CONFIG_LED_PARALLEL_CLOCK_GPIO, "WR en la GPIO %d", c->wr_gpio_num);
+    for (int i = 0; i < LED_PARALLEL_BUS_WIDTH; i++) {
+        CHECK(c->data_gpio_nums[i] >= 0, "línea %d en la GPIO %d", i, c->data_gpio_nums[i]);
+        if (i >= CONFIG_LED_PARALLEL_LANES) {
+            CHECK(c->data_gpio_nums[i] == CONFIG_LED_PARALLEL_SPARE_GPIO,
+                  "línea %d sin tira en la GPIO %d", i, c->data_gpio_nums[i]);
+        }
+    }
+}
+
+static unsigned slot_at(size_t s)
+{
+    return SLOT_BYTES == 2 ? s_sent[2 * s] | (s_sent[2 * s + 1] << 8) : s_sent[s];
+}
+
+/**
+ * @brief Decodifica el frame del bus y lo compara con los píxeles
+ */
+static void check_frame(const char *what, const led_chan_t *px, size_t stride, size_t num_leds,
+                        const led_calib_t *cal, uint32_t frame)
+{
+    static const char wire_order[] = "GRB";     // CONFIG_LED_ORDER_GRB, el de WS2812B
+    const unsigned lane_mask = (1u << CONFIG_LED_PARALLEL_LANES) - 1;
+    const size_t data_slots = (size_t)LED_PARALLEL_PER_LANE * 24 * 3;
+    uint8_t *wire = (uint8_t *)s_wire;
+
+    size_t len = led_chipset_encode(wire, px, stride, num_leds, cal, frame);
+    CHECK(len == LED_CHIPSET_WIRE_BYTES(num_leds), "%s: %zu bytes", what, len);
+    CHECK(led_chipset_transmit(wire, len) == ESP_OK, "%s: transmit", what);
+    CHECK(led_chipset_wait() == ESP_OK, "%s: wait", what);
+    CHECK(s_sent_len == len, "%s: %zu bytes en el bus", what, s_sent_len);
+    if (s_sent_len != len || len != LED_CHIPSET_WIRE_BYTES(num_leds)) {
+        return;
+    }
+
+    int bad_slots = 0, wrong = 0;
+    for (size_t s = 0; s < data_slots; s += 3) {
+        bad_slots += slot_at(s) != lane_mask || (slot_at(s + 1) & ~lane_mask) != 0 ||
+                     slot_at(s + 2) != 0;
+    }
+    for (size_t s = data_slots; s < data_slots + LED_PARALLEL_RESET_SLOTS; s++) {
+        bad_slots += slot_at(s) != 0;
+    }
+    CHECK(bad_slots == 0, "%s: %d palabras fuera de formato", what, bad_slots);
+
+    for (int k = 0; k < CONFIG_LED_PARALLEL_LANES; k++) {
+        for (int j = 0; j < LED_PARALLEL_PER_LANE; j++) {
+            size_t i = (size_t)k * LED_PARALLEL_PER_LANE + j;
+            uint8_t got[3] = {0};
+            for (int ch = 0; ch < 3; ch++) {
+                uint8_t b = 0;
+                for (int bit = 0; bit < 8; bit++) {
+                    size_t s = ((size_t)j * 24 + ch * 8 + bit) * 3 + 1;
+                    b = (uint8_t)(b << 1 | ((slot_at(s) >> k) & 1));
+                }
+                got[wire_order[ch] == 'R' ? 0 : (wire_order[ch] == 'G' ? 1 : 2)] = b;
+            }
+
+            uint8_t want[LED_CHANNELS] = {0};
+            if (i < num_leds) {
+                led_chipset_pixel(cal, i, px + i * stride, frame, want);
+            }
+            if (memcmp(got, want, 3) != 0 && wrong++ < 3) {
+                CHECK(false, "%s: tira %d, LED %d: %02x %02x %02x en vez de %02x %02x %02x",
+                      what, k, j, got[0], got[1], got[2], want[0], want[1], want[2]);
+            }
+        }
+    }
+}
+
+static void bench(const led_chan_t *px)
+{
+    uint8_t *wire = (uint8_t *)s_wire;
+    static uint8_t in[1024][8];
+    volatile uint8_t sink = 0;
+
+    uint64_t start = host_test_ns();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        led_chipset_encode(wire, px, LED_CHANNELS, LED_NUM_LEDS, NULL, f);
+        sink += wire[f];
+    }
+    double encode_ns = (double)(host_test_ns() - start) / BENCH_FRAMES / LED_NUM_LEDS;
+
+    for (int n = 0; n < 1024; n++) {
+        for (int k = 0; k < 8; k++) {
+            in[n][k] = (uint8_t)rnd();
+        }
+    }
+    start = host_test_ns();
+    for (int n = 0; n < TRANSPOSES * 100; n++) {
+        uint8_t out[8];
+        transpose8(in[n & 1023], out);
+        sink += out[n & 7];
+    }
+    double transpose_ns = (double)(host_test_ns() - start) / (TRANSPOSES * 100);
+
+    printf("encode: %.1f ns/píxel (%d LEDs, %d tiras de %d); transpose8: %.1f ns\n", encode_ns,
+           LED_NUM_LEDS, CONFIG_LED_PARALLEL_LANES, LED_PARALLEL_PER_LANE, transpose_ns);
+}
+
+int main(int argc, char **argv)
+{
+    static led_chan_t px[LED_NUM_LEDS * LED_CHANNELS];
+    static led_calib_t cal;
+
+    check_transpose();
+    CHECK(led_chipset_init(LED_CHIPSET_WIRE_BYTES(LED_NUM_LEDS)) == ESP_OK, "init");
+    check_gpios();
+
+    led_calib_init(&cal, 220);
+    for (uint32_t f = 0; f < FRAMES; f++) {
+        for (size_t k = 0; k < LED_NUM_LEDS * LED_CHANNELS; k++) {
+            px[k] = (led_chan_t)(rnd() & LED_CHAN_MAX);
+        }
+        check_frame("tira", px, LED_CHANNELS, LED_NUM_LEDS, NULL, f);
+        check_frame("tira calibrada", px, LED_CHANNELS, LED_NUM_LEDS, &cal, f);
+        check_frame("un color", px, 0, LED_NUM_LEDS, NULL, f);
+        // Las tiras del final quedan a medias o vacías
+        check_frame("parcial", px, LED_CHANNELS, LED_NUM_LEDS - LED_PARALLEL_PER_LANE - 3, NULL,
+                    f);
+    }
+
+    if (host_test_bench(argc, argv)) {
+        bench(px);
+    }
+    return host_test_result("parallel");
+}
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+apibench.py - Mide la API REST de control (main/http_api.h) desde el PC
+
+Lanza comandos contra el dispositivo con conexiones persistentes y mide en
+el cliente las peticiones por segundo y el tiempo de ida y vuelta de cada
+petición. Antes y después lee /api/stats para obtener del dispositivo la
+latencia petición-luz de esos comandos: desde que el comando llega hasta
+que el frame que lo incluye termina de salir hacia la tira.
+
+Los comandos alternan entre dos valores para que cada uno cambie la tira.
+
+USO:
+====
+    apibench.py 192.168.1.50
+    apibench.py 192.168.1.50 -n 2000 -c 4 --endpoint brightness
+"""
+
+import argparse
+import http.client
+import json
+import socket
+import sys
+import threading
+import time
+
+
+# Cuerpos alternos de cada endpoint
+BODIES = {
+    "color": ('{"color":[255,0,0]}', '{"color":[0,0,255]}'),
+    "brightness": ('{"value":64}', '{"value":255}'),
+    "effect": ('{"name":"rainbow"}', '{"name":"plasma"}'),
+}
+
+
+def get_json(host, port, path):
+    conn = http.client.HTTPConnection(host, port, timeout=5)
+    try:
+        conn.request("GET", path)
+        resp = conn.getresponse()
+        return json.loads(resp.read())
+    finally:
+        conn.close()
+
+
+def worker(host, port, path, bodies, count, rtts, statuses, lock):
+    """Envía count peticiones por una conexión persistente"""
+    conn = http.client.HTTPConnection(host, port, timeout=5)
+    conn.connect()
+    conn.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    headers = {"Content-Type": "application/json"}
+    local_rtts = []
+    local_status = {}
+    try:
+        for i in range(count):
+            body = bodies[i & 1]
+            t0 = time.perf_counter()
+            conn.request("POST", path, body, headers)
+            resp = conn.getresponse()
+            resp.read()
+            local_rtts.append(time.perf_counter() - t0)
+            local_status[resp.status] = local_status.get(resp.status, 0) + 1
+    finally:
+        conn.close()
+
+    with lock:
+        rtts.extend(local_rtts)
+        for code, n in local_status.items():
+            statuses[code] = statuses.get(code, 0) + n
+
+
+def percentile(values, p):
+    k = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="Dirección del dispositivo")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("-n", "--requests", type=int, default=500,
+                        help="Peticiones en total (por defecto 500)")
+    parser.add_argument("-c", "--connections", type=int, default=1,
+                        help="Conexiones en paralelo (por defecto 1)")
+    parser.add_argument("--endpoint", choices=sorted(BODIES), default="color")
+    args = parser.parse_args()
+
+    path = "/api/" + args.endpoint
+    per_conn = max(1, args.requests // args.connections)
+
+    try:
+        before = get_json(args.host, args.port, "/api/stats")
+    except (OSError, ValueError) as e:
+        print(f"error: no se puede leer /api/stats: {e}", file=sys.stderr)
+        return 1
+
+    rtts, statuses, lock = [], {}, threading.Lock()
+    threads = [threading.Thread(target=worker,
+                                args=(args.host, args.port, path, BODIES[args.endpoint],
+                                      per_conn, rtts, statuses, lock))
+               for _ in range(args.connections)]
+    t0 = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.perf_counter() - t0
+
+    # Los últimos comandos se presentan en el frame siguiente
+    time.sleep(0.1)
+    after = get_json(args.host, args.port, "/api/stats")
+
+    if not rtts:
+        print("error: ninguna petición completada", file=sys.stderr)
+        return 1
+
+    rtts.sort()
+    ms = [v * 1000.0 for v in rtts]
+    print(f"{path}: {len(rtts)} peticiones en {elapsed:.2f} s con "
+          f"{args.connections} conexión(es)")
+    print(f"  peticiones/s:   {len(rtts) / elapsed:.1f}")
+    print(f"  ida y vuelta:   media {sum(ms) / len(ms):.2f} ms, p50 {percentile(ms, 50):.2f}, "
+          f"p95 {percentile(ms, 95):.2f}, p99 {percentile(ms, 99):.2f}, máx {ms[-1]:.2f}")
+    print("  respuestas:     " + ", ".join(f"{code}: {n}" for code, n in sorted(statuses.items())))
+
+    lb, la = before["latency_us"], after["latency_us"]
+    samples = la["samples"] - lb["samples"]
+    cb, ca = before["commands"], after["commands"]
+    print(f"  comandos:       {ca['applied'] - cb['applied']} aplicados, "
+          f"{ca['dropped'] - cb['dropped']} descartados (cola llena)")
+    if samples > 0:
+        avg_us = (la["sum"] - lb["sum"]) / samples
+        print(f"  petición-luz:   media {avg_us / 1000.0:.2f} ms en {samples} frames, "
+              f"última {la['last'] / 1000.0:.2f} ms, máx. desde el arranque "
+              f"{la['max'] / 1000.0:.2f} ms")
+    else:
+        print("  petición-luz:   sin frames nuevos (¿hay algún efecto o fuente activa?)")
+    hb, ha = before["http"], after["http"]
+    print(f"  servidor:       {ha['handler_avg_us']} us de media por petición "
+          f"(desde el arranque), {ha['errors'] - hb['errors']} errores")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
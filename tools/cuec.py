@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+cuec.py - Compila una hoja de cues al formato binario CUE1 (main/led_cue.h)
+
+La hoja es JSON (una lista de cues, o un objeto con "cues") o CSV con
+cabecera. Cada cue tiene:
+
+    time        Posición: ms (número), "m:ss.mmm", "h:mm:ss.mmm" o
+                "hh:mm:ss:ff" (frames a --fps)
+    effect      Nombre de /api/effects, "none" para detenerlo; vacío no lo
+                cambia
+    color       "#rrggbb" o [r, g, b]: efecto "solid" con ese color
+    brightness  0-255
+    fade        Transición del color y el brillo en ms
+
+Los nombres de efecto se resuelven con GET /api/effects del dispositivo
+(--host) o con --effects, una lista de nombres en el orden del
+dispositivo. Con --host la lista se sube además con POST /api/cues, y con
+--play se arranca con el reloj local.
+
+USO:
+====
+    cuec.py show.json -o show.cue --effects solid,rainbow,fire
+    cuec.py show.csv --host 192.168.1.50 --play 0
+"""
+
+import argparse
+import csv
+import http.client
+import json
+import struct
+import sys
+
+MAGIC = b"CUE1"
+FLAG_COLOR = 0x01
+FLAG_BRIGHTNESS = 0x02
+EFFECT_NONE = -1
+EFFECT_KEEP = -2
+
+
+def parse_time(value, fps):
+    """Posición en ms"""
+    if isinstance(value, (int, float)):
+        return int(value)
+    parts = str(value).strip().split(":")
+    if len(parts) == 4:
+        h, m, s, f = (int(p) for p in parts)
+        return ((h * 60 + m) * 60 + s) * 1000 + f * 1000 // fps
+    seconds = 0.0
+    for p in parts:
+        seconds = seconds * 60 + float(p)
+    return int(round(seconds * 1000)) if len(parts) > 1 else int(float(parts[0]))
+
+
+def parse_color(value):
+    if isinstance(value, list) and len(value) == 3:
+        rgb = [int(v) for v in value]
+    elif isinstance(value, str) and len(value) == 7 and value[0] == "#":
+        rgb = [int(value[i:i + 2], 16) for i in (1, 3, 5)]
+    else:
+        raise ValueError(f"color no válido: {value!r}")
+    if any(v < 0 or v > 255 for v in rgb):
+        raise ValueError(f"color fuera de rango: {value!r}")
+    return rgb
+
+
+def load_sheet(path):
+    with open(path, newline="") as f:
+        if path.endswith(".csv"):
+            return [{k: v for k, v in row.items() if v not in (None, "")}
+                    for row in csv.DictReader(f)]
+        data = json.load(f)
+    return data["cues"] if isinstance(data, dict) else data
+
+
+def compile_cue(cue, effects, fps):
+    t_ms = parse_time(cue["time"], fps)
+    effect, flags, brightness, rgb = EFFECT_KEEP, 0, 0, [0, 0, 0]
+
+    name = cue.get("effect")
+    if name is not None:
+        if name == "none":
+            effect = EFFECT_NONE
+        elif str(name).lstrip("-").isdigit():
+            effect = int(name)
+        elif name in effects:
+            effect = effects.index(name)
+        else:
+            raise ValueError(f"efecto desconocido: {name!r} (¿--host o --effects?)")
+    if "color" in cue:
+        value = cue["color"]
+        if isinstance(value, str) and value.startswith("["):
+            value = json.loads(value)
+        rgb = parse_color(value)
+        flags |= FLAG_COLOR
+    if "brightness" in cue:
+        brightness = int(cue["brightness"])
+        if not 0 <= brightness <= 255:
+            raise ValueError(f"brillo fuera de rango: {brightness}")
+        flags |= FLAG_BRIGHTNESS
+    fade = int(cue.get("fade", 0))
+
+    if not 0 <= t_ms < 2 ** 32 or not 0 <= fade < 2 ** 16:
+        raise ValueError("time o fade fuera de rango")
+    return t_ms, struct.pack("<IhBB3BxHxx", t_ms, effect, flags, brightness, *rgb, fade)
+
+
+def request(host, port, method, path, body=None, ctype="application/json"):
+    conn = http.client.HTTPConnection(host, port, timeout=10)
+    try:
+        conn.request(method, path, body, {"Content-Type": ctype} if body is not None else {})
+        resp = conn.getresponse()
+        data = resp.read()
+        if resp.status != 200:
+            raise OSError(f"{method} {path}: {resp.status} {data.decode(errors='replace')}")
+        return json.loads(data)
+    finally:
+        conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("sheet", help="Hoja de cues (.json o .csv)")
+    parser.add_argument("-o", "--output", help="Fichero binario de salida")
+    parser.add_argument("--host", help="Dispositivo al que subir la lista")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--effects", help="Nombres de efecto separados por comas, sin --host")
+    parser.add_argument("--fps", type=int, default=30,
+                        help="Frames por segundo de las posiciones hh:mm:ss:ff")
+    parser.add_argument("--play", type=int, metavar="MS",
+                        help="Tras subirla, reproducir desde esta posición")
+    args = parser.parse_args()
+
+    try:
+        if args.host:
+            effects = request(args.host, args.port, "GET", "/api/effects")
+        else:
+            effects = args.effects.split(",") if args.effects else []
+
+        records = sorted((compile_cue(c, effects, args.fps) for c in load_sheet(args.sheet)),
+                         key=lambda r: r[0])
+        blob = MAGIC + struct.pack("<HH", len(records), 0) + b"".join(r[1] for r in records)
+
+        if args.output:
+            with open(args.output, "wb") as f:
+                f.write(blob)
+        if args.host:
+            request(args.host, args.port, "POST", "/api/cues", blob, "application/octet-stream")
+            if args.play is not None:
+                request(args.host, args.port, "POST", "/api/cues/play",
+                        json.dumps({"from": args.play}))
+            status = request(args.host, args.port, "GET", "/api/cues")
+            print(f"{status['cues']} cues en el dispositivo, fuente {status['source']}")
+    except (OSError, ValueError, KeyError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+    end = records[-1][0] / 1000.0 if records else 0.0
+    print(f"{len(records)} cues, {len(blob)} bytes, último en {end:.3f} s")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,10 @@
+# Respiración con estado: la fase avanza en la sección frame y se
+# conserva entre frames en un registro global.
+global fase
+
+frame:
+fase = frac(fase + 0.005)
+
+pixel:
+v = 0.5 + 0.5 * sin(fase)
+hsv(0.6 + 0.1 * noise(x * 4, t), 0.8, v * v)
@@ -0,0 +1,6 @@
+# Plasma de dos ondas senoidales.
+# Equivale al efecto nativo "plasma" de main/led_effects.c
+# (0.30078125 es el 0x004D en Q8.8 que usa la versión nativa).
+v1 = sin(2 * x + 0.5 * t)
+v2 = sin(5 * x - 0.30078125 * t)
+rgb(v1 * 0.5 + 0.5, v2 * 0.5 + 0.5, (v1 + v2) * 0.25 + 0.5)
@@ -0,0 +1,9 @@
+# Pulso reactivo al audio: el color recorre la tira con el tiempo, los
+# graves dan el brillo y cada beat añade un destello que se apaga solo.
+# Necesita CONFIG_AUDIO_ENABLE (sin audio todas las entradas valen 0).
+
+pixel:
+bass = max(band0, band1)
+h = x * 0.5 + t * 0.1 + level * 0.25
+v = clamp(0.15 + bass * 0.85 + beat * 0.5)
+hsv(h, 1 - beat * 0.6, v)
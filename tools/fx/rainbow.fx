@@ -0,0 +1,3 @@
+# Arcoíris que recorre la tira: una vuelta de color cada 4 segundos.
+# Equivale al efecto nativo "rainbow" de main/led_effects.c.
+hsv(x + t * 0.25, 1, 1)
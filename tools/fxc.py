@@ -0,0 +1,1031 @@
+#!/usr/bin/env python3
+"""
+fxc.py - Compilador de efectos LED para la VM de bytecode (main/fx_vm.h)
+
+Traduce un lenguaje de expresiones compacto a bytecode FXB1, o a tablas C
+precalculadas cuando el efecto es una función pura de la posición y de un
+periodo de tiempo. Incluye un simulador bit-exacto de la VM para ejecutar
+el programa sobre una tira simulada antes de subirlo al equipo.
+
+LENGUAJE:
+=========
+    # comentario
+    global fase             # registros que persisten entre frames (r8-r15)
+
+    frame:                  # una vez por frame (opcional)
+    fase = frac(fase + 0.01)
+
+    pixel:                  # una vez por píxel
+    h = x + t * 0.25 + fase
+    hsv(h, 1, 0.5 + 0.5 * sin(x * 3))
+
+Entradas:   i (índice), x (i / n), t (segundos), n (número de LEDs)
+Audio:      band0 .. band7, level, beat, onset en [0, 1] (main/audio_reactive.h)
+Salida:     rgb(r, g, b) o hsv(h, s, v), valores en [0, 1]
+Operadores: + - * / <  (y menos unario), paréntesis
+Funciones:  sin cos noise(a, b) min max abs frac floor clamp
+Números en Q16.16: los que son exactos en Q8.8 usan LDI, el resto LDK.
+
+USO:
+====
+    fxc.py build  efecto.fx -o efecto.fxb [--c-array]
+    fxc.py dis    efecto.fxb
+    fxc.py run    efecto.fx|efecto.fxb --leds 60 --frames 100 [--ppm out.ppm]
+                  [--expect ref.ppm] [--fps 60] [--audio beat=1 --audio band0=0.5]
+    fxc.py table  efecto.fx --leds 60 --fps 50 --period 4 -o efecto_table.h
+"""
+
+import argparse
+import math
+import re
+import struct
+import sys
+
+# ============================================================================
+# FORMATO DE LA VM (debe coincidir con main/fx_vm.h)
+# ============================================================================
+
+FX_VM_VERSION = 1
+FX_VM_NUM_REGS = 16
+FX_VM_FIRST_GLOBAL = 8
+FX_VM_MAX_CODE = 256          # CONFIG_FX_VM_MAX_CODE por defecto
+FX_VM_MAX_CONSTS = 32
+FX_VM_NO_ENTRY = 0xFFFF
+
+OPCODES = [
+    "END", "MOV", "LDI", "LDK", "ADD", "SUB", "MUL", "DIV", "MAD", "MIN",
+    "MAX", "NEG", "ABS", "FRAC", "FLOOR", "CLAMP", "LT", "SIN", "COS",
+    "NOISE", "JMP", "JZ", "OUT", "OUTHSV", "AUDIO",
+]
+OP = {name: code for code, name in enumerate(OPCODES)}
+
+# Coste aproximado en ciclos por instrucción en un Xtensa LX6 (despacho del
+# switch incluido). Solo sirve para comparar programas entre sí: la medida
+# real es led_effects_benchmark() en el equipo.
+OP_CYCLES = {
+    "END": 6, "MOV": 10, "LDI": 11, "LDK": 11, "ADD": 11, "SUB": 11,
+    "MUL": 16, "DIV": 60, "MAD": 18, "MIN": 12, "MAX": 12, "NEG": 10,
+    "ABS": 11, "FRAC": 10, "FLOOR": 10, "CLAMP": 12, "LT": 12, "SIN": 24,
+    "COS": 25, "NOISE": 110, "JMP": 8, "JZ": 10, "OUT": 30, "OUTHSV": 70,
+    "AUDIO": 11,
+}
+
+INPUTS = {"i": 0, "x": 1, "t": 2, "n": 3}
+# Índices de audio_feature_t: se leen con la instrucción AUDIO
+AUDIO_INPUTS = dict(("band%d" % k, k) for k in range(8))
+AUDIO_INPUTS.update({"level": 8, "beat": 9, "onset": 10})
+AUDIO_NUM_FEATURES = 11
+FX_ONE = 1 << 16
+
+
+class FxError(Exception):
+    pass
+
+
+# ============================================================================
+# MATEMÁTICA EN PUNTO FIJO (réplica exacta de main/fx_math.[ch])
+# ============================================================================
+
+def i32(v):
+    v &= 0xFFFFFFFF
+    return v - 0x100000000 if v & 0x80000000 else v
+
+
+SIN_TABLE = [int(round(math.sin(2 * math.pi * k / 256) * 32767)) for k in range(256)]
+
+
+def fx_mul(a, b):
+    return i32((a * b) >> 16)
+
+
+def fx_div(a, b):
+    if b == 0:
+        return 0
+    num = a << 16
+    q = abs(num) // abs(b)
+    return i32(q if (num >= 0) == (b >= 0) else -q)
+
+
+def fx_frac(a):
+    return a & (FX_ONE - 1)
+
+
+def fx_clamp01(a):
+    return 0 if a < 0 else (FX_ONE if a > FX_ONE else a)
+
+
+def fx_sin(turns):
+    idx = (turns >> 8) & 0xFF
+    frac = turns & 0xFF
+    s0 = SIN_TABLE[idx]
+    s1 = SIN_TABLE[(idx + 1) & 0xFF]
+    return (s0 + (((s1 - s0) * frac) >> 8)) << 1
+
+
+def fx_cos(turns):
+    return fx_sin(i32(turns + FX_ONE // 4))
+
+
+def fx_to_u8(a):
+    a = fx_clamp01(a)
+    return (a * 255 + FX_ONE // 2) >> 16
+
+
+def _lattice(ix, iy):
+    h = ((ix * 0x27D4EB2D) ^ (iy * 0x165667B1)) & 0xFFFFFFFF
+    h ^= h >> 15
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    return h >> 16
+
+
+def _smoothstep(t):
+    return fx_mul(fx_mul(t, t), 3 * FX_ONE - 2 * t)
+
+
+def fx_value_noise2(x, y):
+    ix, iy = x >> 16, y >> 16
+    fx, fy = _smoothstep(fx_frac(x)), _smoothstep(fx_frac(y))
+    v00, v10 = _lattice(ix, iy), _lattice(ix + 1, iy)
+    v01, v11 = _lattice(ix, iy + 1), _lattice(ix + 1, iy + 1)
+    top = v00 + fx_mul(v10 - v00, fx)
+    bottom = v01 + fx_mul(v11 - v01, fx)
+    return top + fx_mul(bottom - top, fy)
+
+
+def fx_hsv_to_rgb(h, s, v):
+    s, v = fx_clamp01(s), fx_clamp01(v)
+    h6 = fx_frac(h) * 6
+    sector = h6 >> 16
+    f = fx_frac(h6)
+    vv = fx_to_u8(v)
+    p = fx_to_u8(fx_mul(v, FX_ONE - s))
+    q = fx_to_u8(fx_mul(v, FX_ONE - fx_mul(s, f)))
+    t = fx_to_u8(fx_mul(v, FX_ONE - fx_mul(s, FX_ONE - f)))
+    return [(vv, t, p), (q, vv, p), (p, vv, t), (p, q, vv), (t, p, vv)][sector] \
+        if sector < 5 else (vv, p, q)
+
+
+def to_fixed(value):
+    return i32(int(round(value * FX_ONE)))
+
+
+# ============================================================================
+# PARSER
+# ============================================================================
+
+TOKEN_RE = re.compile(r"\s*(?:(\d+\.\d*|\.\d+|\d+)|([A-Za-z_]\w*)|(.))")
+FUNCS = {"sin": 1, "cos": 1, "noise": 2, "min": 2, "max": 2, "abs": 1,
+         "frac": 1, "floor": 1, "clamp": 1}
+
+
+def tokenize(text, lineno):
+    tokens = []
+    for m in TOKEN_RE.finditer(text):
+        num, name, sym = m.groups()
+        if num is not None:
+            tokens.append(("num", to_fixed(float(num))))
+        elif name is not None:
+            tokens.append(("name", name))
+        elif sym is not None and not sym.isspace():
+            tokens.append(("sym", sym))
+    return tokens
+
+
+class Parser:
+    """Parser descendente recursivo de una línea. Genera tuplas:
+    ('num', v) ('var', nombre) ('neg', e) ('bin', op, a, b) ('call', f, args)"""
+
+    def __init__(self, tokens, lineno):
+        self.tokens = tokens
+        self.pos = 0
+        self.lineno = lineno
+
+    def error(self, msg):
+        raise FxError("línea %d: %s" % (self.lineno, msg))
+
+    def peek(self):
+        return self.tokens[self.pos] if self.pos < len(self.tokens) else (None, None)
+
+    def take(self, kind=None, value=None):
+        tok = self.peek()
+        if tok[0] is None or (kind and tok[0] != kind) or (value and tok[1] != value):
+            self.error("se esperaba %s" % (value or kind))
+        self.pos += 1
+        return tok
+
+    def done(self):
+        if self.pos != len(self.tokens):
+            self.error("símbolo inesperado '%s'" % (self.peek()[1],))
+
+    def expr(self):
+        left = self.sum()
+        tok = self.peek()
+        if tok == ("sym", "<"):
+            self.pos += 1
+            return ("bin", "<", left, self.sum())
+        if tok == ("sym", ">"):
+            self.pos += 1
+            return ("bin", "<", self.sum(), left)
+        return left
+
+    def sum(self):
+        node = self.prod()
+        while self.peek() in (("sym", "+"), ("sym", "-")):
+            op = self.take()[1]
+            node = ("bin", op, node, self.prod())
+        return node
+
+    def prod(self):
+        node = self.unary()
+        while self.peek() in (("sym", "*"), ("sym", "/")):
+            op = self.take()[1]
+            node = ("bin", op, node, self.unary())
+        return node
+
+    def unary(self):
+        if self.peek() == ("sym", "-"):
+            self.pos += 1
+            return ("neg", self.unary())
+        return self.atom()
+
+    def atom(self):
+        kind, value = self.peek()
+        if kind == "num":
+            self.pos += 1
+            return ("num", value)
+        if kind == "name":
+            self.pos += 1
+            if self.peek() == ("sym", "("):
+                if value not in FUNCS:
+                    self.error("función desconocida '%s'" % value)
+                args = self.args()
+                if len(args) != FUNCS[value]:
+                    self.error("%s() espera %d argumentos" % (value, FUNCS[value]))
+                return ("call", value, args)
+            if value in AUDIO_INPUTS:
+                return ("audio", AUDIO_INPUTS[value])
+            return ("var", value)
+        if (kind, value) == ("sym", "("):
+            self.pos += 1
+            node = self.expr()
+            self.take("sym", ")")
+            return node
+        self.error("expresión no válida")
+
+    def args(self):
+        self.take("sym", "(")
+        args = [self.expr()]
+        while self.peek() == ("sym", ","):
+            self.pos += 1
+            args.append(self.expr())
+        self.take("sym", ")")
+        return tuple(args)
+
+
+def parse_program(source):
+    """Devuelve (globals, {'frame': [stmts], 'pixel': [stmts]})"""
+    globals_ = []
+    sections = {"frame": [], "pixel": []}
+    current = "pixel"
+
+    for lineno, raw in enumerate(source.splitlines(), 1):
+        line = raw.split("#", 1)[0].strip()
+        if not line:
+            continue
+        if line in ("frame:", "pixel:"):
+            current = line[:-1]
+            continue
+        tokens = tokenize(line, lineno)
+        p = Parser(tokens, lineno)
+
+        if tokens[0] == ("name", "global"):
+            p.pos = 1
+            while True:
+                name = p.take("name")[1]
+                if name in INPUTS or name in AUDIO_INPUTS or name in globals_:
+                    p.error("global '%s' duplicada o reservada" % name)
+                globals_.append(name)
+                if p.peek() != ("sym", ","):
+                    break
+                p.pos += 1
+            p.done()
+            continue
+
+        if tokens[0][0] == "name" and tokens[0][1] in ("rgb", "hsv") and \
+                len(tokens) > 1 and tokens[1] == ("sym", "("):
+            p.pos = 1
+            args = p.args()
+            if len(args) != 3:
+                p.error("%s() espera 3 argumentos" % tokens[0][1])
+            p.done()
+            sections[current].append(("out", tokens[0][1], args, lineno))
+            continue
+
+        name = p.take("name")[1]
+        if name in INPUTS or name in AUDIO_INPUTS:
+            p.error("'%s' es una entrada de solo lectura" % name)
+        p.take("sym", "=")
+        node = p.expr()
+        p.done()
+        sections[current].append(("assign", name, node, lineno))
+
+    if len(globals_) > FX_VM_NUM_REGS - FX_VM_FIRST_GLOBAL:
+        raise FxError("como mucho %d globales" % (FX_VM_NUM_REGS - FX_VM_FIRST_GLOBAL))
+    if not sections["pixel"]:
+        raise FxError("el programa no tiene sección pixel")
+    return globals_, sections
+
+
+# ============================================================================
+# OPTIMIZACIÓN (plegado de constantes y simplificación algebraica)
+# ============================================================================
+
+FOLD_BIN = {
+    "+": lambda a, b: i32(a + b),
+    "-": lambda a, b: i32(a - b),
+    "*": fx_mul,
+    "/": fx_div,
+    "<": lambda a, b: FX_ONE if a < b else 0,
+}
+FOLD_CALL = {
+    "sin": fx_sin, "cos": fx_cos, "noise": fx_value_noise2,
+    "min": min, "max": max, "abs": abs, "frac": fx_frac,
+    "floor": lambda a: a & ~(FX_ONE - 1), "clamp": fx_clamp01,
+}
+
+
+def fold(node):
+    kind = node[0]
+    if kind == "neg":
+        a = fold(node[1])
+        return ("num", i32(-a[1])) if a[0] == "num" else ("neg", a)
+    if kind == "call":
+        args = tuple(fold(a) for a in node[2])
+        if all(a[0] == "num" for a in args):
+            return ("num", FOLD_CALL[node[1]](*[a[1] for a in args]))
+        return ("call", node[1], args)
+    if kind == "bin":
+        op, a, b = node[1], fold(node[2]), fold(node[3])
+        if a[0] == "num" and b[0] == "num":
+            return ("num", FOLD_BIN[op](a[1], b[1]))
+        if op == "+" and a == ("num", 0):
+            return b
+        if op in "+-" and b == ("num", 0):
+            return a
+        if op == "*" and (a == ("num", 0) or b == ("num", 0)):
+            return ("num", 0)
+        if op == "*" and a == ("num", FX_ONE):
+            return b
+        if op in "*/" and b == ("num", FX_ONE):
+            return a
+        if op == "-" and a == ("num", 0):
+            return ("neg", b)
+        return ("bin", op, a, b)
+    return node
+
+
+def uses(node, names):
+    """True si la expresión lee alguna variable de names"""
+    if node[0] == "var":
+        return node[1] in names
+    if node[0] == "neg":
+        return uses(node[1], names)
+    if node[0] == "bin":
+        return uses(node[2], names) or uses(node[3], names)
+    if node[0] == "call":
+        return any(uses(a, names) for a in node[2])
+    return False
+
+
+# ============================================================================
+# GENERACIÓN DE CÓDIGO
+# ============================================================================
+
+BIN_OPS = {"+": "ADD", "-": "SUB", "*": "MUL", "/": "DIV", "<": "LT"}
+CALL_OPS = {"sin": "SIN", "cos": "COS", "noise": "NOISE", "min": "MIN",
+            "max": "MAX", "abs": "ABS", "frac": "FRAC", "floor": "FLOOR",
+            "clamp": "CLAMP"}
+NO_WRITE = {"END", "JMP", "JZ", "OUT", "OUTHSV"}
+TEMP_REGS = [4, 5, 6, 7]
+
+
+class CodeGen:
+    """Generador de código con asignación de registros por recuento de
+    referencias, caché de constantes en registros y extracción de
+    invariantes de la sección pixel a la sección frame.
+
+    Los registros r8-r15 que no son globales del usuario conservan su valor
+    entre la entrada de frame y los píxeles, así que sirven para guardar
+    constantes y subexpresiones que solo dependen de t, n o de globales
+    escritas en la sección frame. Se calculan una vez por frame en lugar
+    de una vez por píxel."""
+
+    def __init__(self, globals_):
+        self.code = []
+        self.consts = []
+        self.globals = {name: FX_VM_FIRST_GLOBAL + k for k, name in enumerate(globals_)}
+        used = set(self.globals.values())
+        self.upper_free = [r for r in range(FX_VM_FIRST_GLOBAL, FX_VM_NUM_REGS) if r not in used]
+        self.hoisted = {}       # expresión -> nombre interno
+        self.hoist_regs = {}    # nombre interno -> registro
+        self.hoist_order = []   # (nombre, expresión) en orden de aparición
+
+    # --- registros -----------------------------------------------------------
+
+    def begin_entry(self, section, pool):
+        self.section = section
+        self.locals = {}
+        self.pool = set(pool)
+        self.free = list(pool)
+        self.refs = {}
+        self.reg_const = {}
+
+    def emit(self, op, a=0, b=0, c=0):
+        if len(self.code) >= FX_VM_MAX_CODE:
+            raise FxError("el programa supera %d instrucciones" % FX_VM_MAX_CODE)
+        self.code.append((OP[op], a, b, c))
+        if op not in NO_WRITE:
+            self.reg_const.pop(a, None)
+
+    def alloc(self, lineno):
+        if not self.free:
+            raise FxError("línea %d: expresión demasiado compleja (sin registros)" % lineno)
+        reg = self.free.pop(0)
+        self.refs[reg] = 1
+        return reg
+
+    def share(self, reg):
+        if reg in self.free:
+            self.free.remove(reg)
+            self.refs[reg] = 1
+        elif reg in self.pool:
+            self.refs[reg] = self.refs.get(reg, 0) + 1
+        return reg
+
+    def release(self, reg):
+        if reg not in self.pool or reg in self.locals.values():
+            return
+        self.refs[reg] -= 1
+        if self.refs[reg] == 0:
+            self.free.insert(0, reg)
+
+    # --- generación ----------------------------------------------------------
+
+    def load_const(self, value, dest):
+        if value % 256 == 0 and -32768 <= (value >> 8) <= 32767:
+            imm = (value >> 8) & 0xFFFF
+            self.emit("LDI", dest, imm & 0xFF, imm >> 8)
+        else:
+            if value not in self.consts:
+                if len(self.consts) >= FX_VM_MAX_CONSTS:
+                    raise FxError("demasiadas constantes (máximo %d)" % FX_VM_MAX_CONSTS)
+                self.consts.append(value)
+            self.emit("LDK", dest, self.consts.index(value))
+        self.reg_const[dest] = value
+
+    def var_reg(self, name, lineno):
+        if name in INPUTS:
+            if self.section == "frame" and name in ("i", "x"):
+                raise FxError("línea %d: '%s' no existe en la sección frame" % (lineno, name))
+            return INPUTS[name]
+        if name in self.hoist_regs:
+            return self.hoist_regs[name]
+        if name in self.globals:
+            return self.globals[name]
+        if name in self.locals:
+            return self.locals[name]
+        raise FxError("línea %d: variable '%s' sin asignar" % (lineno, name))
+
+    def gen(self, node, lineno, dest=None):
+        """Evalúa node y devuelve el registro con el resultado (dest si se da).
+        Si no se da dest, el registro devuelto debe liberarse con release()."""
+        kind = node[0]
+
+        if kind == "var":
+            reg = self.var_reg(node[1], lineno)
+            if dest is not None and dest != reg:
+                self.emit("MOV", dest, reg)
+                return dest
+            return reg if dest is not None else self.share(reg)
+
+        if kind == "num" and dest is None:
+            for reg, value in self.reg_const.items():
+                if value == node[1]:
+                    return self.share(reg)
+
+        target = dest if dest is not None else self.alloc(lineno)
+
+        if kind == "num":
+            self.load_const(node[1], target)
+        elif kind == "audio":
+            self.emit("AUDIO", target, node[1])
+        elif kind == "neg":
+            src = self.gen(node[1], lineno)
+            self.emit("NEG", target, src)
+            self.release(src)
+        elif kind == "bin":
+            op, a, b = node[1], node[2], node[3]
+            # a + b * c  ->  MAD
+            if op == "+" and (b[0] == "bin" and b[1] == "*" or a[0] == "bin" and a[1] == "*"):
+                acc, mul = (a, b) if b[0] == "bin" and b[1] == "*" else (b, a)
+                if not self.reads_reg(mul, target):
+                    self.gen(acc, lineno, target)
+                    rb = self.gen(mul[2], lineno)
+                    rc = self.gen(mul[3], lineno)
+                    self.emit("MAD", target, rb, rc)
+                    self.release(rb)
+                    self.release(rc)
+                    return target
+            ra = self.gen(a, lineno)
+            rb = self.gen(b, lineno)
+            self.emit(BIN_OPS[op], target, ra, rb)
+            self.release(ra)
+            self.release(rb)
+        elif kind == "call":
+            regs = [self.gen(arg, lineno) for arg in node[2]]
+            self.emit(CALL_OPS[node[1]], target, *(regs + [0] * (2 - len(regs))))
+            for r in regs:
+                self.release(r)
+        return target
+
+    def reads_reg(self, node, reg):
+        """True si evaluar node lee el registro reg"""
+        if node[0] == "var":
+            try:
+                return self.var_reg(node[1], 0) == reg
+            except FxError:
+                return False
+        if node[0] == "neg":
+            return self.reads_reg(node[1], reg)
+        if node[0] == "bin":
+            return self.reads_reg(node[2], reg) or self.reads_reg(node[3], reg)
+        if node[0] == "call":
+            return any(self.reads_reg(a, reg) for a in node[2])
+        return False
+
+    # --- extracción de invariantes -------------------------------------------
+
+    def hoist_node(self, node, variant):
+        if node[0] == "var":
+            return node
+        if not uses(node, variant):
+            if node in self.hoisted:
+                return ("var", self.hoisted[node])
+            if self.upper_free:
+                name = "$h%d" % len(self.hoist_order)
+                self.hoisted[node] = name
+                self.hoist_regs[name] = self.upper_free.pop(0)
+                self.hoist_order.append((name, node))
+                return ("var", name)
+            return node
+        if node[0] == "neg":
+            return ("neg", self.hoist_node(node[1], variant))
+        if node[0] == "bin":
+            return ("bin", node[1], self.hoist_node(node[2], variant),
+                    self.hoist_node(node[3], variant))
+        if node[0] == "call":
+            return ("call", node[1], tuple(self.hoist_node(a, variant) for a in node[2]))
+        return node
+
+    def hoist(self, stmts):
+        """Sustituye las subexpresiones invariantes de la sección pixel"""
+        variant = {"i", "x"}
+        variant.update(s[1] for s in stmts if s[0] == "assign")
+        out = []
+        for stmt in stmts:
+            if stmt[0] == "assign":
+                out.append(("assign", stmt[1], self.hoist_node(fold(stmt[2]), variant), stmt[3]))
+            else:
+                out.append(("out", stmt[1],
+                            tuple(self.hoist_node(fold(a), variant) for a in stmt[2]), stmt[3]))
+        return out
+
+    # --- entradas ------------------------------------------------------------
+
+    def gen_stmts(self, section, stmts):
+        assigned = {}
+        for stmt in stmts:
+            if stmt[0] == "assign":
+                assigned[stmt[1]] = assigned.get(stmt[1], 0) + 1
+
+        for stmt in stmts:
+            if stmt[0] == "assign":
+                _, name, node, lineno = stmt
+                node = fold(node)
+                dest = self.globals.get(name, self.locals.get(name))
+                if dest is None and node[0] == "var" and assigned[name] == 1 and \
+                        (node[1] in INPUTS or node[1] in self.hoist_regs):
+                    # Alias de un registro que no cambia en esta entrada: sin código
+                    self.locals[name] = self.var_reg(node[1], lineno)
+                    continue
+                if dest is not None and node[0] != "var" and self.reads_reg(node, dest):
+                    # La expresión lee su propio destino: calcular en temporal
+                    tmp = self.gen(node, lineno)
+                    self.emit("MOV", dest, tmp)
+                    self.release(tmp)
+                    continue
+                if dest is None:
+                    dest = self.alloc(lineno)
+                    self.locals[name] = dest
+                self.gen(node, lineno, dest)
+            else:
+                _, kind, args, lineno = stmt
+                if section == "frame":
+                    raise FxError("línea %d: %s() solo vale en la sección pixel" % (lineno, kind))
+                regs = [self.gen(fold(a), lineno) for a in args]
+                self.emit("OUT" if kind == "rgb" else "OUTHSV", *regs)
+                for r in regs:
+                    self.release(r)
+
+
+def compile_source(source, hoist=True):
+    globals_, sections = parse_program(source)
+    cg = CodeGen(globals_)
+
+    pixel_stmts = sections["pixel"]
+    if hoist:
+        pixel_stmts = cg.hoist(pixel_stmts)
+
+    frame_entry = FX_VM_NO_ENTRY
+    if sections["frame"] or cg.hoist_order:
+        frame_entry = len(cg.code)
+        hoist_regs = set(cg.hoist_regs.values())
+        cg.begin_entry("frame", TEMP_REGS + [r for r in cg.upper_free if r not in hoist_regs])
+        cg.gen_stmts("frame", sections["frame"])
+        for name, node in cg.hoist_order:
+            cg.gen(node, 0, cg.hoist_regs[name])
+        cg.emit("END")
+
+    pixel_entry = len(cg.code)
+    cg.begin_entry("pixel", TEMP_REGS + cg.upper_free)
+    cg.gen_stmts("pixel", pixel_stmts)
+    cg.emit("END")
+
+    return Program(cg.code, cg.consts, frame_entry, pixel_entry, stateful=bool(globals_))
+
+
+# ============================================================================
+# PROGRAMA BINARIO
+# ============================================================================
+
+class Program:
+    def __init__(self, code, consts, frame_entry, pixel_entry, stateful=None):
+        self.code = code
+        self.consts = consts
+        self.frame_entry = frame_entry
+        self.pixel_entry = pixel_entry
+        # None: desconocido (programa cargado de un .fxb)
+        self.stateful = stateful
+
+    def to_bytes(self):
+        out = bytearray(b"FXB1")
+        out += struct.pack("<BBHHH", FX_VM_VERSION, len(self.consts), len(self.code),
+                           self.frame_entry, self.pixel_entry)
+        for k in self.consts:
+            out += struct.pack("<i", k)
+        for insn in self.code:
+            out += bytes(insn)
+        return bytes(out)
+
+    @staticmethod
+    def from_bytes(data):
+        if len(data) < 12 or data[:4] != b"FXB1" or data[4] != FX_VM_VERSION:
+            raise FxError("cabecera FXB1 no válida")
+        n_consts, n_code, frame_entry, pixel_entry = struct.unpack_from("<BHHH", data, 5)
+        if len(data) != 12 + 4 * n_consts + 4 * n_code:
+            raise FxError("tamaño de programa no válido")
+        consts = list(struct.unpack_from("<%di" % n_consts, data, 12))
+        base = 12 + 4 * n_consts
+        code = [tuple(data[base + 4 * k: base + 4 * k + 4]) for k in range(n_code)]
+        return Program(code, consts, frame_entry, pixel_entry)
+
+    def is_pure(self):
+        """Sin globales de usuario ni audio: cada frame solo depende de (i, t)"""
+        return self.stateful is False and all(insn[0] != OP["AUDIO"] for insn in self.code)
+
+    def disassemble(self):
+        lines = []
+        for pc, (op, a, b, c) in enumerate(self.code):
+            mark = ""
+            if pc == self.frame_entry:
+                mark = "frame:"
+            if pc == self.pixel_entry:
+                mark = "pixel:"
+            name = OPCODES[op] if op < len(OPCODES) else "?%d" % op
+            if name == "LDI":
+                imm = b | (c << 8)
+                imm = imm - 0x10000 if imm & 0x8000 else imm
+                args = "r%d, %g" % (a, imm / 256.0)
+            elif name == "LDK":
+                args = "r%d, k%d (%g)" % (a, b, self.consts[b] / FX_ONE)
+            elif name in ("JMP", "JZ"):
+                args = "r%d, @%d" % (a, b | (c << 8))
+            elif name == "AUDIO":
+                names = dict((v, k) for k, v in AUDIO_INPUTS.items())
+                args = "r%d, %s" % (a, names.get(b, "?%d" % b))
+            elif name == "END":
+                args = ""
+            else:
+                args = "r%d, r%d, r%d" % (a, b, c)
+            lines.append("%-7s %4d  %-7s %s" % (mark, pc, name, args))
+        return "\n".join(lines)
+
+
+# ============================================================================
+# SIMULADOR (réplica de main/fx_vm.c)
+# ============================================================================
+
+class Simulator:
+    def __init__(self, program, num_leds, audio=None):
+        self.p = program
+        self.n = num_leds
+        self.audio = audio or [0] * AUDIO_NUM_FEATURES
+        self.globals = [0] * (FX_VM_NUM_REGS - FX_VM_FIRST_GLOBAL)
+        self.instr_per_pixel = []
+        self.cycles = 0
+
+    def execute(self, r, pc, out):
+        code, consts = self.p.code, self.p.consts
+        count = 0
+        while pc < len(code):
+            op, a, b, c = code[pc]
+            pc += 1
+            count += 1
+            name = OPCODES[op]
+            self.cycles += OP_CYCLES[name]
+            if name == "END":
+                break
+            elif name == "MOV":
+                r[a] = r[b]
+            elif name == "LDI":
+                imm = b | (c << 8)
+                r[a] = (imm - 0x10000 if imm & 0x8000 else imm) << 8
+            elif name == "LDK":
+                r[a] = consts[b]
+            elif name == "ADD":
+                r[a] = i32(r[b] + r[c])
+            elif name == "SUB":
+                r[a] = i32(r[b] - r[c])
+            elif name == "MUL":
+                r[a] = fx_mul(r[b], r[c])
+            elif name == "DIV":
+                r[a] = fx_div(r[b], r[c])
+            elif name == "MAD":
+                r[a] = i32(r[a] + fx_mul(r[b], r[c]))
+            elif name == "MIN":
+                r[a] = min(r[b], r[c])
+            elif name == "MAX":
+                r[a] = max(r[b], r[c])
+            elif name == "NEG":
+                r[a] = i32(-r[b])
+            elif name == "ABS":
+                r[a] = i32(abs(r[b]))
+            elif name == "FRAC":
+                r[a] = fx_frac(r[b])
+            elif name == "FLOOR":
+                r[a] = i32(r[b] & ~(FX_ONE - 1))
+            elif name == "CLAMP":
+                r[a] = fx_clamp01(r[b])
+            elif name == "LT":
+                r[a] = FX_ONE if r[b] < r[c] else 0
+            elif name == "SIN":
+                r[a] = fx_sin(r[b])
+            elif name == "COS":
+                r[a] = fx_cos(r[b])
+            elif name == "NOISE":
+                r[a] = fx_value_noise2(r[b], r[c])
+            elif name == "JMP":
+                pc = b | (c << 8)
+            elif name == "JZ":
+                if r[a] == 0:
+                    pc = b | (c << 8)
+            elif name == "OUT":
+                if out is not None:
+                    out[:] = [fx_to_u8(r[a]), fx_to_u8(r[b]), fx_to_u8(r[c])]
+            elif name == "OUTHSV":
+                if out is not None:
+                    out[:] = list(fx_hsv_to_rgb(r[a], r[b], r[c]))
+            elif name == "AUDIO":
+                r[a] = self.audio[b]
+        return count
+
+    def frame(self, t):
+        """Calcula un frame en el instante t (Q16.16) -> lista de (r, g, b)"""
+        g0 = FX_VM_FIRST_GLOBAL
+        if self.p.frame_entry != FX_VM_NO_ENTRY:
+            r = [0] * FX_VM_NUM_REGS
+            r[2], r[3] = t, self.n << 16
+            r[g0:] = self.globals
+            self.execute(r, self.p.frame_entry, None)
+            self.globals = r[g0:]
+
+        step = fx_div(FX_ONE, self.n << 16)
+        r = [0] * FX_VM_NUM_REGS
+        r[g0:] = self.globals
+        pixels = []
+        for i in range(self.n):
+            r[0], r[1], r[2], r[3] = i << 16, i32(step * i), t, self.n << 16
+            r[4:8] = [0, 0, 0, 0]
+            out = [0, 0, 0]
+            self.instr_per_pixel.append(self.execute(r, self.p.pixel_entry, out))
+            pixels.append(tuple(out))
+        self.globals = r[g0:]
+        return pixels
+
+
+def simulate(program, leds, frames, fps, t0=0.0, audio=None):
+    sim = Simulator(program, leds, audio)
+    image = [sim.frame(to_fixed(t0 + f / float(fps))) for f in range(frames)]
+    return image, sim
+
+
+# ============================================================================
+# SALIDAS
+# ============================================================================
+
+def write_ppm(path, image):
+    height, width = len(image), len(image[0])
+    with open(path, "wb") as f:
+        f.write(b"P6\n%d %d\n255\n" % (width, height))
+        for row in image:
+            f.write(bytes(c for px in row for c in px))
+
+
+def read_ppm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    parts = data.split(None, 4)
+    if parts[0] != b"P6":
+        raise FxError("%s no es un PPM binario" % path)
+    width, height = int(parts[1]), int(parts[2])
+    raw = parts[4]
+    return [[tuple(raw[(y * width + x) * 3:(y * width + x) * 3 + 3]) for x in range(width)]
+            for y in range(height)]
+
+
+def c_identifier(path):
+    base = re.sub(r"\.\w+$", "", path.replace("\\", "/").split("/")[-1])
+    return re.sub(r"\W", "_", base).lower()
+
+
+def c_bytes(data, indent="    ", per_line=12):
+    lines = []
+    for k in range(0, len(data), per_line):
+        lines.append(indent + ", ".join("0x%02X" % b for b in data[k:k + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def load_program(path, hoist=True):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] == b"FXB1":
+        return Program.from_bytes(data)
+    return compile_source(data.decode("utf-8"), hoist)
+
+
+# ============================================================================
+# COMANDOS
+# ============================================================================
+
+def cmd_build(args):
+    program = load_program(args.source, not args.no_hoist)
+    data = program.to_bytes()
+    out = args.output or re.sub(r"\.\w+$", "", args.source) + (".h" if args.c_array else ".fxb")
+    if args.c_array:
+        name = c_identifier(args.source)
+        with open(out, "w") as f:
+            f.write("// Generado por tools/fxc.py desde %s, no editar\n" % args.source)
+            f.write("static const uint8_t fx_%s_program[%d] = {\n%s\n};\n"
+                    % (name, len(data), c_bytes(data)))
+    else:
+        with open(out, "wb") as f:
+            f.write(data)
+    print("%s: %d instrucciones, %d constantes, %d bytes -> %s"
+          % (args.source, len(program.code), len(program.consts), len(data), out))
+
+
+def cmd_dis(args):
+    program = load_program(args.source, not args.no_hoist)
+    print(program.disassemble())
+    if program.consts:
+        print("\nconstantes: " + ", ".join("k%d=%g" % (k, v / FX_ONE)
+                                           for k, v in enumerate(program.consts)))
+
+
+def parse_audio(values):
+    """Convierte ["beat=1", "band0=0.5"] en los valores fijos de la instrucción AUDIO"""
+    audio = [0] * AUDIO_NUM_FEATURES
+    for item in values:
+        name, _, value = item.partition("=")
+        if name not in AUDIO_INPUTS:
+            raise FxError("entrada de audio desconocida '%s'" % name)
+        audio[AUDIO_INPUTS[name]] = to_fixed(float(value))
+    return audio
+
+
+def cmd_run(args):
+    program = load_program(args.source, not args.no_hoist)
+    image, sim = simulate(program, args.leds, args.frames, args.fps,
+                          audio=parse_audio(args.audio))
+
+    counts = sim.instr_per_pixel
+    pixels = len(counts)
+    print("%s sobre %d LEDs x %d frames" % (args.source, args.leds, args.frames))
+    print("  instrucciones/píxel: min %d  media %.1f  max %d (límite %d)"
+          % (min(counts), sum(counts) / float(pixels), max(counts), len(program.code)))
+    cpp = sim.cycles / float(pixels)
+    print("  coste estimado: %.0f ciclos/píxel, %.2f ms/frame a 240 MHz"
+          % (cpp, cpp * args.leds / 240e3))
+
+    if args.ppm:
+        write_ppm(args.ppm, image)
+        print("  frames guardados en %s (una fila por frame)" % args.ppm)
+    if args.expect:
+        ref = read_ppm(args.expect)
+        diffs = sum(1 for row, ref_row in zip(image, ref)
+                    for px, ref_px in zip(row, ref_row) if px != ref_px)
+        if len(ref) != len(image) or len(ref[0]) != len(image[0]) or diffs:
+            print("  DIFERENTE de %s (%d píxeles distintos)" % (args.expect, diffs))
+            return 1
+        print("  idéntico a %s" % args.expect)
+    return 0
+
+
+def cmd_table(args):
+    program = load_program(args.source, not args.no_hoist)
+    if not program.is_pure():
+        raise FxError("solo se pueden tabular fuentes .fx sin globales ni audio (efectos sin estado)")
+
+    frames = int(round(args.period * args.fps))
+    image, _ = simulate(program, args.leds, frames + 1, args.fps)
+    if image[frames] != image[0]:
+        print("aviso: el efecto no es periódico con periodo %gs (el frame %d difiere del 0)"
+              % (args.period, frames), file=sys.stderr)
+    image = image[:frames]
+
+    name = c_identifier(args.source)
+    out = args.output or re.sub(r"\.\w+$", "", args.source) + "_table.h"
+    data = bytes(c for row in image for px in row for c in px)
+    with open(out, "w") as f:
+        f.write("// Generado por tools/fxc.py desde %s, no editar\n" % args.source)
+        f.write("// %d frames x %d LEDs, periodo %g s (%g fps)\n\n"
+                % (frames, args.leds, args.period, args.fps))
+        f.write("#include \"led_effects.h\"\n\n")
+        f.write("static const uint8_t fx_%s_frames[%d] = {\n%s\n};\n\n"
+                % (name, len(data), c_bytes(data)))
+        f.write("static const led_fx_table_t fx_%s_table = {\n" % name)
+        f.write("    .frames = fx_%s_frames,\n" % name)
+        f.write("    .num_frames = %d,\n    .num_leds = %d,\n    .period_ms = %d,\n};\n"
+                % (frames, args.leds, int(round(args.period * 1000))))
+    print("%s: tabla de %d bytes -> %s" % (args.source, len(data), out))
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Compilador de efectos para la VM FXB1")
+    sub = parser.add_subparsers(dest="command")
+    sub.required = True
+
+    p = sub.add_parser("build", help="compila a bytecode FXB1")
+    p.add_argument("source")
+    p.add_argument("-o", "--output")
+    p.add_argument("--c-array", action="store_true", help="genera un array C en vez de .fxb")
+    p.set_defaults(func=cmd_build)
+
+    p = sub.add_parser("dis", help="desensambla un programa")
+    p.add_argument("source")
+    p.set_defaults(func=cmd_dis)
+
+    p = sub.add_parser("run", help="ejecuta el programa sobre una tira simulada")
+    p.add_argument("source")
+    p.add_argument("--leds", type=int, default=60)
+    p.add_argument("--frames", type=int, default=60)
+    p.add_argument("--fps", type=float, default=60.0)
+    p.add_argument("--ppm", help="guarda los frames como imagen PPM")
+    p.add_argument("--expect", help="compara con una imagen PPM de referencia")
+    p.add_argument("--audio", action="append", default=[], metavar="NOMBRE=VALOR",
+                   help="valor fijo de una entrada de audio (por defecto 0)")
+    p.set_defaults(func=cmd_run)
+
+    p = sub.add_parser("table", help="genera una tabla C precalculada")
+    p.add_argument("source")
+    p.add_argument("--leds", type=int, required=True)
+    p.add_argument("--fps", type=float, default=50.0)
+    p.add_argument("--period", type=float, required=True, help="periodo en segundos")
+    p.add_argument("-o", "--output")
+    p.set_defaults(func=cmd_table)
+
+    for p in sub.choices.values():
+        p.add_argument("--no-hoist", action="store_true",
+                       help="no extraer invariantes a la sección frame")
+
+    args = parser.parse_args(argv)
+    try:
+        return args.func(args) or 0
+    except (FxError, OSError) as e:
+        print("fxc: %s" % e, file=sys.stderr)
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+gfxpack.py - Empaqueta imágenes PBM/PGM como bitmaps de alpha para fx_gfx
+
+Convierte una imagen en escala de grises en un array C de 1, 2 o 4 bits
+por píxel (main/fx_gfx.h): filas de stride bytes, píxeles del bit más alto
+al más bajo. El valor de cada píxel es la cobertura: en PGM el blanco es
+opaco y el negro transparente; en PBM los bits a 1 (negro) son opacos.
+--invert cambia el criterio.
+
+Con --font la imagen es una tira horizontal de glifos del mismo tamaño y
+se genera un fx_font_t en lugar de un fx_bitmap_t.
+
+USO:
+====
+    gfxpack.py icono.pgm --bpp 2 -o main/fx_icon.h
+    gfxpack.py fuente.pbm --font 5x7 --first 32 -o main/fx_font_big.h
+"""
+
+import argparse
+import re
+import sys
+
+
+class PackError(Exception):
+    pass
+
+
+# ============================================================================
+# LECTURA DE IMÁGENES
+# ============================================================================
+
+def read_netpbm(path):
+    """Devuelve (ancho, alto, filas de cobertura en [0, 1])"""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    # Cabecera: tipo, ancho, alto y (salvo PBM) valor máximo, con comentarios
+    fields = []
+    pos = 0
+    magic = data[:2]
+    if magic not in (b"P1", b"P2", b"P4", b"P5"):
+        raise PackError("%s: solo se admiten PBM y PGM" % path)
+    needed = 3 if magic in (b"P1", b"P4") else 4
+    token = re.compile(rb"\s*(?:#[^\n]*\n\s*)*(\S+)")
+    while len(fields) < needed:
+        m = token.match(data, pos)
+        if not m:
+            raise PackError("%s: cabecera incompleta" % path)
+        fields.append(m.group(1))
+        pos = m.end()
+    pos += 1    # Un único espacio separa la cabecera de los datos binarios
+    width, height = int(fields[1]), int(fields[2])
+    maxval = int(fields[3]) if needed == 4 else 1
+
+    if magic == b"P4":
+        stride = (width + 7) // 8
+        raw = data[pos:pos + stride * height]
+        values = [(raw[y * stride + x // 8] >> (7 - x % 8)) & 1
+                  for y in range(height) for x in range(width)]
+    elif magic == b"P5":
+        values = list(data[pos:pos + width * height])
+    else:
+        text = data[pos - 1:]
+        values = [int(v) for v in re.findall(rb"\d", text)] if magic == b"P1" \
+            else [int(v) for v in text.split()]
+
+    if len(values) < width * height:
+        raise PackError("%s: faltan datos de imagen" % path)
+
+    if magic in (b"P1", b"P4"):
+        cover = [float(v) for v in values]     # En PBM 1 es tinta
+    else:
+        cover = [v / float(maxval) for v in values]
+    return width, height, [cover[y * width:(y + 1) * width] for y in range(height)]
+
+
+# ============================================================================
+# EMPAQUETADO
+# ============================================================================
+
+def pack_rows(rows, bpp):
+    """Cuantiza y empaqueta -> (stride, bytes)"""
+    levels = (1 << bpp) - 1
+    width = len(rows[0])
+    stride = (width * bpp + 7) // 8
+    out = bytearray()
+    for row in rows:
+        line = bytearray(stride)
+        for x, c in enumerate(row):
+            v = int(round(min(max(c, 0.0), 1.0) * levels))
+            bit = x * bpp
+            line[bit // 8] |= v << (8 - bpp - bit % 8)
+        out += line
+    return stride, bytes(out)
+
+
+def c_identifier(path):
+    base = re.sub(r"\.\w+$", "", path.replace("\\", "/").split("/")[-1])
+    return re.sub(r"\W", "_", base).lower()
+
+
+def c_bytes(data, indent="    ", per_line=12):
+    lines = []
+    for k in range(0, len(data), per_line):
+        lines.append(indent + ", ".join("0x%02X" % b for b in data[k:k + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Empaqueta imágenes para fx_gfx")
+    parser.add_argument("image")
+    parser.add_argument("--bpp", type=int, choices=(1, 2, 4), default=1)
+    parser.add_argument("--invert", action="store_true", help="invierte la cobertura")
+    parser.add_argument("--font", metavar="WxH", help="atlas de glifos de WxH píxeles")
+    parser.add_argument("--first", type=int, default=32, help="primer carácter (con --font)")
+    parser.add_argument("--spacing", type=int, default=1, help="columnas entre glifos (con --font)")
+    parser.add_argument("--name", help="nombre C (por defecto, el del fichero)")
+    parser.add_argument("-o", "--output")
+    args = parser.parse_args(argv)
+
+    try:
+        width, height, rows = read_netpbm(args.image)
+        if args.invert:
+            rows = [[1.0 - c for c in row] for row in rows]
+        name = args.name or c_identifier(args.image)
+
+        if args.font:
+            gw, gh = (int(v) for v in args.font.lower().split("x"))
+            if height != gh or width % gw:
+                raise PackError("la imagen (%dx%d) no es una tira de glifos de %dx%d"
+                                % (width, height, gw, gh))
+            count = width // gw
+            data = b""
+            for g in range(count):
+                stride, packed = pack_rows([row[g * gw:(g + 1) * gw] for row in rows], args.bpp)
+                data += packed
+            struct = ("const fx_font_t fx_%s = {\n    .data = fx_%s_data,\n"
+                      "    .width = %d,\n    .height = %d,\n    .bpp = %d,\n    .stride = %d,\n"
+                      "    .first = %d,\n    .count = %d,\n    .spacing = %d,\n};\n"
+                      % (name, name, gw, gh, args.bpp, stride, args.first, count, args.spacing))
+        else:
+            stride, data = pack_rows(rows, args.bpp)
+            struct = ("const fx_bitmap_t fx_%s = {\n    .data = fx_%s_data,\n"
+                      "    .width = %d,\n    .height = %d,\n    .bpp = %d,\n    .stride = %d,\n};\n"
+                      % (name, name, width, height, args.bpp, stride))
+
+        text = ("// Generado por tools/gfxpack.py desde %s, no editar\n\n"
+                "#include \"fx_gfx.h\"\n\n"
+                "static const uint8_t fx_%s_data[%d] = {\n%s\n};\n\nstatic %s"
+                % (args.image, name, len(data), c_bytes(data), struct))
+        out = args.output or re.sub(r"\.\w+$", "", args.image) + ".h"
+        with open(out, "w") as f:
+            f.write(text)
+        print("%s: %dx%d, %d bpp, %d bytes -> %s" % (args.image, width, height, args.bpp,
+                                                    len(data), out))
+    except (PackError, OSError, ValueError) as e:
+        print("gfxpack: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
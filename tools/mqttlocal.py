@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+"""
+mqttlocal.py - Broker MQTT local y prueba del cliente MQTT (main/mqtt_api.h)
+
+Para probar el cliente MQTT sin la instalación domótica: "broker" levanta
+en el PC un broker MQTT 3.1.1 mínimo (sin dependencias) que muestra cada
+mensaje publicado, y "sweep" se conecta a él, mueve el brillo como un
+deslizador y cuenta los mensajes de estado que devuelve el dispositivo.
+
+Con CONFIG_MQTT_API_BROKER_URI apuntando al PC ("mqtt://<ip del PC>"):
+
+USO:
+====
+    mqttlocal.py broker
+    mqttlocal.py sweep --rate 50 --seconds 5
+    mqttlocal.py sweep --device led-a1b2c3 --rate 200
+
+El broker atiende QoS 0 y 1 (QoS 2 se confirma pero se entrega como QoS 0),
+mensajes retenidos y última voluntad; no guarda sesiones. Basta para el
+dispositivo y para "sweep"; no es un broker de producción.
+"""
+
+import argparse
+import json
+import socket
+import socketserver
+import struct
+import sys
+import threading
+import time
+
+
+CONNECT, CONNACK, PUBLISH, PUBACK, PUBREC, PUBREL, PUBCOMP = 1, 2, 3, 4, 5, 6, 7
+SUBSCRIBE, SUBACK, UNSUBSCRIBE, UNSUBACK, PINGREQ, PINGRESP, DISCONNECT = 8, 9, 10, 11, 12, 13, 14
+
+
+# ============================================================================
+# Paquetes
+# ============================================================================
+
+def read_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("conexión cerrada")
+        data += chunk
+    return data
+
+
+def read_packet(sock):
+    """Devuelve (tipo, flags, cuerpo)"""
+    b0 = read_exact(sock, 1)[0]
+    length, shift = 0, 0
+    while True:
+        b = read_exact(sock, 1)[0]
+        length |= (b & 0x7F) << shift
+        if not b & 0x80:
+            break
+        shift += 7
+    return b0 >> 4, b0 & 0x0F, read_exact(sock, length)
+
+
+def packet(ptype, flags, body):
+    n, length = len(body), b""
+    while True:
+        b, n = n & 0x7F, n >> 7
+        length += bytes((b | (0x80 if n else 0),))
+        if not n:
+            break
+    return bytes(((ptype << 4) | flags,)) + length + body
+
+
+def mqtt_str(s):
+    data = s.encode() if isinstance(s, str) else s
+    return struct.pack("!H", len(data)) + data
+
+
+def take_str(body, pos):
+    n = struct.unpack_from("!H", body, pos)[0]
+    return body[pos + 2:pos + 2 + n], pos + 2 + n
+
+
+def publish_packet(topic, payload, qos=0, retain=False, packet_id=1):
+    body = mqtt_str(topic)
+    if qos:
+        body += struct.pack("!H", packet_id)
+    return packet(PUBLISH, (qos << 1) | int(retain), body + payload)
+
+
+def topic_matches(pattern, topic):
+    p, t = pattern.split("/"), topic.split("/")
+    for i, level in enumerate(p):
+        if level == "#":
+            return True
+        if i >= len(t) or (level != "+" and level != t[i]):
+            return False
+    return len(p) == len(t)
+
+
+# ============================================================================
+# Broker
+# ============================================================================
+
+class Broker(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+    def __init__(self, addr, quiet):
+        super().__init__(addr, Session)
+        self.quiet = quiet
+        self.lock = threading.Lock()
+        self.sessions = set()
+        self.retained = {}
+        self.t0 = time.monotonic()
+
+    def log(self, text):
+        print(f"[{time.monotonic() - self.t0:9.3f}] {text}", flush=True)
+
+    def route(self, topic, payload, retain):
+        if not self.quiet:
+            self.log(f"{topic} {payload.decode(errors='replace')}" + (" (r)" if retain else ""))
+        with self.lock:
+            if retain:
+                if payload:
+                    self.retained[topic] = payload
+                else:
+                    self.retained.pop(topic, None)
+            targets = [s for s in self.sessions if any(topic_matches(f, topic) for f in s.filters)]
+        data = publish_packet(topic, payload)
+        for s in targets:
+            s.send(data)
+
+
+class Session(socketserver.BaseRequestHandler):
+    def send(self, data):
+        with self.wlock:
+            try:
+                self.request.sendall(data)
+            except OSError:
+                pass
+
+    def handle(self):
+        broker = self.server
+        sock = self.request
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.wlock = threading.Lock()
+        self.filters = []
+        self.client_id = "?"
+        will = None
+        clean = False
+
+        try:
+            ptype, _, body = read_packet(sock)
+            if ptype != CONNECT:
+                return
+            _, pos = take_str(body, 0)
+            flags = body[pos + 1]
+            client_id, pos = take_str(body, pos + 4)
+            self.client_id = client_id.decode(errors="replace") or "?"
+            if flags & 0x04:
+                wtopic, pos = take_str(body, pos)
+                wmsg, pos = take_str(body, pos)
+                will = (wtopic.decode(), wmsg, bool(flags & 0x20))
+            self.send(packet(CONNACK, 0, b"\x00\x00"))
+            with broker.lock:
+                broker.sessions.add(self)
+            broker.log(f"+ {self.client_id} ({self.client_address[0]})")
+
+            while True:
+                ptype, flags, body = read_packet(sock)
+                if ptype == PUBLISH:
+                    qos = (flags >> 1) & 3
+                    topic, pos = take_str(body, 0)
+                    if qos:
+                        pid = body[pos:pos + 2]
+                        pos += 2
+                        self.send(packet(PUBACK if qos == 1 else PUBREC, 0, pid))
+                    broker.route(topic.decode(), body[pos:], bool(flags & 1))
+                elif ptype == PUBREL:
+                    self.send(packet(PUBCOMP, 0, body[:2]))
+                elif ptype == SUBSCRIBE:
+                    pos, granted, new = 2, b"", []
+                    while pos < len(body):
+                        f, pos = take_str(body, pos)
+                        pos += 1
+                        new.append(f.decode())
+                        granted += b"\x00"
+                    with broker.lock:
+                        self.filters.extend(new)
+                        retained = [(t, p) for t, p in broker.retained.items()
+                                    if any(topic_matches(f, t) for f in new)]
+                    self.send(packet(SUBACK, 0, body[:2] + granted))
+                    for t, p in retained:
+                        self.send(publish_packet(t, p, retain=True))
+                    broker.log(f"  {self.client_id} suscrito a {', '.join(new)}")
+                elif ptype == UNSUBSCRIBE:
+                    self.send(packet(UNSUBACK, 0, body[:2]))
+                elif ptype == PINGREQ:
+                    self.send(packet(PINGRESP, 0, b""))
+                elif ptype == DISCONNECT:
+                    clean = True
+                    return
+        except (ConnectionError, OSError, IndexError, struct.error):
+            pass
+        finally:
+            with broker.lock:
+                broker.sessions.discard(self)
+            broker.log(f"- {self.client_id}")
+            if will and not clean:
+                broker.route(*will)
+
+
+def run_broker(args):
+    broker = Broker((args.bind, args.port), args.quiet)
+    broker.log(f"broker MQTT en {args.bind}:{args.port}")
+    try:
+        broker.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+# ============================================================================
+# Barrido
+# ============================================================================
+
+def run_sweep(args):
+    sock = socket.create_connection((args.host, args.port), timeout=5)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    client_id = b"mqttlocal-sweep"
+    sock.sendall(packet(CONNECT, 0, mqtt_str("MQTT") + bytes((4, 0x02)) +
+                        struct.pack("!H", 60) + mqtt_str(client_id)))
+    if read_packet(sock)[0] != CONNACK:
+        print("error: el broker no aceptó la conexión", file=sys.stderr)
+        return 1
+
+    state_filter = f"{args.base}/{args.device}/state"
+    sock.sendall(packet(SUBSCRIBE, 2, struct.pack("!H", 1) + mqtt_str(state_filter) + b"\x00"))
+
+    states = []
+    done = threading.Event()
+
+    def reader():
+        sock.settimeout(0.5)
+        while not done.is_set():
+            try:
+                ptype, flags, body = read_packet(sock)
+            except socket.timeout:
+                continue
+            except (ConnectionError, OSError):
+                return
+            if ptype == PUBLISH:
+                topic, pos = take_str(body, 0)
+                if (flags >> 1) & 3:
+                    pos += 2
+                states.append((time.monotonic(), flags & 1, topic.decode(), body[pos:]))
+
+    threading.Thread(target=reader, daemon=True).start()
+    time.sleep(0.3)     # Estado retenido de la suscripción
+    retained = len(states)
+
+    target = (f"{args.base}/group/{args.group}" if args.device in ("+", "")
+              else f"{args.base}/{args.device}")
+    topic = f"{target}/set/brightness"
+    period = 1.0 / args.rate
+    count = int(args.rate * args.seconds)
+    t0 = time.monotonic()
+    value = 0
+    for i in range(count):
+        v = i % 510
+        value = v if v < 256 else 509 - v
+        sock.sendall(publish_packet(topic, str(value).encode()))
+        delay = t0 + (i + 1) * period - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+    elapsed = time.monotonic() - t0
+
+    time.sleep(args.settle)
+    done.set()
+    sock.sendall(packet(DISCONNECT, 0, b""))
+    sock.close()
+
+    live = [s for s in states[retained:] if s[0] >= t0]
+    print(f"{topic}: {count} mensajes en {elapsed:.2f} s ({count / elapsed:.1f}/s), "
+          f"último valor {value}")
+    print(f"  estados recibidos: {len(live)} ({len(live) / (elapsed + args.settle):.2f}/s)")
+    if len(live) > 1:
+        gaps = [b[0] - a[0] for a, b in zip(live, live[1:])]
+        print(f"  intervalo mínimo entre estados: {min(gaps) * 1000:.0f} ms")
+    if live:
+        last = json.loads(live[-1][3])
+        ok = last.get("brightness") == value
+        print(f"  último estado: brillo {last.get('brightness')} "
+              f"({'coincide' if ok else 'NO coincide'} con el último valor enviado)")
+        return 0 if ok else 1
+    print("  ningún estado recibido (¿dispositivo conectado al broker?)")
+    return 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    b = sub.add_parser("broker", help="Broker MQTT local")
+    b.add_argument("--bind", default="0.0.0.0")
+    b.add_argument("--port", type=int, default=1883)
+    b.add_argument("-q", "--quiet", action="store_true", help="No mostrar cada mensaje")
+
+    s = sub.add_parser("sweep", help="Barrido de brillo y recuento de estados")
+    s.add_argument("--host", default="127.0.0.1", help="Broker (por defecto local)")
+    s.add_argument("--port", type=int, default=1883)
+    s.add_argument("--base", default="leds", help="CONFIG_MQTT_API_BASE_TOPIC")
+    s.add_argument("--device", default="+",
+                   help="Id del dispositivo (por defecto se manda al grupo)")
+    s.add_argument("--group", default="all", help="CONFIG_MQTT_API_GROUP")
+    s.add_argument("--rate", type=float, default=50, help="Mensajes por segundo")
+    s.add_argument("--seconds", type=float, default=5)
+    s.add_argument("--settle", type=float, default=2.0,
+                   help="Espera final para el último estado (s)")
+
+    args = parser.parse_args()
+    return run_broker(args) if args.cmd == "broker" else run_sweep(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
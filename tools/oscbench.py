@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""
+oscbench.py - Mide el receptor OSC (main/osc_api.h) desde el PC
+
+Tres fases contra el dispositivo, por UDP:
+
+1. Caudal: manda N mensajes de un fader (/led/brightness con un float que
+   barre 0.0-1.0), sueltos o agrupados en bundles, a toda velocidad o a
+   --rate mensajes por segundo. Con /led/stats antes y después se cuenta
+   cuántos llegaron y procesó el dispositivo.
+2. Latencia de red: pings secuenciales (/led/ping, respondidos con
+   /led/pong) para el tiempo de ida y vuelta.
+3. Dispositivo: tiempo de análisis y reparto por paquete, comandos
+   agrupados y percentiles de la latencia petición-luz del fader.
+
+USO:
+====
+    oscbench.py 192.168.1.50
+    oscbench.py 192.168.1.50 -n 20000 --bundle 8
+    oscbench.py 192.168.1.50 --rate 120 --pings 500
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+
+STATS_FIELDS = ("packets", "messages", "bundles", "errors", "unmatched", "rejected",
+                "handle_avg_us", "handle_max_us", "coalesced", "samples",
+                "p50", "p90", "p99")
+
+
+def osc_string(s):
+    data = s.encode() + b"\0"
+    return data + b"\0" * (-len(data) % 4)
+
+
+def osc_message(address, types="", *args):
+    out = osc_string(address) + osc_string("," + types)
+    for t, v in zip(types, args):
+        out += struct.pack({"i": ">i", "f": ">f", "h": ">q"}[t], v)
+    return out
+
+
+def osc_bundle(messages):
+    out = osc_string("#bundle") + struct.pack(">Q", 1)
+    for m in messages:
+        out += struct.pack(">i", len(m)) + m
+    return out
+
+
+def parse_ints(data):
+    """Dirección y argumentos enteros de una respuesta"""
+    end = data.index(b"\0")
+    address = data[:end].decode()
+    pos = (end + 4) & ~3
+    tend = data.index(b"\0", pos)
+    types = data[pos + 1:tend].decode()
+    pos = (tend + 4) & ~3
+    values = []
+    for t in types:
+        if t == "i":
+            values.append(struct.unpack_from(">i", data, pos)[0])
+            pos += 4
+        elif t == "h":
+            values.append(struct.unpack_from(">q", data, pos)[0])
+            pos += 8
+    return address, values
+
+
+def read_stats(sock, addr, reset=False):
+    sock.sendto(osc_message("/led/stats", "i", 1 if reset else 0), addr)
+    deadline = time.monotonic() + 2.0
+    while time.monotonic() < deadline:
+        try:
+            data, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            break
+        address, values = parse_ints(data)
+        if address == "/led/stats" and len(values) == len(STATS_FIELDS):
+            return dict(zip(STATS_FIELDS, values))
+    raise OSError("sin respuesta a /led/stats (¿CONFIG_OSC_API_ENABLE y el puerto?)")
+
+
+def percentile(values, p):
+    k = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="Dirección del dispositivo")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("-n", "--messages", type=int, default=5000,
+                        help="Mensajes del fader (por defecto 5000)")
+    parser.add_argument("--bundle", type=int, default=1,
+                        help="Mensajes por bundle (1: mensajes sueltos)")
+    parser.add_argument("--rate", type=float, default=0,
+                        help="Mensajes por segundo (por defecto sin límite)")
+    parser.add_argument("--pings", type=int, default=200)
+    args = parser.parse_args()
+
+    addr = (args.host, args.port)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(0.5)
+
+    try:
+        before = read_stats(sock, addr, reset=True)
+    except OSError as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+    # 1. Caudal
+    group = max(1, args.bundle)
+    period = group / args.rate if args.rate > 0 else 0
+    sent = 0
+    t0 = time.perf_counter()
+    while sent < args.messages:
+        msgs = []
+        for _ in range(min(group, args.messages - sent)):
+            v = sent % 512
+            level = (v if v < 256 else 511 - v) / 255.0
+            msgs.append(osc_message("/led/brightness", "f", level))
+            sent += 1
+        sock.sendto(msgs[0] if group == 1 else osc_bundle(msgs), addr)
+        if period:
+            delay = t0 + (sent / group) * period - time.perf_counter()
+            if delay > 0:
+                time.sleep(delay)
+    elapsed = time.perf_counter() - t0
+
+    time.sleep(0.2)
+    mid = read_stats(sock, addr)
+
+    # 2. Pings
+    rtts, lost = [], 0
+    for i in range(args.pings):
+        t = time.perf_counter()
+        sock.sendto(osc_message("/led/ping", "h", i), addr)
+        while True:
+            try:
+                data, _ = sock.recvfrom(2048)
+            except socket.timeout:
+                lost += 1
+                break
+            address, values = parse_ints(data)
+            if address == "/led/pong" and values == [i]:
+                rtts.append(time.perf_counter() - t)
+                break
+
+    after = read_stats(sock, addr)
+
+    # La respuesta de /led/stats cuenta como un mensaje más
+    received = mid["messages"] - before["messages"] - 1
+    packets = -(-args.messages // group)
+    print(f"/led/brightness: {args.messages} mensajes en {packets} paquetes, "
+          f"{elapsed:.2f} s ({args.messages / elapsed:.0f} mensajes/s enviados)")
+    print(f"  recibidos:      {received} ({received / elapsed:.0f}/s), "
+          f"{args.messages - received} perdidos, {mid['errors'] - before['errors']} paquetes "
+          f"mal formados, {mid['rejected'] - before['rejected']} rechazados")
+    print(f"  dispositivo:    {mid['handle_avg_us']} us de media por paquete "
+          f"(máx. {mid['handle_max_us']} us), {mid['coalesced'] - before['coalesced']} "
+          f"valores agrupados")
+    if mid["samples"] > 0:
+        print(f"  petición-luz:   p50 {mid['p50'] / 1000.0:.1f} ms, p90 {mid['p90'] / 1000.0:.1f}, "
+              f"p99 {mid['p99'] / 1000.0:.1f} en {mid['samples']} frames")
+    if rtts:
+        rtts.sort()
+        ms = [v * 1000.0 for v in rtts]
+        print(f"  ping:           p50 {percentile(ms, 50):.2f} ms, p90 {percentile(ms, 90):.2f}, "
+              f"p99 {percentile(ms, 99):.2f}, máx {ms[-1]:.2f} ({lost} perdidos de {args.pings})")
+    print(f"  total:          {after['packets']} paquetes, {after['bundles']} bundles, "
+          f"{after['unmatched']} mensajes sin dirección desde el arranque")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+sparsebench.py - Compara actualizaciones parciales y frames completos
+(WS_OP_PIXELS frente a WS_OP_FRAME_RGB, main/ws_api.h)
+
+Mueve un cursor de --width píxeles a lo largo de la tira, un paso por
+mensaje, dos veces: primero mandando solo los píxeles que cambian (los
+que deja el cursor a negro y los nuevos) y después el frame completo de
+cada paso. Para cada modo lee /api/stats antes y después y muestra:
+
+- Bytes por la red (mensajes WebSocket, sin cabeceras TCP/IP)
+- Bytes por el cable de la tira y frames recompuestos solo en parte
+- Tiempo medio de composición, codificación y envío por frame
+
+USO:
+====
+    sparsebench.py 192.168.1.50 --leds 300
+    sparsebench.py 192.168.1.50 --leds 300 --rate 60 -n 600 --width 3
+"""
+
+import argparse
+import http.client
+import json
+import struct
+import sys
+import time
+
+from wsbench import WebSocket
+
+OP_FRAME_RGB = 0x10
+OP_PIXELS = 0x12
+
+CURSOR = (255, 255, 255)
+
+
+def get_stats(host, port):
+    conn = http.client.HTTPConnection(host, port, timeout=5)
+    try:
+        conn.request("GET", "/api/stats")
+        return json.loads(conn.getresponse().read())["render"]
+    finally:
+        conn.close()
+
+
+def pixels_message(leds, prev, pos, width):
+    """Píxeles que cambian al mover el cursor de prev a pos"""
+    old = set((prev + k) % leds for k in range(width)) if prev is not None else set()
+    new = set((pos + k) % leds for k in range(width))
+    entries = [struct.pack("<H3B", i, 0, 0, 0) for i in sorted(old - new)]
+    entries += [struct.pack("<H3B", i, *CURSOR) for i in sorted(new)]
+    return struct.pack("<BH", OP_PIXELS, len(entries)) + b"".join(entries)
+
+
+def frame_message(leds, pos, width):
+    frame = bytearray(leds * 3)
+    for k in range(width):
+        i = (pos + k) % leds
+        frame[i * 3:i * 3 + 3] = bytes(CURSOR)
+    return bytes((OP_FRAME_RGB,)) + bytes(frame)
+
+
+def run(args, mode):
+    ws = WebSocket(args.host, args.port)
+    before = get_stats(args.host, args.port)
+    period = 1.0 / args.rate
+    sent = 0
+    prev = None
+    t0 = time.perf_counter()
+    for step in range(args.messages):
+        pos = step % args.leds
+        msg = (pixels_message(args.leds, prev, pos, args.width) if mode == "pixels"
+               else frame_message(args.leds, pos, args.width))
+        ws.send(msg)
+        sent += len(msg)
+        prev = pos
+        delay = t0 + (step + 1) * period - time.perf_counter()
+        if delay > 0:
+            time.sleep(delay)
+    time.sleep(0.2)
+    after = get_stats(args.host, args.port)
+    ws.close()
+
+    frames = after["frames"] - before["frames"]
+    partial = after["partial"] - before["partial"]
+    wire = after["wire_bytes"] - before["wire_bytes"]
+    out_us = after["output_sum_us"] - before["output_sum_us"]
+    print(f"{mode:7s} {args.messages} mensajes, {sent} bytes por la red "
+          f"({sent / args.messages:.0f} por mensaje)")
+    print(f"        {frames} frames ({partial} parciales), {wire} bytes por el cable "
+          f"({wire / max(frames, 1):.0f} por frame), "
+          f"{out_us / max(frames, 1):.0f} us de salida por frame")
+    return sent, wire, out_us / max(frames, 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="Dirección del dispositivo")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--leds", type=int, required=True,
+                        help="LEDs de la tira (CONFIG_LED_NUM_LEDS)")
+    parser.add_argument("-n", "--messages", type=int, default=300)
+    parser.add_argument("--rate", type=float, default=30,
+                        help="Pasos del cursor por segundo (por defecto 30)")
+    parser.add_argument("--width", type=int, default=3, help="Píxeles del cursor")
+    args = parser.parse_args()
+
+    try:
+        net_p, wire_p, us_p = run(args, "pixels")
+        net_f, wire_f, us_f = run(args, "frame")
+    except (OSError, KeyError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+    print(f"parcial / completo: red {net_p / max(net_f, 1):.3f}, "
+          f"cable {wire_p / max(wire_f, 1):.3f}, salida {us_p / max(us_f, 1):.3f}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""
+wsbench.py - Mide el canal WebSocket de control (main/ws_api.h) desde el PC
+
+Simula un deslizador: manda por una sola conexión valores de brillo (o de
+color) que barren todo el rango, cada uno en un mensaje con un ECHO detrás,
+y mide en el cliente el tiempo de ida y vuelta de cada mensaje. Antes
+reinicia y después lee las estadísticas del dispositivo (WS_OP_STATS) para
+obtener los percentiles de la latencia petición-luz y cuántos valores se
+agruparon con otros antes de aplicarse.
+
+Con --rate se limita la cadencia (mensajes por segundo), como un control
+real; sin ella se mandan tan rápido como el dispositivo responde.
+
+USO:
+====
+    wsbench.py 192.168.1.50
+    wsbench.py 192.168.1.50 -n 5000 --rate 200 --param color
+"""
+
+import argparse
+import base64
+import os
+import socket
+import struct
+import sys
+import time
+
+
+OP_ECHO = 0x00
+OP_COLOR = 0x01
+OP_BRIGHTNESS = 0x03
+OP_STATS = 0x20
+OP_ERROR = 0xFF
+
+STATS_FIELDS = ("received", "dropped", "coalesced", "applied", "samples", "last",
+                "avg", "max", "p50", "p90", "p99", "messages", "frames", "errors")
+
+
+class WebSocket:
+    """Cliente WebSocket mínimo: solo mensajes binarios de un frame"""
+
+    def __init__(self, host, port, path="/ws"):
+        self.sock = socket.create_connection((host, port), timeout=5)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.sock.sendall((f"GET {path} HTTP/1.1\r\nHost: {host}\r\n"
+                           "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                           f"Sec-WebSocket-Key: {key}\r\n"
+                           "Sec-WebSocket-Version: 13\r\n\r\n").encode())
+        head = b""
+        while b"\r\n\r\n" not in head:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                raise OSError("conexión cerrada durante la negociación")
+            head += chunk
+        status = head.split(b"\r\n", 1)[0]
+        if b" 101 " not in status:
+            raise OSError(f"negociación rechazada: {status.decode(errors='replace')}")
+        self.buf = head.split(b"\r\n\r\n", 1)[1]
+
+    def send(self, payload):
+        mask = os.urandom(4)
+        n = len(payload)
+        if n < 126:
+            head = struct.pack("!BB", 0x82, 0x80 | n)
+        elif n < 65536:
+            head = struct.pack("!BBH", 0x82, 0x80 | 126, n)
+        else:
+            head = struct.pack("!BBQ", 0x82, 0x80 | 127, n)
+        body = bytes(b ^ mask[i & 3] for i, b in enumerate(payload))
+        self.sock.sendall(head + mask + body)
+
+    def _read(self, n):
+        while len(self.buf) < n:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise OSError("conexión cerrada")
+            self.buf += chunk
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+    def recv(self):
+        """Devuelve el siguiente mensaje binario"""
+        while True:
+            b0, b1 = self._read(2)
+            n = b1 & 0x7F
+            if n == 126:
+                n = struct.unpack("!H", self._read(2))[0]
+            elif n == 127:
+                n = struct.unpack("!Q", self._read(8))[0]
+            payload = self._read(n)
+            opcode = b0 & 0x0F
+            if opcode == 0x8:
+                raise OSError("el dispositivo cerró la conexión")
+            if opcode == 0x2:
+                return payload
+
+    def close(self):
+        self.sock.close()
+
+
+def read_stats(ws, reset=False):
+    ws.send(bytes((OP_STATS, 1 if reset else 0)))
+    msg = ws.recv()
+    if msg[0] != OP_STATS or len(msg) != 1 + 4 * len(STATS_FIELDS):
+        raise OSError(f"respuesta inesperada a STATS: {msg[:8].hex()}")
+    return dict(zip(STATS_FIELDS, struct.unpack(f"<{len(STATS_FIELDS)}I", msg[1:])))
+
+
+def percentile(values, p):
+    k = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="Dirección del dispositivo")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("-n", "--messages", type=int, default=2000,
+                        help="Mensajes en total (por defecto 2000)")
+    parser.add_argument("--rate", type=float, default=0,
+                        help="Mensajes por segundo (por defecto sin límite)")
+    parser.add_argument("--param", choices=("brightness", "color"), default="brightness")
+    args = parser.parse_args()
+
+    try:
+        ws = WebSocket(args.host, args.port)
+        before = read_stats(ws, reset=True)
+    except OSError as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+    period = 1.0 / args.rate if args.rate > 0 else 0
+    rtts, errors = [], 0
+    t0 = time.perf_counter()
+    for i in range(args.messages):
+        # Barrido de ida y vuelta como un deslizador
+        v = i % 510
+        v = v if v < 256 else 509 - v
+        cmd = (bytes((OP_BRIGHTNESS, v)) if args.param == "brightness"
+               else bytes((OP_COLOR, v, 255 - v, 0)))
+        t = time.perf_counter()
+        ws.send(cmd + bytes((OP_ECHO,)) + struct.pack("<I", i))
+        while True:
+            msg = ws.recv()
+            if msg[0] == OP_ERROR:
+                errors += 1
+                continue
+            break
+        rtts.append(time.perf_counter() - t)
+        if period:
+            delay = t0 + (i + 1) * period - time.perf_counter()
+            if delay > 0:
+                time.sleep(delay)
+    elapsed = time.perf_counter() - t0
+
+    # Los últimos valores se presentan en el frame siguiente
+    time.sleep(0.1)
+    after = read_stats(ws)
+    ws.close()
+
+    rtts.sort()
+    ms = [v * 1000.0 for v in rtts]
+    print(f"/ws {args.param}: {len(ms)} mensajes en {elapsed:.2f} s "
+          f"({len(ms) / elapsed:.1f}/s)")
+    print(f"  ida y vuelta:   media {sum(ms) / len(ms):.2f} ms, p50 {percentile(ms, 50):.2f}, "
+          f"p90 {percentile(ms, 90):.2f}, p99 {percentile(ms, 99):.2f}, máx {ms[-1]:.2f}")
+    print(f"  comandos:       {after['received'] - before['received']} recibidos, "
+          f"{after['applied'] - before['applied']} aplicados, "
+          f"{after['coalesced'] - before['coalesced']} agrupados, {errors} errores")
+    if after["samples"] > 0:
+        print(f"  petición-luz:   p50 {after['p50'] / 1000.0:.1f} ms, "
+              f"p90 {after['p90'] / 1000.0:.1f}, p99 {after['p99'] / 1000.0:.1f}, "
+              f"media {after['avg'] / 1000.0:.2f}, máx {after['max'] / 1000.0:.2f} "
+              f"en {after['samples']} frames")
+    else:
+        print("  petición-luz:   sin frames nuevos (¿hay algún efecto o fuente activa?)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())